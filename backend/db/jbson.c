@@ -244,15 +244,15 @@ _error:
 
 G_GNUC_UNUSED
 static gboolean
-j_bson_iter_value(bson_iter_t* iter, JDBType type, JDBTypeValue* value, GError** error)
+j_bson_value_get(bson_value_t const* bson_value, JDBType type, JDBTypeValue* value, GError** error)
 {
 	J_TRACE_FUNCTION(NULL);
 
 	memset(value, 0, sizeof(*value));
 
-	if (G_UNLIKELY(!iter))
+	if (G_UNLIKELY(!bson_value))
 	{
-		g_set_error_literal(error, J_BACKEND_BSON_ERROR, J_BACKEND_BSON_ERROR_ITER_NULL, "bson iter must not be NULL");
+		g_set_error_literal(error, J_BACKEND_BSON_ERROR, J_BACKEND_BSON_ERROR_BSON_VALUE_NULL, "value must not be NULL");
 		goto _error;
 	}
 
@@ -265,7 +265,7 @@ j_bson_iter_value(bson_iter_t* iter, JDBType type, JDBTypeValue* value, GError**
 	switch (type)
 	{
 		case J_DB_TYPE_SINT32:
-			if (G_UNLIKELY(!BSON_ITER_HOLDS_INT32(iter)))
+			if (G_UNLIKELY(bson_value->value_type != BSON_TYPE_INT32))
 			{
 				g_set_error_literal(error, J_BACKEND_BSON_ERROR, J_BACKEND_BSON_ERROR_ITER_INVALID_TYPE, "bson iter invalid type");
 				goto _error;
@@ -273,12 +273,12 @@ j_bson_iter_value(bson_iter_t* iter, JDBType type, JDBTypeValue* value, GError**
 
 			if (value)
 			{
-				value->val_sint32 = bson_iter_int32(iter);
+				value->val_sint32 = bson_value->value.v_int32;
 			}
 
 			break;
 		case J_DB_TYPE_UINT32:
-			if (G_UNLIKELY(!BSON_ITER_HOLDS_INT32(iter)))
+			if (G_UNLIKELY(bson_value->value_type != BSON_TYPE_INT32))
 			{
 				g_set_error_literal(error, J_BACKEND_BSON_ERROR, J_BACKEND_BSON_ERROR_ITER_INVALID_TYPE, "bson iter invalid type");
 				goto _error;
@@ -286,12 +286,12 @@ j_bson_iter_value(bson_iter_t* iter, JDBType type, JDBTypeValue* value, GError**
 
 			if (value)
 			{
-				value->val_uint32 = bson_iter_int32(iter);
+				value->val_uint32 = bson_value->value.v_int32;
 			}
 
 			break;
 		case J_DB_TYPE_FLOAT64:
-			if (G_UNLIKELY(!BSON_ITER_HOLDS_DOUBLE(iter)))
+			if (G_UNLIKELY(bson_value->value_type != BSON_TYPE_DOUBLE))
 			{
 				g_set_error_literal(error, J_BACKEND_BSON_ERROR, J_BACKEND_BSON_ERROR_ITER_INVALID_TYPE, "bson iter invalid type");
 				goto _error;
@@ -299,12 +299,12 @@ j_bson_iter_value(bson_iter_t* iter, JDBType type, JDBTypeValue* value, GError**
 
 			if (value)
 			{
-				value->val_float64 = bson_iter_double(iter);
+				value->val_float64 = bson_value->value.v_double;
 			}
 
 			break;
 		case J_DB_TYPE_FLOAT32:
-			if (G_UNLIKELY(!BSON_ITER_HOLDS_DOUBLE(iter)))
+			if (G_UNLIKELY(bson_value->value_type != BSON_TYPE_DOUBLE))
 			{
 				g_set_error_literal(error, J_BACKEND_BSON_ERROR, J_BACKEND_BSON_ERROR_ITER_INVALID_TYPE, "bson iter invalid type");
 				goto _error;
@@ -312,12 +312,12 @@ j_bson_iter_value(bson_iter_t* iter, JDBType type, JDBTypeValue* value, GError**
 
 			if (value)
 			{
-				value->val_float32 = bson_iter_double(iter);
+				value->val_float32 = bson_value->value.v_double;
 			}
 
 			break;
 		case J_DB_TYPE_SINT64:
-			if (G_UNLIKELY(!BSON_ITER_HOLDS_INT64(iter)))
+			if (G_UNLIKELY(bson_value->value_type != BSON_TYPE_INT64))
 			{
 				g_set_error_literal(error, J_BACKEND_BSON_ERROR, J_BACKEND_BSON_ERROR_ITER_INVALID_TYPE, "bson iter invalid type");
 				goto _error;
@@ -325,12 +325,12 @@ j_bson_iter_value(bson_iter_t* iter, JDBType type, JDBTypeValue* value, GError**
 
 			if (value)
 			{
-				value->val_sint64 = bson_iter_int64(iter);
+				value->val_sint64 = bson_value->value.v_int64;
 			}
 
 			break;
 		case J_DB_TYPE_UINT64:
-			if (G_UNLIKELY(!BSON_ITER_HOLDS_INT64(iter)))
+			if (G_UNLIKELY(bson_value->value_type != BSON_TYPE_INT64))
 			{
 				g_set_error_literal(error, J_BACKEND_BSON_ERROR, J_BACKEND_BSON_ERROR_ITER_INVALID_TYPE, "bson iter invalid type");
 				goto _error;
@@ -338,12 +338,12 @@ j_bson_iter_value(bson_iter_t* iter, JDBType type, JDBTypeValue* value, GError**
 
 			if (value)
 			{
-				value->val_uint64 = bson_iter_int64(iter);
+				value->val_uint64 = bson_value->value.v_int64;
 			}
 
 			break;
 		case J_DB_TYPE_STRING:
-			if (G_UNLIKELY(!BSON_ITER_HOLDS_UTF8(iter)))
+			if (G_UNLIKELY(bson_value->value_type != BSON_TYPE_UTF8))
 			{
 				g_set_error_literal(error, J_BACKEND_BSON_ERROR, J_BACKEND_BSON_ERROR_ITER_INVALID_TYPE, "bson iter invalid type");
 				goto _error;
@@ -351,25 +351,26 @@ j_bson_iter_value(bson_iter_t* iter, JDBType type, JDBTypeValue* value, GError**
 
 			if (value)
 			{
-				value->val_string = bson_iter_utf8(iter, NULL);
+				value->val_string = bson_value->value.v_utf8.str;
 			}
 
 			break;
 		case J_DB_TYPE_BLOB:
-			if (BSON_ITER_HOLDS_NULL(iter))
+			if (bson_value->value_type == BSON_TYPE_NULL)
 			{
 				value->val_blob_length = 0;
 				value->val_blob = NULL;
 				break;
 			}
 
-			if (G_UNLIKELY(!BSON_ITER_HOLDS_BINARY(iter)))
+			if (G_UNLIKELY(bson_value->value_type != BSON_TYPE_BINARY))
 			{
 				g_set_error_literal(error, J_BACKEND_BSON_ERROR, J_BACKEND_BSON_ERROR_ITER_INVALID_TYPE, "bson iter invalid type");
 				goto _error;
 			}
 
-			bson_iter_binary(iter, NULL, &value->val_blob_length, (const uint8_t**)&value->val_blob);
+			value->val_blob_length = bson_value->value.v_binary.data_len;
+			value->val_blob = (gchar const*)bson_value->value.v_binary.data;
 			break;
 		case J_DB_TYPE_ID:
 		default:
@@ -383,6 +384,24 @@ _error:
 	return FALSE;
 }
 
+G_GNUC_UNUSED
+static gboolean
+j_bson_iter_value(bson_iter_t* iter, JDBType type, JDBTypeValue* value, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	if (G_UNLIKELY(!iter))
+	{
+		g_set_error_literal(error, J_BACKEND_BSON_ERROR, J_BACKEND_BSON_ERROR_ITER_NULL, "bson iter must not be NULL");
+		goto _error;
+	}
+
+	return j_bson_value_get(bson_iter_value(iter), type, value, error);
+
+_error:
+	return FALSE;
+}
+
 G_GNUC_UNUSED
 static gboolean
 j_bson_iter_find(bson_iter_t* iter, const char* key, GError** error)
@@ -22,30 +22,2555 @@
 #include <glib.h>
 #include <gmodule.h>
 
+#include <string.h>
+
 #include <julea.h>
+#include <julea-db.h>
+
+#include "jbson.c"
+
+/*
+ * Every schema is stored as a table holding one array per column.
+ * Rows are addressed by their position, deleted rows are only marked and removed once no iterator refers to the table anymore.
+ *
+ * For every index given in a schema's "_index", the table maintains a hash index (used for equality conditions) and a skip list (used for range conditions).
+ * Multi-field indexes are maintained for their first field only, the remaining conditions are checked per row.
+ *
+ * Queries hold a table's read lock while collecting matching rows, modifications hold its write lock.
+ * Batches are not atomic, all operations are applied immediately.
+ */
+
+/**
+ * The column number used for the "_id" pseudo column.
+ **/
+#define MEMORY_COLUMN_ID (-1)
+
+#define MEMORY_SKIP_LIST_LEVELS 16
+
+/**
+ * Tables are only compacted if at least this many rows have been deleted.
+ **/
+#define MEMORY_COMPACT_THRESHOLD 1024
+
+union JMemoryValue
+{
+	/**
+	 * Used for J_DB_TYPE_SINT32 and J_DB_TYPE_SINT64.
+	 **/
+	gint64 val_sint64;
+
+	/**
+	 * Used for J_DB_TYPE_UINT32 and J_DB_TYPE_UINT64.
+	 **/
+	guint64 val_uint64;
+
+	/**
+	 * Used for J_DB_TYPE_FLOAT32 and J_DB_TYPE_FLOAT64.
+	 **/
+	gdouble val_float64;
+
+	gchar* val_string;
+	GBytes* val_blob;
+};
+
+typedef union JMemoryValue JMemoryValue;
+
+struct JMemoryColumn
+{
+	gchar* name;
+	JDBType type;
+
+	/**
+	 * The column's values (JMemoryValue), one per row.
+	 **/
+	GArray* values;
+
+	/**
+	 * Whether a row's value is set (guint8), unset values are NULL.
+	 **/
+	GArray* set;
+};
+
+typedef struct JMemoryColumn JMemoryColumn;
+
+struct JMemorySkipNode
+{
+	guint32 row;
+	struct JMemorySkipNode* next[];
+};
+
+typedef struct JMemorySkipNode JMemorySkipNode;
+
+/**
+ * A skip list of rows ordered by their value (and position for equal values).
+ **/
+struct JMemorySkipList
+{
+	JMemoryColumn* column;
+	JMemorySkipNode* head;
+	guint level;
+	GRand* rand;
+};
+
+typedef struct JMemorySkipList JMemorySkipList;
+
+/**
+ * A key of a hash index, the value is owned by the key.
+ **/
+struct JMemoryKey
+{
+	JDBType type;
+	JMemoryValue value;
+};
+
+typedef struct JMemoryKey JMemoryKey;
+
+struct JMemoryIndex
+{
+	/**
+	 * The indexed column.
+	 **/
+	guint column;
+
+	/**
+	 * Maps values (JMemoryKey) to the rows containing them (GArray of guint32).
+	 **/
+	GHashTable* hash;
+
+	JMemorySkipList* ordered;
+
+	/**
+	 * The number of declared indexes starting with the indexed column.
+	 **/
+	guint declared;
+};
+
+typedef struct JMemoryIndex JMemoryIndex;
+
+struct JMemoryTable
+{
+	JMemoryColumn* columns;
+	guint column_count;
+
+	/**
+	 * Maps column names to column numbers.
+	 **/
+	GHashTable* column_numbers;
+
+	/**
+	 * The rows' IDs (guint32).
+	 **/
+	GArray* ids;
+
+	/**
+	 * Whether a row has been deleted (guint8).
+	 **/
+	GArray* deleted;
+
+	guint32 deleted_count;
+	guint32 next_id;
+
+	GPtrArray* indexes;
+
+	/**
+	 * The number of iterators referring to the table's rows.
+	 **/
+	gint iterators;
+
+	gint ref_count;
+
+	GRWLock lock[1];
+};
+
+typedef struct JMemoryTable JMemoryTable;
+
+struct JMemoryData
+{
+	/**
+	 * Maps namespaces to hash tables, which map names to tables.
+	 **/
+	GHashTable* namespaces;
+
+	/**
+	 * The ID of the first row of new tables.
+	 **/
+	guint32 id_base;
+
+	GRWLock lock[1];
+};
+
+typedef struct JMemoryData JMemoryData;
+
+struct JMemoryBatch
+{
+	gchar* namespace;
+};
+
+typedef struct JMemoryBatch JMemoryBatch;
+
+/**
+ * A compiled selector.
+ * Groups have children and a mode, conditions have a column, an operator and a value.
+ **/
+struct JMemoryCondition
+{
+	GPtrArray* children;
+	JDBSelectorMode mode;
+
+	gint column;
+	JDBType type;
+	JDBSelectorOperator op;
+	JMemoryValue value;
+
+	/**
+	 * The upper bound of BETWEEN conditions.
+	 **/
+	JMemoryValue upper;
+
+	/**
+	 * The sorted values (JMemoryValue) of IN conditions.
+	 **/
+	GArray* values;
+};
+
+typedef struct JMemoryCondition JMemoryCondition;
+
+struct JMemoryOrder
+{
+	gint column;
+	gboolean descending;
+};
+
+typedef struct JMemoryOrder JMemoryOrder;
+
+struct JMemoryAggregate
+{
+	gchar const* alias;
+	JDBSelectorAggregate function;
+	gint column;
+	JDBType type;
+};
+
+typedef struct JMemoryAggregate JMemoryAggregate;
+
+struct JMemoryAccumulator
+{
+	guint64 count;
+	gint64 sum_sint64;
+	guint64 sum_uint64;
+	gdouble sum_float64;
+	JMemoryValue extreme;
+	gboolean extreme_set;
+};
+
+typedef struct JMemoryAccumulator JMemoryAccumulator;
+
+struct JMemoryGroup
+{
+	/**
+	 * The group's first row, its values are used for the grouping columns.
+	 **/
+	guint32 row;
+	gboolean has_row;
+
+	JMemoryAccumulator accumulators[];
+};
+
+typedef struct JMemoryGroup JMemoryGroup;
+
+/**
+ * A finished aggregated row, consisting of the grouping columns followed by the aggregates.
+ **/
+struct JMemoryResult
+{
+	JMemoryValue* values;
+	gboolean* set;
+};
+
+typedef struct JMemoryResult JMemoryResult;
+
+struct JMemoryIterator
+{
+	JMemoryTable* table;
+
+	/**
+	 * The matching rows (guint32), NULL if aggregated results are returned.
+	 **/
+	GArray* rows;
+
+	/**
+	 * The columns to return (gint), the ID is always returned.
+	 **/
+	GArray* columns;
+
+	/**
+	 * The aggregated results (bson_t*).
+	 **/
+	GPtrArray* results;
+
+	guint position;
+};
+
+typedef struct JMemoryIterator JMemoryIterator;
+
+static gint
+memory_value_compare(JDBType type, JMemoryValue const* a, JMemoryValue const* b)
+{
+	switch (type)
+	{
+		case J_DB_TYPE_SINT32:
+		case J_DB_TYPE_SINT64:
+			return (a->val_sint64 > b->val_sint64) - (a->val_sint64 < b->val_sint64);
+		case J_DB_TYPE_UINT32:
+		case J_DB_TYPE_UINT64:
+			return (a->val_uint64 > b->val_uint64) - (a->val_uint64 < b->val_uint64);
+		case J_DB_TYPE_FLOAT32:
+		case J_DB_TYPE_FLOAT64:
+			return (a->val_float64 > b->val_float64) - (a->val_float64 < b->val_float64);
+		case J_DB_TYPE_STRING:
+			return strcmp(a->val_string, b->val_string);
+		case J_DB_TYPE_BLOB:
+			return g_bytes_compare(a->val_blob, b->val_blob);
+		case J_DB_TYPE_ID:
+		default:
+			g_assert_not_reached();
+	}
+
+	return 0;
+}
+
+static void
+memory_value_clear(JDBType type, JMemoryValue* value)
+{
+	if (type == J_DB_TYPE_STRING)
+	{
+		g_free(value->val_string);
+	}
+	else if (type == J_DB_TYPE_BLOB && value->val_blob != NULL)
+	{
+		g_bytes_unref(value->val_blob);
+	}
+
+	memset(value, 0, sizeof(*value));
+}
+
+/**
+ * Reads a value from a BSON iterator, strings and blobs are copied.
+ *
+ * \param[out] set Whether the value is set, NULL blobs are not.
+ **/
+static gboolean
+memory_value_from_iter(bson_iter_t* iter, JDBType type, JMemoryValue* value, gboolean* set, GError** error)
+{
+	JDBTypeValue val;
+
+	memset(value, 0, sizeof(*value));
+	*set = TRUE;
+
+	if (G_UNLIKELY(!j_bson_iter_value(iter, type, &val, error)))
+	{
+		goto _error;
+	}
+
+	switch (type)
+	{
+		case J_DB_TYPE_SINT32:
+			value->val_sint64 = val.val_sint32;
+			break;
+		case J_DB_TYPE_UINT32:
+			value->val_uint64 = val.val_uint32;
+			break;
+		case J_DB_TYPE_SINT64:
+			value->val_sint64 = val.val_sint64;
+			break;
+		case J_DB_TYPE_UINT64:
+			value->val_uint64 = val.val_uint64;
+			break;
+		case J_DB_TYPE_FLOAT32:
+			value->val_float64 = val.val_float32;
+			break;
+		case J_DB_TYPE_FLOAT64:
+			value->val_float64 = val.val_float64;
+			break;
+		case J_DB_TYPE_STRING:
+			value->val_string = g_strdup(val.val_string);
+			break;
+		case J_DB_TYPE_BLOB:
+			if (val.val_blob == NULL)
+			{
+				*set = FALSE;
+			}
+			else
+			{
+				value->val_blob = g_bytes_new(val.val_blob, val.val_blob_length);
+			}
+			break;
+		case J_DB_TYPE_ID:
+		default:
+			g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_DB_TYPE_INVALID, "db type invalid");
+			goto _error;
+	}
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
+/**
+ * Appends a value to a BSON document.
+ * Like the SQL backends, unset numbers are returned as 0 and unset strings and blobs as null.
+ **/
+static gboolean
+memory_value_append(bson_t* bson, gchar const* name, JDBType type, JMemoryValue const* value, gboolean set, GError** error)
+{
+	JDBTypeValue val;
+	gsize length;
+
+	memset(&val, 0, sizeof(val));
+
+	if (set)
+	{
+		switch (type)
+		{
+			case J_DB_TYPE_SINT32:
+				val.val_sint32 = value->val_sint64;
+				break;
+			case J_DB_TYPE_UINT32:
+				val.val_uint32 = value->val_uint64;
+				break;
+			case J_DB_TYPE_SINT64:
+				val.val_sint64 = value->val_sint64;
+				break;
+			case J_DB_TYPE_UINT64:
+				val.val_uint64 = value->val_uint64;
+				break;
+			case J_DB_TYPE_FLOAT32:
+				val.val_float32 = value->val_float64;
+				break;
+			case J_DB_TYPE_FLOAT64:
+				val.val_float64 = value->val_float64;
+				break;
+			case J_DB_TYPE_STRING:
+				val.val_string = value->val_string;
+				break;
+			case J_DB_TYPE_BLOB:
+				val.val_blob = g_bytes_get_data(value->val_blob, &length);
+				val.val_blob_length = length;
+				break;
+			case J_DB_TYPE_ID:
+			default:
+				break;
+		}
+	}
+
+	return j_bson_append_value(bson, name, type, &val, error);
+}
+
+static gdouble
+memory_value_as_double(JDBType type, JMemoryValue const* value)
+{
+	switch (type)
+	{
+		case J_DB_TYPE_SINT32:
+		case J_DB_TYPE_SINT64:
+			return value->val_sint64;
+		case J_DB_TYPE_UINT32:
+		case J_DB_TYPE_UINT64:
+			return value->val_uint64;
+		case J_DB_TYPE_FLOAT32:
+		case J_DB_TYPE_FLOAT64:
+			return value->val_float64;
+		case J_DB_TYPE_STRING:
+		case J_DB_TYPE_BLOB:
+		case J_DB_TYPE_ID:
+		default:
+			return 0.0;
+	}
+}
+
+static JMemoryKey*
+memory_key_new(JDBType type, JMemoryValue const* value)
+{
+	JMemoryKey* key;
+
+	key = g_slice_new(JMemoryKey);
+	key->type = type;
+	key->value = *value;
+
+	if (type == J_DB_TYPE_STRING)
+	{
+		key->value.val_string = g_strdup(value->val_string);
+	}
+	else if (type == J_DB_TYPE_BLOB)
+	{
+		g_bytes_ref(key->value.val_blob);
+	}
+
+	return key;
+}
+
+static void
+memory_key_free(gpointer data)
+{
+	JMemoryKey* key = data;
+
+	memory_value_clear(key->type, &key->value);
+	g_slice_free(JMemoryKey, key);
+}
+
+static guint
+memory_key_hash(gconstpointer data)
+{
+	JMemoryKey const* key = data;
+	gdouble value;
+
+	switch (key->type)
+	{
+		case J_DB_TYPE_SINT32:
+		case J_DB_TYPE_SINT64:
+		case J_DB_TYPE_UINT32:
+		case J_DB_TYPE_UINT64:
+			return g_int64_hash(&key->value.val_sint64);
+		case J_DB_TYPE_FLOAT32:
+		case J_DB_TYPE_FLOAT64:
+			// 0.0 and -0.0 are equal and must have the same hash
+			value = (key->value.val_float64 == 0.0) ? 0.0 : key->value.val_float64;
+			return g_double_hash(&value);
+		case J_DB_TYPE_STRING:
+			return g_str_hash(key->value.val_string);
+		case J_DB_TYPE_BLOB:
+			return g_bytes_hash(key->value.val_blob);
+		case J_DB_TYPE_ID:
+		default:
+			return 0;
+	}
+}
+
+static gboolean
+memory_key_equal(gconstpointer a, gconstpointer b)
+{
+	JMemoryKey const* key_a = a;
+	JMemoryKey const* key_b = b;
+
+	return (memory_value_compare(key_a->type, &key_a->value, &key_b->value) == 0);
+}
+
+static JMemoryValue const*
+memory_skip_list_value(JMemorySkipList* list, guint32 row)
+{
+	return &g_array_index(list->column->values, JMemoryValue, row);
+}
+
+static gint
+memory_skip_list_compare(JMemorySkipList* list, guint32 a, guint32 b)
+{
+	gint cmp;
+
+	cmp = memory_value_compare(list->column->type, memory_skip_list_value(list, a), memory_skip_list_value(list, b));
+
+	if (cmp == 0)
+	{
+		cmp = (a > b) - (a < b);
+	}
+
+	return cmp;
+}
+
+static JMemorySkipList*
+memory_skip_list_new(JMemoryColumn* column)
+{
+	JMemorySkipList* list;
+
+	list = g_slice_new(JMemorySkipList);
+	list->column = column;
+	list->head = g_malloc0(sizeof(JMemorySkipNode) + MEMORY_SKIP_LIST_LEVELS * sizeof(JMemorySkipNode*));
+	list->level = 1;
+	list->rand = g_rand_new();
+
+	return list;
+}
+
+static void
+memory_skip_list_free(JMemorySkipList* list)
+{
+	JMemorySkipNode* node;
+
+	node = list->head;
+
+	while (node != NULL)
+	{
+		JMemorySkipNode* next = node->next[0];
+
+		g_free(node);
+		node = next;
+	}
+
+	g_rand_free(list->rand);
+	g_slice_free(JMemorySkipList, list);
+}
+
+/**
+ * Finds the predecessors of a row on all levels.
+ **/
+static void
+memory_skip_list_find(JMemorySkipList* list, guint32 row, JMemorySkipNode** update)
+{
+	JMemorySkipNode* node = list->head;
+
+	for (guint i = list->level; i-- > 0;)
+	{
+		while (node->next[i] != NULL && memory_skip_list_compare(list, node->next[i]->row, row) < 0)
+		{
+			node = node->next[i];
+		}
+
+		update[i] = node;
+	}
+}
+
+static void
+memory_skip_list_insert(JMemorySkipList* list, guint32 row)
+{
+	JMemorySkipNode* update[MEMORY_SKIP_LIST_LEVELS];
+	JMemorySkipNode* node;
+	guint level = 1;
+
+	memory_skip_list_find(list, row, update);
+
+	while (level < MEMORY_SKIP_LIST_LEVELS && (g_rand_int(list->rand) & 3) == 0)
+	{
+		level++;
+	}
+
+	for (guint i = list->level; i < level; i++)
+	{
+		update[i] = list->head;
+	}
+
+	list->level = MAX(list->level, level);
+
+	node = g_malloc(sizeof(JMemorySkipNode) + level * sizeof(JMemorySkipNode*));
+	node->row = row;
+
+	for (guint i = 0; i < level; i++)
+	{
+		node->next[i] = update[i]->next[i];
+		update[i]->next[i] = node;
+	}
+}
+
+/**
+ * Removes a row, which has to be done before its value is changed.
+ **/
+static void
+memory_skip_list_remove(JMemorySkipList* list, guint32 row)
+{
+	JMemorySkipNode* update[MEMORY_SKIP_LIST_LEVELS];
+	JMemorySkipNode* node;
+
+	memory_skip_list_find(list, row, update);
+	node = update[0]->next[0];
+
+	if (node == NULL || node->row != row)
+	{
+		return;
+	}
+
+	for (guint i = 0; i < list->level && update[i]->next[i] == node; i++)
+	{
+		update[i]->next[i] = node->next[i];
+	}
+
+	g_free(node);
+
+	while (list->level > 1 && list->head->next[list->level - 1] == NULL)
+	{
+		list->level--;
+	}
+}
+
+/**
+ * Returns the first node whose value is greater than (or equal to, if inclusive) the given value.
+ **/
+static JMemorySkipNode*
+memory_skip_list_lower_bound(JMemorySkipList* list, JMemoryValue const* value, gboolean inclusive)
+{
+	JMemorySkipNode* node = list->head;
+
+	for (guint i = list->level; i-- > 0;)
+	{
+		while (node->next[i] != NULL)
+		{
+			gint cmp;
+
+			cmp = memory_value_compare(list->column->type, memory_skip_list_value(list, node->next[i]->row), value);
+
+			if (cmp > 0 || (cmp == 0 && inclusive))
+			{
+				break;
+			}
+
+			node = node->next[i];
+		}
+	}
+
+	return node->next[0];
+}
+
+static gboolean
+memory_table_get_value(JMemoryTable* table, gint column, guint32 row, JMemoryValue* value, JDBType* type)
+{
+	JMemoryColumn* memory_column;
+
+	if (column == MEMORY_COLUMN_ID)
+	{
+		value->val_uint64 = g_array_index(table->ids, guint32, row);
+		*type = J_DB_TYPE_UINT32;
+
+		return TRUE;
+	}
+
+	memory_column = &table->columns[column];
+	*value = g_array_index(memory_column->values, JMemoryValue, row);
+	*type = memory_column->type;
+
+	return g_array_index(memory_column->set, guint8, row);
+}
+
+static gboolean
+memory_table_find_column(JMemoryTable* table, gchar const* name, gboolean allow_id, gint* column, GError** error)
+{
+	gpointer number;
+
+	if (allow_id && g_strcmp0(name, "_id") == 0)
+	{
+		*column = MEMORY_COLUMN_ID;
+
+		return TRUE;
+	}
+
+	if (G_UNLIKELY(!g_hash_table_lookup_extended(table->column_numbers, name, NULL, &number)))
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_VARIABLE_NOT_FOUND, "variable not found");
+
+		return FALSE;
+	}
+
+	*column = GPOINTER_TO_INT(number);
+
+	return TRUE;
+}
+
+static void
+memory_index_insert(JMemoryTable* table, JMemoryIndex* index, guint32 row)
+{
+	JMemoryColumn* column = &table->columns[index->column];
+	JMemoryKey probe;
+	GArray* rows;
+
+	// NULL values never match a condition
+	if (!g_array_index(column->set, guint8, row))
+	{
+		return;
+	}
+
+	probe.type = column->type;
+	probe.value = g_array_index(column->values, JMemoryValue, row);
+
+	if ((rows = g_hash_table_lookup(index->hash, &probe)) == NULL)
+	{
+		rows = g_array_new(FALSE, FALSE, sizeof(guint32));
+		g_hash_table_insert(index->hash, memory_key_new(probe.type, &probe.value), rows);
+	}
+
+	g_array_append_val(rows, row);
+	memory_skip_list_insert(index->ordered, row);
+}
+
+static void
+memory_index_remove(JMemoryTable* table, JMemoryIndex* index, guint32 row)
+{
+	JMemoryColumn* column = &table->columns[index->column];
+	JMemoryKey probe;
+	GArray* rows;
+
+	if (!g_array_index(column->set, guint8, row))
+	{
+		return;
+	}
+
+	probe.type = column->type;
+	probe.value = g_array_index(column->values, JMemoryValue, row);
+
+	if ((rows = g_hash_table_lookup(index->hash, &probe)) != NULL)
+	{
+		for (guint i = 0; i < rows->len; i++)
+		{
+			if (g_array_index(rows, guint32, i) == row)
+			{
+				// Keep the remaining rows in insertion order
+				g_array_remove_index(rows, i);
+				break;
+			}
+		}
+
+		if (rows->len == 0)
+		{
+			g_hash_table_remove(index->hash, &probe);
+		}
+	}
+
+	memory_skip_list_remove(index->ordered, row);
+}
+
+static void
+memory_index_free(gpointer data)
+{
+	JMemoryIndex* index = data;
+
+	g_hash_table_unref(index->hash);
+	memory_skip_list_free(index->ordered);
+	g_slice_free(JMemoryIndex, index);
+}
+
+/**
+ * Adds an index for a column, existing rows are indexed immediately.
+ **/
+static JMemoryIndex*
+memory_table_add_index(JMemoryTable* table, guint column)
+{
+	JMemoryIndex* index;
+
+	index = g_slice_new(JMemoryIndex);
+	index->column = column;
+	index->declared = 1;
+	index->hash = g_hash_table_new_full(memory_key_hash, memory_key_equal, memory_key_free, (GDestroyNotify)g_array_unref);
+	index->ordered = memory_skip_list_new(&table->columns[column]);
+
+	for (guint32 row = 0; row < table->ids->len; row++)
+	{
+		if (!g_array_index(table->deleted, guint8, row))
+		{
+			memory_index_insert(table, index, row);
+		}
+	}
+
+	g_ptr_array_add(table->indexes, index);
+
+	return index;
+}
+
+static JMemoryIndex*
+memory_table_get_index(JMemoryTable* table, gint column)
+{
+	for (guint i = 0; i < table->indexes->len; i++)
+	{
+		JMemoryIndex* index = g_ptr_array_index(table->indexes, i);
+
+		if ((gint)index->column == column)
+		{
+			return index;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * Returns the column used for an index, which is its first field.
+ * All other fields have to exist, too.
+ **/
+static gboolean
+memory_table_find_index_column(JMemoryTable* table, bson_iter_t* iter, gint* column, GError** error)
+{
+	gboolean has_next;
+	gboolean first = TRUE;
+
+	while (TRUE)
+	{
+		JDBTypeValue value;
+		gint field_column;
+
+		if (G_UNLIKELY(!j_bson_iter_next(iter, &has_next, error)))
+		{
+			goto _error;
+		}
+
+		if (!has_next)
+		{
+			break;
+		}
+
+		if (G_UNLIKELY(!j_bson_iter_value(iter, J_DB_TYPE_STRING, &value, error)))
+		{
+			goto _error;
+		}
+
+		if (G_UNLIKELY(!memory_table_find_column(table, value.val_string, FALSE, &field_column, error)))
+		{
+			goto _error;
+		}
+
+		if (first)
+		{
+			*column = field_column;
+			first = FALSE;
+		}
+	}
+
+	if (G_UNLIKELY(first))
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_NO_VARIABLE_SET, "no variable set");
+		goto _error;
+	}
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
+static JMemoryTable*
+memory_table_ref(JMemoryTable* table)
+{
+	g_atomic_int_inc(&table->ref_count);
+
+	return table;
+}
+
+static void
+memory_table_unref(gpointer data)
+{
+	JMemoryTable* table = data;
+
+	if (g_atomic_int_dec_and_test(&table->ref_count))
+	{
+		g_ptr_array_unref(table->indexes);
+
+		for (guint i = 0; i < table->column_count; i++)
+		{
+			JMemoryColumn* column = &table->columns[i];
+
+			for (guint32 row = 0; row < column->values->len; row++)
+			{
+				memory_value_clear(column->type, &g_array_index(column->values, JMemoryValue, row));
+			}
+
+			g_free(column->name);
+			g_array_unref(column->values);
+			g_array_unref(column->set);
+		}
+
+		g_free(table->columns);
+		g_hash_table_unref(table->column_numbers);
+		g_array_unref(table->ids);
+		g_array_unref(table->deleted);
+		g_rw_lock_clear(table->lock);
+		g_slice_free(JMemoryTable, table);
+	}
+}
+
+/**
+ * Creates a table for a schema, including the indexes given in "_index".
+ * Its rows are numbered starting at id_base.
+ **/
+static JMemoryTable*
+memory_table_new(bson_t const* schema, guint32 id_base, GError** error)
+{
+	JMemoryTable* table;
+	bson_iter_t iter;
+	bson_iter_t iter_index;
+	bson_iter_t iter_child;
+	bson_iter_t iter_field;
+	gboolean has_index = FALSE;
+	gboolean has_next;
+	g_autoptr(GArray) columns = NULL;
+
+	columns = g_array_new(FALSE, FALSE, sizeof(JMemoryColumn));
+
+	table = g_slice_new0(JMemoryTable);
+	table->ref_count = 1;
+	table->next_id = id_base;
+	table->column_numbers = g_hash_table_new(g_str_hash, g_str_equal);
+	table->ids = g_array_new(FALSE, FALSE, sizeof(guint32));
+	table->deleted = g_array_new(FALSE, FALSE, sizeof(guint8));
+	table->indexes = g_ptr_array_new_with_free_func(memory_index_free);
+	g_rw_lock_init(table->lock);
+
+	if (G_UNLIKELY(!j_bson_iter_init(&iter, schema, error)))
+	{
+		goto _error;
+	}
+
+	while (TRUE)
+	{
+		JMemoryColumn column;
+		JDBTypeValue value;
+		gchar const* key;
+
+		if (G_UNLIKELY(!j_bson_iter_next(&iter, &has_next, error)))
+		{
+			goto _error;
+		}
+
+		if (!has_next)
+		{
+			break;
+		}
+
+		key = j_bson_iter_key(&iter, error);
+
+		if (g_strcmp0(key, "_index") == 0)
+		{
+			iter_index = iter;
+			has_index = TRUE;
+			continue;
+		}
+
+		if (G_UNLIKELY(!j_bson_iter_value(&iter, J_DB_TYPE_UINT32, &value, error)))
+		{
+			goto _error;
+		}
+
+		switch (value.val_uint32)
+		{
+			case J_DB_TYPE_SINT32:
+			case J_DB_TYPE_UINT32:
+			case J_DB_TYPE_FLOAT32:
+			case J_DB_TYPE_SINT64:
+			case J_DB_TYPE_UINT64:
+			case J_DB_TYPE_FLOAT64:
+			case J_DB_TYPE_STRING:
+			case J_DB_TYPE_BLOB:
+				break;
+			case J_DB_TYPE_ID:
+			default:
+				g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_DB_TYPE_INVALID, "db type invalid");
+				goto _error;
+		}
+
+		column.name = g_strdup(key);
+		column.type = value.val_uint32;
+		column.values = g_array_new(FALSE, FALSE, sizeof(JMemoryValue));
+		column.set = g_array_new(FALSE, FALSE, sizeof(guint8));
+		g_array_append_val(columns, column);
+	}
+
+	if (G_UNLIKELY(columns->len == 0))
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_SCHEMA_EMPTY, "schema empty");
+		goto _error;
+	}
+
+	table->column_count = columns->len;
+	table->columns = (JMemoryColumn*)(gpointer)g_array_free(g_steal_pointer(&columns), FALSE);
+
+	for (guint i = 0; i < table->column_count; i++)
+	{
+		g_hash_table_insert(table->column_numbers, table->columns[i].name, GUINT_TO_POINTER(i));
+	}
+
+	if (has_index)
+	{
+		if (G_UNLIKELY(!j_bson_iter_recurse_array(&iter_index, &iter_child, error)))
+		{
+			goto _error;
+		}
+
+		while (TRUE)
+		{
+			JMemoryIndex* index;
+			gint column;
+
+			if (G_UNLIKELY(!j_bson_iter_next(&iter_child, &has_next, error)))
+			{
+				goto _error;
+			}
+
+			if (!has_next)
+			{
+				break;
+			}
+
+			if (G_UNLIKELY(!j_bson_iter_recurse_array(&iter_child, &iter_field, error)))
+			{
+				goto _error;
+			}
+
+			// Only the first field is indexed, conditions on the other fields are checked per row
+			if (G_UNLIKELY(!memory_table_find_index_column(table, &iter_field, &column, error)))
+			{
+				goto _error;
+			}
+
+			if ((index = memory_table_get_index(table, column)) != NULL)
+			{
+				index->declared++;
+			}
+			else
+			{
+				memory_table_add_index(table, column);
+			}
+		}
+	}
+
+	return table;
+
+_error:
+	if (columns != NULL)
+	{
+		for (guint i = 0; i < columns->len; i++)
+		{
+			JMemoryColumn* column = &g_array_index(columns, JMemoryColumn, i);
+
+			g_free(column->name);
+			g_array_unref(column->values);
+			g_array_unref(column->set);
+		}
+	}
+
+	memory_table_unref(table);
+
+	return NULL;
+}
+
+/**
+ * Removes deleted rows from a table and rebuilds its indexes.
+ * The table's write lock has to be held and no iterator may refer to the table's rows.
+ **/
+static void
+memory_table_compact(JMemoryTable* table)
+{
+	guint32 target = 0;
+
+	for (guint32 row = 0; row < table->ids->len; row++)
+	{
+		if (g_array_index(table->deleted, guint8, row))
+		{
+			continue;
+		}
+
+		if (target != row)
+		{
+			g_array_index(table->ids, guint32, target) = g_array_index(table->ids, guint32, row);
+
+			for (guint i = 0; i < table->column_count; i++)
+			{
+				JMemoryColumn* column = &table->columns[i];
+
+				g_array_index(column->values, JMemoryValue, target) = g_array_index(column->values, JMemoryValue, row);
+				g_array_index(column->set, guint8, target) = g_array_index(column->set, guint8, row);
+			}
+		}
+
+		target++;
+	}
+
+	// Values of deleted rows have already been freed
+	g_array_set_size(table->ids, target);
+	g_array_set_size(table->deleted, target);
+	memset(table->deleted->data, 0, target);
+
+	for (guint i = 0; i < table->column_count; i++)
+	{
+		g_array_set_size(table->columns[i].values, target);
+		g_array_set_size(table->columns[i].set, target);
+	}
+
+	table->deleted_count = 0;
+
+	for (guint i = 0; i < table->indexes->len; i++)
+	{
+		JMemoryIndex* index = g_ptr_array_index(table->indexes, i);
+
+		g_hash_table_remove_all(index->hash);
+		memory_skip_list_free(index->ordered);
+		index->ordered = memory_skip_list_new(&table->columns[index->column]);
+
+		for (guint32 row = 0; row < target; row++)
+		{
+			memory_index_insert(table, index, row);
+		}
+	}
+}
+
+static void
+memory_condition_free(gpointer data)
+{
+	JMemoryCondition* condition = data;
+
+	if (condition->children != NULL)
+	{
+		g_ptr_array_unref(condition->children);
+	}
+	else
+	{
+		memory_value_clear(condition->type, &condition->value);
+		memory_value_clear(condition->type, &condition->upper);
+
+		if (condition->values != NULL)
+		{
+			for (guint i = 0; i < condition->values->len; i++)
+			{
+				memory_value_clear(condition->type, &g_array_index(condition->values, JMemoryValue, i));
+			}
+
+			g_array_unref(condition->values);
+		}
+	}
+
+	g_slice_free(JMemoryCondition, condition);
+}
+
+static gint
+memory_condition_compare_values(gconstpointer a, gconstpointer b, gpointer data)
+{
+	JDBType const* type = data;
+
+	return memory_value_compare(*type, a, b);
+}
+
+/**
+ * Reads the values of an IN condition, which are sorted and deduplicated for binary searches and index lookups.
+ * NULL blobs never match and are dropped.
+ **/
+static gboolean
+memory_condition_parse_values(JMemoryCondition* condition, bson_iter_t* iter, GError** error)
+{
+	bson_iter_t iter_array;
+	gboolean has_next;
+	guint length = 0;
+
+	condition->values = g_array_new(FALSE, FALSE, sizeof(JMemoryValue));
+
+	if (G_UNLIKELY(!j_bson_iter_recurse_array(iter, &iter_array, error)))
+	{
+		goto _error;
+	}
+
+	while (TRUE)
+	{
+		JMemoryValue value;
+		gboolean set;
+
+		if (G_UNLIKELY(!j_bson_iter_next(&iter_array, &has_next, error)))
+		{
+			goto _error;
+		}
+
+		if (!has_next)
+		{
+			break;
+		}
+
+		if (G_UNLIKELY(!memory_value_from_iter(&iter_array, condition->type, &value, &set, error)))
+		{
+			goto _error;
+		}
+
+		if (set)
+		{
+			g_array_append_val(condition->values, value);
+		}
+	}
+
+	g_array_sort_with_data(condition->values, memory_condition_compare_values, &condition->type);
+
+	for (guint i = 0; i < condition->values->len; i++)
+	{
+		JMemoryValue* value = &g_array_index(condition->values, JMemoryValue, i);
+
+		if (length > 0 && memory_value_compare(condition->type, &g_array_index(condition->values, JMemoryValue, length - 1), value) == 0)
+		{
+			memory_value_clear(condition->type, value);
+			continue;
+		}
+
+		g_array_index(condition->values, JMemoryValue, length) = *value;
+		length++;
+	}
+
+	g_array_set_size(condition->values, length);
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
+/**
+ * Compiles a selector's conditions, using the same format as the SQL backends.
+ * Keys starting with an underscore belong to options, documents containing "_mode" are nested selectors.
+ **/
+static JMemoryCondition*
+memory_condition_new(JMemoryTable* table, bson_iter_t* iter, JDBSelectorMode mode, GError** error)
+{
+	JMemoryCondition* condition;
+	gboolean has_next;
+
+	condition = g_slice_new0(JMemoryCondition);
+	condition->children = g_ptr_array_new_with_free_func(memory_condition_free);
+	condition->mode = mode;
+
+	if (G_UNLIKELY(mode != J_DB_SELECTOR_MODE_AND && mode != J_DB_SELECTOR_MODE_OR))
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_OPERATOR_INVALID, "operator invalid");
+		goto _error;
+	}
+
+	while (TRUE)
+	{
+		JMemoryCondition* child;
+		JDBTypeValue value;
+		bson_iter_t iter_child;
+		bson_iter_t iter_field;
+		gboolean set;
+
+		if (G_UNLIKELY(!j_bson_iter_next(iter, &has_next, error)))
+		{
+			goto _error;
+		}
+
+		if (!has_next)
+		{
+			break;
+		}
+
+		if (bson_iter_key(iter)[0] == '_')
+		{
+			continue;
+		}
+
+		if (G_UNLIKELY(!j_bson_iter_recurse_document(iter, &iter_child, error)))
+		{
+			goto _error;
+		}
+
+		iter_field = iter_child;
+
+		if (j_bson_iter_find(&iter_field, "_mode", NULL))
+		{
+			if (G_UNLIKELY(!j_bson_iter_value(&iter_field, J_DB_TYPE_UINT32, &value, error)))
+			{
+				goto _error;
+			}
+
+			if (G_UNLIKELY((child = memory_condition_new(table, &iter_child, value.val_uint32, error)) == NULL))
+			{
+				goto _error;
+			}
+
+			g_ptr_array_add(condition->children, child);
+			continue;
+		}
+
+		child = g_slice_new0(JMemoryCondition);
+		g_ptr_array_add(condition->children, child);
+
+		iter_field = iter_child;
+
+		if (G_UNLIKELY(!j_bson_iter_find(&iter_field, "_name", error)))
+		{
+			goto _error;
+		}
+
+		if (G_UNLIKELY(!j_bson_iter_value(&iter_field, J_DB_TYPE_STRING, &value, error)))
+		{
+			goto _error;
+		}
+
+		if (G_UNLIKELY(!memory_table_find_column(table, value.val_string, TRUE, &child->column, error)))
+		{
+			goto _error;
+		}
+
+		child->type = (child->column == MEMORY_COLUMN_ID) ? J_DB_TYPE_UINT32 : table->columns[child->column].type;
+
+		iter_field = iter_child;
+
+		if (G_UNLIKELY(!j_bson_iter_find(&iter_field, "_operator", error)))
+		{
+			goto _error;
+		}
+
+		if (G_UNLIKELY(!j_bson_iter_value(&iter_field, J_DB_TYPE_UINT32, &value, error)))
+		{
+			goto _error;
+		}
+
+		child->op = value.val_uint32;
+
+		switch (child->op)
+		{
+			case J_DB_SELECTOR_OPERATOR_LT:
+			case J_DB_SELECTOR_OPERATOR_LE:
+			case J_DB_SELECTOR_OPERATOR_GT:
+			case J_DB_SELECTOR_OPERATOR_GE:
+			case J_DB_SELECTOR_OPERATOR_EQ:
+			case J_DB_SELECTOR_OPERATOR_NE:
+			case J_DB_SELECTOR_OPERATOR_IN:
+			case J_DB_SELECTOR_OPERATOR_BETWEEN:
+				break;
+			case J_DB_SELECTOR_OPERATOR_PREFIX:
+				if (G_UNLIKELY(child->type != J_DB_TYPE_STRING))
+				{
+					g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_DB_TYPE_INVALID, "db type invalid");
+					goto _error;
+				}
+				break;
+			default:
+				g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_COMPARATOR_INVALID, "comparator invalid");
+				goto _error;
+		}
+
+		iter_field = iter_child;
+
+		if (G_UNLIKELY(!j_bson_iter_find(&iter_field, "_value", error)))
+		{
+			goto _error;
+		}
+
+		if (child->op == J_DB_SELECTOR_OPERATOR_IN)
+		{
+			if (G_UNLIKELY(!memory_condition_parse_values(child, &iter_field, error)))
+			{
+				goto _error;
+			}
+
+			continue;
+		}
+
+		if (G_UNLIKELY(!memory_value_from_iter(&iter_field, child->type, &child->value, &set, error)))
+		{
+			goto _error;
+		}
+
+		if (G_UNLIKELY(!set))
+		{
+			g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_NO_VARIABLE_SET, "no variable set");
+			goto _error;
+		}
+
+		if (child->op == J_DB_SELECTOR_OPERATOR_BETWEEN)
+		{
+			iter_field = iter_child;
+
+			if (G_UNLIKELY(!j_bson_iter_find(&iter_field, "_upper", error)))
+			{
+				goto _error;
+			}
+
+			if (G_UNLIKELY(!memory_value_from_iter(&iter_field, child->type, &child->upper, &set, error)))
+			{
+				goto _error;
+			}
+
+			if (G_UNLIKELY(!set))
+			{
+				g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_NO_VARIABLE_SET, "no variable set");
+				goto _error;
+			}
+		}
+	}
+
+	if (G_UNLIKELY(condition->children->len == 0))
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_SELECTOR_EMPTY, "selector empty");
+		goto _error;
+	}
+
+	return condition;
+
+_error:
+	memory_condition_free(condition);
+
+	return NULL;
+}
+
+/**
+ * Compiles a selector, a selector without conditions is returned as NULL and matches all rows.
+ **/
+static gboolean
+memory_condition_compile(JMemoryTable* table, bson_t const* selector, JMemoryCondition** condition, GError** error)
+{
+	JDBSelectorMode mode = J_DB_SELECTOR_MODE_AND;
+	JDBTypeValue value;
+	bson_iter_t iter;
+	gboolean has_conditions = FALSE;
+
+	*condition = NULL;
+
+	if (selector == NULL || !j_bson_iter_init(&iter, selector, NULL))
+	{
+		return TRUE;
+	}
+
+	while (bson_iter_next(&iter))
+	{
+		if (bson_iter_key(&iter)[0] != '_')
+		{
+			has_conditions = TRUE;
+			break;
+		}
+	}
+
+	if (!has_conditions)
+	{
+		return TRUE;
+	}
+
+	if (j_bson_iter_init(&iter, selector, NULL) && j_bson_iter_find(&iter, "_mode", NULL))
+	{
+		if (G_UNLIKELY(!j_bson_iter_value(&iter, J_DB_TYPE_UINT32, &value, error)))
+		{
+			return FALSE;
+		}
+
+		mode = value.val_uint32;
+	}
+
+	if (G_UNLIKELY(!j_bson_iter_init(&iter, selector, error)))
+	{
+		return FALSE;
+	}
+
+	*condition = memory_condition_new(table, &iter, mode, error);
+
+	return (*condition != NULL);
+}
+
+static gboolean
+memory_condition_matches(JMemoryTable* table, JMemoryCondition const* condition, guint32 row)
+{
+	JMemoryValue value;
+	JDBType type;
+	gint cmp;
+
+	if (condition->children != NULL)
+	{
+		for (guint i = 0; i < condition->children->len; i++)
+		{
+			gboolean matches;
+
+			matches = memory_condition_matches(table, g_ptr_array_index(condition->children, i), row);
+
+			if (condition->mode == J_DB_SELECTOR_MODE_AND && !matches)
+			{
+				return FALSE;
+			}
+
+			if (condition->mode == J_DB_SELECTOR_MODE_OR && matches)
+			{
+				return TRUE;
+			}
+		}
+
+		return (condition->mode == J_DB_SELECTOR_MODE_AND);
+	}
+
+	// Like in SQL, comparisons with NULL are never true
+	if (!memory_table_get_value(table, condition->column, row, &value, &type))
+	{
+		return FALSE;
+	}
+
+	if (condition->op == J_DB_SELECTOR_OPERATOR_IN)
+	{
+		guint lower = 0;
+		guint upper = condition->values->len;
+
+		while (lower < upper)
+		{
+			guint middle = lower + (upper - lower) / 2;
+
+			cmp = memory_value_compare(type, &value, &g_array_index(condition->values, JMemoryValue, middle));
+
+			if (cmp == 0)
+			{
+				return TRUE;
+			}
+			else if (cmp < 0)
+			{
+				upper = middle;
+			}
+			else
+			{
+				lower = middle + 1;
+			}
+		}
+
+		return FALSE;
+	}
+
+	if (condition->op == J_DB_SELECTOR_OPERATOR_PREFIX)
+	{
+		return g_str_has_prefix(value.val_string, condition->value.val_string);
+	}
+
+	cmp = memory_value_compare(type, &value, &condition->value);
+
+	switch (condition->op)
+	{
+		case J_DB_SELECTOR_OPERATOR_LT:
+			return (cmp < 0);
+		case J_DB_SELECTOR_OPERATOR_LE:
+			return (cmp <= 0);
+		case J_DB_SELECTOR_OPERATOR_GT:
+			return (cmp > 0);
+		case J_DB_SELECTOR_OPERATOR_GE:
+			return (cmp >= 0);
+		case J_DB_SELECTOR_OPERATOR_EQ:
+			return (cmp == 0);
+		case J_DB_SELECTOR_OPERATOR_NE:
+			return (cmp != 0);
+		case J_DB_SELECTOR_OPERATOR_BETWEEN:
+			return (cmp >= 0 && memory_value_compare(type, &value, &condition->upper) <= 0);
+		default:
+			return FALSE;
+	}
+}
+
+/**
+ * Collects candidate rows using an index.
+ * This is only possible if all of the top-level conditions have to be true and one of them refers to an indexed column.
+ * Equality and IN conditions use the hash index, range and prefix conditions use the skip list.
+ *
+ * \return FALSE if no index could be used.
+ **/
+static gboolean
+memory_table_select_indexed(JMemoryTable* table, JMemoryCondition const* condition, GArray* candidates)
+{
+	JMemoryIndex* index = NULL;
+	JMemoryValue const* lower = NULL;
+	JMemoryValue const* upper = NULL;
+	gboolean lower_inclusive = FALSE;
+	gboolean upper_inclusive = FALSE;
+	gchar const* prefix = NULL;
+	JMemorySkipNode* node;
+
+	if (condition->mode != J_DB_SELECTOR_MODE_AND && condition->children->len > 1)
+	{
+		return FALSE;
+	}
+
+	for (guint i = 0; i < condition->children->len; i++)
+	{
+		JMemoryCondition const* child = g_ptr_array_index(condition->children, i);
+		JMemoryIndex* child_index;
+
+		if (child->children != NULL || child->column == MEMORY_COLUMN_ID || (child_index = memory_table_get_index(table, child->column)) == NULL)
+		{
+			continue;
+		}
+
+		if (child->op == J_DB_SELECTOR_OPERATOR_EQ || child->op == J_DB_SELECTOR_OPERATOR_IN)
+		{
+			guint count;
+
+			count = (child->op == J_DB_SELECTOR_OPERATOR_EQ) ? 1 : child->values->len;
+
+			// The values of IN conditions are unique, so no row is returned twice
+			for (guint j = 0; j < count; j++)
+			{
+				GArray* rows;
+				JMemoryKey probe;
+
+				probe.type = child->type;
+				probe.value = (child->op == J_DB_SELECTOR_OPERATOR_EQ) ? child->value : g_array_index(child->values, JMemoryValue, j);
+
+				if ((rows = g_hash_table_lookup(child_index->hash, &probe)) != NULL)
+				{
+					g_array_append_vals(candidates, rows->data, rows->len);
+				}
+			}
+
+			return TRUE;
+		}
+
+		// Use the first indexed column that has range conditions, combining its lower and upper bound
+		if (index != NULL && index != child_index)
+		{
+			continue;
+		}
+
+		switch (child->op)
+		{
+			case J_DB_SELECTOR_OPERATOR_GT:
+			case J_DB_SELECTOR_OPERATOR_GE:
+				if (lower == NULL)
+				{
+					index = child_index;
+					lower = &child->value;
+					lower_inclusive = (child->op == J_DB_SELECTOR_OPERATOR_GE);
+				}
+				break;
+			case J_DB_SELECTOR_OPERATOR_LT:
+			case J_DB_SELECTOR_OPERATOR_LE:
+				if (upper == NULL)
+				{
+					index = child_index;
+					upper = &child->value;
+					upper_inclusive = (child->op == J_DB_SELECTOR_OPERATOR_LE);
+				}
+				break;
+			case J_DB_SELECTOR_OPERATOR_BETWEEN:
+				if (lower == NULL && upper == NULL)
+				{
+					index = child_index;
+					lower = &child->value;
+					lower_inclusive = TRUE;
+					upper = &child->upper;
+					upper_inclusive = TRUE;
+				}
+				break;
+			case J_DB_SELECTOR_OPERATOR_PREFIX:
+				// All strings starting with the prefix follow the prefix itself
+				if (lower == NULL)
+				{
+					index = child_index;
+					lower = &child->value;
+					lower_inclusive = TRUE;
+					prefix = child->value.val_string;
+				}
+				break;
+			case J_DB_SELECTOR_OPERATOR_EQ:
+			case J_DB_SELECTOR_OPERATOR_NE:
+			case J_DB_SELECTOR_OPERATOR_IN:
+			default:
+				break;
+		}
+	}
+
+	if (index == NULL)
+	{
+		return FALSE;
+	}
+
+	if (lower != NULL)
+	{
+		node = memory_skip_list_lower_bound(index->ordered, lower, lower_inclusive);
+	}
+	else
+	{
+		node = index->ordered->head->next[0];
+	}
+
+	for (; node != NULL; node = node->next[0])
+	{
+		JMemoryValue const* value;
+
+		value = memory_skip_list_value(index->ordered, node->row);
+
+		if (upper != NULL)
+		{
+			gint cmp;
+
+			cmp = memory_value_compare(index->ordered->column->type, value, upper);
+
+			if (cmp > 0 || (cmp == 0 && !upper_inclusive))
+			{
+				break;
+			}
+		}
+
+		if (prefix != NULL && !g_str_has_prefix(value->val_string, prefix))
+		{
+			break;
+		}
+
+		g_array_append_val(candidates, node->row);
+	}
+
+	return TRUE;
+}
+
+/**
+ * Returns the live rows matching a condition.
+ * The table has to be locked.
+ **/
+static GArray*
+memory_table_select(JMemoryTable* table, JMemoryCondition const* condition)
+{
+	GArray* rows;
+	g_autoptr(GArray) candidates = NULL;
+
+	rows = g_array_new(FALSE, FALSE, sizeof(guint32));
+
+	if (condition != NULL)
+	{
+		candidates = g_array_new(FALSE, FALSE, sizeof(guint32));
+
+		if (memory_table_select_indexed(table, condition, candidates))
+		{
+			for (guint i = 0; i < candidates->len; i++)
+			{
+				guint32 row = g_array_index(candidates, guint32, i);
+
+				// Candidates only satisfy one condition, check the remaining ones
+				if (!g_array_index(table->deleted, guint8, row) && memory_condition_matches(table, condition, row))
+				{
+					g_array_append_val(rows, row);
+				}
+			}
+
+			return rows;
+		}
+	}
+
+	for (guint32 row = 0; row < table->ids->len; row++)
+	{
+		if (!g_array_index(table->deleted, guint8, row) && (condition == NULL || memory_condition_matches(table, condition, row)))
+		{
+			g_array_append_val(rows, row);
+		}
+	}
+
+	return rows;
+}
+
+/**
+ * Reads the values to set from an entry.
+ *
+ * \param[out] values An array of (column, value, set) per field, the values are owned by the caller.
+ **/
+static gboolean
+memory_table_parse_entry(JMemoryTable* table, bson_t const* metadata, GArray* columns, GArray* values, GArray* set, GError** error)
+{
+	bson_iter_t iter;
+	gboolean has_next;
+
+	if (G_UNLIKELY(!j_bson_iter_init(&iter, metadata, error)))
+	{
+		goto _error;
+	}
+
+	while (TRUE)
+	{
+		JMemoryValue value;
+		gboolean value_set;
+		gint column;
+
+		if (G_UNLIKELY(!j_bson_iter_next(&iter, &has_next, error)))
+		{
+			goto _error;
+		}
+
+		if (!has_next)
+		{
+			break;
+		}
+
+		if (G_UNLIKELY(!memory_table_find_column(table, bson_iter_key(&iter), FALSE, &column, error)))
+		{
+			goto _error;
+		}
+
+		if (G_UNLIKELY(!memory_value_from_iter(&iter, table->columns[column].type, &value, &value_set, error)))
+		{
+			goto _error;
+		}
+
+		g_array_append_val(columns, column);
+		g_array_append_val(values, value);
+		g_array_append_val(set, value_set);
+	}
+
+	if (G_UNLIKELY(columns->len == 0))
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_NO_VARIABLE_SET, "no variable set");
+		goto _error;
+	}
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
+static void
+memory_table_clear_entry(JMemoryTable* table, GArray* columns, GArray* values)
+{
+	for (guint i = 0; i < values->len; i++)
+	{
+		gint column = g_array_index(columns, gint, i);
+
+		memory_value_clear(table->columns[column].type, &g_array_index(values, JMemoryValue, i));
+	}
+}
+
+static JMemoryTable*
+memory_table_lookup(JMemoryData* bd, gchar const* namespace, gchar const* name, GError** error)
+{
+	JMemoryTable* table = NULL;
+	GHashTable* tables;
+
+	g_rw_lock_reader_lock(bd->lock);
+
+	if ((tables = g_hash_table_lookup(bd->namespaces, namespace)) != NULL && (table = g_hash_table_lookup(tables, name)) != NULL)
+	{
+		memory_table_ref(table);
+	}
+
+	g_rw_lock_reader_unlock(bd->lock);
+
+	if (table == NULL)
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_SCHEMA_NOT_FOUND, "schema not found");
+	}
+
+	return table;
+}
+
+static void
+memory_iterator_free(JMemoryIterator* iterator)
+{
+	g_atomic_int_add(&iterator->table->iterators, -1);
+	memory_table_unref(iterator->table);
+
+	if (iterator->rows != NULL)
+	{
+		g_array_unref(iterator->rows);
+	}
+
+	if (iterator->columns != NULL)
+	{
+		g_array_unref(iterator->columns);
+	}
+
+	if (iterator->results != NULL)
+	{
+		g_ptr_array_unref(iterator->results);
+	}
+
+	g_slice_free(JMemoryIterator, iterator);
+}
+
+/**
+ * Parses a selector's order into columns.
+ *
+ * \param names The names that can be ordered by, NULL to use the table's columns.
+ **/
+static gboolean
+memory_query_parse_order(JMemoryTable* table, bson_t const* selector, GPtrArray* names, GArray* order, GError** error)
+{
+	bson_iter_t iter;
+	bson_iter_t iter_child;
+	gboolean has_next;
+
+	if (selector == NULL || !j_bson_iter_init(&iter, selector, NULL) || !j_bson_iter_find(&iter, "_order", NULL))
+	{
+		return TRUE;
+	}
+
+	if (G_UNLIKELY(!j_bson_iter_recurse_document(&iter, &iter_child, error)))
+	{
+		goto _error;
+	}
+
+	while (TRUE)
+	{
+		JMemoryOrder memory_order;
+		JDBTypeValue value;
+		bson_iter_t iter_order;
+		gchar const* name;
+
+		if (G_UNLIKELY(!j_bson_iter_next(&iter_child, &has_next, error)))
+		{
+			goto _error;
+		}
+
+		if (!has_next)
+		{
+			break;
+		}
+
+		if (G_UNLIKELY(!j_bson_iter_recurse_document(&iter_child, &iter_order, error)))
+		{
+			goto _error;
+		}
+
+		if (G_UNLIKELY(!j_bson_iter_find(&iter_order, "_name", error)))
+		{
+			goto _error;
+		}
+
+		if (G_UNLIKELY(!j_bson_iter_value(&iter_order, J_DB_TYPE_STRING, &value, error)))
+		{
+			goto _error;
+		}
+
+		name = value.val_string;
+
+		if (names == NULL)
+		{
+			if (G_UNLIKELY(!memory_table_find_column(table, name, TRUE, &memory_order.column, error)))
+			{
+				goto _error;
+			}
+		}
+		else
+		{
+			memory_order.column = -1;
+
+			for (guint i = 0; i < names->len; i++)
+			{
+				if (g_strcmp0(g_ptr_array_index(names, i), name) == 0)
+				{
+					memory_order.column = i;
+					break;
+				}
+			}
+
+			if (G_UNLIKELY(memory_order.column < 0))
+			{
+				g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_VARIABLE_NOT_FOUND, "variable not found");
+				goto _error;
+			}
+		}
+
+		if (G_UNLIKELY(!j_bson_iter_recurse_document(&iter_child, &iter_order, error)))
+		{
+			goto _error;
+		}
+
+		if (G_UNLIKELY(!j_bson_iter_find(&iter_order, "_order", error)))
+		{
+			goto _error;
+		}
+
+		if (G_UNLIKELY(!j_bson_iter_value(&iter_order, J_DB_TYPE_UINT32, &value, error)))
+		{
+			goto _error;
+		}
+
+		memory_order.descending = (value.val_uint32 == J_DB_SELECTOR_ORDER_DESCENDING);
+		g_array_append_val(order, memory_order);
+	}
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
+/**
+ * Compares two values for sorting, NULL values come first like in SQLite.
+ **/
+static gint
+memory_query_compare_values(JDBType type, JMemoryValue const* a, gboolean a_set, JMemoryValue const* b, gboolean b_set)
+{
+	if (!a_set || !b_set)
+	{
+		return (a_set - b_set);
+	}
+
+	return memory_value_compare(type, a, b);
+}
+
+struct JMemoryRowOrder
+{
+	JMemoryTable* table;
+	GArray* order;
+};
+
+typedef struct JMemoryRowOrder JMemoryRowOrder;
+
+static gint
+memory_query_compare_rows(gconstpointer a, gconstpointer b, gpointer data)
+{
+	JMemoryRowOrder* row_order = data;
+	guint32 row_a = *(guint32 const*)a;
+	guint32 row_b = *(guint32 const*)b;
+
+	for (guint i = 0; i < row_order->order->len; i++)
+	{
+		JMemoryOrder* order = &g_array_index(row_order->order, JMemoryOrder, i);
+		JMemoryValue value_a;
+		JMemoryValue value_b;
+		JDBType type;
+		gboolean set_a;
+		gboolean set_b;
+		gint cmp;
+
+		set_a = memory_table_get_value(row_order->table, order->column, row_a, &value_a, &type);
+		set_b = memory_table_get_value(row_order->table, order->column, row_b, &value_b, &type);
+		cmp = memory_query_compare_values(type, &value_a, set_a, &value_b, set_b);
+
+		if (cmp != 0)
+		{
+			return (order->descending) ? -cmp : cmp;
+		}
+	}
+
+	return 0;
+}
+
+struct JMemoryResultOrder
+{
+	GArray* order;
+	GArray* types;
+};
+
+typedef struct JMemoryResultOrder JMemoryResultOrder;
+
+static gint
+memory_query_compare_results(gconstpointer a, gconstpointer b, gpointer data)
+{
+	JMemoryResultOrder* result_order = data;
+	JMemoryResult const* result_a = *(JMemoryResult const* const*)a;
+	JMemoryResult const* result_b = *(JMemoryResult const* const*)b;
+
+	for (guint i = 0; i < result_order->order->len; i++)
+	{
+		JMemoryOrder* order = &g_array_index(result_order->order, JMemoryOrder, i);
+		JDBType type = g_array_index(result_order->types, JDBType, order->column);
+		gint cmp;
+
+		cmp = memory_query_compare_values(type, &result_a->values[order->column], result_a->set[order->column], &result_b->values[order->column], result_b->set[order->column]);
+
+		if (cmp != 0)
+		{
+			return (order->descending) ? -cmp : cmp;
+		}
+	}
+
+	return 0;
+}
+
+static void
+memory_result_free(gpointer data)
+{
+	JMemoryResult* result = data;
+
+	g_free(result->values);
+	g_free(result->set);
+	g_slice_free(JMemoryResult, result);
+}
+
+/**
+ * Appends a row's value to a group key, NULL values form their own group.
+ **/
+static void
+memory_group_key_append(GString* key, JDBType type, JMemoryValue const* value, gboolean set)
+{
+	gconstpointer data;
+	gsize length;
+	guint64 length64;
+
+	g_string_append_c(key, set);
+
+	if (!set)
+	{
+		return;
+	}
+
+	switch (type)
+	{
+		case J_DB_TYPE_STRING:
+			g_string_append_len(key, value->val_string, strlen(value->val_string) + 1);
+			break;
+		case J_DB_TYPE_BLOB:
+			data = g_bytes_get_data(value->val_blob, &length);
+			length64 = length;
+			g_string_append_len(key, (gchar const*)&length64, sizeof(length64));
+			g_string_append_len(key, data, length);
+			break;
+		case J_DB_TYPE_SINT32:
+		case J_DB_TYPE_UINT32:
+		case J_DB_TYPE_FLOAT32:
+		case J_DB_TYPE_SINT64:
+		case J_DB_TYPE_UINT64:
+		case J_DB_TYPE_FLOAT64:
+		case J_DB_TYPE_ID:
+		default:
+			g_string_append_len(key, (gchar const*)value, sizeof(*value));
+			break;
+	}
+}
+
+static void
+memory_group_key_free(gpointer data)
+{
+	g_string_free(data, TRUE);
+}
+
+static void
+memory_accumulator_add(JMemoryAccumulator* accumulator, JMemoryAggregate const* aggregate, JDBType type, JMemoryValue const* value, gboolean set)
+{
+	if (aggregate->column == MEMORY_COLUMN_ID)
+	{
+		// COUNT(*) counts all rows
+		accumulator->count++;
+		return;
+	}
+
+	// Aggregates ignore NULL values
+	if (!set)
+	{
+		return;
+	}
+
+	accumulator->count++;
+
+	switch (aggregate->function)
+	{
+		case J_DB_SELECTOR_AGGREGATE_SUM:
+			if (aggregate->type == J_DB_TYPE_FLOAT64)
+			{
+				accumulator->sum_float64 += memory_value_as_double(type, value);
+			}
+			else if (aggregate->type == J_DB_TYPE_UINT64)
+			{
+				accumulator->sum_uint64 += value->val_uint64;
+			}
+			else
+			{
+				accumulator->sum_sint64 += (type == J_DB_TYPE_SINT32 || type == J_DB_TYPE_SINT64) ? value->val_sint64 : (gint64)value->val_uint64;
+			}
+			break;
+		case J_DB_SELECTOR_AGGREGATE_MIN:
+			if (!accumulator->extreme_set || memory_value_compare(type, value, &accumulator->extreme) < 0)
+			{
+				accumulator->extreme = *value;
+				accumulator->extreme_set = TRUE;
+			}
+			break;
+		case J_DB_SELECTOR_AGGREGATE_MAX:
+			if (!accumulator->extreme_set || memory_value_compare(type, value, &accumulator->extreme) > 0)
+			{
+				accumulator->extreme = *value;
+				accumulator->extreme_set = TRUE;
+			}
+			break;
+		case J_DB_SELECTOR_AGGREGATE_AVG:
+			accumulator->sum_float64 += memory_value_as_double(type, value);
+			break;
+		case J_DB_SELECTOR_AGGREGATE_COUNT:
+		default:
+			break;
+	}
+}
+
+/**
+ * Stores an aggregate's final value, aggregates over no values are NULL except for COUNT.
+ **/
+static void
+memory_accumulator_finish(JMemoryAccumulator const* accumulator, JMemoryAggregate const* aggregate, JMemoryValue* value, gboolean* set)
+{
+	memset(value, 0, sizeof(*value));
+	*set = (accumulator->count > 0);
 
-struct JMemoryData
+	switch (aggregate->function)
+	{
+		case J_DB_SELECTOR_AGGREGATE_COUNT:
+			value->val_uint64 = accumulator->count;
+			*set = TRUE;
+			break;
+		case J_DB_SELECTOR_AGGREGATE_SUM:
+			if (aggregate->type == J_DB_TYPE_FLOAT64)
+			{
+				value->val_float64 = accumulator->sum_float64;
+			}
+			else if (aggregate->type == J_DB_TYPE_UINT64)
+			{
+				value->val_uint64 = accumulator->sum_uint64;
+			}
+			else
+			{
+				value->val_sint64 = accumulator->sum_sint64;
+			}
+			break;
+		case J_DB_SELECTOR_AGGREGATE_MIN:
+		case J_DB_SELECTOR_AGGREGATE_MAX:
+			*value = accumulator->extreme;
+			*set = accumulator->extreme_set;
+			break;
+		case J_DB_SELECTOR_AGGREGATE_AVG:
+			value->val_float64 = (accumulator->count > 0) ? accumulator->sum_float64 / accumulator->count : 0.0;
+			break;
+		default:
+			*set = FALSE;
+			break;
+	}
+}
+
+/**
+ * Groups and aggregates the matching rows, the results are appended to results as BSON documents.
+ * The table has to be locked, values are only copied when creating the documents.
+ **/
+static gboolean
+memory_query_aggregate(JMemoryTable* table, bson_t const* selector, GArray* rows, guint64 offset, guint64 limit, GPtrArray* results, GError** error)
 {
-	bson_t* schema_cache;
-	bson_t* entry_cache;
-	guint32 entry_counter;
+	bson_iter_t iter;
+	bson_iter_t iter_child;
+	gboolean has_next;
+	JMemoryResultOrder result_order;
+	g_autoptr(GArray) group_columns = NULL;
+	g_autoptr(GArray) aggregates = NULL;
+	g_autoptr(GArray) order = NULL;
+	g_autoptr(GArray) types = NULL;
+	g_autoptr(GPtrArray) names = NULL;
+	g_autoptr(GPtrArray) groups = NULL;
+	g_autoptr(GPtrArray) finished = NULL;
+	g_autoptr(GHashTable) group_keys = NULL;
+	g_autoptr(GString) key = NULL;
+
+	group_columns = g_array_new(FALSE, FALSE, sizeof(gint));
+	aggregates = g_array_new(FALSE, FALSE, sizeof(JMemoryAggregate));
+	order = g_array_new(FALSE, FALSE, sizeof(JMemoryOrder));
+	types = g_array_new(FALSE, FALSE, sizeof(JDBType));
+	names = g_ptr_array_new();
+	groups = g_ptr_array_new_with_free_func(g_free);
+	finished = g_ptr_array_new_with_free_func(memory_result_free);
+	group_keys = g_hash_table_new_full((GHashFunc)g_string_hash, (GEqualFunc)g_string_equal, memory_group_key_free, NULL);
+	key = g_string_new(NULL);
+
+	if (j_bson_iter_init(&iter, selector, NULL) && j_bson_iter_find(&iter, "_group", NULL))
+	{
+		if (G_UNLIKELY(!j_bson_iter_recurse_document(&iter, &iter_child, error)))
+		{
+			goto _error;
+		}
+
+		while (TRUE)
+		{
+			JDBTypeValue value;
+			gint column;
+
+			if (G_UNLIKELY(!j_bson_iter_next(&iter_child, &has_next, error)))
+			{
+				goto _error;
+			}
+
+			if (!has_next)
+			{
+				break;
+			}
+
+			if (G_UNLIKELY(!j_bson_iter_value(&iter_child, J_DB_TYPE_STRING, &value, error)))
+			{
+				goto _error;
+			}
+
+			if (G_UNLIKELY(!memory_table_find_column(table, value.val_string, FALSE, &column, error)))
+			{
+				goto _error;
+			}
+
+			g_array_append_val(group_columns, column);
+			g_array_append_val(types, table->columns[column].type);
+			g_ptr_array_add(names, table->columns[column].name);
+		}
+	}
 
-	GMutex lock[1];
-};
+	if (j_bson_iter_init(&iter, selector, NULL) && j_bson_iter_find(&iter, "_aggregate", NULL))
+	{
+		if (G_UNLIKELY(!j_bson_iter_recurse_document(&iter, &iter_child, error)))
+		{
+			goto _error;
+		}
+
+		while (TRUE)
+		{
+			JMemoryAggregate aggregate;
+			JDBTypeValue value;
+			bson_iter_t iter_aggregate;
+
+			if (G_UNLIKELY(!j_bson_iter_next(&iter_child, &has_next, error)))
+			{
+				goto _error;
+			}
+
+			if (!has_next)
+			{
+				break;
+			}
+
+			if (G_UNLIKELY(!j_bson_iter_recurse_document(&iter_child, &iter_aggregate, error)) || G_UNLIKELY(!j_bson_iter_find(&iter_aggregate, "_name", error)) || G_UNLIKELY(!j_bson_iter_value(&iter_aggregate, J_DB_TYPE_STRING, &value, error)))
+			{
+				goto _error;
+			}
+
+			aggregate.alias = value.val_string;
+
+			if (G_UNLIKELY(!j_bson_iter_recurse_document(&iter_child, &iter_aggregate, error)) || G_UNLIKELY(!j_bson_iter_find(&iter_aggregate, "_function", error)) || G_UNLIKELY(!j_bson_iter_value(&iter_aggregate, J_DB_TYPE_UINT32, &value, error)))
+			{
+				goto _error;
+			}
+
+			aggregate.function = value.val_uint32;
+
+			switch (aggregate.function)
+			{
+				case J_DB_SELECTOR_AGGREGATE_COUNT:
+				case J_DB_SELECTOR_AGGREGATE_SUM:
+				case J_DB_SELECTOR_AGGREGATE_MIN:
+				case J_DB_SELECTOR_AGGREGATE_MAX:
+				case J_DB_SELECTOR_AGGREGATE_AVG:
+					break;
+				default:
+					g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_OPERATOR_INVALID, "operator invalid");
+					goto _error;
+			}
+
+			// Without a field, the aggregate is COUNT(*)
+			aggregate.column = MEMORY_COLUMN_ID;
+
+			if (G_UNLIKELY(!j_bson_iter_recurse_document(&iter_child, &iter_aggregate, error)))
+			{
+				goto _error;
+			}
+
+			if (j_bson_iter_find(&iter_aggregate, "_field", NULL))
+			{
+				if (G_UNLIKELY(!j_bson_iter_value(&iter_aggregate, J_DB_TYPE_STRING, &value, error)))
+				{
+					goto _error;
+				}
+
+				if (G_UNLIKELY(!memory_table_find_column(table, value.val_string, FALSE, &aggregate.column, error)))
+				{
+					goto _error;
+				}
+			}
+
+			if (G_UNLIKELY(!j_bson_iter_recurse_document(&iter_child, &iter_aggregate, error)) || G_UNLIKELY(!j_bson_iter_find(&iter_aggregate, "_type", error)) || G_UNLIKELY(!j_bson_iter_value(&iter_aggregate, J_DB_TYPE_UINT32, &value, error)))
+			{
+				goto _error;
+			}
+
+			aggregate.type = value.val_uint32;
+
+			g_array_append_val(aggregates, aggregate);
+			g_array_append_val(types, aggregate.type);
+			g_ptr_array_add(names, (gpointer)aggregate.alias);
+		}
+	}
 
-typedef struct JMemoryData JMemoryData;
+	if (G_UNLIKELY(!memory_query_parse_order(table, selector, names, order, error)))
+	{
+		goto _error;
+	}
+
+	for (guint i = 0; i < rows->len; i++)
+	{
+		guint32 row = g_array_index(rows, guint32, i);
+		JMemoryGroup* group;
+
+		g_string_truncate(key, 0);
+
+		for (guint j = 0; j < group_columns->len; j++)
+		{
+			JMemoryValue value;
+			JDBType type;
+			gboolean set;
+
+			set = memory_table_get_value(table, g_array_index(group_columns, gint, j), row, &value, &type);
+			memory_group_key_append(key, type, &value, set);
+		}
+
+		if ((group = g_hash_table_lookup(group_keys, key)) == NULL)
+		{
+			group = g_malloc0(sizeof(JMemoryGroup) + aggregates->len * sizeof(JMemoryAccumulator));
+			group->row = row;
+			group->has_row = TRUE;
+			g_ptr_array_add(groups, group);
+			g_hash_table_insert(group_keys, g_string_new_len(key->str, key->len), group);
+		}
+
+		for (guint j = 0; j < aggregates->len; j++)
+		{
+			JMemoryAggregate* aggregate = &g_array_index(aggregates, JMemoryAggregate, j);
+			JMemoryValue value = { 0 };
+			JDBType type = J_DB_TYPE_UINT32;
+			gboolean set = FALSE;
+
+			if (aggregate->column != MEMORY_COLUMN_ID)
+			{
+				set = memory_table_get_value(table, aggregate->column, row, &value, &type);
+			}
+
+			memory_accumulator_add(&group->accumulators[j], aggregate, type, &value, set);
+		}
+	}
+
+	// Like in SQL, aggregating without grouping always returns one row
+	if (groups->len == 0 && group_columns->len == 0)
+	{
+		g_ptr_array_add(groups, g_malloc0(sizeof(JMemoryGroup) + aggregates->len * sizeof(JMemoryAccumulator)));
+	}
+
+	for (guint i = 0; i < groups->len; i++)
+	{
+		JMemoryGroup* group = g_ptr_array_index(groups, i);
+		JMemoryResult* result;
+
+		result = g_slice_new(JMemoryResult);
+		result->values = g_new0(JMemoryValue, types->len);
+		result->set = g_new0(gboolean, types->len);
+
+		for (guint j = 0; j < group_columns->len && group->has_row; j++)
+		{
+			JDBType type;
+
+			result->set[j] = memory_table_get_value(table, g_array_index(group_columns, gint, j), group->row, &result->values[j], &type);
+		}
+
+		for (guint j = 0; j < aggregates->len; j++)
+		{
+			memory_accumulator_finish(&group->accumulators[j], &g_array_index(aggregates, JMemoryAggregate, j), &result->values[group_columns->len + j], &result->set[group_columns->len + j]);
+		}
+
+		g_ptr_array_add(finished, result);
+	}
+
+	if (order->len > 0)
+	{
+		result_order.order = order;
+		result_order.types = types;
+		g_ptr_array_sort_with_data(finished, memory_query_compare_results, &result_order);
+	}
+
+	for (guint64 i = offset; i < finished->len && i - offset < limit; i++)
+	{
+		JMemoryResult* result = g_ptr_array_index(finished, i);
+		bson_t* bson;
+
+		bson = bson_new();
+		g_ptr_array_add(results, bson);
+
+		for (guint j = 0; j < types->len; j++)
+		{
+			if (G_UNLIKELY(!memory_value_append(bson, g_ptr_array_index(names, j), g_array_index(types, JDBType, j), &result->values[j], result->set[j], error)))
+			{
+				goto _error;
+			}
+		}
+	}
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
 
 static gboolean
 backend_batch_start(gpointer backend_data, gchar const* namespace, JSemantics* semantics, gpointer* batch, GError** error)
 {
+	J_TRACE_FUNCTION(NULL);
+
+	JMemoryBatch* memory_batch;
+
 	(void)backend_data;
 	(void)semantics;
-	(void)namespace;
-	(void)batch;
 	(void)error;
 
-	// Return something != NULL
-	*batch = batch;
+	g_return_val_if_fail(namespace != NULL, FALSE);
+
+	memory_batch = g_slice_new(JMemoryBatch);
+	memory_batch->namespace = g_strdup(namespace);
+	*batch = memory_batch;
 
 	return TRUE;
 }
@@ -53,214 +2578,794 @@ backend_batch_start(gpointer backend_data, gchar const* namespace, JSemantics* s
 static gboolean
 backend_batch_execute(gpointer backend_data, gpointer batch, GError** error)
 {
+	J_TRACE_FUNCTION(NULL);
+
+	JMemoryBatch* memory_batch = batch;
+
 	(void)backend_data;
-	(void)batch;
 	(void)error;
 
+	// All operations have already been applied
+	g_free(memory_batch->namespace);
+	g_slice_free(JMemoryBatch, memory_batch);
+
 	return TRUE;
 }
 
 static gboolean
 backend_schema_create(gpointer backend_data, gpointer batch, gchar const* name, bson_t const* schema, GError** error)
 {
+	J_TRACE_FUNCTION(NULL);
+
 	JMemoryData* bd = backend_data;
+	JMemoryBatch* memory_batch = batch;
+	JMemoryTable* table;
+	GHashTable* tables;
 
-	(void)batch;
-	(void)name;
-	(void)schema;
-	(void)error;
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(schema != NULL, FALSE);
+	g_return_val_if_fail(batch != NULL, FALSE);
+
+	if (G_UNLIKELY((table = memory_table_new(schema, bd->id_base, error)) == NULL))
+	{
+		goto _error;
+	}
+
+	g_rw_lock_writer_lock(bd->lock);
 
-	g_mutex_lock(bd->lock);
+	if ((tables = g_hash_table_lookup(bd->namespaces, memory_batch->namespace)) == NULL)
+	{
+		tables = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, memory_table_unref);
+		g_hash_table_insert(bd->namespaces, g_strdup(memory_batch->namespace), tables);
+	}
 
-	if (bd->schema_cache != NULL)
+	if (G_UNLIKELY(g_hash_table_contains(tables, name)))
 	{
-		bson_destroy(bd->schema_cache);
+		g_rw_lock_writer_unlock(bd->lock);
+		memory_table_unref(table);
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_FAILED, "schema already exists");
+		goto _error;
 	}
 
-	bd->schema_cache = bson_copy(schema);
+	g_hash_table_insert(tables, g_strdup(name), table);
 
-	g_mutex_unlock(bd->lock);
+	g_rw_lock_writer_unlock(bd->lock);
 
 	return TRUE;
+
+_error:
+	return FALSE;
 }
 
 static gboolean
 backend_schema_get(gpointer backend_data, gpointer batch, gchar const* name, bson_t* schema, GError** error)
 {
-	gboolean ret = FALSE;
+	J_TRACE_FUNCTION(NULL);
+
 	JMemoryData* bd = backend_data;
+	JMemoryBatch* memory_batch = batch;
+	JMemoryTable* table;
+	JDBTypeValue value;
 
-	(void)batch;
-	(void)name;
-	(void)schema;
-	(void)error;
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(batch != NULL, FALSE);
 
-	g_mutex_lock(bd->lock);
+	if (G_UNLIKELY((table = memory_table_lookup(bd, memory_batch->namespace, name, error)) == NULL))
+	{
+		goto _error;
+	}
 
-	if (bd->schema_cache != NULL)
+	if (schema != NULL)
 	{
-		// FIXME schema is uninitialized if backend is running on the server but initialized if running on the client
-		// bson_copy_to requires the destination to be uninitialized
-		//bson_destroy(schema);
-		bson_copy_to(bd->schema_cache, schema);
-		ret = TRUE;
+		if (G_UNLIKELY(!j_bson_init(schema, error)))
+		{
+			goto _error_unref;
+		}
+
+		value.val_uint32 = J_DB_TYPE_UINT32;
+
+		if (G_UNLIKELY(!j_bson_append_value(schema, "_id", J_DB_TYPE_UINT32, &value, error)))
+		{
+			goto _error_unref;
+		}
+
+		// Columns never change after a table has been created
+		for (guint i = 0; i < table->column_count; i++)
+		{
+			value.val_uint32 = table->columns[i].type;
+
+			if (G_UNLIKELY(!j_bson_append_value(schema, table->columns[i].name, J_DB_TYPE_UINT32, &value, error)))
+			{
+				goto _error_unref;
+			}
+		}
 	}
 
-	g_mutex_unlock(bd->lock);
+	memory_table_unref(table);
+
+	return TRUE;
+
+_error_unref:
+	memory_table_unref(table);
 
-	return ret;
+_error:
+	return FALSE;
 }
 
 static gboolean
 backend_schema_delete(gpointer backend_data, gpointer batch, gchar const* name, GError** error)
 {
+	J_TRACE_FUNCTION(NULL);
+
 	JMemoryData* bd = backend_data;
+	JMemoryBatch* memory_batch = batch;
+	GHashTable* tables;
+	gboolean found = FALSE;
 
-	(void)batch;
-	(void)name;
-	(void)error;
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(batch != NULL, FALSE);
+
+	g_rw_lock_writer_lock(bd->lock);
+
+	// Iterators keep their own reference to the table
+	if ((tables = g_hash_table_lookup(bd->namespaces, memory_batch->namespace)) != NULL)
+	{
+		found = g_hash_table_remove(tables, name);
+
+		if (g_hash_table_size(tables) == 0)
+		{
+			g_hash_table_remove(bd->namespaces, memory_batch->namespace);
+		}
+	}
+
+	g_rw_lock_writer_unlock(bd->lock);
+
+	if (G_UNLIKELY(!found))
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_SCHEMA_NOT_FOUND, "schema not found");
+	}
+
+	return found;
+}
+
+static gboolean
+backend_index_create(gpointer backend_data, gpointer batch, gchar const* name, bson_t const* index, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JMemoryData* bd = backend_data;
+	JMemoryBatch* memory_batch = batch;
+	JMemoryIndex* memory_index;
+	JMemoryTable* table;
+	bson_iter_t iter;
+	gint column;
+
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(index != NULL, FALSE);
+	g_return_val_if_fail(batch != NULL, FALSE);
+
+	if (G_UNLIKELY((table = memory_table_lookup(bd, memory_batch->namespace, name, error)) == NULL))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!j_bson_iter_init(&iter, index, error)) || G_UNLIKELY(!memory_table_find_index_column(table, &iter, &column, error)))
+	{
+		memory_table_unref(table);
+		goto _error;
+	}
+
+	// Building the index only takes as long as sorting the column, writers are blocked in the meantime
+	g_rw_lock_writer_lock(table->lock);
+
+	if ((memory_index = memory_table_get_index(table, column)) != NULL)
+	{
+		memory_index->declared++;
+	}
+	else
+	{
+		memory_table_add_index(table, column);
+	}
+
+	g_rw_lock_writer_unlock(table->lock);
+
+	memory_table_unref(table);
+
+	return TRUE;
 
-	g_mutex_lock(bd->lock);
+_error:
+	return FALSE;
+}
+
+static gboolean
+backend_index_delete(gpointer backend_data, gpointer batch, gchar const* name, bson_t const* index, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JMemoryData* bd = backend_data;
+	JMemoryBatch* memory_batch = batch;
+	JMemoryIndex* memory_index;
+	JMemoryTable* table;
+	bson_iter_t iter;
+	gint column;
+
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(index != NULL, FALSE);
+	g_return_val_if_fail(batch != NULL, FALSE);
+
+	if (G_UNLIKELY((table = memory_table_lookup(bd, memory_batch->namespace, name, error)) == NULL))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!j_bson_iter_init(&iter, index, error)) || G_UNLIKELY(!memory_table_find_index_column(table, &iter, &column, error)))
+	{
+		memory_table_unref(table);
+		goto _error;
+	}
+
+	g_rw_lock_writer_lock(table->lock);
 
-	if (bd->schema_cache != NULL)
+	if ((memory_index = memory_table_get_index(table, column)) != NULL && --memory_index->declared == 0)
 	{
-		bson_destroy(bd->schema_cache);
-		bd->schema_cache = NULL;
+		g_ptr_array_remove_fast(table->indexes, memory_index);
 	}
 
-	g_mutex_unlock(bd->lock);
+	g_rw_lock_writer_unlock(table->lock);
+
+	memory_table_unref(table);
+
+	if (G_UNLIKELY(memory_index == NULL))
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_FAILED, "index not found");
+		goto _error;
+	}
 
 	return TRUE;
+
+_error:
+	return FALSE;
 }
 
 static gboolean
 backend_insert(gpointer backend_data, gpointer batch, gchar const* name, bson_t const* metadata, bson_t* id, GError** error)
 {
+	J_TRACE_FUNCTION(NULL);
+
 	JMemoryData* bd = backend_data;
+	JMemoryBatch* memory_batch = batch;
+	JMemoryTable* table;
+	JDBTypeValue value;
+	guint32 row;
+	guint32 row_id;
+	guint8 deleted = FALSE;
+	g_autoptr(GArray) columns = NULL;
+	g_autoptr(GArray) values = NULL;
+	g_autoptr(GArray) set = NULL;
+	g_autofree JMemoryValue* row_values = NULL;
+	g_autofree gboolean* row_set = NULL;
+
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(metadata != NULL, FALSE);
+	g_return_val_if_fail(batch != NULL, FALSE);
+
+	if (G_UNLIKELY((table = memory_table_lookup(bd, memory_batch->namespace, name, error)) == NULL))
+	{
+		goto _error;
+	}
 
-	(void)batch;
-	(void)name;
-	(void)metadata;
-	(void)id;
-	(void)error;
+	columns = g_array_new(FALSE, FALSE, sizeof(gint));
+	values = g_array_new(FALSE, FALSE, sizeof(JMemoryValue));
+	set = g_array_new(FALSE, FALSE, sizeof(gboolean));
+
+	if (G_UNLIKELY(!memory_table_parse_entry(table, metadata, columns, values, set, error)))
+	{
+		goto _error_clear;
+	}
+
+	// Later values for the same field replace earlier ones
+	row_values = g_new0(JMemoryValue, table->column_count);
+	row_set = g_new0(gboolean, table->column_count);
+
+	for (guint i = 0; i < columns->len; i++)
+	{
+		gint column = g_array_index(columns, gint, i);
+
+		memory_value_clear(table->columns[column].type, &row_values[column]);
+		row_values[column] = g_array_index(values, JMemoryValue, i);
+		row_set[column] = g_array_index(set, gboolean, i);
+	}
+
+	g_rw_lock_writer_lock(table->lock);
 
-	g_mutex_lock(bd->lock);
+	row = table->ids->len;
+	row_id = table->next_id++;
 
-	if (bd->entry_cache != NULL)
+	g_array_append_val(table->ids, row_id);
+	g_array_append_val(table->deleted, deleted);
+
+	for (guint i = 0; i < table->column_count; i++)
+	{
+		guint8 column_set = row_set[i];
+
+		g_array_append_val(table->columns[i].values, row_values[i]);
+		g_array_append_val(table->columns[i].set, column_set);
+	}
+
+	for (guint i = 0; i < table->indexes->len; i++)
+	{
+		memory_index_insert(table, g_ptr_array_index(table->indexes, i), row);
+	}
+
+	g_rw_lock_writer_unlock(table->lock);
+
+	memory_table_unref(table);
+
+	if (G_UNLIKELY(!j_bson_init(id, error)))
+	{
+		goto _error;
+	}
+
+	value.val_uint32 = row_id;
+
+	if (G_UNLIKELY(!j_bson_append_value(id, "_value", J_DB_TYPE_UINT32, &value, error)))
 	{
-		bson_destroy(bd->entry_cache);
+		goto _error;
 	}
 
-	bd->entry_cache = bson_copy(metadata);
-	bd->entry_counter++;
+	value.val_uint32 = J_DB_TYPE_UINT32;
 
-	g_mutex_unlock(bd->lock);
+	if (G_UNLIKELY(!j_bson_append_value(id, "_value_type", J_DB_TYPE_UINT32, &value, error)))
+	{
+		goto _error;
+	}
 
 	return TRUE;
+
+_error_clear:
+	memory_table_clear_entry(table, columns, values);
+	memory_table_unref(table);
+
+_error:
+	return FALSE;
 }
 
 static gboolean
 backend_update(gpointer backend_data, gpointer batch, gchar const* name, bson_t const* selector, bson_t const* metadata, GError** error)
 {
-	(void)backend_data;
-	(void)batch;
-	(void)name;
-	(void)selector;
-	(void)metadata;
-	(void)error;
+	J_TRACE_FUNCTION(NULL);
+
+	JMemoryData* bd = backend_data;
+	JMemoryBatch* memory_batch = batch;
+	JMemoryCondition* condition = NULL;
+	JMemoryTable* table;
+	g_autoptr(GArray) columns = NULL;
+	g_autoptr(GArray) values = NULL;
+	g_autoptr(GArray) set = NULL;
+	g_autoptr(GArray) rows = NULL;
+
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(metadata != NULL, FALSE);
+	g_return_val_if_fail(batch != NULL, FALSE);
+
+	if (G_UNLIKELY((table = memory_table_lookup(bd, memory_batch->namespace, name, error)) == NULL))
+	{
+		goto _error;
+	}
+
+	columns = g_array_new(FALSE, FALSE, sizeof(gint));
+	values = g_array_new(FALSE, FALSE, sizeof(JMemoryValue));
+	set = g_array_new(FALSE, FALSE, sizeof(gboolean));
+
+	if (G_UNLIKELY(!memory_table_parse_entry(table, metadata, columns, values, set, error)))
+	{
+		goto _error_clear;
+	}
+
+	if (G_UNLIKELY(!memory_condition_compile(table, selector, &condition, error)))
+	{
+		goto _error_clear;
+	}
+
+	g_rw_lock_writer_lock(table->lock);
+
+	rows = memory_table_select(table, condition);
+
+	for (guint i = 0; i < rows->len; i++)
+	{
+		guint32 row = g_array_index(rows, guint32, i);
+
+		for (guint j = 0; j < columns->len; j++)
+		{
+			gint column = g_array_index(columns, gint, j);
+			JMemoryColumn* memory_column = &table->columns[column];
+			JMemoryIndex* index;
+			JMemoryValue* value;
+
+			// Rows have to be removed from the index before their value changes
+			if ((index = memory_table_get_index(table, column)) != NULL)
+			{
+				memory_index_remove(table, index, row);
+			}
+
+			value = &g_array_index(memory_column->values, JMemoryValue, row);
+			memory_value_clear(memory_column->type, value);
+			*value = g_array_index(values, JMemoryValue, j);
+			g_array_index(memory_column->set, guint8, row) = g_array_index(set, gboolean, j);
+
+			// Every row needs its own copy
+			if (memory_column->type == J_DB_TYPE_STRING)
+			{
+				value->val_string = g_strdup(value->val_string);
+			}
+			else if (memory_column->type == J_DB_TYPE_BLOB && value->val_blob != NULL)
+			{
+				g_bytes_ref(value->val_blob);
+			}
+
+			if (index != NULL)
+			{
+				memory_index_insert(table, index, row);
+			}
+		}
+	}
+
+	g_rw_lock_writer_unlock(table->lock);
+
+	if (condition != NULL)
+	{
+		memory_condition_free(condition);
+	}
+
+	memory_table_clear_entry(table, columns, values);
+	memory_table_unref(table);
+
+	if (G_UNLIKELY(rows->len == 0))
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS, "no more elements");
+		goto _error;
+	}
 
 	return TRUE;
+
+_error_clear:
+	memory_table_clear_entry(table, columns, values);
+	memory_table_unref(table);
+
+_error:
+	return FALSE;
 }
 
 static gboolean
 backend_delete(gpointer backend_data, gpointer batch, gchar const* name, bson_t const* selector, GError** error)
 {
+	J_TRACE_FUNCTION(NULL);
+
 	JMemoryData* bd = backend_data;
+	JMemoryBatch* memory_batch = batch;
+	JMemoryCondition* condition = NULL;
+	JMemoryTable* table;
+	g_autoptr(GArray) rows = NULL;
 
-	(void)batch;
-	(void)name;
-	(void)selector;
-	(void)error;
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(batch != NULL, FALSE);
+
+	if (G_UNLIKELY((table = memory_table_lookup(bd, memory_batch->namespace, name, error)) == NULL))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!memory_condition_compile(table, selector, &condition, error)))
+	{
+		memory_table_unref(table);
+		goto _error;
+	}
+
+	g_rw_lock_writer_lock(table->lock);
+
+	rows = memory_table_select(table, condition);
+
+	for (guint i = 0; i < rows->len; i++)
+	{
+		guint32 row = g_array_index(rows, guint32, i);
+
+		for (guint j = 0; j < table->indexes->len; j++)
+		{
+			memory_index_remove(table, g_ptr_array_index(table->indexes, j), row);
+		}
+
+		for (guint j = 0; j < table->column_count; j++)
+		{
+			memory_value_clear(table->columns[j].type, &g_array_index(table->columns[j].values, JMemoryValue, row));
+			g_array_index(table->columns[j].set, guint8, row) = FALSE;
+		}
+
+		g_array_index(table->deleted, guint8, row) = TRUE;
+		table->deleted_count++;
+	}
+
+	// Iterators refer to rows by their position, so they must not be moved while iterators exist
+	if (table->deleted_count >= MEMORY_COMPACT_THRESHOLD && table->deleted_count >= table->ids->len / 2 && g_atomic_int_get(&table->iterators) == 0)
+	{
+		memory_table_compact(table);
+	}
 
-	g_mutex_lock(bd->lock);
+	g_rw_lock_writer_unlock(table->lock);
 
-	if (bd->entry_cache != NULL)
+	if (condition != NULL)
 	{
-		bson_destroy(bd->entry_cache);
-		bd->entry_cache = NULL;
+		memory_condition_free(condition);
 	}
 
-	bd->entry_counter--;
+	memory_table_unref(table);
 
-	g_mutex_unlock(bd->lock);
+	if (G_UNLIKELY(rows->len == 0))
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS, "no more elements");
+		goto _error;
+	}
 
 	return TRUE;
+
+_error:
+	return FALSE;
 }
 
 static gboolean
 backend_query(gpointer backend_data, gpointer batch, gchar const* name, bson_t const* selector, gpointer* iterator, GError** error)
 {
+	J_TRACE_FUNCTION(NULL);
+
 	JMemoryData* bd = backend_data;
-	guint32* counter;
+	JMemoryBatch* memory_batch = batch;
+	JMemoryCondition* condition = NULL;
+	JMemoryIterator* memory_iterator = NULL;
+	JMemoryTable* table;
+	JDBTypeValue value;
+	bson_iter_t iter;
+	bson_iter_t iter_child;
+	gboolean has_next;
+	guint64 limit = G_MAXUINT64;
+	guint64 offset = 0;
+	g_autoptr(GArray) rows = NULL;
+	g_autoptr(GArray) order = NULL;
+
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(iterator != NULL, FALSE);
+	g_return_val_if_fail(batch != NULL, FALSE);
+
+	if (G_UNLIKELY((table = memory_table_lookup(bd, memory_batch->namespace, name, error)) == NULL))
+	{
+		goto _error;
+	}
 
-	(void)batch;
-	(void)name;
-	(void)selector;
-	(void)error;
+	memory_iterator = g_slice_new0(JMemoryIterator);
+	memory_iterator->table = table;
+	g_atomic_int_inc(&table->iterators);
+
+	if (selector != NULL && j_bson_iter_init(&iter, selector, NULL) && j_bson_iter_find(&iter, "_limit", NULL))
+	{
+		if (G_UNLIKELY(!j_bson_iter_value(&iter, J_DB_TYPE_UINT64, &value, error)))
+		{
+			goto _error;
+		}
 
-	counter = g_new(guint32, 1);
-	*iterator = counter;
+		limit = value.val_uint64;
+	}
+
+	if (selector != NULL && j_bson_iter_init(&iter, selector, NULL) && j_bson_iter_find(&iter, "_offset", NULL))
+	{
+		if (G_UNLIKELY(!j_bson_iter_value(&iter, J_DB_TYPE_UINT64, &value, error)))
+		{
+			goto _error;
+		}
 
-	g_mutex_lock(bd->lock);
+		offset = value.val_uint64;
+	}
 
-	if (bd->entry_cache == NULL)
+	if (G_UNLIKELY(!memory_condition_compile(table, selector, &condition, error)))
 	{
-		*counter = 0;
+		goto _error;
 	}
-	else if (selector != NULL)
+
+	g_rw_lock_reader_lock(table->lock);
+
+	rows = memory_table_select(table, condition);
+
+	if (selector != NULL && (bson_has_field(selector, "_aggregate") || bson_has_field(selector, "_group")))
 	{
-		*counter = 1;
+		memory_iterator->results = g_ptr_array_new_with_free_func((GDestroyNotify)bson_destroy);
+
+		if (G_UNLIKELY(!memory_query_aggregate(table, selector, rows, offset, limit, memory_iterator->results, error)))
+		{
+			goto _error_unlock;
+		}
 	}
 	else
 	{
-		*counter = bd->entry_counter;
+		JMemoryRowOrder row_order;
+
+		memory_iterator->columns = g_array_new(FALSE, FALSE, sizeof(gint));
+
+		if (selector != NULL && j_bson_iter_init(&iter, selector, NULL) && j_bson_iter_find(&iter, "_projection", NULL))
+		{
+			// Only return the requested fields, the ID is always included
+			if (G_UNLIKELY(!j_bson_iter_recurse_document(&iter, &iter_child, error)))
+			{
+				goto _error_unlock;
+			}
+
+			while (TRUE)
+			{
+				gint column;
+
+				if (G_UNLIKELY(!j_bson_iter_next(&iter_child, &has_next, error)))
+				{
+					goto _error_unlock;
+				}
+
+				if (!has_next)
+				{
+					break;
+				}
+
+				if (G_UNLIKELY(!j_bson_iter_value(&iter_child, J_DB_TYPE_STRING, &value, error)))
+				{
+					goto _error_unlock;
+				}
+
+				if (G_UNLIKELY(!memory_table_find_column(table, value.val_string, TRUE, &column, error)))
+				{
+					goto _error_unlock;
+				}
+
+				if (column != MEMORY_COLUMN_ID)
+				{
+					g_array_append_val(memory_iterator->columns, column);
+				}
+			}
+		}
+		else
+		{
+			for (gint i = 0; i < (gint)table->column_count; i++)
+			{
+				g_array_append_val(memory_iterator->columns, i);
+			}
+		}
+
+		order = g_array_new(FALSE, FALSE, sizeof(JMemoryOrder));
+
+		if (G_UNLIKELY(!memory_query_parse_order(table, selector, NULL, order, error)))
+		{
+			goto _error_unlock;
+		}
+
+		if (order->len > 0)
+		{
+			row_order.table = table;
+			row_order.order = order;
+			g_array_sort_with_data(rows, memory_query_compare_rows, &row_order);
+		}
+
+		if (offset >= rows->len)
+		{
+			g_array_set_size(rows, 0);
+		}
+		else
+		{
+			g_array_remove_range(rows, 0, offset);
+			g_array_set_size(rows, MIN(rows->len, limit));
+		}
+
+		memory_iterator->rows = g_steal_pointer(&rows);
+	}
+
+	g_rw_lock_reader_unlock(table->lock);
+
+	if (condition != NULL)
+	{
+		memory_condition_free(condition);
 	}
 
-	g_mutex_unlock(bd->lock);
+	*iterator = memory_iterator;
 
 	return TRUE;
+
+_error_unlock:
+	g_rw_lock_reader_unlock(table->lock);
+
+_error:
+	if (condition != NULL)
+	{
+		memory_condition_free(condition);
+	}
+
+	if (memory_iterator != NULL)
+	{
+		memory_iterator_free(memory_iterator);
+	}
+
+	return FALSE;
 }
 
 static gboolean
 backend_iterate(gpointer backend_data, gpointer iterator, bson_t* metadata, GError** error)
 {
-	gboolean ret = TRUE;
-	guint32* counter = iterator;
-	JMemoryData* bd = backend_data;
+	J_TRACE_FUNCTION(NULL);
 
-	(void)iterator;
-	(void)metadata;
-	(void)error;
+	JMemoryIterator* memory_iterator = iterator;
+	JMemoryTable* table = memory_iterator->table;
+	gboolean found = FALSE;
+
+	(void)backend_data;
+
+	g_return_val_if_fail(iterator != NULL, FALSE);
+	g_return_val_if_fail(metadata != NULL, FALSE);
+
+	if (memory_iterator->results != NULL)
+	{
+		if (memory_iterator->position < memory_iterator->results->len)
+		{
+			bson_concat(metadata, g_ptr_array_index(memory_iterator->results, memory_iterator->position));
+			memory_iterator->position++;
+			found = TRUE;
+		}
+	}
+	else
+	{
+		g_rw_lock_reader_lock(table->lock);
+
+		// Rows deleted after the query are skipped
+		while (memory_iterator->position < memory_iterator->rows->len)
+		{
+			guint32 row = g_array_index(memory_iterator->rows, guint32, memory_iterator->position);
+			JDBTypeValue value;
+
+			memory_iterator->position++;
+
+			if (g_array_index(table->deleted, guint8, row))
+			{
+				continue;
+			}
+
+			value.val_uint32 = g_array_index(table->ids, guint32, row);
+
+			if (G_UNLIKELY(!j_bson_append_value(metadata, "_id", J_DB_TYPE_UINT32, &value, error)))
+			{
+				g_rw_lock_reader_unlock(table->lock);
+				goto _error;
+			}
+
+			for (guint i = 0; i < memory_iterator->columns->len; i++)
+			{
+				JMemoryColumn* column = &table->columns[g_array_index(memory_iterator->columns, gint, i)];
 
-	g_mutex_lock(bd->lock);
+				if (G_UNLIKELY(!memory_value_append(metadata, column->name, column->type, &g_array_index(column->values, JMemoryValue, row), g_array_index(column->set, guint8, row), error)))
+				{
+					g_rw_lock_reader_unlock(table->lock);
+					goto _error;
+				}
+			}
 
-	if (*counter <= 0 || bd->entry_cache == NULL)
+			found = TRUE;
+			break;
+		}
+
+		g_rw_lock_reader_unlock(table->lock);
+	}
+
+	if (!found)
 	{
-		g_free(counter);
 		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS, "no more elements");
-		ret = FALSE;
-		goto end;
+		goto _error;
 	}
 
-	(*counter)--;
-	// bson_copy_to requires the destination to be uninitialized
-	bson_destroy(metadata);
-	bson_copy_to(bd->entry_cache, metadata);
+	return TRUE;
 
-end:
-	g_mutex_unlock(bd->lock);
+_error:
+	memory_iterator_free(memory_iterator);
 
-	return ret;
+	return FALSE;
 }
 
 static gboolean
@@ -271,10 +3376,9 @@ backend_init(gchar const* path, gpointer* backend_data)
 	(void)path;
 
 	bd = g_slice_new(JMemoryData);
-	bd->schema_cache = NULL;
-	bd->entry_cache = NULL;
-	bd->entry_counter = 0;
-	g_mutex_init(bd->lock);
+	bd->namespaces = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, (GDestroyNotify)g_hash_table_unref);
+	bd->id_base = 1;
+	g_rw_lock_init(bd->lock);
 
 	*backend_data = bd;
 
@@ -286,18 +3390,19 @@ backend_fini(gpointer backend_data)
 {
 	JMemoryData* bd = backend_data;
 
-	if (bd->schema_cache != NULL)
-	{
-		bson_destroy(bd->schema_cache);
-	}
+	g_hash_table_unref(bd->namespaces);
+	g_rw_lock_clear(bd->lock);
+	g_slice_free(JMemoryData, bd);
+}
 
-	if (bd->entry_cache != NULL)
-	{
-		bson_destroy(bd->entry_cache);
-	}
+static gboolean
+backend_set_id_base(gpointer backend_data, guint32 id_base)
+{
+	JMemoryData* bd = backend_data;
 
-	g_mutex_clear(bd->lock);
-	g_slice_free(JMemoryData, bd);
+	bd->id_base = id_base;
+
+	return TRUE;
 }
 
 static JBackend memory_backend = {
@@ -309,13 +3414,16 @@ static JBackend memory_backend = {
 		.backend_schema_create = backend_schema_create,
 		.backend_schema_get = backend_schema_get,
 		.backend_schema_delete = backend_schema_delete,
+		.backend_index_create = backend_index_create,
+		.backend_index_delete = backend_index_delete,
 		.backend_insert = backend_insert,
 		.backend_update = backend_update,
 		.backend_delete = backend_delete,
 		.backend_query = backend_query,
 		.backend_iterate = backend_iterate,
 		.backend_batch_start = backend_batch_start,
-		.backend_batch_execute = backend_batch_execute }
+		.backend_batch_execute = backend_batch_execute,
+		.backend_set_id_base = backend_set_id_base }
 };
 
 G_MODULE_EXPORT
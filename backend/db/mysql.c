@@ -35,9 +35,19 @@
 #define SQL_MODE SQL_MODE_MULTI_THREAD
 
 #define SQL_AUTOINCREMENT_STRING " NOT NULL AUTO_INCREMENT "
+#define SQL_ID_RANGE_STRING " "
+#define SQL_ID_BASE_STRING "ALTER TABLE " SQL_QUOTE "%s_%s" SQL_QUOTE " AUTO_INCREMENT = %u"
 #define SQL_UINT64_TYPE " BIGINT UNSIGNED "
 #define SQL_LAST_INSERT_ID_STRING " SELECT LAST_INSERT_ID() "
+#define SQL_FIRST_INSERT_ID_STRING " SELECT LAST_INSERT_ID() "
+#define SQL_MAX_VARIABLES 65535
 #define SQL_QUOTE "`"
+#define SQL_INDEX_ONLINE_STRING " ALGORITHM=INPLACE LOCK=NONE "
+#define SQL_INDEX_DROP_ON_TABLE TRUE
+#define SQL_INDEX_COLUMNS_STRING "SELECT index_name, column_name FROM information_schema.statistics WHERE table_schema = DATABASE() AND table_name = ? ORDER BY index_name, seq_in_index"
+#define SQL_STATEMENT_CACHE_SIZE 256
+// Connections are shared by all threads, a thread only holds one while it executes a batch
+#define SQL_CONNECTION_POOL_SIZE 16
 
 struct JMySQLData
 {
@@ -58,6 +68,10 @@ struct mysql_stmt_wrapper
 	my_bool* is_null; //reused for in AND out
 	my_bool* is_error; //reused for in AND out
 	unsigned long* length; //output
+
+	/**
+	 * Whether the statement has been executed, its rows are fetched from the server one by one until it is reset.
+	 **/
 	gboolean active;
 	guint param_count_in;
 	guint param_count_out;
@@ -415,9 +429,20 @@ j_sql_reset(MYSQL* backend_db, void* _stmt, GError** error)
 	g_return_val_if_fail(backend_db != NULL, FALSE);
 	g_return_val_if_fail(_stmt != NULL, FALSE);
 
+	// Unread rows are still pending on the connection, discard them so that other statements can be executed
+	if (wrapper->active && wrapper->param_count_out && mysql_stmt_free_result(wrapper->stmt))
+	{
+		g_set_error(error, J_BACKEND_SQL_ERROR, J_BACKEND_SQL_ERROR_RESET, "sql reset failed error was '%s'", mysql_stmt_error(wrapper->stmt));
+		wrapper->active = FALSE;
+		goto _error;
+	}
+
 	wrapper->active = FALSE;
 
 	return TRUE;
+
+_error:
+	return FALSE;
 }
 
 static gboolean
@@ -506,20 +531,19 @@ j_sql_step(MYSQL* backend_db, void* _stmt, gboolean* found, GError** error)
 			goto _error;
 		}
 
-		if (wrapper->param_count_out)
-		{
-			if ((status = mysql_stmt_store_result(wrapper->stmt)))
-			{
-				g_set_error(error, J_BACKEND_SQL_ERROR, J_BACKEND_SQL_ERROR_STEP, "sql step failed error was  (%d):'%s'", status, mysql_stmt_error(wrapper->stmt));
-				goto _error;
-			}
-		}
+		// The result is not stored using mysql_stmt_store_result, large results would have to be buffered completely
 		wrapper->active = TRUE;
 	}
 
 	if (wrapper->param_count_out)
 	{
-		*found = mysql_stmt_fetch(wrapper->stmt) == 0;
+		if ((status = mysql_stmt_fetch(wrapper->stmt)) == 1)
+		{
+			g_set_error(error, J_BACKEND_SQL_ERROR, J_BACKEND_SQL_ERROR_STEP, "sql step failed error was  (%d):'%s'", status, mysql_stmt_error(wrapper->stmt));
+			goto _error;
+		}
+
+		*found = status == 0;
 	}
 	else
 	{
@@ -567,6 +591,36 @@ _error2:
 	return FALSE;
 }
 
+static gboolean
+j_sql_changes(MYSQL* backend_db, void* _stmt, guint64* changes, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	mysql_stmt_wrapper* wrapper = _stmt;
+	my_ulonglong affected;
+
+	(void)backend_db;
+
+	g_return_val_if_fail(backend_db != NULL, FALSE);
+	g_return_val_if_fail(_stmt != NULL, FALSE);
+	g_return_val_if_fail(changes != NULL, FALSE);
+
+	affected = mysql_stmt_affected_rows(wrapper->stmt);
+
+	if (G_UNLIKELY(affected == (my_ulonglong)-1))
+	{
+		g_set_error(error, J_BACKEND_SQL_ERROR, J_BACKEND_SQL_ERROR_STEP, "sql step failed error was '%s'", mysql_stmt_error(wrapper->stmt));
+		goto _error;
+	}
+
+	*changes = affected;
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
 static void*
 j_sql_open(gpointer backend_data)
 {
@@ -587,7 +641,7 @@ j_sql_open(gpointer backend_data)
 				bd->db_database, //database name
 				3306, //port number
 				NULL, //unix socket
-				0 //client flags
+				CLIENT_FOUND_ROWS //client flags, count matched instead of changed rows
 				))
 	{
 		goto _error;
@@ -614,10 +668,11 @@ j_sql_close(MYSQL* backend_db)
 }
 
 static gboolean
-j_sql_start_transaction(MYSQL* backend_db, GError** error)
+j_sql_start_transaction(MYSQL* backend_db, JSemantics* semantics, GError** error)
 {
 	J_TRACE_FUNCTION(NULL);
 
+	(void)semantics;
 	(void)error;
 
 	mysql_query(backend_db, "START TRANSACTION");
@@ -711,13 +766,18 @@ static JBackend mysql_backend = {
 		.backend_schema_create = backend_schema_create,
 		.backend_schema_get = backend_schema_get,
 		.backend_schema_delete = backend_schema_delete,
+		.backend_index_create = backend_index_create,
+		.backend_index_delete = backend_index_delete,
+		.backend_statistics = backend_statistics,
 		.backend_insert = backend_insert,
+		.backend_insert_many = backend_insert_many,
 		.backend_update = backend_update,
 		.backend_delete = backend_delete,
 		.backend_query = backend_query,
 		.backend_iterate = backend_iterate,
 		.backend_batch_start = backend_batch_start,
 		.backend_batch_execute = backend_batch_execute,
+		.backend_set_id_base = backend_set_id_base,
 	},
 };
 
@@ -161,6 +161,15 @@ backend_fini(gpointer backend_data)
 	(void)backend_data;
 }
 
+static gboolean
+backend_set_id_base(gpointer backend_data, guint32 id_base)
+{
+	(void)backend_data;
+	(void)id_base;
+
+	return TRUE;
+}
+
 static JBackend null_backend = {
 	.type = J_BACKEND_TYPE_DB,
 	.component = J_BACKEND_COMPONENT_CLIENT | J_BACKEND_COMPONENT_SERVER,
@@ -176,7 +185,8 @@ static JBackend null_backend = {
 		.backend_query = backend_query,
 		.backend_iterate = backend_iterate,
 		.backend_batch_start = backend_batch_start,
-		.backend_batch_execute = backend_batch_execute }
+		.backend_batch_execute = backend_batch_execute,
+		.backend_set_id_base = backend_set_id_base }
 };
 
 G_MODULE_EXPORT
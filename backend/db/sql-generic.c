@@ -23,11 +23,28 @@
  * this file does not care which sql-database is actually in use, and uses only defines sql-syntax to allow fast and easy implementations for any new sql-database backend
 */
 
+struct JSqlStatistics
+{
+	guint64 statements_hit;
+	guint64 statements_missed;
+	guint64 statements_evicted;
+};
+
+typedef struct JSqlStatistics JSqlStatistics;
+
 struct JThreadVariables
 {
 	gboolean initialized;
 	void* sql_backend;
 	GHashTable* namespaces;
+
+	/**
+	 * The cached statements (JSqlCacheSQLPrepared*), ordered from most to least recently used.
+	 * At most SQL_STATEMENT_CACHE_SIZE statements are kept.
+	 **/
+	GQueue statements;
+
+	JSqlStatistics statistics;
 };
 
 typedef struct JThreadVariables JThreadVariables;
@@ -42,7 +59,7 @@ typedef struct JSqlCacheNames JSqlCacheNames;
 struct JSqlCacheSQLQueries
 {
 	GHashTable* types; // variablename(char*) -> variabletype(JDBType)
-	GHashTable* queries; //sql(char*) -> (JSqlCacheSQLPrepared*)
+	GHashTable* queries; //sql(char*) -> (JSqlCacheSQLPrepared*), hashed using sql_statement_hash
 };
 
 typedef struct JSqlCacheSQLQueries JSqlCacheSQLQueries;
@@ -53,10 +70,42 @@ struct JSqlCacheSQLPrepared
 	void* stmt;
 	guint variables_count;
 	GHashTable* variables_index;
+
+	/**
+	 * The types of the returned columns, NULL if they are taken from the schema.
+	 **/
+	GArray* variables_type;
+
+	/**
+	 * The LIKE patterns bound to the statement, they have to stay valid until it has been executed.
+	 **/
+	GPtrArray* patterns;
+
 	gboolean initialized;
 	gchar* namespace;
 	gchar* name;
 	gpointer backend_data;
+
+	/**
+	 * The connection the statement has been prepared on.
+	 **/
+	JThreadVariables* thread_variables;
+
+	/**
+	 * The statement's key in queries, which owns it.
+	 **/
+	gchar const* query;
+	JSqlCacheSQLQueries* queries;
+
+	/**
+	 * The statement's link in the thread's statement cache, its data is NULL if it is not linked.
+	 **/
+	GList lru;
+
+	/**
+	 * Whether an iterator is using the statement, it must not be evicted in this case.
+	 **/
+	gboolean iterating;
 };
 
 typedef struct JSqlCacheSQLPrepared JSqlCacheSQLPrepared;
@@ -71,29 +120,56 @@ struct JSqlBatch
 
 typedef struct JSqlBatch JSqlBatch;
 
-struct JSqlIterator
-{
-	char* namespace;
-	char* name;
-	GArray* arr;
-	guint index;
-};
-
-typedef struct JSqlIterator JSqlIterator;
-
 static void thread_variables_fini(void* ptr);
 static GPrivate thread_variables_global = G_PRIVATE_INIT(thread_variables_fini);
 
+/**
+ * The statistics of all threads, the statistics of finished threads are accumulated separately.
+ **/
+static GMutex sql_statistics_mutex[1];
+static GSList* sql_statistics_threads = NULL;
+static JSqlStatistics sql_statistics_finished = { 0, 0, 0 };
+
+/**
+ * The idle connections (JThreadVariables*) if SQL_CONNECTION_POOL_SIZE is not 0.
+ * A thread takes a connection when it starts a batch and returns it when the batch is executed.
+ **/
+static GAsyncQueue* sql_connection_pool = NULL;
+static gint sql_connection_count = 0;
+
+/**
+ * The ID of the first entry of new schemas.
+ **/
+static guint32 sql_id_base = 1;
+
 static void
 sql_generic_init(void)
 {
 	J_TRACE_FUNCTION(NULL);
+
+	if (SQL_CONNECTION_POOL_SIZE > 0)
+	{
+		sql_connection_pool = g_async_queue_new();
+	}
 }
 
 static void
 sql_generic_fini(void)
 {
 	J_TRACE_FUNCTION(NULL);
+
+	if (SQL_CONNECTION_POOL_SIZE > 0)
+	{
+		JThreadVariables* thread_variables;
+
+		while ((thread_variables = g_async_queue_try_pop(sql_connection_pool)) != NULL)
+		{
+			thread_variables_fini(thread_variables);
+		}
+
+		g_async_queue_unref(sql_connection_pool);
+		sql_connection_pool = NULL;
+	}
 }
 
 static void
@@ -105,6 +181,29 @@ thread_variables_fini(void* ptr)
 
 	if (thread_variables)
 	{
+		if (thread_variables->initialized)
+		{
+			g_mutex_lock(sql_statistics_mutex);
+			sql_statistics_threads = g_slist_remove(sql_statistics_threads, thread_variables);
+			sql_statistics_finished.statements_hit += thread_variables->statistics.statements_hit;
+			sql_statistics_finished.statements_missed += thread_variables->statistics.statements_missed;
+			sql_statistics_finished.statements_evicted += thread_variables->statistics.statements_evicted;
+			g_mutex_unlock(sql_statistics_mutex);
+
+			if (SQL_CONNECTION_POOL_SIZE > 0)
+			{
+				g_atomic_int_add(&sql_connection_count, -1);
+			}
+		}
+
+		// The statements are freed below, do not unlink them one by one
+		for (GList* link = thread_variables->statements.head; link != NULL; link = link->next)
+		{
+			link->data = NULL;
+		}
+
+		g_queue_init(&thread_variables->statements);
+
 		if (thread_variables->namespaces)
 		{
 			g_hash_table_destroy(thread_variables->namespaces);
@@ -115,6 +214,63 @@ thread_variables_fini(void* ptr)
 	}
 }
 
+/**
+ * Takes an idle connection from the pool.
+ * Returns NULL if a new connection may be opened, waits for another thread to return one if SQL_CONNECTION_POOL_SIZE connections are open.
+ **/
+static JThreadVariables*
+sql_connection_acquire(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JThreadVariables* thread_variables = NULL;
+
+	while (TRUE)
+	{
+		if ((thread_variables = g_async_queue_try_pop(sql_connection_pool)) != NULL)
+		{
+			break;
+		}
+
+		if (g_atomic_int_add(&sql_connection_count, 1) < SQL_CONNECTION_POOL_SIZE)
+		{
+			break;
+		}
+
+		g_atomic_int_add(&sql_connection_count, -1);
+
+		// Retry periodically since a connection might also become available because another thread failed to open it
+		if ((thread_variables = g_async_queue_timeout_pop(sql_connection_pool, G_USEC_PER_SEC / 10)) != NULL)
+		{
+			break;
+		}
+	}
+
+	return thread_variables;
+}
+
+/**
+ * Returns the calling thread's connection to the pool.
+ **/
+static void
+sql_connection_release(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JThreadVariables* thread_variables;
+
+	if (SQL_CONNECTION_POOL_SIZE == 0)
+	{
+		return;
+	}
+
+	if ((thread_variables = g_private_get(&thread_variables_global)) != NULL)
+	{
+		g_private_set(&thread_variables_global, NULL);
+		g_async_queue_push(sql_connection_pool, thread_variables);
+	}
+}
+
 static void freeJSqlCacheNames(void* ptr);
 
 static JThreadVariables*
@@ -126,10 +282,16 @@ thread_variables_get(gpointer backend_data, GError** error)
 
 	thread_variables = g_private_get(&thread_variables_global);
 
+	if (!thread_variables && SQL_CONNECTION_POOL_SIZE > 0 && (thread_variables = sql_connection_acquire()) != NULL)
+	{
+		g_private_set(&thread_variables_global, thread_variables);
+	}
+
 	if (!thread_variables)
 	{
 		thread_variables = g_new0(JThreadVariables, 1);
 		thread_variables->initialized = FALSE;
+		g_queue_init(&thread_variables->statements);
 	}
 
 	if (!thread_variables->initialized)
@@ -153,28 +315,24 @@ thread_variables_get(gpointer backend_data, GError** error)
 		thread_variables->namespaces = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, freeJSqlCacheNames);
 		thread_variables->initialized = TRUE;
 		g_private_replace(&thread_variables_global, thread_variables);
+
+		g_mutex_lock(sql_statistics_mutex);
+		sql_statistics_threads = g_slist_prepend(sql_statistics_threads, thread_variables);
+		g_mutex_unlock(sql_statistics_mutex);
 	}
 
 	return thread_variables;
 
 _error:
-	return NULL;
-}
-
-static void
-freeJSqlIterator(gpointer ptr)
-{
-	J_TRACE_FUNCTION(NULL);
-
-	JSqlIterator* iter = ptr;
+	j_sql_close(thread_variables->sql_backend);
+	g_free(thread_variables);
 
-	if (ptr)
+	if (SQL_CONNECTION_POOL_SIZE > 0)
 	{
-		g_free(iter->namespace);
-		g_free(iter->name);
-		g_array_free(iter->arr, TRUE);
-		g_free(iter);
+		g_atomic_int_add(&sql_connection_count, -1);
 	}
+
+	return NULL;
 }
 
 static void
@@ -224,13 +382,12 @@ freeJSqlCacheSQLPrepared(void* ptr)
 	J_TRACE_FUNCTION(NULL);
 
 	JSqlCacheSQLPrepared* p = ptr;
-	JThreadVariables* thread_variables = NULL;
-
-	if (G_UNLIKELY(!(thread_variables = thread_variables_get(p->backend_data, NULL))))
-		g_assert_not_reached();
 
 	if (ptr)
 	{
+		// The statement may be freed while its connection is not the calling thread's
+		JThreadVariables* thread_variables = p->thread_variables;
+
 		if (p->initialized)
 		{
 			if (p->variables_index)
@@ -238,6 +395,11 @@ freeJSqlCacheSQLPrepared(void* ptr)
 				g_hash_table_destroy(p->variables_index);
 			}
 
+			if (p->variables_type)
+			{
+				g_array_unref(p->variables_type);
+			}
+
 			if (p->sql)
 			{
 				g_string_free(p->sql, TRUE);
@@ -249,12 +411,81 @@ freeJSqlCacheSQLPrepared(void* ptr)
 			}
 		}
 
+		if (p->patterns)
+		{
+			g_ptr_array_unref(p->patterns);
+		}
+
+		if (p->lru.data != NULL)
+		{
+			g_queue_unlink(&thread_variables->statements, &p->lru);
+		}
+
 		g_free(p->namespace);
 		g_free(p->name);
 		g_free(p);
 	}
 }
 
+/**
+ * Returns a statement's hash for looking it up in the statement cache.
+ * The cache is keyed by the full statement, which has to be generated anyway and cannot collide.
+ * Statements are hashed eight bytes at a time, which is considerably cheaper than g_str_hash for long statements.
+ **/
+static guint
+sql_statement_hash(gconstpointer key)
+{
+	gchar const* query = key;
+	gsize length;
+	guint64 hash;
+	guint64 word;
+	gsize i;
+
+	length = strlen(query);
+	hash = G_GUINT64_CONSTANT(0xcbf29ce484222325) ^ length;
+
+	for (i = 0; i + sizeof(word) <= length; i += sizeof(word))
+	{
+		memcpy(&word, query + i, sizeof(word));
+		hash = (hash ^ word) * G_GUINT64_CONSTANT(0x9e3779b97f4a7c15);
+		hash ^= hash >> 32;
+	}
+
+	word = 0;
+	memcpy(&word, query + i, length - i);
+	hash = (hash ^ word) * G_GUINT64_CONSTANT(0x9e3779b97f4a7c15);
+	hash ^= hash >> 32;
+
+	return (guint)hash;
+}
+
+/**
+ * Evicts the least recently used statements until the statement cache is not larger than SQL_STATEMENT_CACHE_SIZE.
+ **/
+static void
+sql_statement_cache_evict(JThreadVariables* thread_variables)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GList* link = thread_variables->statements.tail;
+
+	while (thread_variables->statements.length > SQL_STATEMENT_CACHE_SIZE && link != NULL)
+	{
+		JSqlCacheSQLPrepared* prepared = link->data;
+
+		link = link->prev;
+
+		if (prepared->iterating)
+		{
+			continue;
+		}
+
+		// Removing the statement unlinks and frees it
+		g_hash_table_remove(prepared->queries->queries, prepared->query);
+		thread_variables->statistics.statements_evicted++;
+	}
+}
+
 static JSqlCacheSQLQueries*
 _getCachePrepared(gpointer backend_data, gchar const* namespace, gchar const* name, GError** error)
 {
@@ -285,7 +516,7 @@ _getCachePrepared(gpointer backend_data, gchar const* namespace, gchar const* na
 	if (!(cacheQueries = g_hash_table_lookup(cacheNames->names, name)))
 	{
 		cacheQueries = g_new0(JSqlCacheSQLQueries, 1);
-		cacheQueries->queries = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, freeJSqlCacheSQLPrepared);
+		cacheQueries->queries = g_hash_table_new_full(sql_statement_hash, g_str_equal, g_free, freeJSqlCacheSQLPrepared);
 		cacheQueries->types = NULL;
 
 		if (G_UNLIKELY(!g_hash_table_insert(cacheNames->names, g_strdup(name), cacheQueries)))
@@ -415,17 +646,37 @@ getCachePrepared(gpointer backend_data, gchar const* namespace, gchar const* nam
 		goto _error;
 	}
 
-	if (!(cachePrepared = g_hash_table_lookup(cacheQueries->queries, query)))
+	if ((cachePrepared = g_hash_table_lookup(cacheQueries->queries, query)) != NULL)
+	{
+		thread_variables->statistics.statements_hit++;
+
+		g_queue_unlink(&thread_variables->statements, &cachePrepared->lru);
+		g_queue_push_head_link(&thread_variables->statements, &cachePrepared->lru);
+	}
+	else
 	{
+		gchar* key;
+
+		thread_variables->statistics.statements_missed++;
+
+		key = g_strdup(query);
+
 		cachePrepared = g_new0(JSqlCacheSQLPrepared, 1);
 		cachePrepared->namespace = g_strdup(namespace);
 		cachePrepared->name = g_strdup(name);
 		cachePrepared->backend_data = backend_data;
+		cachePrepared->thread_variables = thread_variables;
+		cachePrepared->query = key;
+		cachePrepared->queries = cacheQueries;
+		cachePrepared->lru.data = cachePrepared;
 
-		if (G_UNLIKELY(!g_hash_table_insert(cacheQueries->queries, g_strdup(query), cachePrepared)))
+		if (G_UNLIKELY(!g_hash_table_insert(cacheQueries->queries, key, cachePrepared)))
 		{
 			g_assert_not_reached();
 		}
+
+		g_queue_push_head_link(&thread_variables->statements, &cachePrepared->lru);
+		sql_statement_cache_evict(thread_variables);
 	}
 
 	return cachePrepared;
@@ -476,7 +727,7 @@ _backend_batch_start(gpointer backend_data, JSqlBatch* batch, GError** error)
 		goto _error;
 	}
 
-	if (!j_sql_start_transaction(thread_variables->sql_backend, error))
+	if (!j_sql_start_transaction(thread_variables->sql_backend, batch->semantics, error))
 	{
 		goto _error;
 	}
@@ -499,6 +750,13 @@ _backend_batch_execute(gpointer backend_data, JSqlBatch* batch, GError** error)
 
 	g_return_val_if_fail(batch->open || (!batch->open && batch->aborted), FALSE);
 
+	// The transaction has already been rolled back, there is nothing to commit
+	if (batch->aborted)
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_FAILED, "batch aborted");
+		goto _error;
+	}
+
 	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, error))))
 	{
 		goto _error;
@@ -577,6 +835,8 @@ _error:
 	j_semantics_unref(batch->semantics);
 	g_free(batch);
 
+	sql_connection_release();
+
 	if (SQL_MODE == SQL_MODE_SINGLE_THREAD)
 		G_UNLOCK(sql_backend_lock);
 
@@ -600,6 +860,8 @@ backend_batch_execute(gpointer backend_data, gpointer _batch, GError** error)
 	j_semantics_unref(batch->semantics);
 	g_free(batch);
 
+	sql_connection_release();
+
 	if (SQL_MODE == SQL_MODE_SINGLE_THREAD)
 		G_UNLOCK(sql_backend_lock);
 
@@ -609,47 +871,137 @@ _error:
 	j_semantics_unref(batch->semantics);
 	g_free(batch);
 
+	sql_connection_release();
+
 	if (SQL_MODE == SQL_MODE_SINGLE_THREAD)
 		G_UNLOCK(sql_backend_lock);
 
 	return FALSE;
 }
 
+/**
+ * Appends an index's quoted name to sql and its comma-separated fields to columns.
+ * The name is derived from the fields, allowing an index to be deleted by specifying the same fields.
+ * It contains a hash of the schema and the fields, so that it does not exceed the databases' identifier lengths.
+ *
+ * \param[in]  schema_cache If not NULL, all fields have to be part of the schema since they are inserted into the statement.
+ * \param[out] fields       If not NULL, receives the fields.
+ **/
 static gboolean
-backend_schema_create(gpointer backend_data, gpointer _batch, gchar const* name, bson_t const* schema, GError** error)
+build_index_name(gchar const* namespace, gchar const* name, bson_iter_t* iter, GHashTable* schema_cache, GString* sql, GString* columns, GPtrArray* fields, GError** error)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JSqlCacheSQLPrepared* prepared = NULL;
-	JSqlBatch* batch = _batch;
-	bson_iter_t iter;
-	bson_iter_t iter_child;
-	bson_iter_t iter_child2;
-	JDBType type;
-	gboolean first;
-	guint i;
-	gboolean has_next;
-	gboolean equals;
-	guint counter = 0;
-	gboolean found_index = FALSE;
+	g_autoptr(GChecksum) checksum = NULL;
 	JDBTypeValue value;
-	const char* string_tmp;
-	GString* sql = g_string_new(NULL);
-	JThreadVariables* thread_variables = NULL;
-	g_autoptr(GArray) arr_types_in = NULL;
+	gboolean has_next;
+	gboolean first = TRUE;
 
-	g_return_val_if_fail(name != NULL, FALSE);
-	g_return_val_if_fail(batch != NULL, FALSE);
-	g_return_val_if_fail(schema != NULL, FALSE);
+	checksum = g_checksum_new(G_CHECKSUM_SHA1);
 
-	arr_types_in = g_array_new(FALSE, FALSE, sizeof(JDBType));
+	// Include the terminating null bytes, so that the fields cannot be confused with each other
+	g_checksum_update(checksum, (guchar const*)namespace, strlen(namespace) + 1);
+	g_checksum_update(checksum, (guchar const*)name, strlen(name) + 1);
 
-	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, error))))
+	while (TRUE)
+	{
+		if (G_UNLIKELY(!j_bson_iter_next(iter, &has_next, error)))
+		{
+			goto _error;
+		}
+
+		if (!has_next)
+		{
+			break;
+		}
+
+		if (G_UNLIKELY(!j_bson_iter_value(iter, J_DB_TYPE_STRING, &value, error)))
+		{
+			goto _error;
+		}
+
+		if (G_UNLIKELY(schema_cache != NULL && !g_hash_table_contains(schema_cache, value.val_string)))
+		{
+			g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_VARIABLE_NOT_FOUND, "variable not found");
+			goto _error;
+		}
+
+		g_checksum_update(checksum, (guchar const*)value.val_string, strlen(value.val_string) + 1);
+
+		if (columns != NULL)
+		{
+			g_string_append_printf(columns, "%s%s", (first) ? "" : ", ", value.val_string);
+		}
+
+		if (fields != NULL)
+		{
+			g_ptr_array_add(fields, (gpointer)value.val_string);
+		}
+
+		first = FALSE;
+	}
+
+	if (G_UNLIKELY(first))
 	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_NO_VARIABLE_SET, "no variable set");
 		goto _error;
 	}
 
-	prepared = getCachePrepared(backend_data, batch->namespace, name, "_schema_create", error);
+	g_string_append_printf(sql, SQL_QUOTE "index_%s" SQL_QUOTE, g_checksum_get_string(checksum));
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
+/**
+ * Returns whether an index has been named by a previous version of build_index_name.
+ * These indexes were created with a schema and named after the schema and their position.
+ **/
+static gboolean
+index_name_is_legacy(gchar const* namespace, gchar const* name, gchar const* index_name)
+{
+	g_autofree gchar* prefix = NULL;
+	gchar const* suffix;
+
+	prefix = g_strdup_printf("%s_%s_", namespace, name);
+
+	if (!g_str_has_prefix(index_name, prefix))
+	{
+		return FALSE;
+	}
+
+	suffix = index_name + strlen(prefix);
+
+	return (suffix[0] != '\0' && strspn(suffix, "0123456789") == strlen(suffix));
+}
+
+/**
+ * Looks up the name of an index on fields that has been named by a previous version of build_index_name.
+ * The database's catalog is searched for an index on exactly these fields.
+ *
+ * \param[out] sql    Receives the index's quoted name if it exists.
+ * \param[out] exists Receives whether such an index exists.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+find_legacy_index_name(gpointer backend_data, JThreadVariables* thread_variables, JSqlBatch* batch, gchar const* name, GPtrArray* fields, GString* sql, gboolean* exists, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JSqlCacheSQLPrepared* prepared = NULL;
+	g_autofree gchar* table = NULL;
+	g_autofree gchar* current = NULL;
+	g_autofree gchar* match = NULL;
+	JDBTypeValue value;
+	gboolean found;
+	gboolean equal = FALSE;
+	guint column = 0;
+
+	*exists = FALSE;
+	prepared = getCachePrepared(backend_data, batch->namespace, name, "_index_columns", error);
 
 	if (G_UNLIKELY(!prepared))
 	{
@@ -658,14 +1010,17 @@ backend_schema_create(gpointer backend_data, gpointer _batch, gchar const* name,
 
 	if (!prepared->initialized)
 	{
-		type = J_DB_TYPE_STRING;
-		g_array_append_val(arr_types_in, type);
-		g_array_append_val(arr_types_in, type);
-		g_array_append_val(arr_types_in, type);
-		type = J_DB_TYPE_UINT32;
+		g_autoptr(GArray) arr_types_in = NULL;
+		g_autoptr(GArray) arr_types_out = NULL;
+		JDBType type = J_DB_TYPE_STRING;
+
+		arr_types_in = g_array_new(FALSE, FALSE, sizeof(JDBType));
+		arr_types_out = g_array_new(FALSE, FALSE, sizeof(JDBType));
 		g_array_append_val(arr_types_in, type);
+		g_array_append_val(arr_types_out, type);
+		g_array_append_val(arr_types_out, type);
 
-		if (G_UNLIKELY(!j_sql_prepare(thread_variables->sql_backend, "INSERT INTO schema_structure(namespace, name, varname, vartype) VALUES (?, ?, ?, ?)", &prepared->stmt, arr_types_in, NULL, error)))
+		if (G_UNLIKELY(!j_sql_prepare(thread_variables->sql_backend, SQL_INDEX_COLUMNS_STRING, &prepared->stmt, arr_types_in, arr_types_out, error)))
 		{
 			goto _error;
 		}
@@ -673,39 +1028,173 @@ backend_schema_create(gpointer backend_data, gpointer _batch, gchar const* name,
 		prepared->initialized = TRUE;
 	}
 
-	if (G_UNLIKELY(!_backend_batch_execute(backend_data, batch, error)))
-	{
-		//no ddl in transaction - most databases wont support that - continue without any open transaction
-		goto _error;
-	}
-
-	g_string_append_printf(sql, "CREATE TABLE " SQL_QUOTE "%s_%s" SQL_QUOTE " ( _id INTEGER " SQL_AUTOINCREMENT_STRING " PRIMARY KEY", batch->namespace, name);
+	table = g_strdup_printf("%s_%s", batch->namespace, name);
+	value.val_string = table;
 
-	if (G_UNLIKELY(!j_bson_iter_init(&iter, schema, error)))
+	if (G_UNLIKELY(!j_sql_bind_value(thread_variables->sql_backend, prepared->stmt, 1, J_DB_TYPE_STRING, &value, error)))
 	{
 		goto _error;
 	}
 
-	while (TRUE)
+	// The rows are sorted by index and by the columns' positions within the index
+	while (match == NULL)
 	{
-		if (G_UNLIKELY(!j_bson_iter_next(&iter, &has_next, error)))
+		if (G_UNLIKELY(!j_sql_step(thread_variables->sql_backend, prepared->stmt, &found, error)))
 		{
 			goto _error;
 		}
 
-		if (!has_next)
+		if (found)
 		{
-			break;
+			if (G_UNLIKELY(!j_sql_column(thread_variables->sql_backend, prepared->stmt, 0, J_DB_TYPE_STRING, &value, error)))
+			{
+				goto _error;
+			}
 		}
 
-		if (G_UNLIKELY(!j_bson_iter_key_equals(&iter, "_index", &equals, error)))
+		if (!found || g_strcmp0(current, value.val_string) != 0)
 		{
-			goto _error;
-		}
+			if (current != NULL && equal && column == fields->len && index_name_is_legacy(batch->namespace, name, current))
+			{
+				match = g_steal_pointer(&current);
+			}
 
-		if (equals)
-		{
-			found_index = TRUE;
+			if (!found)
+			{
+				break;
+			}
+
+			g_free(current);
+			current = g_strdup(value.val_string);
+			equal = TRUE;
+			column = 0;
+		}
+
+		if (G_UNLIKELY(!j_sql_column(thread_variables->sql_backend, prepared->stmt, 1, J_DB_TYPE_STRING, &value, error)))
+		{
+			goto _error;
+		}
+
+		equal = equal && column < fields->len && g_strcmp0(value.val_string, g_ptr_array_index(fields, column)) == 0;
+		column++;
+	}
+
+	if (G_UNLIKELY(!j_sql_reset(thread_variables->sql_backend, prepared->stmt, error)))
+	{
+		goto _error;
+	}
+
+	if (match != NULL)
+	{
+		g_string_append_printf(sql, SQL_QUOTE "%s" SQL_QUOTE, match);
+		*exists = TRUE;
+	}
+
+	return TRUE;
+
+_error:
+	if (prepared != NULL && prepared->initialized)
+	{
+		j_sql_reset(thread_variables->sql_backend, prepared->stmt, NULL);
+	}
+
+	return FALSE;
+}
+
+static gboolean
+backend_schema_create(gpointer backend_data, gpointer _batch, gchar const* name, bson_t const* schema, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JSqlCacheSQLPrepared* prepared = NULL;
+	JSqlBatch* batch = _batch;
+	bson_iter_t iter;
+	bson_iter_t iter_child;
+	bson_iter_t iter_child2;
+	JDBType type;
+	gboolean has_next;
+	gboolean equals;
+	guint counter = 0;
+	gboolean found_index = FALSE;
+	JDBTypeValue value;
+	GString* sql = g_string_new(NULL);
+	GString* columns = NULL;
+	JThreadVariables* thread_variables = NULL;
+	g_autoptr(GArray) arr_types_in = NULL;
+
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(batch != NULL, FALSE);
+	g_return_val_if_fail(schema != NULL, FALSE);
+
+	arr_types_in = g_array_new(FALSE, FALSE, sizeof(JDBType));
+
+	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, error))))
+	{
+		goto _error;
+	}
+
+	prepared = getCachePrepared(backend_data, batch->namespace, name, "_schema_create", error);
+
+	if (G_UNLIKELY(!prepared))
+	{
+		goto _error;
+	}
+
+	if (!prepared->initialized)
+	{
+		type = J_DB_TYPE_STRING;
+		g_array_append_val(arr_types_in, type);
+		g_array_append_val(arr_types_in, type);
+		g_array_append_val(arr_types_in, type);
+		type = J_DB_TYPE_UINT32;
+		g_array_append_val(arr_types_in, type);
+
+		if (G_UNLIKELY(!j_sql_prepare(thread_variables->sql_backend, "INSERT INTO schema_structure(namespace, name, varname, vartype) VALUES (?, ?, ?, ?)", &prepared->stmt, arr_types_in, NULL, error)))
+		{
+			goto _error;
+		}
+
+		prepared->initialized = TRUE;
+	}
+
+	if (G_UNLIKELY(!_backend_batch_execute(backend_data, batch, error)))
+	{
+		//no ddl in transaction - most databases wont support that - continue without any open transaction
+		goto _error;
+	}
+
+	g_string_append_printf(sql, "CREATE TABLE " SQL_QUOTE "%s_%s" SQL_QUOTE " ( _id INTEGER " SQL_AUTOINCREMENT_STRING " PRIMARY KEY", batch->namespace, name);
+
+	if (sql_id_base > 1)
+	{
+		g_string_append(sql, SQL_ID_RANGE_STRING);
+	}
+
+	if (G_UNLIKELY(!j_bson_iter_init(&iter, schema, error)))
+	{
+		goto _error;
+	}
+
+	while (TRUE)
+	{
+		if (G_UNLIKELY(!j_bson_iter_next(&iter, &has_next, error)))
+		{
+			goto _error;
+		}
+
+		if (!has_next)
+		{
+			break;
+		}
+
+		if (G_UNLIKELY(!j_bson_iter_key_equals(&iter, "_index", &equals, error)))
+		{
+			goto _error;
+		}
+
+		if (equals)
+		{
+			found_index = TRUE;
 		}
 		else
 		{
@@ -766,6 +1255,17 @@ backend_schema_create(gpointer backend_data, gpointer _batch, gchar const* name,
 		goto _error;
 	}
 
+	if (sql_id_base > 1)
+	{
+		g_string_truncate(sql, 0);
+		g_string_append_printf(sql, SQL_ID_BASE_STRING, batch->namespace, name, sql_id_base);
+
+		if (G_UNLIKELY(!j_sql_exec(thread_variables->sql_backend, sql->str, error)))
+		{
+			goto _error;
+		}
+	}
+
 	if (sql)
 	{
 		g_string_free(sql, TRUE);
@@ -774,8 +1274,6 @@ backend_schema_create(gpointer backend_data, gpointer _batch, gchar const* name,
 
 	if (found_index)
 	{
-		i = 0;
-
 		if (G_UNLIKELY(!j_bson_iter_init(&iter, schema, error)))
 		{
 			goto _error;
@@ -803,47 +1301,22 @@ backend_schema_create(gpointer backend_data, gpointer _batch, gchar const* name,
 				break;
 			}
 
-			sql = g_string_new(NULL);
-			first = TRUE;
-
-			g_string_append_printf(sql, "CREATE INDEX " SQL_QUOTE "%s_%s_%d" SQL_QUOTE " ON " SQL_QUOTE "%s_%s" SQL_QUOTE " ( ", batch->namespace, name, i, batch->namespace, name);
-
 			if (G_UNLIKELY(!j_bson_iter_recurse_array(&iter_child, &iter_child2, error)))
 			{
 				goto _error;
 			}
 
-			while (TRUE)
-			{
-				if (G_UNLIKELY(!j_bson_iter_next(&iter_child2, &has_next, error)))
-				{
-					goto _error;
-				}
-
-				if (!has_next)
-				{
-					break;
-				}
-
-				if (first)
-				{
-					first = FALSE;
-				}
-				else
-				{
-					g_string_append(sql, ", ");
-				}
-
-				if (G_UNLIKELY(!j_bson_iter_value(&iter_child2, J_DB_TYPE_STRING, &value, error)))
-				{
-					goto _error;
-				}
+			sql = g_string_new("CREATE INDEX ");
+			columns = g_string_new(NULL);
 
-				string_tmp = value.val_string;
-				g_string_append_printf(sql, "%s", string_tmp);
+			if (G_UNLIKELY(!build_index_name(batch->namespace, name, &iter_child2, NULL, sql, columns, NULL, error)))
+			{
+				goto _error;
 			}
 
-			g_string_append(sql, " )");
+			g_string_append_printf(sql, " ON " SQL_QUOTE "%s_%s" SQL_QUOTE " ( %s )", batch->namespace, name, columns->str);
+			g_string_free(columns, TRUE);
+			columns = NULL;
 
 			if (G_UNLIKELY(!j_sql_exec(thread_variables->sql_backend, sql->str, error)))
 			{
@@ -855,8 +1328,6 @@ backend_schema_create(gpointer backend_data, gpointer _batch, gchar const* name,
 				g_string_free(sql, TRUE);
 				sql = NULL;
 			}
-
-			i++;
 		}
 	}
 
@@ -978,6 +1449,11 @@ _error:
 		g_string_free(sql, TRUE);
 	}
 
+	if (columns)
+	{
+		g_string_free(columns, TRUE);
+	}
+
 	return FALSE;
 }
 
@@ -1244,132 +1720,291 @@ _error2:
 	return FALSE;
 }
 
+/**
+ * Creates an index on an existing table.
+ * Most databases do not support DDL within transactions, so the batch's pending operations are committed first.
+ * Databases supporting online DDL build the index without blocking concurrent writes (see SQL_INDEX_ONLINE_STRING).
+ **/
 static gboolean
-backend_insert(gpointer backend_data, gpointer _batch, gchar const* name, bson_t const* metadata, bson_t* id, GError** error)
+backend_index_create(gpointer backend_data, gpointer _batch, gchar const* name, bson_t const* index, GError** error)
 {
 	J_TRACE_FUNCTION(NULL);
 
 	JSqlBatch* batch = _batch;
-	guint i;
-	bson_iter_t iter;
-	gpointer type_tmp;
-	JDBType type;
-	GHashTableIter schema_iter;
-	GHashTable* schema_cache = NULL;
-	const char* string_tmp;
-	gboolean found;
-	JSqlCacheSQLPrepared* prepared = NULL;
-	JSqlCacheSQLPrepared* prepared_id = NULL;
 	JThreadVariables* thread_variables = NULL;
-	g_autoptr(GArray) arr_types_in = NULL;
-	g_autoptr(GArray) id_arr_types_out = NULL;
-	gboolean has_next;
-	guint index;
-	guint count = 0;
-	JDBTypeValue value;
+	GHashTable* schema_cache;
+	bson_iter_t iter;
+	g_autoptr(GString) sql = NULL;
+	g_autoptr(GString) columns = NULL;
 
 	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(index != NULL, FALSE);
 	g_return_val_if_fail(batch != NULL, FALSE);
-	g_return_val_if_fail(metadata != NULL, FALSE);
 
-	arr_types_in = g_array_new(FALSE, FALSE, sizeof(JDBType));
-	id_arr_types_out = g_array_new(FALSE, FALSE, sizeof(JDBType));
+	sql = g_string_new("CREATE INDEX ");
+	columns = g_string_new(NULL);
 
 	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, error))))
 	{
 		goto _error;
 	}
 
-	if (G_UNLIKELY(!j_bson_has_enough_keys(metadata, 1, error)))
+	if (G_UNLIKELY(!(schema_cache = getCacheSchema(backend_data, batch, name, error))))
 	{
 		goto _error;
 	}
 
-	prepared_id = getCachePrepared(backend_data, batch->namespace, name, "_insert_id", error);
-
-	if (G_UNLIKELY(!prepared_id))
+	if (G_UNLIKELY(!j_bson_iter_init(&iter, index, error)))
 	{
 		goto _error;
 	}
 
-	if (!prepared_id->initialized)
+	if (G_UNLIKELY(!build_index_name(batch->namespace, name, &iter, schema_cache, sql, columns, NULL, error)))
 	{
-		type = J_DB_TYPE_UINT32;
-		g_array_append_val(id_arr_types_out, type);
-
-		if (G_UNLIKELY(!j_sql_prepare(thread_variables->sql_backend, SQL_LAST_INSERT_ID_STRING, &prepared_id->stmt, NULL, id_arr_types_out, error)))
-		{
-			goto _error;
-		}
-
-		prepared_id->initialized = TRUE;
+		goto _error;
 	}
 
-	prepared = getCachePrepared(backend_data, batch->namespace, name, "_insert", error);
+	g_string_append_printf(sql, " ON " SQL_QUOTE "%s_%s" SQL_QUOTE " ( %s )" SQL_INDEX_ONLINE_STRING, batch->namespace, name, columns->str);
 
-	if (G_UNLIKELY(!prepared))
+	if (G_UNLIKELY(!_backend_batch_execute(backend_data, batch, error)))
 	{
 		goto _error;
 	}
 
-	if (!(schema_cache = getCacheSchema(backend_data, batch, name, error)))
+	if (G_UNLIKELY(!j_sql_exec(thread_variables->sql_backend, sql->str, error)))
 	{
 		goto _error;
 	}
 
-	if (!prepared->initialized)
+	if (G_UNLIKELY(!_backend_batch_start(backend_data, batch, error)))
 	{
-		gchar* key;
-
-		prepared->sql = g_string_new(NULL);
-		prepared->variables_count = 0;
-		prepared->variables_index = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
-		g_string_append_printf(prepared->sql, "INSERT INTO " SQL_QUOTE "%s_%s" SQL_QUOTE " (", batch->namespace, name);
-		g_hash_table_iter_init(&schema_iter, schema_cache);
+		goto _error;
+	}
 
-		while (g_hash_table_iter_next(&schema_iter, (gpointer*)&key, &type_tmp))
-		{
-			type = GPOINTER_TO_INT(type_tmp);
+	return TRUE;
 
-			if (prepared->variables_count)
-			{
-				g_string_append(prepared->sql, ", ");
-			}
+_error:
+	if (!batch->open)
+	{
+		_backend_batch_start(backend_data, batch, NULL);
+	}
 
-			prepared->variables_count++;
-			g_string_append_printf(prepared->sql, "%s", key);
-			g_array_append_val(arr_types_in, type);
-			g_hash_table_insert(prepared->variables_index, g_strdup(key), GINT_TO_POINTER(prepared->variables_count));
-		}
+	return FALSE;
+}
 
-		g_string_append(prepared->sql, ") VALUES (");
+/**
+ * Deletes an index that has been created with the same fields, either using backend_index_create or when creating the schema.
+ * Indexes named by previous versions are found using the database's catalog.
+ **/
+static gboolean
+backend_index_delete(gpointer backend_data, gpointer _batch, gchar const* name, bson_t const* index, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
 
-		if (prepared->variables_count)
-		{
-			g_string_append_printf(prepared->sql, " ?");
-		}
+	JSqlBatch* batch = _batch;
+	JThreadVariables* thread_variables = NULL;
+	GHashTable* schema_cache;
+	bson_iter_t iter;
+	g_autoptr(GString) sql = NULL;
+	g_autoptr(GString) legacy_sql = NULL;
+	g_autoptr(GPtrArray) fields = NULL;
+	gboolean legacy;
 
-		for (i = 1; i < prepared->variables_count; i++)
-		{
-			g_string_append_printf(prepared->sql, ", ?");
-		}
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(index != NULL, FALSE);
+	g_return_val_if_fail(batch != NULL, FALSE);
 
-		g_string_append(prepared->sql, " )");
+	sql = g_string_new("DROP INDEX ");
+	legacy_sql = g_string_new("DROP INDEX ");
+	fields = g_ptr_array_new();
 
-		if (G_UNLIKELY(!j_sql_prepare(thread_variables->sql_backend, prepared->sql->str, &prepared->stmt, arr_types_in, NULL, error)))
-		{
-			goto _error;
-		}
+	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, error))))
+	{
+		goto _error;
+	}
 
-		prepared->initialized = TRUE;
+	if (G_UNLIKELY(!(schema_cache = getCacheSchema(backend_data, batch, name, error))))
+	{
+		goto _error;
 	}
 
-	if (G_UNLIKELY(!j_bson_iter_init(&iter, metadata, error)))
+	if (G_UNLIKELY(!j_bson_iter_init(&iter, index, error)))
 	{
 		goto _error;
 	}
 
-	for (i = 0; i < prepared->variables_count; i++)
+	if (G_UNLIKELY(!build_index_name(batch->namespace, name, &iter, schema_cache, sql, NULL, fields, error)))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!find_legacy_index_name(backend_data, thread_variables, batch, name, fields, legacy_sql, &legacy, error)))
+	{
+		goto _error;
+	}
+
+	if (legacy)
+	{
+		g_string_assign(sql, legacy_sql->str);
+	}
+
+	if (SQL_INDEX_DROP_ON_TABLE)
+	{
+		g_string_append_printf(sql, " ON " SQL_QUOTE "%s_%s" SQL_QUOTE SQL_INDEX_ONLINE_STRING, batch->namespace, name);
+	}
+
+	if (G_UNLIKELY(!_backend_batch_execute(backend_data, batch, error)))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!j_sql_exec(thread_variables->sql_backend, sql->str, error)))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!_backend_batch_start(backend_data, batch, error)))
+	{
+		goto _error;
+	}
+
+	return TRUE;
+
+_error:
+	if (!batch->open)
+	{
+		_backend_batch_start(backend_data, batch, NULL);
+	}
+
+	return FALSE;
+}
+
+static gboolean
+backend_insert(gpointer backend_data, gpointer _batch, gchar const* name, bson_t const* metadata, bson_t* id, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JSqlBatch* batch = _batch;
+	guint i;
+	bson_iter_t iter;
+	gpointer type_tmp;
+	JDBType type;
+	GHashTableIter schema_iter;
+	GHashTable* schema_cache = NULL;
+	const char* string_tmp;
+	gboolean found;
+	JSqlCacheSQLPrepared* prepared = NULL;
+	JSqlCacheSQLPrepared* prepared_id = NULL;
+	JThreadVariables* thread_variables = NULL;
+	g_autoptr(GArray) arr_types_in = NULL;
+	g_autoptr(GArray) id_arr_types_out = NULL;
+	gboolean has_next;
+	guint index;
+	guint count = 0;
+	JDBTypeValue value;
+
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(batch != NULL, FALSE);
+	g_return_val_if_fail(metadata != NULL, FALSE);
+
+	arr_types_in = g_array_new(FALSE, FALSE, sizeof(JDBType));
+	id_arr_types_out = g_array_new(FALSE, FALSE, sizeof(JDBType));
+
+	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, error))))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!j_bson_has_enough_keys(metadata, 1, error)))
+	{
+		goto _error;
+	}
+
+	prepared_id = getCachePrepared(backend_data, batch->namespace, name, "_insert_id", error);
+
+	if (G_UNLIKELY(!prepared_id))
+	{
+		goto _error;
+	}
+
+	if (!prepared_id->initialized)
+	{
+		type = J_DB_TYPE_UINT32;
+		g_array_append_val(id_arr_types_out, type);
+
+		if (G_UNLIKELY(!j_sql_prepare(thread_variables->sql_backend, SQL_LAST_INSERT_ID_STRING, &prepared_id->stmt, NULL, id_arr_types_out, error)))
+		{
+			goto _error;
+		}
+
+		prepared_id->initialized = TRUE;
+	}
+
+	prepared = getCachePrepared(backend_data, batch->namespace, name, "_insert", error);
+
+	if (G_UNLIKELY(!prepared))
+	{
+		goto _error;
+	}
+
+	if (!(schema_cache = getCacheSchema(backend_data, batch, name, error)))
+	{
+		goto _error;
+	}
+
+	if (!prepared->initialized)
+	{
+		gchar* key;
+
+		prepared->sql = g_string_new(NULL);
+		prepared->variables_count = 0;
+		prepared->variables_index = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+		g_string_append_printf(prepared->sql, "INSERT INTO " SQL_QUOTE "%s_%s" SQL_QUOTE " (", batch->namespace, name);
+		g_hash_table_iter_init(&schema_iter, schema_cache);
+
+		while (g_hash_table_iter_next(&schema_iter, (gpointer*)&key, &type_tmp))
+		{
+			type = GPOINTER_TO_INT(type_tmp);
+
+			if (prepared->variables_count)
+			{
+				g_string_append(prepared->sql, ", ");
+			}
+
+			prepared->variables_count++;
+			g_string_append_printf(prepared->sql, "%s", key);
+			g_array_append_val(arr_types_in, type);
+			g_hash_table_insert(prepared->variables_index, g_strdup(key), GINT_TO_POINTER(prepared->variables_count));
+		}
+
+		g_string_append(prepared->sql, ") VALUES (");
+
+		if (prepared->variables_count)
+		{
+			g_string_append_printf(prepared->sql, " ?");
+		}
+
+		for (i = 1; i < prepared->variables_count; i++)
+		{
+			g_string_append_printf(prepared->sql, ", ?");
+		}
+
+		g_string_append(prepared->sql, " )");
+
+		if (G_UNLIKELY(!j_sql_prepare(thread_variables->sql_backend, prepared->sql->str, &prepared->stmt, arr_types_in, NULL, error)))
+		{
+			goto _error;
+		}
+
+		prepared->initialized = TRUE;
+	}
+
+	if (G_UNLIKELY(!j_bson_iter_init(&iter, metadata, error)))
+	{
+		goto _error;
+	}
+
+	for (i = 0; i < prepared->variables_count; i++)
 	{
 		if (G_UNLIKELY(!j_sql_bind_null(thread_variables->sql_backend, prepared->stmt, i + 1, error)))
 		{
@@ -1477,47 +2112,656 @@ _error2:
 	return FALSE;
 }
 
+/**
+ * The maximum number of entries inserted by a single statement.
+ **/
+#define SQL_INSERT_MANY_ROWS 256
+
+/**
+ * Inserts multiple entries using multi-row INSERT statements.
+ * The entries of a statement receive consecutive IDs, the first one is queried after each statement.
+ **/
 static gboolean
-build_selector_query(gpointer backend_data, bson_iter_t* iter, GString* sql, JDBSelectorMode mode, guint* variables_count, GArray* arr_types_in, GHashTable* schema_cache, GError** error)
+backend_insert_many(gpointer backend_data, gpointer _batch, gchar const* name, bson_t const* metadata, guint count, bson_t* ids, GError** error)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JDBSelectorMode mode_child;
-	gboolean equals;
-	gboolean has_next;
-	JDBSelectorOperator op;
-	gboolean first = TRUE;
+	JSqlBatch* batch = _batch;
+	bson_iter_t iter;
+	gpointer type_tmp;
+	JDBType type;
+	GHashTableIter schema_iter;
+	GHashTable* schema_cache = NULL;
 	const char* string_tmp;
-	JDBTypeValue value;
-	bson_iter_t iterchild;
+	gboolean found;
+	JSqlCacheSQLPrepared* prepared = NULL;
+	JSqlCacheSQLPrepared* prepared_id = NULL;
 	JThreadVariables* thread_variables = NULL;
-	JDBType type;
+	gboolean has_next;
+	guint rows_max;
+	guint done = 0;
+	JDBTypeValue value;
+
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(batch != NULL, FALSE);
+	g_return_val_if_fail(metadata != NULL, FALSE);
+	g_return_val_if_fail(ids != NULL, FALSE);
 
 	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, error))))
 	{
 		goto _error;
 	}
 
-	g_string_append(sql, "( ");
+	if (!(schema_cache = getCacheSchema(backend_data, batch, name, error)))
+	{
+		goto _error;
+	}
 
-	while (TRUE)
+	rows_max = CLAMP(SQL_MAX_VARIABLES / MAX(g_hash_table_size(schema_cache), 1), 1, SQL_INSERT_MANY_ROWS);
+
+	prepared_id = getCachePrepared(backend_data, batch->namespace, name, "_insert_first_id", error);
+
+	if (G_UNLIKELY(!prepared_id))
 	{
-		if (G_UNLIKELY(!j_bson_iter_next(iter, &has_next, error)))
+		goto _error;
+	}
+
+	if (!prepared_id->initialized)
+	{
+		g_autoptr(GArray) id_arr_types_out = NULL;
+
+		id_arr_types_out = g_array_new(FALSE, FALSE, sizeof(JDBType));
+		type = J_DB_TYPE_UINT32;
+		g_array_append_val(id_arr_types_out, type);
+
+		if (G_UNLIKELY(!j_sql_prepare(thread_variables->sql_backend, SQL_FIRST_INSERT_ID_STRING, &prepared_id->stmt, NULL, id_arr_types_out, error)))
 		{
 			goto _error;
 		}
 
-		if (!has_next)
+		prepared_id->initialized = TRUE;
+	}
+
+	while (done < count)
+	{
+		g_autofree gchar* key = NULL;
+		guint rows;
+		guint32 first;
+
+		rows = MIN(count - done, rows_max);
+
+		// Statements are cached per number of rows, so at most rows_max statements exist per schema
+		key = g_strdup_printf("_insert_many_%u", rows);
+		prepared = getCachePrepared(backend_data, batch->namespace, name, key, error);
+
+		if (G_UNLIKELY(!prepared))
 		{
-			break;
+			goto _error;
+		}
+
+		if (!prepared->initialized)
+		{
+			g_autoptr(GArray) arr_types_in = NULL;
+			gchar* column;
+
+			arr_types_in = g_array_new(FALSE, FALSE, sizeof(JDBType));
+			prepared->sql = g_string_new(NULL);
+			prepared->variables_count = 0;
+			prepared->variables_index = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+			g_string_append_printf(prepared->sql, "INSERT INTO " SQL_QUOTE "%s_%s" SQL_QUOTE " (", batch->namespace, name);
+			g_hash_table_iter_init(&schema_iter, schema_cache);
+
+			while (g_hash_table_iter_next(&schema_iter, (gpointer*)&column, &type_tmp))
+			{
+				if (prepared->variables_count)
+				{
+					g_string_append(prepared->sql, ", ");
+				}
+
+				prepared->variables_count++;
+				g_string_append_printf(prepared->sql, "%s", column);
+				g_hash_table_insert(prepared->variables_index, g_strdup(column), GINT_TO_POINTER(prepared->variables_count));
+			}
+
+			g_string_append(prepared->sql, ") VALUES ");
+
+			for (guint r = 0; r < rows; r++)
+			{
+				g_string_append(prepared->sql, (r > 0) ? ", (" : "(");
+				g_hash_table_iter_init(&schema_iter, schema_cache);
+
+				for (guint c = 0; g_hash_table_iter_next(&schema_iter, NULL, &type_tmp); c++)
+				{
+					type = GPOINTER_TO_INT(type_tmp);
+					g_string_append(prepared->sql, (c > 0) ? ", ?" : "?");
+					g_array_append_val(arr_types_in, type);
+				}
+
+				g_string_append(prepared->sql, ")");
+			}
+
+			if (G_UNLIKELY(!j_sql_prepare(thread_variables->sql_backend, prepared->sql->str, &prepared->stmt, arr_types_in, NULL, error)))
+			{
+				goto _error;
+			}
+
+			prepared->initialized = TRUE;
+		}
+
+		for (guint i = 0; i < rows * prepared->variables_count; i++)
+		{
+			if (G_UNLIKELY(!j_sql_bind_null(thread_variables->sql_backend, prepared->stmt, i + 1, error)))
+			{
+				goto _error;
+			}
+		}
+
+		for (guint r = 0; r < rows; r++)
+		{
+			guint fields = 0;
+
+			if (G_UNLIKELY(!j_bson_iter_init(&iter, &metadata[done + r], error)))
+			{
+				goto _error;
+			}
+
+			while (TRUE)
+			{
+				guint index;
+
+				if (G_UNLIKELY(!j_bson_iter_next(&iter, &has_next, error)))
+				{
+					goto _error;
+				}
+
+				if (!has_next)
+				{
+					break;
+				}
+
+				string_tmp = j_bson_iter_key(&iter, error);
+
+				if (G_UNLIKELY(!string_tmp))
+				{
+					goto _error;
+				}
+
+				type = GPOINTER_TO_INT(g_hash_table_lookup(schema_cache, string_tmp));
+				index = GPOINTER_TO_INT(g_hash_table_lookup(prepared->variables_index, string_tmp));
+
+				if (G_UNLIKELY(!index))
+				{
+					g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_VARIABLE_NOT_FOUND, "variable not found");
+					goto _error;
+				}
+
+				fields++;
+
+				if (G_UNLIKELY(!j_bson_iter_value(&iter, type, &value, error)))
+				{
+					goto _error;
+				}
+
+				if (G_UNLIKELY(!j_sql_bind_value(thread_variables->sql_backend, prepared->stmt, r * prepared->variables_count + index, type, &value, error)))
+				{
+					goto _error;
+				}
+			}
+
+			if (G_UNLIKELY(!fields))
+			{
+				g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_NO_VARIABLE_SET, "no variable set");
+				goto _error;
+			}
+		}
+
+		if (G_UNLIKELY(!j_sql_step_and_reset_check_done(thread_variables->sql_backend, prepared->stmt, error)))
+		{
+			goto _error;
+		}
+
+		if (G_UNLIKELY(!j_sql_step(thread_variables->sql_backend, prepared_id->stmt, &found, error)))
+		{
+			goto _error;
+		}
+
+		if (!found)
+		{
+			g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS, "no more elements");
+			goto _error;
+		}
+
+		if (G_UNLIKELY(!j_sql_column(thread_variables->sql_backend, prepared_id->stmt, 0, J_DB_TYPE_UINT32, &value, error)))
+		{
+			goto _error;
+		}
+
+		if (G_UNLIKELY(!j_sql_reset(thread_variables->sql_backend, prepared_id->stmt, error)))
+		{
+			goto _error;
+		}
+
+		first = value.val_uint32;
+
+		for (guint r = 0; r < rows; r++)
+		{
+			value.val_uint32 = first + r;
+
+			if (G_UNLIKELY(!j_bson_append_value(&ids[done + r], "_value", J_DB_TYPE_UINT32, &value, error)))
+			{
+				goto _error;
+			}
+
+			value.val_uint32 = J_DB_TYPE_UINT32;
+
+			if (G_UNLIKELY(!j_bson_append_value(&ids[done + r], "_value_type", J_DB_TYPE_UINT32, &value, error)))
+			{
+				goto _error;
+			}
+		}
+
+		done += rows;
+	}
+
+	return TRUE;
+
+_error:
+	if (G_UNLIKELY(!_backend_batch_abort(backend_data, batch, NULL)))
+	{
+		goto _error2;
+	}
+
+	return FALSE;
+
+_error2:
+	/*something failed very hard*/
+	return FALSE;
+}
+
+/**
+ * Returns whether a selector's key belongs to an option like the mode or the projection instead of a condition.
+ **/
+static gboolean
+selector_key_is_option(bson_iter_t const* iter)
+{
+	return (bson_iter_key(iter)[0] == '_');
+}
+
+/**
+ * Returns whether a selector contains at least one condition.
+ **/
+static gboolean
+selector_has_conditions(bson_t const* selector)
+{
+	bson_iter_t iter;
+
+	if (selector == NULL || !bson_iter_init(&iter, selector))
+	{
+		return FALSE;
+	}
+
+	while (bson_iter_next(&iter))
+	{
+		if (!selector_key_is_option(&iter))
+		{
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
+
+/**
+ * Returns the number of placeholders used for an IN list.
+ * Lists are padded by repeating their last value, so that lists of similar length share a prepared statement.
+ **/
+static guint
+selector_in_placeholders(guint count)
+{
+	guint placeholders = 1;
+
+	if (count > 64)
+	{
+		return ((count + 63) / 64) * 64;
+	}
+
+	while (placeholders < count)
+	{
+		placeholders *= 2;
+	}
+
+	return placeholders;
+}
+
+/**
+ * Returns the number of values of an IN list.
+ **/
+static gboolean
+selector_in_count(bson_iter_t* iter, guint* count, GError** error)
+{
+	bson_iter_t iter_array;
+	gboolean has_next;
+
+	*count = 0;
+
+	if (G_UNLIKELY(!j_bson_iter_recurse_array(iter, &iter_array, error)))
+	{
+		goto _error;
+	}
+
+	while (TRUE)
+	{
+		if (G_UNLIKELY(!j_bson_iter_next(&iter_array, &has_next, error)))
+		{
+			goto _error;
+		}
+
+		if (!has_next)
+		{
+			break;
+		}
+
+		(*count)++;
+	}
+
+	if (G_UNLIKELY(*count == 0))
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_NO_VARIABLE_SET, "no variable set");
+		goto _error;
+	}
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
+/**
+ * Returns a LIKE pattern matching all strings starting with prefix.
+ * '!' is used as the escape character because the backslash is not an escape character in all backends.
+ **/
+static gchar*
+selector_prefix_pattern(gchar const* prefix)
+{
+	GString* pattern;
+
+	pattern = g_string_sized_new(strlen(prefix) + 2);
+
+	for (gchar const* c = prefix; *c != '\0'; c++)
+	{
+		if (*c == '%' || *c == '_' || *c == '!')
+		{
+			g_string_append_c(pattern, '!');
+		}
+
+		g_string_append_c(pattern, *c);
+	}
+
+	g_string_append_c(pattern, '%');
+
+	return g_string_free(pattern, FALSE);
+}
+
+/**
+ * Returns whether a name can be inserted into a statement as an identifier.
+ **/
+static gboolean
+name_is_identifier(gchar const* name)
+{
+	if (name == NULL || !g_ascii_isalpha(name[0]))
+	{
+		return FALSE;
+	}
+
+	for (guint i = 0; name[i] != '\0'; i++)
+	{
+		if (!g_ascii_isalnum(name[i]) && name[i] != '_')
+		{
+			return FALSE;
+		}
+	}
+
+	return TRUE;
+}
+
+/**
+ * Returns the SQL function of an aggregate.
+ **/
+static gchar const*
+aggregate_function(JDBSelectorAggregate aggregate)
+{
+	switch (aggregate)
+	{
+		case J_DB_SELECTOR_AGGREGATE_COUNT:
+			return "COUNT";
+		case J_DB_SELECTOR_AGGREGATE_SUM:
+			return "SUM";
+		case J_DB_SELECTOR_AGGREGATE_MIN:
+			return "MIN";
+		case J_DB_SELECTOR_AGGREGATE_MAX:
+			return "MAX";
+		case J_DB_SELECTOR_AGGREGATE_AVG:
+			return "AVG";
+		default:
+			return NULL;
+	}
+}
+
+/**
+ * Appends the grouping fields and aggregates of a selector to a query's column list.
+ * Aggregates are stored in the selector's "_aggregate" document as {_name, _function, _field, _type}, "_field" is missing for COUNT(*).
+ * Grouping fields are stored in the selector's "_group" document and also appended to the GROUP BY clause.
+ **/
+static gboolean
+build_aggregate_query(bson_t const* selector, GString* sql, GString* group_sql, guint* variables_count, GHashTable* variables_index, GArray* arr_types_out, GHashTable* aliases, GHashTable* schema_cache, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	bson_iter_t iter;
+	bson_iter_t iterchild;
+	bson_iter_t iteraggregate;
+	JDBTypeValue value;
+	JDBType type;
+	gpointer type_tmp;
+	gboolean has_next;
+
+	if (j_bson_iter_init(&iter, selector, NULL) && j_bson_iter_find(&iter, "_group", NULL))
+	{
+		if (G_UNLIKELY(!j_bson_iter_recurse_document(&iter, &iterchild, error)))
+		{
+			goto _error;
+		}
+
+		while (TRUE)
+		{
+			if (G_UNLIKELY(!j_bson_iter_next(&iterchild, &has_next, error)))
+			{
+				goto _error;
+			}
+
+			if (!has_next)
+			{
+				break;
+			}
+
+			if (G_UNLIKELY(!j_bson_iter_value(&iterchild, J_DB_TYPE_STRING, &value, error)))
+			{
+				goto _error;
+			}
+
+			if (G_UNLIKELY(!g_hash_table_lookup_extended(schema_cache, value.val_string, NULL, &type_tmp)))
+			{
+				g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_VARIABLE_NOT_FOUND, "variable not found");
+				goto _error;
+			}
+
+			type = GPOINTER_TO_INT(type_tmp);
+
+			g_string_append_printf(sql, "%s%s", (*variables_count > 0) ? ", " : "", value.val_string);
+			g_string_append_printf(group_sql, "%s%s", (group_sql->len > 0) ? ", " : "", value.val_string);
+			g_hash_table_insert(variables_index, GINT_TO_POINTER(*variables_count), g_strdup(value.val_string));
+			g_array_append_val(arr_types_out, type);
+			(*variables_count)++;
+		}
+	}
+
+	if (j_bson_iter_init(&iter, selector, NULL) && j_bson_iter_find(&iter, "_aggregate", NULL))
+	{
+		if (G_UNLIKELY(!j_bson_iter_recurse_document(&iter, &iterchild, error)))
+		{
+			goto _error;
+		}
+
+		while (TRUE)
+		{
+			gchar const* alias;
+			gchar const* field = NULL;
+			gchar const* function;
+
+			if (G_UNLIKELY(!j_bson_iter_next(&iterchild, &has_next, error)))
+			{
+				goto _error;
+			}
+
+			if (!has_next)
+			{
+				break;
+			}
+
+			if (G_UNLIKELY(!j_bson_iter_recurse_document(&iterchild, &iteraggregate, error)))
+			{
+				goto _error;
+			}
+
+			if (G_UNLIKELY(!j_bson_iter_find(&iteraggregate, "_name", error)))
+			{
+				goto _error;
+			}
+
+			if (G_UNLIKELY(!j_bson_iter_value(&iteraggregate, J_DB_TYPE_STRING, &value, error)))
+			{
+				goto _error;
+			}
+
+			alias = value.val_string;
+
+			// Aliases are inserted into the statement, so only plain identifiers are allowed
+			if (G_UNLIKELY(!name_is_identifier(alias) || g_hash_table_contains(schema_cache, alias) || g_hash_table_contains(aliases, alias)))
+			{
+				g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_VARIABLE_NOT_FOUND, "variable not found");
+				goto _error;
+			}
+
+			if (G_UNLIKELY(!j_bson_iter_recurse_document(&iterchild, &iteraggregate, error)))
+			{
+				goto _error;
+			}
+
+			if (G_UNLIKELY(!j_bson_iter_find(&iteraggregate, "_function", error)))
+			{
+				goto _error;
+			}
+
+			if (G_UNLIKELY(!j_bson_iter_value(&iteraggregate, J_DB_TYPE_UINT32, &value, error)))
+			{
+				goto _error;
+			}
+
+			if (G_UNLIKELY(!(function = aggregate_function(value.val_uint32))))
+			{
+				g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_OPERATOR_INVALID, "operator invalid");
+				goto _error;
+			}
+
+			if (G_UNLIKELY(!j_bson_iter_recurse_document(&iterchild, &iteraggregate, error)))
+			{
+				goto _error;
+			}
+
+			if (j_bson_iter_find(&iteraggregate, "_field", NULL))
+			{
+				if (G_UNLIKELY(!j_bson_iter_value(&iteraggregate, J_DB_TYPE_STRING, &value, error)))
+				{
+					goto _error;
+				}
+
+				field = value.val_string;
+
+				if (G_UNLIKELY(!g_hash_table_contains(schema_cache, field)))
+				{
+					g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_VARIABLE_NOT_FOUND, "variable not found");
+					goto _error;
+				}
+			}
+
+			if (G_UNLIKELY(!j_bson_iter_recurse_document(&iterchild, &iteraggregate, error)))
+			{
+				goto _error;
+			}
+
+			if (G_UNLIKELY(!j_bson_iter_find(&iteraggregate, "_type", error)))
+			{
+				goto _error;
+			}
+
+			if (G_UNLIKELY(!j_bson_iter_value(&iteraggregate, J_DB_TYPE_UINT32, &value, error)))
+			{
+				goto _error;
+			}
+
+			type = value.val_uint32;
+
+			g_string_append_printf(sql, "%s%s(%s) AS " SQL_QUOTE "%s" SQL_QUOTE, (*variables_count > 0) ? ", " : "", function, (field != NULL) ? field : "*", alias);
+			g_hash_table_insert(variables_index, GINT_TO_POINTER(*variables_count), g_strdup(alias));
+			g_hash_table_add(aliases, (gpointer)alias);
+			g_array_append_val(arr_types_out, type);
+			(*variables_count)++;
+		}
+	}
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
+static gboolean
+build_selector_query(gpointer backend_data, bson_iter_t* iter, GString* sql, JDBSelectorMode mode, guint* variables_count, GArray* arr_types_in, GHashTable* schema_cache, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBSelectorMode mode_child;
+	gboolean has_next;
+	JDBSelectorOperator op;
+	gboolean first = TRUE;
+	const char* string_tmp;
+	JDBTypeValue value;
+	bson_iter_t iterchild;
+	JThreadVariables* thread_variables = NULL;
+	JDBType type;
+	guint placeholders;
+	guint count;
+
+	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, error))))
+	{
+		goto _error;
+	}
+
+	g_string_append(sql, "( ");
+
+	while (TRUE)
+	{
+		if (G_UNLIKELY(!j_bson_iter_next(iter, &has_next, error)))
+		{
+			goto _error;
 		}
 
-		if (G_UNLIKELY(!j_bson_iter_key_equals(iter, "_mode", &equals, error)))
+		if (!has_next)
 		{
-			goto _error;
+			break;
 		}
 
-		if (equals)
+		if (selector_key_is_option(iter))
 		{
 			continue;
 		}
@@ -1595,7 +2839,7 @@ build_selector_query(gpointer backend_data, bson_iter_t* iter, GString* sql, JDB
 			}
 
 			type = GPOINTER_TO_INT(g_hash_table_lookup(schema_cache, string_tmp));
-			g_array_append_val(arr_types_in, type);
+			placeholders = 1;
 
 			if (G_UNLIKELY(!j_bson_iter_recurse_document(iter, &iterchild, error)))
 			{
@@ -1617,31 +2861,69 @@ build_selector_query(gpointer backend_data, bson_iter_t* iter, GString* sql, JDB
 			switch (op)
 			{
 				case J_DB_SELECTOR_OPERATOR_LT:
-					g_string_append(sql, "<");
+					g_string_append(sql, "< ?");
 					break;
 				case J_DB_SELECTOR_OPERATOR_LE:
-					g_string_append(sql, "<=");
+					g_string_append(sql, "<= ?");
 					break;
 				case J_DB_SELECTOR_OPERATOR_GT:
-					g_string_append(sql, ">");
+					g_string_append(sql, "> ?");
 					break;
 				case J_DB_SELECTOR_OPERATOR_GE:
-					g_string_append(sql, ">=");
+					g_string_append(sql, ">= ?");
 					break;
 				case J_DB_SELECTOR_OPERATOR_EQ:
-					g_string_append(sql, "=");
+					g_string_append(sql, "= ?");
 					break;
 				case J_DB_SELECTOR_OPERATOR_NE:
-					g_string_append(sql, "!=");
+					g_string_append(sql, "!= ?");
+					break;
+				case J_DB_SELECTOR_OPERATOR_IN:
+					if (G_UNLIKELY(!j_bson_iter_recurse_document(iter, &iterchild, error)))
+					{
+						goto _error;
+					}
+
+					if (G_UNLIKELY(!j_bson_iter_find(&iterchild, "_value", error)))
+					{
+						goto _error;
+					}
+
+					if (G_UNLIKELY(!selector_in_count(&iterchild, &count, error)))
+					{
+						goto _error;
+					}
+
+					placeholders = selector_in_placeholders(count);
+
+					g_string_append(sql, "IN ( ?");
+
+					for (guint i = 1; i < placeholders; i++)
+					{
+						g_string_append(sql, ", ?");
+					}
+
+					g_string_append(sql, " )");
+					break;
+				case J_DB_SELECTOR_OPERATOR_BETWEEN:
+					placeholders = 2;
+					g_string_append(sql, "BETWEEN ? AND ?");
+					break;
+				case J_DB_SELECTOR_OPERATOR_PREFIX:
+					// A constant prefix allows using an index
+					g_string_append(sql, "LIKE ? ESCAPE '!'");
 					break;
 				default:
 					g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_COMPARATOR_INVALID, "comparator invalid");
 					goto _error;
 			}
 
-			(*variables_count)++;
+			for (guint i = 0; i < placeholders; i++)
+			{
+				g_array_append_val(arr_types_in, type);
+			}
 
-			g_string_append_printf(sql, " ?");
+			(*variables_count) += placeholders;
 		}
 	}
 
@@ -1659,18 +2941,32 @@ _error:
 	return FALSE;
 }
 
+/**
+ * Frees the LIKE patterns bound to a statement before binding new values.
+ **/
+static void
+prepared_clear_patterns(JSqlCacheSQLPrepared* prepared)
+{
+	if (prepared->patterns != NULL)
+	{
+		g_ptr_array_set_size(prepared->patterns, 0);
+	}
+}
+
 static gboolean
 bind_selector_query(gpointer backend_data, bson_iter_t* iter, JSqlCacheSQLPrepared* prepared, guint* variables_count, GHashTable* schema_cache, GError** error)
 {
 	J_TRACE_FUNCTION(NULL);
 
 	bson_iter_t iterchild;
+	bson_iter_t iter_array;
 	JDBTypeValue value;
 	JDBType type;
+	JDBSelectorOperator op;
 	gboolean has_next;
-	gboolean equals;
 	JThreadVariables* thread_variables = NULL;
 	char const* string_tmp;
+	guint count;
 
 	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, error))))
 	{
@@ -1689,12 +2985,7 @@ bind_selector_query(gpointer backend_data, bson_iter_t* iter, JSqlCacheSQLPrepar
 			break;
 		}
 
-		if (G_UNLIKELY(!j_bson_iter_key_equals(iter, "_mode", &equals, error)))
-		{
-			goto _error;
-		}
-
-		if (equals)
+		if (selector_key_is_option(iter))
 		{
 			continue;
 		}
@@ -1718,8 +3009,6 @@ bind_selector_query(gpointer backend_data, bson_iter_t* iter, JSqlCacheSQLPrepar
 		}
 		else
 		{
-			(*variables_count)++;
-
 			if (G_UNLIKELY(!j_bson_iter_recurse_document(iter, &iterchild, error)))
 			{
 				goto _error;
@@ -1736,6 +3025,24 @@ bind_selector_query(gpointer backend_data, bson_iter_t* iter, JSqlCacheSQLPrepar
 			}
 
 			string_tmp = value.val_string;
+			type = GPOINTER_TO_INT(g_hash_table_lookup(schema_cache, string_tmp));
+
+			if (G_UNLIKELY(!j_bson_iter_recurse_document(iter, &iterchild, error)))
+			{
+				goto _error;
+			}
+
+			if (G_UNLIKELY(!j_bson_iter_find(&iterchild, "_operator", error)))
+			{
+				goto _error;
+			}
+
+			if (G_UNLIKELY(!j_bson_iter_value(&iterchild, J_DB_TYPE_UINT32, &value, error)))
+			{
+				goto _error;
+			}
+
+			op = value.val_uint32;
 
 			if (G_UNLIKELY(!j_bson_iter_recurse_document(iter, &iterchild, error)))
 			{
@@ -1747,17 +3054,102 @@ bind_selector_query(gpointer backend_data, bson_iter_t* iter, JSqlCacheSQLPrepar
 				goto _error;
 			}
 
-			type = GPOINTER_TO_INT(g_hash_table_lookup(schema_cache, string_tmp));
+			if (op == J_DB_SELECTOR_OPERATOR_IN)
+			{
+				if (G_UNLIKELY(!j_bson_iter_recurse_array(&iterchild, &iter_array, error)))
+				{
+					goto _error;
+				}
+
+				count = 0;
+
+				while (TRUE)
+				{
+					if (G_UNLIKELY(!j_bson_iter_next(&iter_array, &has_next, error)))
+					{
+						goto _error;
+					}
+
+					if (!has_next)
+					{
+						break;
+					}
+
+					if (G_UNLIKELY(!j_bson_iter_value(&iter_array, type, &value, error)))
+					{
+						goto _error;
+					}
+
+					(*variables_count)++;
+					count++;
+
+					if (G_UNLIKELY(!j_sql_bind_value(thread_variables->sql_backend, prepared->stmt, *variables_count, type, &value, error)))
+					{
+						goto _error;
+					}
+				}
+
+				// Pad the list with its last value
+				for (guint i = count; i < selector_in_placeholders(count); i++)
+				{
+					(*variables_count)++;
+
+					if (G_UNLIKELY(!j_sql_bind_value(thread_variables->sql_backend, prepared->stmt, *variables_count, type, &value, error)))
+					{
+						goto _error;
+					}
+				}
+
+				continue;
+			}
 
 			if (G_UNLIKELY(!j_bson_iter_value(&iterchild, type, &value, error)))
 			{
 				goto _error;
 			}
 
+			if (op == J_DB_SELECTOR_OPERATOR_PREFIX)
+			{
+				if (prepared->patterns == NULL)
+				{
+					prepared->patterns = g_ptr_array_new_with_free_func(g_free);
+				}
+
+				value.val_string = selector_prefix_pattern(value.val_string);
+				g_ptr_array_add(prepared->patterns, (gpointer)value.val_string);
+			}
+
+			(*variables_count)++;
+
 			if (G_UNLIKELY(!j_sql_bind_value(thread_variables->sql_backend, prepared->stmt, *variables_count, type, &value, error)))
 			{
 				goto _error;
 			}
+
+			if (op == J_DB_SELECTOR_OPERATOR_BETWEEN)
+			{
+				if (G_UNLIKELY(!j_bson_iter_recurse_document(iter, &iterchild, error)))
+				{
+					goto _error;
+				}
+
+				if (G_UNLIKELY(!j_bson_iter_find(&iterchild, "_upper", error)))
+				{
+					goto _error;
+				}
+
+				if (G_UNLIKELY(!j_bson_iter_value(&iterchild, type, &value, error)))
+				{
+					goto _error;
+				}
+
+				(*variables_count)++;
+
+				if (G_UNLIKELY(!j_sql_bind_value(thread_variables->sql_backend, prepared->stmt, *variables_count, type, &value, error)))
+				{
+					goto _error;
+				}
+			}
 		}
 	}
 
@@ -1766,187 +3158,113 @@ bind_selector_query(gpointer backend_data, bson_iter_t* iter, JSqlCacheSQLPrepar
 _error:
 	return FALSE;
 }
+/**
+ * Appends a selector's conditions as a WHERE clause.
+ * Nothing is appended if the selector does not contain any conditions.
+ **/
 static gboolean
-_backend_query(gpointer backend_data, gpointer _batch, gchar const* name, bson_t const* selector, gpointer* iterator, GError** error)
+build_selector_where(gpointer backend_data, bson_t const* selector, GString* sql, guint* variables_count, GArray* arr_types_in, GHashTable* schema_cache, GError** error)
 {
 	J_TRACE_FUNCTION(NULL);
 
 	JDBSelectorMode mode_child;
-	JSqlBatch* batch = _batch;
-	gboolean sql_found;
 	JDBTypeValue value;
-	guint count = 0;
 	bson_iter_t iter;
-	guint variables_count;
-	JSqlCacheSQLPrepared* prepared = NULL;
-	GString* sql = g_string_new(NULL);
-	JSqlIterator* iteratorOut = NULL;
-	JThreadVariables* thread_variables = NULL;
-	g_autoptr(GArray) arr_types_in = NULL;
-	g_autoptr(GArray) arr_types_out = NULL;
-	JDBType type;
-	GHashTable* schema_cache = NULL;
 
-	if (!(schema_cache = getCacheSchema(backend_data, batch, name, error)))
+	if (!selector_has_conditions(selector))
 	{
-		goto _error;
+		return TRUE;
 	}
 
-	arr_types_in = g_array_new(FALSE, FALSE, sizeof(JDBType));
-	arr_types_out = g_array_new(FALSE, FALSE, sizeof(JDBType));
-	type = J_DB_TYPE_UINT32;
-	g_array_append_val(arr_types_out, type);
+	g_string_append(sql, " WHERE ");
 
-	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, error))))
+	if (G_UNLIKELY(!j_bson_iter_init(&iter, selector, error)))
 	{
 		goto _error;
 	}
 
-	*iterator = NULL;
-	iteratorOut = g_new(JSqlIterator, 1);
-	iteratorOut->namespace = g_strdup(batch->namespace);
-	iteratorOut->name = g_strdup(name);
-	iteratorOut->index = 0;
-	iteratorOut->arr = g_array_new(FALSE, FALSE, sizeof(guint64));
-
-	g_string_append_printf(sql, "SELECT DISTINCT _id FROM " SQL_QUOTE "%s_%s" SQL_QUOTE, batch->namespace, name);
-
-	if (selector && j_bson_has_enough_keys(selector, 2, NULL))
+	if (G_UNLIKELY(!j_bson_iter_find(&iter, "_mode", error)))
 	{
-		g_string_append(sql, " WHERE ");
-
-		if (G_UNLIKELY(!j_bson_iter_init(&iter, selector, error)))
-		{
-			goto _error;
-		}
-
-		if (G_UNLIKELY(!j_bson_iter_find(&iter, "_mode", error)))
-		{
-			goto _error;
-		}
-
-		if (G_UNLIKELY(!j_bson_iter_value(&iter, J_DB_TYPE_UINT32, &value, error)))
-		{
-			goto _error;
-		}
-
-		mode_child = value.val_uint32;
-
-		if (G_UNLIKELY(!j_bson_iter_init(&iter, selector, error)))
-		{
-			goto _error;
-		}
-
-		variables_count = 0;
-
-		if (G_UNLIKELY(!build_selector_query(backend_data, &iter, sql, mode_child, &variables_count, arr_types_in, schema_cache, error)))
-		{
-			goto _error;
-		}
+		goto _error;
 	}
 
-	prepared = getCachePrepared(backend_data, batch->namespace, name, sql->str, error);
-
-	if (G_UNLIKELY(!prepared))
+	if (G_UNLIKELY(!j_bson_iter_value(&iter, J_DB_TYPE_UINT32, &value, error)))
 	{
 		goto _error;
 	}
 
-	if (!prepared->initialized)
-	{
-		prepared->sql = g_string_new(sql->str);
-		prepared->variables_count = variables_count;
-
-		if (G_UNLIKELY(!j_sql_prepare(thread_variables->sql_backend, prepared->sql->str, &prepared->stmt, arr_types_in, arr_types_out, error)))
-		{
-			goto _error;
-		}
+	mode_child = value.val_uint32;
 
-		prepared->initialized = TRUE;
+	if (G_UNLIKELY(!j_bson_iter_init(&iter, selector, error)))
+	{
+		goto _error;
 	}
 
-	if (selector && j_bson_has_enough_keys(selector, 2, NULL))
+	if (G_UNLIKELY(!build_selector_query(backend_data, &iter, sql, mode_child, variables_count, arr_types_in, schema_cache, error)))
 	{
-		if (G_UNLIKELY(!j_bson_iter_init(&iter, selector, error)))
-		{
-			goto _error;
-		}
-
-		variables_count = 0;
-
-		if (G_UNLIKELY(!bind_selector_query(backend_data, &iter, prepared, &variables_count, schema_cache, error)))
-		{
-			goto _error;
-		}
+		goto _error;
 	}
 
-	while (TRUE)
-	{
-		if (G_UNLIKELY(!j_sql_step(thread_variables->sql_backend, prepared->stmt, &sql_found, error)))
-		{
-			goto _error;
-		}
+	return TRUE;
 
-		if (!sql_found)
-		{
-			break;
-		}
-		count++;
+_error:
+	return FALSE;
+}
 
-		if (G_UNLIKELY(!j_sql_column(thread_variables->sql_backend, prepared->stmt, 0, J_DB_TYPE_UINT32, &value, error)))
-		{
-			goto _error;
-		}
+/**
+ * Executes a prepared UPDATE or DELETE statement.
+ * Fails with J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS if no rows matched.
+ **/
+static gboolean
+execute_modification(JThreadVariables* thread_variables, JSqlCacheSQLPrepared* prepared, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
 
-		g_array_append_val(iteratorOut->arr, value.val_uint32);
-	}
+	gboolean sql_found;
+	guint64 changes = 0;
 
-	if (G_UNLIKELY(!j_sql_reset(thread_variables->sql_backend, prepared->stmt, error)))
+	if (G_UNLIKELY(!j_sql_step(thread_variables->sql_backend, prepared->stmt, &sql_found, error)))
 	{
 		goto _error;
 	}
 
-	if (!count)
+	if (G_UNLIKELY(!j_sql_changes(thread_variables->sql_backend, prepared->stmt, &changes, error)))
 	{
-		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS, "no more elements");
 		goto _error;
 	}
 
-	if (sql)
+	if (G_UNLIKELY(!j_sql_reset(thread_variables->sql_backend, prepared->stmt, error)))
 	{
-		g_string_free(sql, TRUE);
-		sql = NULL;
+		goto _error;
 	}
 
-	*iterator = iteratorOut;
+	if (changes == 0)
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS, "no more elements");
+		goto _error2;
+	}
 
 	return TRUE;
 
 _error:
-	if (sql)
-	{
-		g_string_free(sql, TRUE);
-	}
-
-	freeJSqlIterator(iteratorOut);
+	j_sql_reset(thread_variables->sql_backend, prepared->stmt, NULL);
 
+_error2:
 	return FALSE;
 }
+
 static gboolean
 backend_update(gpointer backend_data, gpointer _batch, gchar const* name, bson_t const* selector, bson_t const* metadata, GError** error)
 {
 	J_TRACE_FUNCTION(NULL);
 
 	JSqlBatch* batch = _batch;
-	guint count;
 	gboolean equals;
 	JDBType type;
 	JDBTypeValue value;
-	JSqlIterator* iterator = NULL;
 	guint variables_count;
 	bson_iter_t iter;
 	guint index;
-	guint j;
 	GHashTable* schema_cache = NULL;
 	const char* string_tmp;
 	gboolean has_next;
@@ -1978,6 +3296,13 @@ backend_update(gpointer backend_data, gpointer _batch, gchar const* name, bson_t
 		goto _error;
 	}
 
+	// Options do not select anything on their own
+	if (G_UNLIKELY(!selector_has_conditions(selector)))
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_SELECTOR_EMPTY, "selector empty");
+		goto _error;
+	}
+
 	variables_count = 0;
 	variables_index = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
 	g_string_append_printf(sql, "UPDATE " SQL_QUOTE "%s_%s" SQL_QUOTE " SET ", batch->namespace, name);
@@ -2028,11 +3353,20 @@ backend_update(gpointer backend_data, gpointer _batch, gchar const* name, bson_t
 		g_hash_table_insert(variables_index, g_strdup(string_tmp), GINT_TO_POINTER(variables_count));
 	}
 
-	variables_count++;
-	type = J_DB_TYPE_UINT32;
-	g_array_append_val(arr_types_in, type);
-	g_string_append_printf(sql, " WHERE _id = ?");
-	g_hash_table_insert(variables_index, g_strdup("_id"), GINT_TO_POINTER(variables_count));
+	if (G_UNLIKELY(!variables_count))
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_NO_VARIABLE_SET, "no variable set");
+		goto _error;
+	}
+
+	// The selector is compiled into the statement, so all matching rows are updated at once
+	index = variables_count;
+
+	if (G_UNLIKELY(!build_selector_where(backend_data, selector, sql, &index, arr_types_in, schema_cache, error)))
+	{
+		goto _error;
+	}
+
 	prepared = getCachePrepared(backend_data, batch->namespace, name, sql->str, error);
 
 	if (G_UNLIKELY(!prepared))
@@ -2056,87 +3390,79 @@ backend_update(gpointer backend_data, gpointer _batch, gchar const* name, bson_t
 		prepared->initialized = TRUE;
 	}
 
-	if (G_UNLIKELY(!_backend_query(backend_data, batch, name, selector, (gpointer*)&iterator, error)))
+	if (G_UNLIKELY(!j_bson_iter_init(&iter, metadata, error)))
 	{
 		goto _error;
 	}
 
-	for (j = 0; j < iterator->arr->len; j++)
+	while (TRUE)
 	{
-		count = 0;
-		index = GPOINTER_TO_INT(g_hash_table_lookup(prepared->variables_index, "_id"));
-
-		if (G_UNLIKELY(!index))
-		{
-			g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_VARIABLE_NOT_FOUND, "variable not found");
-			goto _error;
-		}
-
-		value.val_uint32 = g_array_index(iterator->arr, guint64, j);
-
-		if (G_UNLIKELY(!j_sql_bind_value(thread_variables->sql_backend, prepared->stmt, index, J_DB_TYPE_UINT32, &value, error)))
+		if (G_UNLIKELY(!j_bson_iter_next(&iter, &has_next, error)))
 		{
 			goto _error;
 		}
 
-		if (G_UNLIKELY(!j_bson_iter_init(&iter, metadata, error)))
+		if (!has_next)
 		{
-			goto _error;
+			break;
 		}
 
-		while (TRUE)
-		{
-			if (G_UNLIKELY(!j_bson_iter_next(&iter, &has_next, error)))
-			{
-				goto _error;
-			}
-
-			if (!has_next)
-			{
-				break;
-			}
-
-			string_tmp = j_bson_iter_key(&iter, error);
-
-			if (G_UNLIKELY(!string_tmp))
-			{
-				goto _error;
-			}
-
-			type = GPOINTER_TO_INT(g_hash_table_lookup(schema_cache, string_tmp));
-			index = GPOINTER_TO_INT(g_hash_table_lookup(prepared->variables_index, string_tmp));
+		if (G_UNLIKELY(!j_bson_iter_key_equals(&iter, "_index", &equals, error)))
+		{
+			goto _error;
+		}
 
-			if (G_UNLIKELY(!index))
-			{
-				g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_VARIABLE_NOT_FOUND, "variable not found");
-				goto _error;
-			}
+		if (equals)
+		{
+			continue;
+		}
 
-			count++;
+		string_tmp = j_bson_iter_key(&iter, error);
 
-			if (G_UNLIKELY(!j_bson_iter_value(&iter, type, &value, error)))
-			{
-				goto _error;
-			}
+		if (G_UNLIKELY(!string_tmp))
+		{
+			goto _error;
+		}
 
-			if (G_UNLIKELY(!j_sql_bind_value(thread_variables->sql_backend, prepared->stmt, index, type, &value, error)))
-			{
-				goto _error;
-			}
+		type = GPOINTER_TO_INT(g_hash_table_lookup(schema_cache, string_tmp));
+		index = GPOINTER_TO_INT(g_hash_table_lookup(prepared->variables_index, string_tmp));
+
+		if (G_UNLIKELY(!index))
+		{
+			g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_VARIABLE_NOT_FOUND, "variable not found");
+			goto _error;
 		}
 
-		if (G_UNLIKELY(!j_sql_step_and_reset_check_done(thread_variables->sql_backend, prepared->stmt, error)))
+		if (G_UNLIKELY(!j_bson_iter_value(&iter, type, &value, error)))
 		{
 			goto _error;
 		}
 
-		if (!count)
+		if (G_UNLIKELY(!j_sql_bind_value(thread_variables->sql_backend, prepared->stmt, index, type, &value, error)))
 		{
-			g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS, "no more elements");
 			goto _error;
 		}
 	}
 
+	if (G_UNLIKELY(!j_bson_iter_init(&iter, selector, error)))
+	{
+		goto _error;
+	}
+
+	index = prepared->variables_count;
+
+	prepared_clear_patterns(prepared);
+
+	if (G_UNLIKELY(!bind_selector_query(backend_data, &iter, prepared, &index, schema_cache, error)))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!execute_modification(thread_variables, prepared, error)))
+	{
+		goto _error;
+	}
+
 	if (sql)
 	{
 		g_string_free(sql, TRUE);
@@ -2146,8 +3472,6 @@ backend_update(gpointer backend_data, gpointer _batch, gchar const* name, bson_t
 	if (variables_index)
 		g_hash_table_destroy(variables_index);
 
-	freeJSqlIterator(iterator);
-
 	return TRUE;
 
 _error:
@@ -2160,8 +3484,6 @@ _error:
 	if (variables_index)
 		g_hash_table_destroy(variables_index);
 
-	freeJSqlIterator(iterator);
-
 	if (G_UNLIKELY(!_backend_batch_abort(backend_data, batch, NULL)))
 	{
 		goto _error2;
@@ -2179,11 +3501,11 @@ backend_delete(gpointer backend_data, gpointer _batch, gchar const* name, bson_t
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JDBType type;
 	JSqlBatch* batch = _batch;
-	JSqlIterator* iterator = NULL;
-	guint j;
-	JDBTypeValue value;
+	bson_iter_t iter;
+	guint variables_count = 0;
+	GHashTable* schema_cache = NULL;
+	GString* sql = g_string_new(NULL);
 	JSqlCacheSQLPrepared* prepared = NULL;
 	JThreadVariables* thread_variables = NULL;
 	g_autoptr(GArray) arr_types_in = NULL;
@@ -2191,21 +3513,27 @@ backend_delete(gpointer backend_data, gpointer _batch, gchar const* name, bson_t
 	g_return_val_if_fail(name != NULL, FALSE);
 	g_return_val_if_fail(batch != NULL, FALSE);
 
+	if (!(schema_cache = getCacheSchema(backend_data, batch, name, error)))
+	{
+		goto _error;
+	}
+
 	arr_types_in = g_array_new(FALSE, FALSE, sizeof(JDBType));
-	type = J_DB_TYPE_UINT32;
-	g_array_append_val(arr_types_in, type);
 
 	if (G_UNLIKELY(!(thread_variables = thread_variables_get(backend_data, error))))
 	{
 		goto _error;
 	}
 
-	if (G_UNLIKELY(!_backend_query(backend_data, batch, name, selector, (gpointer*)&iterator, error)))
+	// The selector is compiled into the statement, so all matching rows are deleted at once
+	g_string_append_printf(sql, "DELETE FROM " SQL_QUOTE "%s_%s" SQL_QUOTE, batch->namespace, name);
+
+	if (G_UNLIKELY(!build_selector_where(backend_data, selector, sql, &variables_count, arr_types_in, schema_cache, error)))
 	{
 		goto _error;
 	}
 
-	prepared = getCachePrepared(backend_data, batch->namespace, name, "_delete", error);
+	prepared = getCachePrepared(backend_data, batch->namespace, name, sql->str, error);
 
 	if (G_UNLIKELY(!prepared))
 	{
@@ -2214,9 +3542,9 @@ backend_delete(gpointer backend_data, gpointer _batch, gchar const* name, bson_t
 
 	if (!prepared->initialized)
 	{
-		prepared->sql = g_string_new(NULL);
-		prepared->variables_count = 1;
-		g_string_append_printf(prepared->sql, "DELETE FROM " SQL_QUOTE "%s_%s" SQL_QUOTE " WHERE _id = ?", batch->namespace, name);
+		prepared->sql = sql;
+		sql = NULL;
+		prepared->variables_count = variables_count;
 
 		if (G_UNLIKELY(!j_sql_prepare(thread_variables->sql_backend, prepared->sql->str, &prepared->stmt, arr_types_in, NULL, error)))
 		{
@@ -2226,27 +3554,40 @@ backend_delete(gpointer backend_data, gpointer _batch, gchar const* name, bson_t
 		prepared->initialized = TRUE;
 	}
 
-	for (j = 0; j < iterator->arr->len; j++)
+	if (selector_has_conditions(selector))
 	{
-		value.val_uint32 = g_array_index(iterator->arr, guint64, j);
-
-		if (G_UNLIKELY(!j_sql_bind_value(thread_variables->sql_backend, prepared->stmt, 1, J_DB_TYPE_UINT32, &value, error)))
+		if (G_UNLIKELY(!j_bson_iter_init(&iter, selector, error)))
 		{
 			goto _error;
 		}
 
-		if (G_UNLIKELY(!j_sql_step_and_reset_check_done(thread_variables->sql_backend, prepared->stmt, error)))
+		variables_count = 0;
+
+		prepared_clear_patterns(prepared);
+
+		if (G_UNLIKELY(!bind_selector_query(backend_data, &iter, prepared, &variables_count, schema_cache, error)))
 		{
 			goto _error;
 		}
 	}
 
-	freeJSqlIterator(iterator);
+	if (G_UNLIKELY(!execute_modification(thread_variables, prepared, error)))
+	{
+		goto _error;
+	}
+
+	if (sql)
+	{
+		g_string_free(sql, TRUE);
+	}
 
 	return TRUE;
 
 _error:
-	freeJSqlIterator(iterator);
+	if (sql)
+	{
+		g_string_free(sql, TRUE);
+	}
 
 	if (G_UNLIKELY(!_backend_batch_abort(backend_data, batch, NULL)))
 	{
@@ -2265,7 +3606,6 @@ backend_query(gpointer backend_data, gpointer _batch, gchar const* name, bson_t
 {
 	J_TRACE_FUNCTION(NULL);
 
-	JDBSelectorMode mode_child;
 	GHashTableIter schema_iter;
 
 	GHashTable* schema_cache = NULL;
@@ -2274,16 +3614,23 @@ backend_query(gpointer backend_data, gpointer _batch, gchar const* name, bson_t
 
 	JSqlBatch* batch = _batch;
 	bson_iter_t iter;
+	bson_iter_t iterchild;
 	guint variables_count;
-	guint variables_count2;
+	guint variables_count2 = 0;
 	JDBTypeValue value;
+	gboolean has_next;
 	char* string_tmp;
+	gboolean has_limit = FALSE;
+	guint64 limit = G_MAXINT64;
+	guint64 offset = 0;
 	JSqlCacheSQLPrepared* prepared = NULL;
 	GHashTable* variables_index = NULL;
 	GString* sql = g_string_new(NULL);
 	JThreadVariables* thread_variables = NULL;
 	g_autoptr(GArray) arr_types_in = NULL;
 	g_autoptr(GArray) arr_types_out = NULL;
+	g_autoptr(GHashTable) aliases = NULL;
+	g_autoptr(GString) group_sql = NULL;
 
 	g_return_val_if_fail(name != NULL, FALSE);
 	g_return_val_if_fail(batch != NULL, FALSE);
@@ -2307,59 +3654,207 @@ backend_query(gpointer backend_data, gpointer _batch, gchar const* name, bson_t
 
 	g_hash_table_iter_init(&schema_iter, schema_cache);
 
-	g_string_append(sql, "_id");
-	g_hash_table_insert(variables_index, GINT_TO_POINTER(variables_count), g_strdup("_id"));
-	type = J_DB_TYPE_UINT32;
-	g_array_append_val(arr_types_out, type);
-	variables_count++;
-
-	while (g_hash_table_iter_next(&schema_iter, (gpointer*)&string_tmp, &type_tmp))
+	if (selector && ((j_bson_iter_init(&iter, selector, NULL) && j_bson_iter_find(&iter, "_aggregate", NULL)) || (j_bson_iter_init(&iter, selector, NULL) && j_bson_iter_find(&iter, "_group", NULL))))
 	{
-		type = GPOINTER_TO_INT(type_tmp);
-
-		if (strcmp(string_tmp, "_id") == 0)
-			continue;
+		// Aggregated results consist of the grouping fields and the aggregates, they do not have an ID
+		aliases = g_hash_table_new(g_str_hash, g_str_equal);
+		group_sql = g_string_new(NULL);
 
-		g_string_append_printf(sql, ", %s", string_tmp);
-		g_hash_table_insert(variables_index, GINT_TO_POINTER(variables_count), g_strdup(string_tmp));
+		if (G_UNLIKELY(!build_aggregate_query(selector, sql, group_sql, &variables_count, variables_index, arr_types_out, aliases, schema_cache, error)))
+		{
+			goto _error;
+		}
+	}
+	else
+	{
+		g_string_append(sql, "_id");
+		g_hash_table_insert(variables_index, GINT_TO_POINTER(variables_count), g_strdup("_id"));
+		type = J_DB_TYPE_UINT32;
 		g_array_append_val(arr_types_out, type);
 		variables_count++;
+
+		if (selector && j_bson_iter_init(&iter, selector, NULL) && j_bson_iter_find(&iter, "_projection", NULL))
+		{
+			// Only return the requested fields, the ID is always included
+			if (G_UNLIKELY(!j_bson_iter_recurse_document(&iter, &iterchild, error)))
+			{
+				goto _error;
+			}
+
+			while (TRUE)
+			{
+				if (G_UNLIKELY(!j_bson_iter_next(&iterchild, &has_next, error)))
+				{
+					goto _error;
+				}
+
+				if (!has_next)
+				{
+					break;
+				}
+
+				if (G_UNLIKELY(!j_bson_iter_value(&iterchild, J_DB_TYPE_STRING, &value, error)))
+				{
+					goto _error;
+				}
+
+				if (G_UNLIKELY(!g_hash_table_lookup_extended(schema_cache, value.val_string, NULL, &type_tmp)))
+				{
+					g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_VARIABLE_NOT_FOUND, "variable not found");
+					goto _error;
+				}
+
+				if (strcmp(value.val_string, "_id") == 0)
+					continue;
+
+				type = GPOINTER_TO_INT(type_tmp);
+
+				g_string_append_printf(sql, ", %s", value.val_string);
+				g_hash_table_insert(variables_index, GINT_TO_POINTER(variables_count), g_strdup(value.val_string));
+				g_array_append_val(arr_types_out, type);
+				variables_count++;
+			}
+		}
+		else
+		{
+			while (g_hash_table_iter_next(&schema_iter, (gpointer*)&string_tmp, &type_tmp))
+			{
+				type = GPOINTER_TO_INT(type_tmp);
+
+				if (strcmp(string_tmp, "_id") == 0)
+					continue;
+
+				g_string_append_printf(sql, ", %s", string_tmp);
+				g_hash_table_insert(variables_index, GINT_TO_POINTER(variables_count), g_strdup(string_tmp));
+				g_array_append_val(arr_types_out, type);
+				variables_count++;
+			}
+		}
 	}
 
 	g_string_append_printf(sql, " FROM " SQL_QUOTE "%s_%s" SQL_QUOTE, batch->namespace, name);
 
-	if (selector && j_bson_has_enough_keys(selector, 2, NULL))
+	variables_count2 = 0;
+
+	if (G_UNLIKELY(!build_selector_where(backend_data, selector, sql, &variables_count2, arr_types_in, schema_cache, error)))
 	{
-		g_string_append(sql, " WHERE ");
+		goto _error;
+	}
 
-		if (G_UNLIKELY(!j_bson_iter_init(&iter, selector, error)))
+	if (group_sql != NULL && group_sql->len > 0)
+	{
+		g_string_append_printf(sql, " GROUP BY %s", group_sql->str);
+	}
+
+	if (selector && j_bson_iter_init(&iter, selector, NULL) && j_bson_iter_find(&iter, "_order", NULL))
+	{
+		gboolean first = TRUE;
+
+		if (G_UNLIKELY(!j_bson_iter_recurse_document(&iter, &iterchild, error)))
 		{
 			goto _error;
 		}
 
-		if (G_UNLIKELY(!j_bson_iter_find(&iter, "_mode", error)))
+		while (TRUE)
 		{
-			goto _error;
+			bson_iter_t iterorder;
+			gchar const* order_name;
+			gboolean is_alias;
+
+			if (G_UNLIKELY(!j_bson_iter_next(&iterchild, &has_next, error)))
+			{
+				goto _error;
+			}
+
+			if (!has_next)
+			{
+				break;
+			}
+
+			if (G_UNLIKELY(!j_bson_iter_recurse_document(&iterchild, &iterorder, error)))
+			{
+				goto _error;
+			}
+
+			if (G_UNLIKELY(!j_bson_iter_find(&iterorder, "_name", error)))
+			{
+				goto _error;
+			}
+
+			if (G_UNLIKELY(!j_bson_iter_value(&iterorder, J_DB_TYPE_STRING, &value, error)))
+			{
+				goto _error;
+			}
+
+			order_name = value.val_string;
+
+			// Names are inserted into the statement, so only known fields and aggregates are allowed
+			is_alias = (aliases != NULL && g_hash_table_contains(aliases, order_name));
+
+			if (G_UNLIKELY(!is_alias && !g_hash_table_contains(schema_cache, order_name)))
+			{
+				g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_VARIABLE_NOT_FOUND, "variable not found");
+				goto _error;
+			}
+
+			if (G_UNLIKELY(!j_bson_iter_recurse_document(&iterchild, &iterorder, error)))
+			{
+				goto _error;
+			}
+
+			if (G_UNLIKELY(!j_bson_iter_find(&iterorder, "_order", error)))
+			{
+				goto _error;
+			}
+
+			if (G_UNLIKELY(!j_bson_iter_value(&iterorder, J_DB_TYPE_UINT32, &value, error)))
+			{
+				goto _error;
+			}
+
+			g_string_append(sql, (first) ? " ORDER BY " : ", ");
+			if (is_alias)
+			{
+				g_string_append_printf(sql, SQL_QUOTE "%s" SQL_QUOTE " %s", order_name, (value.val_uint32 == J_DB_SELECTOR_ORDER_DESCENDING) ? "DESC" : "ASC");
+			}
+			else
+			{
+				g_string_append_printf(sql, "%s %s", order_name, (value.val_uint32 == J_DB_SELECTOR_ORDER_DESCENDING) ? "DESC" : "ASC");
+			}
+
+			first = FALSE;
 		}
+	}
 
-		if (G_UNLIKELY(!j_bson_iter_value(&iter, J_DB_TYPE_UINT32, &value, error)))
+	if (selector && j_bson_iter_init(&iter, selector, NULL) && j_bson_iter_find(&iter, "_limit", NULL))
+	{
+		if (G_UNLIKELY(!j_bson_iter_value(&iter, J_DB_TYPE_UINT64, &value, error)))
 		{
 			goto _error;
 		}
 
-		mode_child = value.val_uint32;
+		limit = value.val_uint64;
+		has_limit = TRUE;
+	}
 
-		if (G_UNLIKELY(!j_bson_iter_init(&iter, selector, error)))
+	if (selector && j_bson_iter_init(&iter, selector, NULL) && j_bson_iter_find(&iter, "_offset", NULL))
+	{
+		if (G_UNLIKELY(!j_bson_iter_value(&iter, J_DB_TYPE_UINT64, &value, error)))
 		{
 			goto _error;
 		}
 
-		variables_count2 = 0;
+		offset = value.val_uint64;
+		has_limit = TRUE;
+	}
 
-		if (G_UNLIKELY(!build_selector_query(backend_data, &iter, sql, mode_child, &variables_count2, arr_types_in, schema_cache, error)))
-		{
-			goto _error;
-		}
+	if (has_limit)
+	{
+		// Both values are bound to keep the number of prepared statements low
+		g_string_append(sql, " LIMIT ? OFFSET ?");
+		type = J_DB_TYPE_UINT64;
+		g_array_append_val(arr_types_in, type);
+		g_array_append_val(arr_types_in, type);
 	}
 
 	prepared = getCachePrepared(backend_data, batch->namespace, name, sql->str, error);
@@ -2374,6 +3869,7 @@ backend_query(gpointer backend_data, gpointer _batch, gchar const* name, bson_t
 		prepared->sql = g_string_new(sql->str);
 		prepared->variables_index = variables_index;
 		prepared->variables_count = variables_count;
+		prepared->variables_type = g_array_ref(arr_types_out);
 
 		if (G_UNLIKELY(!j_sql_prepare(thread_variables->sql_backend, prepared->sql->str, &prepared->stmt, arr_types_in, arr_types_out, error)))
 		{
@@ -2387,7 +3883,7 @@ backend_query(gpointer backend_data, gpointer _batch, gchar const* name, bson_t
 		variables_index = NULL;
 	}
 
-	if (selector && j_bson_has_enough_keys(selector, 2, NULL))
+	if (selector_has_conditions(selector))
 	{
 		if (G_UNLIKELY(!j_bson_iter_init(&iter, selector, error)))
 		{
@@ -2396,13 +3892,37 @@ backend_query(gpointer backend_data, gpointer _batch, gchar const* name, bson_t
 
 		variables_count2 = 0;
 
+		prepared_clear_patterns(prepared);
+
 		if (G_UNLIKELY(!bind_selector_query(backend_data, &iter, prepared, &variables_count2, schema_cache, error)))
 		{
 			goto _error;
 		}
 	}
+	else
+	{
+		variables_count2 = 0;
+	}
+
+	if (has_limit)
+	{
+		value.val_uint64 = MIN(limit, (guint64)G_MAXINT64);
+
+		if (G_UNLIKELY(!j_sql_bind_value(thread_variables->sql_backend, prepared->stmt, variables_count2 + 1, J_DB_TYPE_UINT64, &value, error)))
+		{
+			goto _error;
+		}
+
+		value.val_uint64 = MIN(offset, (guint64)G_MAXINT64);
+
+		if (G_UNLIKELY(!j_sql_bind_value(thread_variables->sql_backend, prepared->stmt, variables_count2 + 2, J_DB_TYPE_UINT64, &value, error)))
+		{
+			goto _error;
+		}
+	}
 
 	*iterator = prepared;
+	prepared->iterating = TRUE;
 
 	if (sql)
 	{
@@ -2470,7 +3990,15 @@ backend_iterate(gpointer backend_data, gpointer _iterator, bson_t* metadata, GEr
 		for (i = 0; i < prepared->variables_count; i++)
 		{
 			string_tmp = g_hash_table_lookup(prepared->variables_index, GINT_TO_POINTER(i));
-			type = GPOINTER_TO_INT(g_hash_table_lookup(schema_cache, string_tmp));
+
+			if (prepared->variables_type != NULL)
+			{
+				type = g_array_index(prepared->variables_type, JDBType, i);
+			}
+			else
+			{
+				type = GPOINTER_TO_INT(g_hash_table_lookup(schema_cache, string_tmp));
+			}
 
 			if (G_UNLIKELY(!j_sql_column(thread_variables->sql_backend, prepared->stmt, i, type, &value, error)))
 			{
@@ -2493,6 +4021,9 @@ backend_iterate(gpointer backend_data, gpointer _iterator, bson_t* metadata, GEr
 	return TRUE;
 
 _error:
+	// The iterator is finished, so the statement may be evicted again
+	prepared->iterating = FALSE;
+
 	if (G_UNLIKELY(!j_sql_reset(thread_variables->sql_backend, prepared->stmt, NULL)))
 	{
 		goto _error3;
@@ -2504,4 +4035,55 @@ _error3:
 	/*something failed very hard*/
 	return FALSE;
 }
+
+/**
+ * Sets the ID of the first entry of new schemas.
+ **/
+static gboolean
+backend_set_id_base(gpointer backend_data, guint32 id_base)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	(void)backend_data;
+
+	sql_id_base = id_base;
+
+	return TRUE;
+}
+
+/**
+ * Adds the statement cache's statistics of all threads.
+ **/
+static gboolean
+backend_statistics(gpointer backend_data, JStatistics* statistics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JSqlStatistics total;
+
+	(void)backend_data;
+
+	g_mutex_lock(sql_statistics_mutex);
+
+	total = sql_statistics_finished;
+
+	// The counters of running threads are read without synchronization, so they may be slightly outdated
+	for (GSList* link = sql_statistics_threads; link != NULL; link = link->next)
+	{
+		JThreadVariables* thread_variables = link->data;
+
+		total.statements_hit += thread_variables->statistics.statements_hit;
+		total.statements_missed += thread_variables->statistics.statements_missed;
+		total.statements_evicted += thread_variables->statistics.statements_evicted;
+	}
+
+	g_mutex_unlock(sql_statistics_mutex);
+
+	j_statistics_add(statistics, J_STATISTICS_DB_STATEMENTS_HIT, total.statements_hit);
+	j_statistics_add(statistics, J_STATISTICS_DB_STATEMENTS_MISSED, total.statements_missed);
+	j_statistics_add(statistics, J_STATISTICS_DB_STATEMENTS_EVICTED, total.statements_evicted);
+
+	return TRUE;
+}
+
 #endif
@@ -39,17 +39,81 @@
 #define SQL_MODE SQL_MODE_SINGLE_THREAD
 
 #define SQL_AUTOINCREMENT_STRING " "
+// Only tables with AUTOINCREMENT keep their last ID in sqlite_sequence, which is needed to start at another ID
+#define SQL_ID_RANGE_STRING " AUTOINCREMENT "
+#define SQL_ID_BASE_STRING "INSERT INTO sqlite_sequence (name, seq) VALUES ('%s_%s', %u - 1)"
 #define SQL_UINT64_TYPE " UNSIGNED BIGINT "
 #define SQL_LAST_INSERT_ID_STRING " SELECT last_insert_rowid() "
+#define SQL_FIRST_INSERT_ID_STRING " SELECT last_insert_rowid() - changes() + 1 "
+#define SQL_MAX_VARIABLES 999
 #define SQL_QUOTE "\""
+#define SQL_INDEX_ONLINE_STRING " "
+#define SQL_INDEX_DROP_ON_TABLE FALSE
+#define SQL_INDEX_COLUMNS_STRING "SELECT m.name, i.name FROM sqlite_master AS m, pragma_index_info(m.name) AS i WHERE m.type = 'index' AND m.tbl_name = ? ORDER BY m.name, i.seqno"
+#define SQL_STATEMENT_CACHE_SIZE 256
+// Every thread uses its own connection, in-memory databases are private to their connection
+#define SQL_CONNECTION_POOL_SIZE 0
+
+/**
+ * The interval (in microseconds) between background checkpoints if commits are not synchronous.
+ **/
+#define SQLITE_CHECKPOINT_INTERVAL G_USEC_PER_SEC
+
+enum JSQLiteSynchronous
+{
+	J_SQLITE_SYNCHRONOUS_OFF = 0,
+	J_SQLITE_SYNCHRONOUS_NORMAL = 1,
+	J_SQLITE_SYNCHRONOUS_FULL = 2
+};
+
+typedef enum JSQLiteSynchronous JSQLiteSynchronous;
 
 struct JSQLiteData
 {
 	gchar* path;
+
+	/**
+	 * The maximum number of bytes mapped into memory, 0 disables memory mapping.
+	 **/
+	guint64 mmap_size;
+
+	/**
+	 * The page cache size in KiB.
+	 **/
+	guint64 cache_size;
+
+	/**
+	 * The thread checkpointing the log, NULL for in-memory databases.
+	 * It is stopped by setting #checkpoint_stop and signaling #checkpoint_cond.
+	 **/
+	GThread* checkpoint_thread;
+	GMutex checkpoint_mutex;
+	GCond checkpoint_cond;
+	gboolean checkpoint_stop;
+
+	/**
+	 * Whether commits have not been synchronized yet.
+	 **/
+	gint checkpoint_pending;
 };
 
 typedef struct JSQLiteData JSQLiteData;
 
+/**
+ * The state of a connection.
+ * Every thread uses its own connection, so it is stored per thread.
+ **/
+struct JSQLiteConnection
+{
+	JSQLiteData* data;
+	gboolean wal;
+	JSQLiteSynchronous synchronous;
+};
+
+typedef struct JSQLiteConnection JSQLiteConnection;
+
+static GPrivate sqlite_connection = G_PRIVATE_INIT(g_free);
+
 static gboolean
 j_sql_finalize(sqlite3* backend_db, void* _stmt, GError** error)
 {
@@ -357,6 +421,19 @@ _error2:
 	return FALSE;
 }
 
+static gboolean
+j_sql_changes(sqlite3* backend_db, void* _stmt, guint64* changes, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	(void)_stmt;
+	(void)error;
+
+	*changes = sqlite3_changes(backend_db);
+
+	return TRUE;
+}
+
 static void*
 j_sql_open(gpointer backend_data)
 {
@@ -364,11 +441,20 @@ j_sql_open(gpointer backend_data)
 
 	JSQLiteData* bd = backend_data;
 
+	JSQLiteConnection* connection;
 	sqlite3* backend_db = NULL;
 	g_autofree gchar* dirname = NULL;
+	g_autofree gchar* pragma = NULL;
 
 	g_return_val_if_fail(bd->path != NULL, FALSE);
 
+	connection = g_new(JSQLiteConnection, 1);
+	connection->data = bd;
+	connection->wal = FALSE;
+	// The default is FULL, it is adjusted according to the semantics of each batch
+	connection->synchronous = J_SQLITE_SYNCHRONOUS_FULL;
+	g_private_replace(&sqlite_connection, connection);
+
 	if (strncmp("memory", bd->path, 5))
 	{
 		dirname = g_path_get_dirname(bd->path);
@@ -377,6 +463,23 @@ j_sql_open(gpointer backend_data)
 		{
 			goto _error;
 		}
+
+		// Readers do not block writers and commits only append to the log
+		if (G_UNLIKELY(!j_sql_exec(backend_db, "PRAGMA journal_mode = WAL", NULL)))
+		{
+			goto _error;
+		}
+
+		connection->wal = TRUE;
+
+		pragma = g_strdup_printf("PRAGMA mmap_size = %" G_GUINT64_FORMAT, bd->mmap_size);
+
+		if (G_UNLIKELY(!j_sql_exec(backend_db, pragma, NULL)))
+		{
+			goto _error;
+		}
+
+		g_clear_pointer(&pragma, g_free);
 	}
 	else
 	{
@@ -385,11 +488,26 @@ j_sql_open(gpointer backend_data)
 			goto _error;
 		}
 	}
+
+	// Negative values specify the size in KiB instead of pages
+	pragma = g_strdup_printf("PRAGMA cache_size = -%" G_GUINT64_FORMAT, bd->cache_size);
+
+	if (G_UNLIKELY(!j_sql_exec(backend_db, pragma, NULL)))
+	{
+		goto _error;
+	}
+
 	if (G_UNLIKELY(!j_sql_exec(backend_db, "PRAGMA foreign_keys = ON", NULL)))
 	{
 		goto _error;
 	}
 
+	// Prefix matches are case-sensitive like comparisons, which also allows LIKE to use indexes
+	if (G_UNLIKELY(!j_sql_exec(backend_db, "PRAGMA case_sensitive_like = ON", NULL)))
+	{
+		goto _error;
+	}
+
 	return backend_db;
 
 _error:
@@ -406,12 +524,60 @@ j_sql_close(sqlite3* backend_db)
 	sqlite3_close(backend_db);
 }
 
+/**
+ * Returns the synchronous mode required by the semantics.
+ * Like the key-value backends, only J_SEMANTICS_SAFETY_STORAGE waits for commits to reach storage.
+ * In WAL mode, NORMAL keeps the database consistent but the latest commits might be lost on power failure.
+ **/
+static JSQLiteSynchronous
+j_sql_synchronous(JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	if (j_semantics_get(semantics, J_SEMANTICS_SAFETY) == J_SEMANTICS_SAFETY_STORAGE)
+	{
+		return J_SQLITE_SYNCHRONOUS_FULL;
+	}
+
+	if (j_semantics_get(semantics, J_SEMANTICS_PERSISTENCY) == J_SEMANTICS_PERSISTENCY_NONE)
+	{
+		return J_SQLITE_SYNCHRONOUS_OFF;
+	}
+
+	return J_SQLITE_SYNCHRONOUS_NORMAL;
+}
+
 static gboolean
-j_sql_start_transaction(sqlite3* backend_db, GError** error)
+j_sql_start_transaction(sqlite3* backend_db, JSemantics* semantics, GError** error)
 {
 	J_TRACE_FUNCTION(NULL);
 
+	JSQLiteConnection* connection = g_private_get(&sqlite_connection);
+	JSQLiteSynchronous synchronous;
+
+	g_return_val_if_fail(connection != NULL, FALSE);
+
+	synchronous = j_sql_synchronous(semantics);
+
+	// The mode can not be changed within a transaction
+	if (connection->synchronous != synchronous)
+	{
+		g_autofree gchar* pragma = NULL;
+
+		pragma = g_strdup_printf("PRAGMA synchronous = %d", synchronous);
+
+		if (G_UNLIKELY(!j_sql_exec(backend_db, pragma, error)))
+		{
+			goto _error;
+		}
+
+		connection->synchronous = synchronous;
+	}
+
 	return j_sql_exec(backend_db, "BEGIN TRANSACTION", error);
+
+_error:
+	return FALSE;
 }
 
 static gboolean
@@ -419,7 +585,25 @@ j_sql_commit_transaction(sqlite3* backend_db, GError** error)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	return j_sql_exec(backend_db, "COMMIT", error);
+	JSQLiteConnection* connection = g_private_get(&sqlite_connection);
+
+	g_return_val_if_fail(connection != NULL, FALSE);
+
+	if (G_UNLIKELY(!j_sql_exec(backend_db, "COMMIT", error)))
+	{
+		goto _error;
+	}
+
+	// Commits are only synchronized by checkpoints, which run periodically in the background to limit how many can be lost
+	if (connection->wal && connection->synchronous == J_SQLITE_SYNCHRONOUS_NORMAL)
+	{
+		g_atomic_int_set(&(connection->data->checkpoint_pending), TRUE);
+	}
+
+	return TRUE;
+
+_error:
+	return FALSE;
 }
 
 static gboolean
@@ -432,15 +616,105 @@ j_sql_abort_transaction(sqlite3* backend_db, GError** error)
 
 #include "sql-generic.c"
 
+/**
+ * Checkpoints the log periodically if there are commits that have not been synchronized.
+ * The thread uses its own connection, which synchronizes the log before checkpointing it.
+ **/
+static gpointer
+j_sqlite_checkpoint_thread(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JSQLiteData* bd = data;
+	sqlite3* backend_db = NULL;
+
+	g_mutex_lock(&(bd->checkpoint_mutex));
+
+	while (!bd->checkpoint_stop)
+	{
+		gint log_frames = 0;
+		gint checkpointed_frames = 0;
+		gint ret;
+
+		g_cond_wait_until(&(bd->checkpoint_cond), &(bd->checkpoint_mutex), g_get_monotonic_time() + SQLITE_CHECKPOINT_INTERVAL);
+
+		if (bd->checkpoint_stop || !g_atomic_int_compare_and_exchange(&(bd->checkpoint_pending), TRUE, FALSE))
+		{
+			continue;
+		}
+
+		g_mutex_unlock(&(bd->checkpoint_mutex));
+
+		// The database exists once something has been committed
+		if (backend_db == NULL)
+		{
+			if (sqlite3_open(bd->path, &backend_db) != SQLITE_OK || !j_sql_exec(backend_db, "PRAGMA synchronous = FULL", NULL))
+			{
+				g_clear_pointer(&backend_db, sqlite3_close);
+			}
+		}
+
+		ret = (backend_db != NULL) ? sqlite3_wal_checkpoint_v2(backend_db, NULL, SQLITE_CHECKPOINT_PASSIVE, &log_frames, &checkpointed_frames) : SQLITE_ERROR;
+
+		// Passive checkpoints do not wait for readers, the remaining frames are checkpointed later
+		if (ret != SQLITE_OK || checkpointed_frames < log_frames)
+		{
+			g_atomic_int_set(&(bd->checkpoint_pending), TRUE);
+		}
+
+		g_mutex_lock(&(bd->checkpoint_mutex));
+	}
+
+	g_mutex_unlock(&(bd->checkpoint_mutex));
+
+	if (backend_db != NULL)
+	{
+		sqlite3_close(backend_db);
+	}
+
+	return NULL;
+}
+
 static gboolean
 backend_init(gchar const* _path, gpointer* backend_data)
 {
 	J_TRACE_FUNCTION(NULL);
 
 	JSQLiteData* bd;
+	g_auto(GStrv) split = NULL;
+
+	g_return_val_if_fail(_path != NULL, FALSE);
+
+	/* Path syntax: path[:mmap-size[:cache-size]]
+	 * Both sizes are specified in MiB.
+	 */
+	split = g_strsplit(_path, ":", 3);
 
 	bd = g_slice_new(JSQLiteData);
-	bd->path = g_strdup(_path);
+	bd->path = g_strdup(split[0]);
+	bd->mmap_size = 256 * 1024 * 1024;
+	bd->cache_size = 64 * 1024;
+
+	if (split[0] != NULL && split[1] != NULL)
+	{
+		bd->mmap_size = g_ascii_strtoull(split[1], NULL, 10) * 1024 * 1024;
+
+		if (split[2] != NULL)
+		{
+			bd->cache_size = g_ascii_strtoull(split[2], NULL, 10) * 1024;
+		}
+	}
+
+	bd->checkpoint_thread = NULL;
+	g_mutex_init(&(bd->checkpoint_mutex));
+	g_cond_init(&(bd->checkpoint_cond));
+	bd->checkpoint_stop = FALSE;
+	bd->checkpoint_pending = FALSE;
+
+	if (strncmp("memory", bd->path, 5))
+	{
+		bd->checkpoint_thread = g_thread_new("sqlite-checkpoint", j_sqlite_checkpoint_thread, bd);
+	}
 
 	*backend_data = bd;
 
@@ -458,6 +732,19 @@ backend_fini(gpointer backend_data)
 
 	sql_generic_fini();
 
+	if (bd->checkpoint_thread != NULL)
+	{
+		g_mutex_lock(&(bd->checkpoint_mutex));
+		bd->checkpoint_stop = TRUE;
+		g_cond_signal(&(bd->checkpoint_cond));
+		g_mutex_unlock(&(bd->checkpoint_mutex));
+
+		g_thread_join(bd->checkpoint_thread);
+	}
+
+	g_cond_clear(&(bd->checkpoint_cond));
+	g_mutex_clear(&(bd->checkpoint_mutex));
+
 	g_free(bd->path);
 	g_slice_free(JSQLiteData, bd);
 }
@@ -471,13 +758,18 @@ static JBackend sqlite_backend = {
 		.backend_schema_create = backend_schema_create,
 		.backend_schema_get = backend_schema_get,
 		.backend_schema_delete = backend_schema_delete,
+		.backend_index_create = backend_index_create,
+		.backend_index_delete = backend_index_delete,
+		.backend_statistics = backend_statistics,
 		.backend_insert = backend_insert,
+		.backend_insert_many = backend_insert_many,
 		.backend_update = backend_update,
 		.backend_delete = backend_delete,
 		.backend_query = backend_query,
 		.backend_iterate = backend_iterate,
 		.backend_batch_start = backend_batch_start,
 		.backend_batch_execute = backend_batch_execute,
+		.backend_set_id_base = backend_set_id_base,
 	},
 };
 
@@ -34,6 +34,19 @@ struct JLMDBBatch
 
 typedef struct JLMDBBatch JLMDBBatch;
 
+struct JLMDBBulk
+{
+	JLMDBBatch* batch;
+
+	/**
+	 * Whether keys can still be appended.
+	 * Appending fails if a key is not greater than all existing keys.
+	 **/
+	gboolean append;
+};
+
+typedef struct JLMDBBulk JLMDBBulk;
+
 struct JLMDBData
 {
 	MDB_env* env;
@@ -178,6 +191,83 @@ backend_get(gpointer backend_data, gpointer data, gchar const* key, gpointer* va
 	return ret;
 }
 
+static gboolean
+backend_bulk_start(gpointer backend_data, gchar const* namespace, JSemantics* semantics, gpointer* data)
+{
+	JLMDBBulk* bulk;
+	JLMDBBatch* batch;
+
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(data != NULL, FALSE);
+
+	if (!backend_batch_start(backend_data, namespace, semantics, (gpointer*)&batch))
+	{
+		*data = NULL;
+
+		return FALSE;
+	}
+
+	bulk = g_slice_new(JLMDBBulk);
+	bulk->batch = batch;
+	bulk->append = TRUE;
+
+	*data = bulk;
+
+	return TRUE;
+}
+
+static gboolean
+backend_bulk_put(gpointer backend_data, gpointer data, gchar const* key, gconstpointer value, guint32 len)
+{
+	JLMDBData* bd = backend_data;
+	JLMDBBulk* bulk = data;
+	MDB_val m_key;
+	MDB_val m_value;
+	g_autofree gchar* nskey = NULL;
+
+	g_return_val_if_fail(data != NULL, FALSE);
+	g_return_val_if_fail(key != NULL, FALSE);
+	g_return_val_if_fail(value != NULL, FALSE);
+
+	if (!bulk->append)
+	{
+		return backend_put(backend_data, bulk->batch, key, value, len);
+	}
+
+	nskey = g_strdup_printf("%s:%s", bulk->batch->namespace, key);
+
+	m_key.mv_size = strlen(nskey) + 1;
+	m_key.mv_data = nskey;
+	m_value.mv_size = len;
+	m_value.mv_data = value;
+
+	// MDB_APPEND skips the tree search and fills pages completely
+	if (mdb_put(bulk->batch->txn, bd->dbi, &m_key, &m_value, MDB_APPEND) == 0)
+	{
+		return TRUE;
+	}
+
+	// The key is not greater than all existing keys (for example, because other namespaces follow)
+	bulk->append = FALSE;
+
+	return backend_put(backend_data, bulk->batch, key, value, len);
+}
+
+static gboolean
+backend_bulk_execute(gpointer backend_data, gpointer data)
+{
+	JLMDBBulk* bulk = data;
+	gboolean ret;
+
+	g_return_val_if_fail(data != NULL, FALSE);
+
+	ret = backend_batch_execute(backend_data, bulk->batch);
+
+	g_slice_free(JLMDBBulk, bulk);
+
+	return ret;
+}
+
 static gboolean
 backend_get_all(gpointer backend_data, gchar const* namespace, gpointer* data)
 {
@@ -350,7 +440,10 @@ static JBackend lmdb_backend = {
 		.backend_get = backend_get,
 		.backend_get_all = backend_get_all,
 		.backend_get_by_prefix = backend_get_by_prefix,
-		.backend_iterate = backend_iterate }
+		.backend_iterate = backend_iterate,
+		.backend_bulk_start = backend_bulk_start,
+		.backend_bulk_put = backend_bulk_put,
+		.backend_bulk_execute = backend_bulk_execute }
 };
 
 G_MODULE_EXPORT
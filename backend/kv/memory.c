@@ -0,0 +1,1113 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2020 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+#include <gmodule.h>
+
+#include <fcntl.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <julea.h>
+
+/**
+ * Number of lock stripes per namespace.
+ * Keys are distributed across stripes by their hash.
+ **/
+#define J_MEMORY_STRIPES 16
+
+/**
+ * Maximum height of a stripe's skip list.
+ **/
+#define J_MEMORY_SKIPLIST_LEVELS 16
+
+/**
+ * Snapshot file header, including a format version.
+ **/
+#define J_MEMORY_SNAPSHOT_MAGIC "JKVMEM01"
+
+/**
+ * A stored key-value pair.
+ * Entries are reference-counted so iterators can keep using them without holding locks.
+ **/
+struct JMemoryEntry
+{
+	gchar* key;
+	gpointer value;
+	guint32 len;
+	gint ref_count;
+};
+
+typedef struct JMemoryEntry JMemoryEntry;
+
+/**
+ * A skip list node.
+ **/
+struct JMemoryNode
+{
+	JMemoryEntry* entry;
+	guint levels;
+	struct JMemoryNode* next[];
+};
+
+typedef struct JMemoryNode JMemoryNode;
+
+/**
+ * A part of a namespace with its own lock.
+ **/
+struct JMemoryStripe
+{
+	/**
+	 * The nodes, indexed by key, for point lookups.
+	 **/
+	GHashTable* nodes;
+
+	/**
+	 * The skip list head, for ordered iteration.
+	 **/
+	JMemoryNode* head;
+
+	/**
+	 * The number of skip list levels in use.
+	 **/
+	guint levels;
+
+	GRand* rand;
+
+	GRWLock lock[1];
+};
+
+typedef struct JMemoryStripe JMemoryStripe;
+
+struct JMemoryNamespace
+{
+	gchar* name;
+	JMemoryStripe stripes[J_MEMORY_STRIPES];
+};
+
+typedef struct JMemoryNamespace JMemoryNamespace;
+
+struct JMemoryData
+{
+	/**
+	 * The namespaces, indexed by name.
+	 * Contains #JMemoryNamespace elements.
+	 **/
+	GHashTable* namespaces;
+
+	GRWLock lock[1];
+
+	/**
+	 * The snapshot file, NULL if snapshots are disabled.
+	 **/
+	gchar* snapshot_path;
+
+	/**
+	 * The interval between periodic snapshots in seconds, 0 to only write a snapshot at shutdown.
+	 **/
+	guint64 snapshot_interval;
+
+	GThread* snapshot_thread;
+	gboolean snapshot_stop;
+
+	GMutex snapshot_mutex[1];
+	GCond snapshot_cond[1];
+};
+
+typedef struct JMemoryData JMemoryData;
+
+struct JMemoryBatch
+{
+	JMemoryNamespace* namespace;
+	JSemantics* semantics;
+};
+
+typedef struct JMemoryBatch JMemoryBatch;
+
+struct JMemoryIterator
+{
+	/**
+	 * The matching entries in key order.
+	 * Contains #JMemoryEntry elements.
+	 **/
+	GPtrArray* entries;
+
+	guint position;
+};
+
+typedef struct JMemoryIterator JMemoryIterator;
+
+static JMemoryEntry*
+memory_entry_new(gchar const* key, gconstpointer value, guint32 len)
+{
+	JMemoryEntry* entry;
+
+	entry = g_slice_new(JMemoryEntry);
+	entry->key = g_strdup(key);
+	entry->value = g_memdup(value, len);
+	entry->len = len;
+	entry->ref_count = 1;
+
+	return entry;
+}
+
+static JMemoryEntry*
+memory_entry_ref(JMemoryEntry* entry)
+{
+	g_atomic_int_inc(&(entry->ref_count));
+
+	return entry;
+}
+
+static void
+memory_entry_unref(gpointer data)
+{
+	JMemoryEntry* entry = data;
+
+	if (g_atomic_int_dec_and_test(&(entry->ref_count)))
+	{
+		g_free(entry->value);
+		g_free(entry->key);
+
+		g_slice_free(JMemoryEntry, entry);
+	}
+}
+
+static gchar const*
+memory_merge_key(GPtrArray** stripe_entries, guint const* positions, guint stripe)
+{
+	JMemoryEntry const* entry = g_ptr_array_index(stripe_entries[stripe], positions[stripe]);
+
+	return entry->key;
+}
+
+/**
+ * Restores the heap property of a min-heap of stripes ordered by their next key.
+ **/
+static void
+memory_merge_sift_down(guint* heap, guint heap_len, guint i, GPtrArray** stripe_entries, guint const* positions)
+{
+	while (TRUE)
+	{
+		guint smallest = i;
+		guint left = 2 * i + 1;
+		guint right = 2 * i + 2;
+		guint tmp;
+
+		if (left < heap_len && strcmp(memory_merge_key(stripe_entries, positions, heap[left]), memory_merge_key(stripe_entries, positions, heap[smallest])) < 0)
+		{
+			smallest = left;
+		}
+
+		if (right < heap_len && strcmp(memory_merge_key(stripe_entries, positions, heap[right]), memory_merge_key(stripe_entries, positions, heap[smallest])) < 0)
+		{
+			smallest = right;
+		}
+
+		if (smallest == i)
+		{
+			break;
+		}
+
+		tmp = heap[i];
+		heap[i] = heap[smallest];
+		heap[smallest] = tmp;
+
+		i = smallest;
+	}
+}
+
+/**
+ * Merges the stripes' entries, which are sorted on their own, into one sorted array.
+ * The references are moved to #entries.
+ **/
+static void
+memory_merge(GPtrArray** stripe_entries, GPtrArray* entries)
+{
+	guint heap[J_MEMORY_STRIPES];
+	guint positions[J_MEMORY_STRIPES];
+	guint heap_len = 0;
+
+	for (guint i = 0; i < J_MEMORY_STRIPES; i++)
+	{
+		positions[i] = 0;
+
+		if (stripe_entries[i]->len > 0)
+		{
+			heap[heap_len] = i;
+			heap_len++;
+		}
+	}
+
+	for (guint i = heap_len / 2; i > 0; i--)
+	{
+		memory_merge_sift_down(heap, heap_len, i - 1, stripe_entries, positions);
+	}
+
+	while (heap_len > 0)
+	{
+		guint stripe = heap[0];
+
+		g_ptr_array_add(entries, g_ptr_array_index(stripe_entries[stripe], positions[stripe]));
+		positions[stripe]++;
+
+		if (positions[stripe] == stripe_entries[stripe]->len)
+		{
+			heap_len--;
+			heap[0] = heap[heap_len];
+		}
+
+		memory_merge_sift_down(heap, heap_len, 0, stripe_entries, positions);
+	}
+}
+
+static JMemoryNode*
+memory_node_new(JMemoryEntry* entry, guint levels)
+{
+	JMemoryNode* node;
+
+	node = g_malloc0(sizeof(JMemoryNode) + levels * sizeof(JMemoryNode*));
+	node->entry = entry;
+	node->levels = levels;
+
+	return node;
+}
+
+static void
+memory_stripe_init(JMemoryStripe* stripe)
+{
+	stripe->nodes = g_hash_table_new(g_str_hash, g_str_equal);
+	stripe->head = memory_node_new(NULL, J_MEMORY_SKIPLIST_LEVELS);
+	stripe->levels = 1;
+	stripe->rand = g_rand_new();
+
+	g_rw_lock_init(stripe->lock);
+}
+
+static void
+memory_stripe_clear(JMemoryStripe* stripe)
+{
+	JMemoryNode* node;
+
+	node = stripe->head->next[0];
+
+	while (node != NULL)
+	{
+		JMemoryNode* next = node->next[0];
+
+		memory_entry_unref(node->entry);
+		g_free(node);
+
+		node = next;
+	}
+
+	g_free(stripe->head);
+	g_hash_table_unref(stripe->nodes);
+	g_rand_free(stripe->rand);
+
+	g_rw_lock_clear(stripe->lock);
+}
+
+/**
+ * Finds the last node on each level whose key is smaller than the given key.
+ * Must be called with the stripe's lock held.
+ *
+ * \return The last node on the lowest level whose key is smaller than #key.
+ **/
+static JMemoryNode*
+memory_stripe_find(JMemoryStripe* stripe, gchar const* key, JMemoryNode** update)
+{
+	JMemoryNode* node = stripe->head;
+
+	for (guint i = stripe->levels; i > 0; i--)
+	{
+		guint level = i - 1;
+
+		while (node->next[level] != NULL && strcmp(node->next[level]->entry->key, key) < 0)
+		{
+			node = node->next[level];
+		}
+
+		if (update != NULL)
+		{
+			update[level] = node;
+		}
+	}
+
+	return node;
+}
+
+/**
+ * Stores an entry.
+ * Must be called with the stripe's lock held for writing.
+ **/
+static void
+memory_stripe_put(JMemoryStripe* stripe, gchar const* key, gconstpointer value, guint32 len)
+{
+	JMemoryEntry* entry;
+	JMemoryNode* node;
+
+	entry = memory_entry_new(key, value, len);
+
+	if ((node = g_hash_table_lookup(stripe->nodes, key)) != NULL)
+	{
+		JMemoryEntry* old_entry = node->entry;
+
+		node->entry = entry;
+		// The hash table's key belongs to the old entry
+		g_hash_table_replace(stripe->nodes, entry->key, node);
+		memory_entry_unref(old_entry);
+	}
+	else
+	{
+		JMemoryNode* update[J_MEMORY_SKIPLIST_LEVELS];
+		guint levels = 1;
+
+		while (levels < J_MEMORY_SKIPLIST_LEVELS && (g_rand_int(stripe->rand) & 3) == 0)
+		{
+			levels++;
+		}
+
+		memory_stripe_find(stripe, key, update);
+
+		for (guint i = stripe->levels; i < levels; i++)
+		{
+			update[i] = stripe->head;
+		}
+
+		stripe->levels = MAX(stripe->levels, levels);
+
+		node = memory_node_new(entry, levels);
+
+		for (guint i = 0; i < levels; i++)
+		{
+			node->next[i] = update[i]->next[i];
+			update[i]->next[i] = node;
+		}
+
+		g_hash_table_insert(stripe->nodes, entry->key, node);
+	}
+}
+
+/**
+ * Removes an entry.
+ * Must be called with the stripe's lock held for writing.
+ **/
+static gboolean
+memory_stripe_delete(JMemoryStripe* stripe, gchar const* key)
+{
+	JMemoryNode* update[J_MEMORY_SKIPLIST_LEVELS];
+	JMemoryNode* node;
+
+	if ((node = g_hash_table_lookup(stripe->nodes, key)) == NULL)
+	{
+		return FALSE;
+	}
+
+	g_hash_table_remove(stripe->nodes, key);
+
+	memory_stripe_find(stripe, key, update);
+
+	for (guint i = 0; i < node->levels; i++)
+	{
+		if (update[i]->next[i] == node)
+		{
+			update[i]->next[i] = node->next[i];
+		}
+	}
+
+	while (stripe->levels > 1 && stripe->head->next[stripe->levels - 1] == NULL)
+	{
+		stripe->levels--;
+	}
+
+	memory_entry_unref(node->entry);
+	g_free(node);
+
+	return TRUE;
+}
+
+/**
+ * Collects references to all entries starting with a prefix.
+ * Must be called with the stripe's lock held.
+ **/
+static void
+memory_stripe_collect(JMemoryStripe* stripe, gchar const* prefix, GPtrArray* entries)
+{
+	JMemoryNode* node;
+
+	// The skip list is sorted by key, so all matching entries follow the lower bound
+	node = memory_stripe_find(stripe, prefix, NULL);
+
+	for (node = node->next[0]; node != NULL && g_str_has_prefix(node->entry->key, prefix); node = node->next[0])
+	{
+		g_ptr_array_add(entries, memory_entry_ref(node->entry));
+	}
+}
+
+static JMemoryStripe*
+memory_namespace_get_stripe(JMemoryNamespace* namespace, gchar const* key)
+{
+	return &(namespace->stripes[g_str_hash(key) % J_MEMORY_STRIPES]);
+}
+
+static void
+memory_namespace_free(gpointer data)
+{
+	JMemoryNamespace* namespace = data;
+
+	for (guint i = 0; i < J_MEMORY_STRIPES; i++)
+	{
+		memory_stripe_clear(&(namespace->stripes[i]));
+	}
+
+	g_free(namespace->name);
+
+	g_slice_free(JMemoryNamespace, namespace);
+}
+
+/**
+ * Returns a namespace.
+ *
+ * \param bd        The backend data.
+ * \param name      The namespace's name.
+ * \param create    Whether to create the namespace if it does not exist.
+ *
+ * \return The namespace, NULL if it does not exist and #create is FALSE.
+ **/
+static JMemoryNamespace*
+memory_get_namespace(JMemoryData* bd, gchar const* name, gboolean create)
+{
+	JMemoryNamespace* namespace;
+
+	g_rw_lock_reader_lock(bd->lock);
+	namespace = g_hash_table_lookup(bd->namespaces, name);
+	g_rw_lock_reader_unlock(bd->lock);
+
+	if (namespace != NULL || !create)
+	{
+		return namespace;
+	}
+
+	g_rw_lock_writer_lock(bd->lock);
+
+	// Another thread might have created the namespace in the meantime
+	if ((namespace = g_hash_table_lookup(bd->namespaces, name)) == NULL)
+	{
+		namespace = g_slice_new(JMemoryNamespace);
+		namespace->name = g_strdup(name);
+
+		for (guint i = 0; i < J_MEMORY_STRIPES; i++)
+		{
+			memory_stripe_init(&(namespace->stripes[i]));
+		}
+
+		g_hash_table_insert(bd->namespaces, namespace->name, namespace);
+	}
+
+	g_rw_lock_writer_unlock(bd->lock);
+
+	return namespace;
+}
+
+static gboolean
+memory_snapshot_write_string(FILE* file, gchar const* string)
+{
+	guint32 len;
+
+	len = strlen(string);
+
+	return (fwrite(&len, sizeof(len), 1, file) == 1 && fwrite(string, 1, len, file) == len);
+}
+
+/**
+ * Makes a rename in a directory durable.
+ **/
+static gboolean
+memory_snapshot_sync_directory(gchar const* path)
+{
+	g_autofree gchar* dirname = NULL;
+	gboolean ret;
+	gint fd;
+
+	dirname = g_path_get_dirname(path);
+
+	if ((fd = open(dirname, O_RDONLY)) == -1)
+	{
+		return FALSE;
+	}
+
+	ret = (fsync(fd) == 0);
+	close(fd);
+
+	return ret;
+}
+
+/**
+ * Writes all namespaces to the snapshot file.
+ * The snapshot is written and synced to a temporary file first and renamed afterwards, so a crash never leaves a partial snapshot behind.
+ * Values are stored in host byte order.
+ **/
+static gboolean
+memory_snapshot_write(JMemoryData* bd)
+{
+	gboolean ret = TRUE;
+
+	GHashTableIter iter[1];
+	FILE* file;
+	g_autofree gchar* tmp_path = NULL;
+	gpointer value;
+
+	tmp_path = g_strdup_printf("%s.tmp", bd->snapshot_path);
+
+	if ((file = g_fopen(tmp_path, "wb")) == NULL)
+	{
+		g_warning("Could not write snapshot %s.", tmp_path);
+		return FALSE;
+	}
+
+	ret = (fwrite(J_MEMORY_SNAPSHOT_MAGIC, 1, strlen(J_MEMORY_SNAPSHOT_MAGIC), file) == strlen(J_MEMORY_SNAPSHOT_MAGIC));
+
+	g_rw_lock_reader_lock(bd->lock);
+	g_hash_table_iter_init(iter, bd->namespaces);
+
+	while (ret && g_hash_table_iter_next(iter, NULL, &value))
+	{
+		JMemoryNamespace* namespace = value;
+
+		for (guint i = 0; ret && i < J_MEMORY_STRIPES; i++)
+		{
+			JMemoryStripe* stripe = &(namespace->stripes[i]);
+
+			g_rw_lock_reader_lock(stripe->lock);
+
+			for (JMemoryNode* node = stripe->head->next[0]; ret && node != NULL; node = node->next[0])
+			{
+				ret = memory_snapshot_write_string(file, namespace->name)
+				      && memory_snapshot_write_string(file, node->entry->key)
+				      && fwrite(&(node->entry->len), sizeof(node->entry->len), 1, file) == 1
+				      && fwrite(node->entry->value, 1, node->entry->len, file) == node->entry->len;
+			}
+
+			g_rw_lock_reader_unlock(stripe->lock);
+		}
+	}
+
+	g_rw_lock_reader_unlock(bd->lock);
+
+	// The data has to be on disk before the rename makes it visible
+	ret = ret && fflush(file) == 0 && fsync(fileno(file)) == 0;
+	ret = (fclose(file) == 0) && ret;
+
+	if (ret)
+	{
+		ret = (g_rename(tmp_path, bd->snapshot_path) == 0) && memory_snapshot_sync_directory(bd->snapshot_path);
+
+		if (!ret)
+		{
+			g_warning("Could not replace snapshot %s.", bd->snapshot_path);
+		}
+	}
+	else
+	{
+		g_warning("Could not write snapshot %s.", tmp_path);
+		g_unlink(tmp_path);
+	}
+
+	return ret;
+}
+
+/**
+ * Reads a length and allocates a buffer for the data following it.
+ * The length is checked against the rest of the file, so corrupt snapshots can not cause huge allocations.
+ *
+ * \param file A snapshot.
+ * \param size The snapshot's size.
+ * \param extra The number of additional bytes to allocate.
+ * \param data Returns the data, NULL if nothing has been allocated.
+ * \param len Returns the length.
+ *
+ * \return TRUE on success, FALSE if the snapshot is truncated or corrupt.
+ **/
+static gboolean
+memory_snapshot_read_data(FILE* file, gsize size, gsize extra, gpointer* data, guint32* len)
+{
+	glong position;
+
+	*data = NULL;
+
+	if (fread(len, sizeof(*len), 1, file) != 1)
+	{
+		return FALSE;
+	}
+
+	if ((position = ftell(file)) < 0 || (gsize)position > size || *len > size - (gsize)position)
+	{
+		return FALSE;
+	}
+
+	if ((gsize)*len + extra == 0)
+	{
+		return TRUE;
+	}
+
+	if ((*data = g_try_malloc((gsize)*len + extra)) == NULL)
+	{
+		return FALSE;
+	}
+
+	if (fread(*data, 1, *len, file) != *len)
+	{
+		g_clear_pointer(data, g_free);
+		return FALSE;
+	}
+
+	return TRUE;
+}
+
+static gchar*
+memory_snapshot_read_string(FILE* file, gsize size)
+{
+	gpointer string;
+	guint32 len;
+
+	if (!memory_snapshot_read_data(file, size, 1, &string, &len))
+	{
+		return NULL;
+	}
+
+	((gchar*)string)[len] = '\0';
+
+	return string;
+}
+
+/**
+ * Loads the snapshot file, if it exists.
+ **/
+static gboolean
+memory_snapshot_read(JMemoryData* bd)
+{
+	gboolean ret = TRUE;
+
+	FILE* file;
+	GStatBuf buf;
+	gchar magic[sizeof(J_MEMORY_SNAPSHOT_MAGIC)];
+
+	if ((file = g_fopen(bd->snapshot_path, "rb")) == NULL)
+	{
+		// Nothing to restore
+		return TRUE;
+	}
+
+	if (fstat(fileno(file), &buf) != 0)
+	{
+		g_warning("Could not get size of snapshot %s.", bd->snapshot_path);
+		ret = FALSE;
+		goto end;
+	}
+
+	if (fread(magic, 1, strlen(J_MEMORY_SNAPSHOT_MAGIC), file) != strlen(J_MEMORY_SNAPSHOT_MAGIC)
+	    || memcmp(magic, J_MEMORY_SNAPSHOT_MAGIC, strlen(J_MEMORY_SNAPSHOT_MAGIC)) != 0)
+	{
+		g_warning("Snapshot %s has an unknown format.", bd->snapshot_path);
+		ret = FALSE;
+		goto end;
+	}
+
+	while (TRUE)
+	{
+		JMemoryNamespace* namespace;
+		JMemoryStripe* stripe;
+		g_autofree gchar* name = NULL;
+		g_autofree gchar* key = NULL;
+		g_autofree gpointer value = NULL;
+		guint32 len;
+
+		// End of snapshot
+		if (ftell(file) == (glong)buf.st_size)
+		{
+			break;
+		}
+
+		if ((name = memory_snapshot_read_string(file, buf.st_size)) == NULL
+		    || (key = memory_snapshot_read_string(file, buf.st_size)) == NULL)
+		{
+			ret = FALSE;
+			break;
+		}
+
+		if (!memory_snapshot_read_data(file, buf.st_size, 0, &value, &len))
+		{
+			ret = FALSE;
+			break;
+		}
+
+		namespace = memory_get_namespace(bd, name, TRUE);
+		stripe = memory_namespace_get_stripe(namespace, key);
+		memory_stripe_put(stripe, key, value, len);
+	}
+
+	if (!ret)
+	{
+		g_warning("Snapshot %s is truncated or corrupt.", bd->snapshot_path);
+	}
+
+end:
+	fclose(file);
+
+	return ret;
+}
+
+static gpointer
+memory_snapshot_thread(gpointer data)
+{
+	JMemoryData* bd = data;
+
+	g_mutex_lock(bd->snapshot_mutex);
+
+	while (!bd->snapshot_stop)
+	{
+		gint64 end_time;
+
+		end_time = g_get_monotonic_time() + bd->snapshot_interval * G_TIME_SPAN_SECOND;
+
+		if (!g_cond_wait_until(bd->snapshot_cond, bd->snapshot_mutex, end_time))
+		{
+			g_mutex_unlock(bd->snapshot_mutex);
+			memory_snapshot_write(bd);
+			g_mutex_lock(bd->snapshot_mutex);
+		}
+	}
+
+	g_mutex_unlock(bd->snapshot_mutex);
+
+	return NULL;
+}
+
+static gboolean
+backend_batch_start(gpointer backend_data, gchar const* namespace, JSemantics* semantics, gpointer* backend_batch)
+{
+	JMemoryData* bd = backend_data;
+	JMemoryBatch* batch;
+
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(backend_batch != NULL, FALSE);
+
+	batch = g_slice_new(JMemoryBatch);
+	batch->namespace = memory_get_namespace(bd, namespace, TRUE);
+	batch->semantics = j_semantics_ref(semantics);
+
+	*backend_batch = batch;
+
+	return TRUE;
+}
+
+static gboolean
+backend_batch_execute(gpointer backend_data, gpointer backend_batch)
+{
+	JMemoryBatch* batch = backend_batch;
+
+	(void)backend_data;
+
+	g_return_val_if_fail(backend_batch != NULL, FALSE);
+
+	// Operations are applied immediately, there is nothing left to do
+
+	j_semantics_unref(batch->semantics);
+	g_slice_free(JMemoryBatch, batch);
+
+	return TRUE;
+}
+
+static gboolean
+backend_put(gpointer backend_data, gpointer backend_batch, gchar const* key, gconstpointer value, guint32 len)
+{
+	JMemoryBatch* batch = backend_batch;
+	JMemoryStripe* stripe;
+
+	(void)backend_data;
+
+	g_return_val_if_fail(backend_batch != NULL, FALSE);
+	g_return_val_if_fail(key != NULL, FALSE);
+	g_return_val_if_fail(value != NULL, FALSE);
+
+	stripe = memory_namespace_get_stripe(batch->namespace, key);
+
+	g_rw_lock_writer_lock(stripe->lock);
+	memory_stripe_put(stripe, key, value, len);
+	g_rw_lock_writer_unlock(stripe->lock);
+
+	return TRUE;
+}
+
+static gboolean
+backend_delete(gpointer backend_data, gpointer backend_batch, gchar const* key)
+{
+	gboolean ret;
+
+	JMemoryBatch* batch = backend_batch;
+	JMemoryStripe* stripe;
+
+	(void)backend_data;
+
+	g_return_val_if_fail(backend_batch != NULL, FALSE);
+	g_return_val_if_fail(key != NULL, FALSE);
+
+	stripe = memory_namespace_get_stripe(batch->namespace, key);
+
+	g_rw_lock_writer_lock(stripe->lock);
+	ret = memory_stripe_delete(stripe, key);
+	g_rw_lock_writer_unlock(stripe->lock);
+
+	return ret;
+}
+
+static gboolean
+backend_get(gpointer backend_data, gpointer backend_batch, gchar const* key, gpointer* value, guint32* len)
+{
+	gboolean ret = FALSE;
+
+	JMemoryBatch* batch = backend_batch;
+	JMemoryNode* node;
+	JMemoryStripe* stripe;
+
+	(void)backend_data;
+
+	g_return_val_if_fail(backend_batch != NULL, FALSE);
+	g_return_val_if_fail(key != NULL, FALSE);
+	g_return_val_if_fail(value != NULL, FALSE);
+	g_return_val_if_fail(len != NULL, FALSE);
+
+	stripe = memory_namespace_get_stripe(batch->namespace, key);
+
+	g_rw_lock_reader_lock(stripe->lock);
+
+	if ((node = g_hash_table_lookup(stripe->nodes, key)) != NULL)
+	{
+		*value = g_memdup(node->entry->value, node->entry->len);
+		*len = node->entry->len;
+
+		ret = TRUE;
+	}
+
+	g_rw_lock_reader_unlock(stripe->lock);
+
+	return ret;
+}
+
+static gboolean
+backend_get_by_prefix(gpointer backend_data, gchar const* namespace, gchar const* prefix, gpointer* backend_iterator)
+{
+	JMemoryData* bd = backend_data;
+	JMemoryIterator* iterator;
+	JMemoryNamespace* ns;
+
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(prefix != NULL, FALSE);
+	g_return_val_if_fail(backend_iterator != NULL, FALSE);
+
+	iterator = g_slice_new(JMemoryIterator);
+	iterator->entries = g_ptr_array_new_with_free_func(memory_entry_unref);
+	iterator->position = 0;
+
+	if ((ns = memory_get_namespace(bd, namespace, FALSE)) != NULL)
+	{
+		GPtrArray* stripe_entries[J_MEMORY_STRIPES];
+
+		for (guint i = 0; i < J_MEMORY_STRIPES; i++)
+		{
+			JMemoryStripe* stripe = &(ns->stripes[i]);
+
+			stripe_entries[i] = g_ptr_array_new();
+
+			g_rw_lock_reader_lock(stripe->lock);
+			memory_stripe_collect(stripe, prefix, stripe_entries[i]);
+			g_rw_lock_reader_unlock(stripe->lock);
+		}
+
+		// Each stripe is sorted on its own, merge them
+		memory_merge(stripe_entries, iterator->entries);
+
+		for (guint i = 0; i < J_MEMORY_STRIPES; i++)
+		{
+			g_ptr_array_unref(stripe_entries[i]);
+		}
+	}
+
+	*backend_iterator = iterator;
+
+	return TRUE;
+}
+
+static gboolean
+backend_get_all(gpointer backend_data, gchar const* namespace, gpointer* backend_iterator)
+{
+	return backend_get_by_prefix(backend_data, namespace, "", backend_iterator);
+}
+
+static gboolean
+backend_iterate(gpointer backend_data, gpointer backend_iterator, gchar const** key, gconstpointer* value, guint32* len)
+{
+	JMemoryIterator* iterator = backend_iterator;
+
+	(void)backend_data;
+
+	g_return_val_if_fail(backend_iterator != NULL, FALSE);
+	g_return_val_if_fail(key != NULL, FALSE);
+	g_return_val_if_fail(value != NULL, FALSE);
+	g_return_val_if_fail(len != NULL, FALSE);
+
+	if (iterator->position < iterator->entries->len)
+	{
+		JMemoryEntry* entry = g_ptr_array_index(iterator->entries, iterator->position);
+
+		*key = entry->key;
+		*value = entry->value;
+		*len = entry->len;
+
+		iterator->position++;
+
+		return TRUE;
+	}
+
+	g_ptr_array_unref(iterator->entries);
+	g_slice_free(JMemoryIterator, iterator);
+
+	return FALSE;
+}
+
+static void
+memory_data_free(JMemoryData* bd)
+{
+	g_hash_table_unref(bd->namespaces);
+
+	g_cond_clear(bd->snapshot_cond);
+	g_mutex_clear(bd->snapshot_mutex);
+	g_rw_lock_clear(bd->lock);
+
+	g_free(bd->snapshot_path);
+
+	g_slice_free(JMemoryData, bd);
+}
+
+static gboolean
+backend_init(gchar const* path, gpointer* backend_data)
+{
+	JMemoryData* bd;
+	g_auto(GStrv) split = NULL;
+
+	g_return_val_if_fail(path != NULL, FALSE);
+
+	/* Path syntax: [snapshot-path][:snapshot-interval]
+	   e.g.: /tmp/julea-kv.snapshot:60 */
+	split = g_strsplit(path, ":", 2);
+
+	bd = g_slice_new(JMemoryData);
+	bd->namespaces = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, memory_namespace_free);
+	bd->snapshot_path = NULL;
+	bd->snapshot_interval = 0;
+	bd->snapshot_thread = NULL;
+	bd->snapshot_stop = FALSE;
+
+	g_rw_lock_init(bd->lock);
+	g_mutex_init(bd->snapshot_mutex);
+	g_cond_init(bd->snapshot_cond);
+
+	if (split[0] != NULL && split[0][0] != '\0')
+	{
+		g_autofree gchar* dirname = NULL;
+
+		bd->snapshot_path = g_strdup(split[0]);
+
+		dirname = g_path_get_dirname(bd->snapshot_path);
+		g_mkdir_with_parents(dirname, 0700);
+
+		if (split[1] != NULL)
+		{
+			bd->snapshot_interval = g_ascii_strtoull(split[1], NULL, 10);
+		}
+
+		// Starting with an empty store would overwrite the snapshot at shutdown
+		if (!memory_snapshot_read(bd))
+		{
+			g_critical("Could not restore snapshot %s.", bd->snapshot_path);
+			memory_data_free(bd);
+
+			return FALSE;
+		}
+
+		if (bd->snapshot_interval > 0)
+		{
+			bd->snapshot_thread = g_thread_new("julea-kv-memory-snapshot", memory_snapshot_thread, bd);
+		}
+	}
+
+	*backend_data = bd;
+
+	return TRUE;
+}
+
+static void
+backend_fini(gpointer backend_data)
+{
+	JMemoryData* bd = backend_data;
+
+	if (bd->snapshot_thread != NULL)
+	{
+		g_mutex_lock(bd->snapshot_mutex);
+		bd->snapshot_stop = TRUE;
+		g_cond_signal(bd->snapshot_cond);
+		g_mutex_unlock(bd->snapshot_mutex);
+
+		g_thread_join(bd->snapshot_thread);
+	}
+
+	if (bd->snapshot_path != NULL)
+	{
+		memory_snapshot_write(bd);
+	}
+
+	memory_data_free(bd);
+}
+
+static JBackend memory_backend = {
+	.type = J_BACKEND_TYPE_KV,
+	.component = J_BACKEND_COMPONENT_CLIENT | J_BACKEND_COMPONENT_SERVER,
+	.kv = {
+		.backend_init = backend_init,
+		.backend_fini = backend_fini,
+		.backend_batch_start = backend_batch_start,
+		.backend_batch_execute = backend_batch_execute,
+		.backend_put = backend_put,
+		.backend_delete = backend_delete,
+		.backend_get = backend_get,
+		.backend_get_all = backend_get_all,
+		.backend_get_by_prefix = backend_get_by_prefix,
+		.backend_iterate = backend_iterate }
+};
+
+G_MODULE_EXPORT
+JBackend*
+backend_info(void)
+{
+	return &memory_backend;
+}
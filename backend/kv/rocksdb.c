@@ -20,6 +20,7 @@
 
 #include <glib.h>
 #include <gmodule.h>
+#include <glib/gstdio.h>
 
 #include <rocksdb/c.h>
 
@@ -34,10 +35,30 @@ struct JRocksDBBatch
 
 typedef struct JRocksDBBatch JRocksDBBatch;
 
+struct JRocksDBBulk
+{
+	rocksdb_sstfilewriter_t* writer;
+	gchar* path;
+	guint64 count;
+	gchar* last_key;
+
+	/**
+	 * Keys that are not strictly ascending cannot be added to the SST file.
+	 * They are stored in a regular batch that is written after ingesting the file.
+	 **/
+	JRocksDBBatch* batch;
+};
+
+typedef struct JRocksDBBulk JRocksDBBulk;
+
 struct JRocksDBData
 {
 	rocksdb_t* db;
+	gchar* path;
 
+	rocksdb_options_t* options;
+	rocksdb_envoptions_t* env_options;
+	rocksdb_ingestexternalfileoptions_t* ingest_options;
 	rocksdb_readoptions_t* read_options;
 	rocksdb_writeoptions_t* write_options;
 	rocksdb_writeoptions_t* write_options_sync;
@@ -164,6 +185,111 @@ backend_get(gpointer backend_data, gpointer backend_batch, gchar const* key, gpo
 	return (result != NULL);
 }
 
+static gboolean
+backend_bulk_start(gpointer backend_data, gchar const* namespace, JSemantics* semantics, gpointer* backend_bulk)
+{
+	JRocksDBData* bd = backend_data;
+	JRocksDBBulk* bulk;
+	g_autofree gchar* rocksdb_error = NULL;
+	static gint counter = 0;
+
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(backend_bulk != NULL, FALSE);
+
+	bulk = g_slice_new(JRocksDBBulk);
+	bulk->writer = rocksdb_sstfilewriter_create(bd->env_options, bd->options);
+	bulk->path = g_strdup_printf("%s.bulk-%d.sst", bd->path, g_atomic_int_add(&counter, 1));
+	bulk->count = 0;
+	bulk->last_key = NULL;
+	bulk->batch = NULL;
+
+	backend_batch_start(backend_data, namespace, semantics, (gpointer*)&(bulk->batch));
+
+	rocksdb_sstfilewriter_open(bulk->writer, bulk->path, &rocksdb_error);
+
+	if (rocksdb_error != NULL)
+	{
+		rocksdb_sstfilewriter_destroy(bulk->writer);
+		bulk->writer = NULL;
+	}
+
+	*backend_bulk = bulk;
+
+	return TRUE;
+}
+
+static gboolean
+backend_bulk_put(gpointer backend_data, gpointer backend_bulk, gchar const* key, gconstpointer value, guint32 len)
+{
+	JRocksDBBulk* bulk = backend_bulk;
+	g_autofree gchar* nskey = NULL;
+	g_autofree gchar* rocksdb_error = NULL;
+
+	g_return_val_if_fail(backend_bulk != NULL, FALSE);
+	g_return_val_if_fail(key != NULL, FALSE);
+	g_return_val_if_fail(value != NULL, FALSE);
+
+	if (bulk->writer == NULL || (bulk->last_key != NULL && g_strcmp0(key, bulk->last_key) <= 0))
+	{
+		return backend_put(backend_data, bulk->batch, key, value, len);
+	}
+
+	nskey = g_strdup_printf("%s:%s", bulk->batch->namespace, key);
+	rocksdb_sstfilewriter_put(bulk->writer, nskey, strlen(nskey) + 1, value, len, &rocksdb_error);
+
+	if (rocksdb_error != NULL)
+	{
+		return backend_put(backend_data, bulk->batch, key, value, len);
+	}
+
+	g_free(bulk->last_key);
+	bulk->last_key = g_strdup(key);
+	bulk->count++;
+
+	return TRUE;
+}
+
+static gboolean
+backend_bulk_execute(gpointer backend_data, gpointer backend_bulk)
+{
+	JRocksDBBulk* bulk = backend_bulk;
+	JRocksDBData* bd = backend_data;
+	gboolean ret = TRUE;
+
+	g_return_val_if_fail(backend_bulk != NULL, FALSE);
+
+	if (bulk->writer != NULL)
+	{
+		if (bulk->count > 0)
+		{
+			g_autofree gchar* finish_error = NULL;
+			g_autofree gchar* ingest_error = NULL;
+			gchar const* files[] = { bulk->path };
+
+			rocksdb_sstfilewriter_finish(bulk->writer, &finish_error);
+
+			if (finish_error == NULL)
+			{
+				// The file is moved into the database, it only remains if ingesting failed
+				rocksdb_ingest_external_file(bd->db, files, G_N_ELEMENTS(files), bd->ingest_options, &ingest_error);
+			}
+
+			ret = (finish_error == NULL && ingest_error == NULL);
+		}
+
+		rocksdb_sstfilewriter_destroy(bulk->writer);
+		g_unlink(bulk->path);
+	}
+
+	ret = backend_batch_execute(backend_data, bulk->batch) && ret;
+
+	g_free(bulk->last_key);
+	g_free(bulk->path);
+	g_slice_free(JRocksDBBulk, bulk);
+
+	return ret;
+}
+
 static gboolean
 backend_get_all(gpointer backend_data, gchar const* namespace, gpointer* backend_iterator)
 {
@@ -269,7 +395,6 @@ static gboolean
 backend_init(gchar const* path, gpointer* backend_data)
 {
 	JRocksDBData* bd;
-	rocksdb_options_t* options;
 	g_autofree gchar* dirname = NULL;
 	gint const compressions[] = { rocksdb_lz4_compression, rocksdb_snappy_compression, rocksdb_no_compression };
 
@@ -279,20 +404,24 @@ backend_init(gchar const* path, gpointer* backend_data)
 	g_mkdir_with_parents(dirname, 0700);
 
 	bd = g_slice_new(JRocksDBData);
+	bd->path = g_strdup(path);
+	bd->env_options = rocksdb_envoptions_create();
+	bd->ingest_options = rocksdb_ingestexternalfileoptions_create();
+	rocksdb_ingestexternalfileoptions_set_move_files(bd->ingest_options, 1);
 	bd->read_options = rocksdb_readoptions_create();
 	bd->write_options = rocksdb_writeoptions_create();
 	bd->write_options_sync = rocksdb_writeoptions_create();
 	rocksdb_writeoptions_set_sync(bd->write_options_sync, 1);
 
-	options = rocksdb_options_create();
-	rocksdb_options_set_create_if_missing(options, 1);
+	bd->options = rocksdb_options_create();
+	rocksdb_options_set_create_if_missing(bd->options, 1);
 
 	for (guint i = 0; i < G_N_ELEMENTS(compressions); i++)
 	{
 		g_autofree gchar* error = NULL;
 
-		rocksdb_options_set_compression(options, compressions[i]);
-		bd->db = rocksdb_open(options, path, &error);
+		rocksdb_options_set_compression(bd->options, compressions[i]);
+		bd->db = rocksdb_open(bd->options, path, &error);
 
 		if (bd->db != NULL)
 		{
@@ -300,8 +429,7 @@ backend_init(gchar const* path, gpointer* backend_data)
 		}
 	}
 
-	rocksdb_options_destroy(options);
-
+	// The options are kept for creating SST files with matching settings
 	*backend_data = bd;
 
 	return (bd->db != NULL);
@@ -315,12 +443,17 @@ backend_fini(gpointer backend_data)
 	rocksdb_readoptions_destroy(bd->read_options);
 	rocksdb_writeoptions_destroy(bd->write_options);
 	rocksdb_writeoptions_destroy(bd->write_options_sync);
+	rocksdb_ingestexternalfileoptions_destroy(bd->ingest_options);
+	rocksdb_envoptions_destroy(bd->env_options);
 
 	if (bd->db != NULL)
 	{
 		rocksdb_close(bd->db);
 	}
 
+	rocksdb_options_destroy(bd->options);
+	g_free(bd->path);
+
 	g_slice_free(JRocksDBData, bd);
 }
 
@@ -337,7 +470,10 @@ static JBackend rocksdb_backend = {
 		.backend_get = backend_get,
 		.backend_get_all = backend_get_all,
 		.backend_get_by_prefix = backend_get_by_prefix,
-		.backend_iterate = backend_iterate }
+		.backend_iterate = backend_iterate,
+		.backend_bulk_start = backend_bulk_start,
+		.backend_bulk_put = backend_bulk_put,
+		.backend_bulk_execute = backend_bulk_execute }
 };
 
 G_MODULE_EXPORT
@@ -89,6 +89,159 @@ benchmark_kv_put_batch(BenchmarkResult* result)
 	_benchmark_kv_put(result, TRUE);
 }
 
+static void
+benchmark_kv_bulk_put(BenchmarkResult* result)
+{
+	guint const n = 200000;
+
+	g_autoptr(JBatch) delete_batch = NULL;
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JSemantics) semantics = NULL;
+	gdouble elapsed;
+	gboolean ret;
+
+	semantics = j_benchmark_get_semantics();
+	delete_batch = j_batch_new(semantics);
+	batch = j_batch_new(semantics);
+
+	j_benchmark_timer_start();
+
+	for (guint i = 0; i < n; i++)
+	{
+		g_autoptr(JKV) object = NULL;
+		g_autofree gchar* name = NULL;
+
+		name = g_strdup_printf("benchmark-%d", i);
+		object = j_kv_new("benchmark", name);
+		j_kv_bulk_put(object, g_strdup("empty"), 6, g_free, batch);
+
+		j_kv_delete(object, delete_batch);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	elapsed = j_benchmark_timer_elapsed();
+
+	ret = j_batch_execute(delete_batch);
+	g_assert_true(ret);
+
+	result->elapsed_time = elapsed;
+	result->operations = n;
+}
+
+struct BenchmarkKVPutSync
+{
+	guint index;
+	guint n;
+};
+
+typedef struct BenchmarkKVPutSync BenchmarkKVPutSync;
+
+static gpointer
+_benchmark_kv_put_sync_thread(gpointer data)
+{
+	BenchmarkKVPutSync* put_sync = data;
+
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JSemantics) semantics = NULL;
+	gboolean ret;
+
+	semantics = j_semantics_new(J_SEMANTICS_TEMPLATE_DEFAULT);
+	j_semantics_set(semantics, J_SEMANTICS_SAFETY, J_SEMANTICS_SAFETY_STORAGE);
+	batch = j_batch_new(semantics);
+
+	for (guint i = 0; i < put_sync->n; i++)
+	{
+		g_autoptr(JKV) object = NULL;
+		g_autofree gchar* name = NULL;
+
+		name = g_strdup_printf("benchmark-%u-%u", put_sync->index, i);
+		object = j_kv_new("benchmark", name);
+		j_kv_put(object, g_strdup("empty"), 6, g_free, batch);
+
+		ret = j_batch_execute(batch);
+		g_assert_true(ret);
+	}
+
+	return NULL;
+}
+
+/**
+ * Measures synchronous puts of multiple concurrent clients.
+ * Each client waits for its put to be on storage before issuing the next one.
+ **/
+static void
+_benchmark_kv_put_sync(BenchmarkResult* result, guint clients)
+{
+	guint const n = 1000;
+
+	g_autoptr(JBatch) delete_batch = NULL;
+	g_autoptr(JSemantics) semantics = NULL;
+	g_autofree GThread** threads = NULL;
+	g_autofree BenchmarkKVPutSync* put_syncs = NULL;
+	gdouble elapsed;
+	gboolean ret;
+
+	semantics = j_benchmark_get_semantics();
+	delete_batch = j_batch_new(semantics);
+	threads = g_new(GThread*, clients);
+	put_syncs = g_new(BenchmarkKVPutSync, clients);
+
+	j_benchmark_timer_start();
+
+	for (guint i = 0; i < clients; i++)
+	{
+		put_syncs[i].index = i;
+		put_syncs[i].n = n;
+		threads[i] = g_thread_new("benchmark-kv-put-sync", _benchmark_kv_put_sync_thread, &(put_syncs[i]));
+	}
+
+	for (guint i = 0; i < clients; i++)
+	{
+		g_thread_join(threads[i]);
+	}
+
+	elapsed = j_benchmark_timer_elapsed();
+
+	for (guint i = 0; i < clients; i++)
+	{
+		for (guint j = 0; j < n; j++)
+		{
+			g_autoptr(JKV) object = NULL;
+			g_autofree gchar* name = NULL;
+
+			name = g_strdup_printf("benchmark-%u-%u", i, j);
+			object = j_kv_new("benchmark", name);
+			j_kv_delete(object, delete_batch);
+		}
+	}
+
+	ret = j_batch_execute(delete_batch);
+	g_assert_true(ret);
+
+	result->elapsed_time = elapsed;
+	result->operations = n * clients;
+}
+
+static void
+benchmark_kv_put_sync_1(BenchmarkResult* result)
+{
+	_benchmark_kv_put_sync(result, 1);
+}
+
+static void
+benchmark_kv_put_sync_4(BenchmarkResult* result)
+{
+	_benchmark_kv_put_sync(result, 4);
+}
+
+static void
+benchmark_kv_put_sync_16(BenchmarkResult* result)
+{
+	_benchmark_kv_put_sync(result, 16);
+}
+
 static void
 _benchmark_kv_get_callback(gpointer value, guint32 len, gpointer data)
 {
@@ -304,6 +457,10 @@ benchmark_kv(void)
 {
 	j_benchmark_run("/kv/put", benchmark_kv_put);
 	j_benchmark_run("/kv/put-batch", benchmark_kv_put_batch);
+	j_benchmark_run("/kv/bulk-put", benchmark_kv_bulk_put);
+	j_benchmark_run("/kv/put-sync-1", benchmark_kv_put_sync_1);
+	j_benchmark_run("/kv/put-sync-4", benchmark_kv_put_sync_4);
+	j_benchmark_run("/kv/put-sync-16", benchmark_kv_put_sync_16);
 	j_benchmark_run("/kv/get", benchmark_kv_get);
 	j_benchmark_run("/kv/get-batch", benchmark_kv_get_batch);
 	j_benchmark_run("/kv/delete", benchmark_kv_delete);
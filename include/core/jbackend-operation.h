@@ -116,6 +116,8 @@ G_BEGIN_DECLS
 gboolean j_backend_operation_unwrap_db_schema_create(JBackend*, gpointer, JBackendOperation*);
 gboolean j_backend_operation_unwrap_db_schema_get(JBackend*, gpointer, JBackendOperation*);
 gboolean j_backend_operation_unwrap_db_schema_delete(JBackend*, gpointer, JBackendOperation*);
+gboolean j_backend_operation_unwrap_db_index_create(JBackend*, gpointer, JBackendOperation*);
+gboolean j_backend_operation_unwrap_db_index_delete(JBackend*, gpointer, JBackendOperation*);
 gboolean j_backend_operation_unwrap_db_insert(JBackend*, gpointer, JBackendOperation*);
 gboolean j_backend_operation_unwrap_db_update(JBackend*, gpointer, JBackendOperation*);
 gboolean j_backend_operation_unwrap_db_delete(JBackend*, gpointer, JBackendOperation*);
@@ -174,6 +176,40 @@ static const JBackendOperation j_backend_operation_db_schema_delete = {
 	.out_param_count = 1,
 };
 
+static const JBackendOperation j_backend_operation_db_index_create = {
+	.in_param = {
+		{ .type = J_BACKEND_OPERATION_PARAM_TYPE_STR },
+		{ .type = J_BACKEND_OPERATION_PARAM_TYPE_STR },
+		{
+			.type = J_BACKEND_OPERATION_PARAM_TYPE_BSON,
+			.bson_initialized = TRUE,
+		},
+	},
+	.out_param = {
+		{ .type = J_BACKEND_OPERATION_PARAM_TYPE_ERROR },
+	},
+	.backend_func = j_backend_operation_unwrap_db_index_create,
+	.in_param_count = 3,
+	.out_param_count = 1,
+};
+
+static const JBackendOperation j_backend_operation_db_index_delete = {
+	.in_param = {
+		{ .type = J_BACKEND_OPERATION_PARAM_TYPE_STR },
+		{ .type = J_BACKEND_OPERATION_PARAM_TYPE_STR },
+		{
+			.type = J_BACKEND_OPERATION_PARAM_TYPE_BSON,
+			.bson_initialized = TRUE,
+		},
+	},
+	.out_param = {
+		{ .type = J_BACKEND_OPERATION_PARAM_TYPE_ERROR },
+	},
+	.backend_func = j_backend_operation_unwrap_db_index_delete,
+	.in_param_count = 3,
+	.out_param_count = 1,
+};
+
 static const JBackendOperation j_backend_operation_db_insert = {
 	.in_param = {
 		{ .type = J_BACKEND_OPERATION_PARAM_TYPE_STR },
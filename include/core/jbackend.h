@@ -35,6 +35,7 @@
 #include <bson.h>
 
 #include <core/jsemantics.h>
+#include <core/jstatistics.h>
 #include <core/jtransformation.h>
 
 G_BEGIN_DECLS
@@ -164,6 +165,16 @@ struct JBackend
 			gboolean (*backend_get_all)(gpointer, gchar const*, gpointer*);
 			gboolean (*backend_get_by_prefix)(gpointer, gchar const*, gchar const*, gpointer*);
 			gboolean (*backend_iterate)(gpointer, gpointer, gchar const**, gconstpointer*, guint32*);
+
+			/**
+			 * Load sorted key-value pairs in bulk (optional)
+			 *
+			 * Keys passed to backend_bulk_put are strictly ascending.
+			 * Backends that do not implement these functions fall back to regular batches.
+			 */
+			gboolean (*backend_bulk_start)(gpointer, gchar const*, JSemantics*, gpointer*);
+			gboolean (*backend_bulk_put)(gpointer, gpointer, gchar const*, gconstpointer, guint32);
+			gboolean (*backend_bulk_execute)(gpointer, gpointer);
 		} kv;
 
 		struct
@@ -172,6 +183,14 @@ struct JBackend
 			void (*backend_fini)(gpointer);
 
 			gboolean (*backend_batch_start)(gpointer, gchar const*, JSemantics*, gpointer*, GError**);
+
+			/**
+			* Commits and releases a batch
+			*
+			* Batches whose transaction has been aborted by a failed operation are only released.
+			*
+			* \return TRUE if the batch has been committed, FALSE otherwise.
+			**/
 			gboolean (*backend_batch_execute)(gpointer, gpointer, GError**);
 
 			/**
@@ -370,6 +389,67 @@ struct JBackend
 			* \return TRUE on success, FALSE otherwise.
 			**/
 			gboolean (*backend_iterate)(gpointer, gpointer, bson_t*, GError**);
+
+			/**
+			* Inserts multiple entries into a schema (optional)
+			*
+			* \param[in]  name     Schema name (e.g., "files")
+			* \param[in]  metadata An array of entries, each one like backend_insert's metadata
+			* \param[in]  count    The number of entries
+			* \param[out] ids      An array of initialized BSONs receiving the entries' ids
+			*
+			* Backends that do not implement this function fall back to backend_insert.
+			* On failure, backends may abort the batch, so that none of its operations take effect.
+			*
+			* \return TRUE on success, FALSE otherwise.
+			**/
+			gboolean (*backend_insert_many)(gpointer, gpointer, gchar const*, bson_t const*, guint, bson_t*, GError**);
+
+			/**
+			* Creates an index on an existing schema (optional)
+			*
+			* \param[in] name  Schema name (e.g., "files")
+			* \param[in] index The fields to index, in order
+			* \code
+			* ["var_name1", "var_name2"]
+			* \endcode
+			*
+			* Existing entries are indexed, concurrent operations on the schema should not be blocked while doing so if possible.
+			*
+			* \return TRUE on success, FALSE otherwise.
+			**/
+			gboolean (*backend_index_create)(gpointer, gpointer, gchar const*, bson_t const*, GError**);
+
+			/**
+			* Deletes an index (optional)
+			*
+			* \param[in] name  Schema name (e.g., "files")
+			* \param[in] index The indexed fields, as given when creating the index or the schema
+			*
+			* \return TRUE on success, FALSE otherwise.
+			**/
+			gboolean (*backend_index_delete)(gpointer, gpointer, gchar const*, bson_t const*, GError**);
+
+			/**
+			* Adds the backend's statistics (optional)
+			*
+			* \param[in] statistics The statistics to add to, covering all threads
+			*
+			* \return TRUE on success, FALSE otherwise.
+			**/
+			gboolean (*backend_statistics)(gpointer, JStatistics*);
+
+			/**
+			* Sets the ID of the first entry of new schemas (optional)
+			*
+			* \param[in] id_base The first ID, see j_backend_db_id_base()
+			*
+			* Called before any other operation if there are multiple DB servers, so that IDs are unique across all servers.
+			* Backends that do not implement this function can only be used with a single DB server.
+			*
+			* \return TRUE on success, FALSE otherwise.
+			**/
+			gboolean (*backend_set_id_base)(gpointer, guint32);
 		} db;
 	};
 };
@@ -417,6 +497,10 @@ gboolean j_backend_kv_get_all(JBackend*, gchar const*, gpointer*);
 gboolean j_backend_kv_get_by_prefix(JBackend*, gchar const*, gchar const*, gpointer*);
 gboolean j_backend_kv_iterate(JBackend*, gpointer, gchar const**, gconstpointer*, guint32*);
 
+gboolean j_backend_kv_bulk_start(JBackend*, gchar const*, JSemantics*, gpointer*);
+gboolean j_backend_kv_bulk_put(JBackend*, gpointer, gchar const*, gconstpointer, guint32);
+gboolean j_backend_kv_bulk_execute(JBackend*, gpointer);
+
 gboolean j_backend_db_init(JBackend*, gchar const*);
 void j_backend_db_fini(JBackend*);
 
@@ -427,7 +511,17 @@ gboolean j_backend_db_schema_create(JBackend*, gpointer, gchar const*, bson_t co
 gboolean j_backend_db_schema_get(JBackend*, gpointer, gchar const*, bson_t*, GError**);
 gboolean j_backend_db_schema_delete(JBackend*, gpointer, gchar const*, GError**);
 
+gboolean j_backend_db_index_create(JBackend*, gpointer, gchar const*, bson_t const*, GError**);
+gboolean j_backend_db_index_delete(JBackend*, gpointer, gchar const*, bson_t const*, GError**);
+
+gboolean j_backend_db_statistics(JBackend*, JStatistics*);
+
+guint32 j_backend_db_id_base(guint32, guint32);
+guint32 j_backend_db_id_server(guint32, guint32);
+gboolean j_backend_db_set_id_base(JBackend*, guint32);
+
 gboolean j_backend_db_insert(JBackend*, gpointer, gchar const*, bson_t const*, bson_t*, GError**);
+gboolean j_backend_db_insert_many(JBackend*, gpointer, gchar const*, bson_t const*, guint, bson_t*, GError**);
 gboolean j_backend_db_update(JBackend*, gpointer, gchar const*, bson_t const*, bson_t const*, GError**);
 gboolean j_backend_db_delete(JBackend*, gpointer, gchar const*, bson_t const*, GError**);
 
@@ -58,7 +58,13 @@ enum JMessageType
 	J_MESSAGE_TRANSFORMATION_OBJECT_DELETE,
 	J_MESSAGE_TRANSFORMATION_OBJECT_READ,
 	J_MESSAGE_TRANSFORMATION_OBJECT_STATUS,
-	J_MESSAGE_TRANSFORMATION_OBJECT_WRITE
+	J_MESSAGE_TRANSFORMATION_OBJECT_WRITE,
+	J_MESSAGE_KV_BULK_PUT,
+	J_MESSAGE_DB_QUERY_OPEN,
+	J_MESSAGE_DB_QUERY_NEXT,
+	J_MESSAGE_DB_QUERY_CLOSE,
+	J_MESSAGE_DB_INDEX_CREATE,
+	J_MESSAGE_DB_INDEX_DELETE
 };
 
 typedef enum JMessageType JMessageType;
@@ -0,0 +1,55 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2020 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ **/
+
+#ifndef JULEA_ROW_BLOCK_H
+#define JULEA_ROW_BLOCK_H
+
+#if !defined(JULEA_H) && !defined(JULEA_COMPILATION)
+#error "Only <julea.h> can be included directly."
+#endif
+
+#include <glib.h>
+
+#include <bson.h>
+
+G_BEGIN_DECLS
+
+struct JRowBlock;
+
+typedef struct JRowBlock JRowBlock;
+
+gpointer j_row_block_encode(bson_t const*, guint32*);
+
+JRowBlock* j_row_block_new(gconstpointer, guint32);
+void j_row_block_free(JRowBlock*);
+
+guint32 j_row_block_get_row_count(JRowBlock*);
+guint32 j_row_block_get_column_count(JRowBlock*);
+
+gchar const* j_row_block_get_column_name(JRowBlock*, guint32);
+gboolean j_row_block_get_column_index(JRowBlock*, gchar const*, guint32*);
+
+gboolean j_row_block_get_value(JRowBlock*, guint32, guint32, bson_value_t*);
+
+G_END_DECLS
+
+#endif
@@ -40,7 +40,10 @@ enum JStatisticsType
 	J_STATISTICS_BYTES_READ,
 	J_STATISTICS_BYTES_WRITTEN,
 	J_STATISTICS_BYTES_RECEIVED,
-	J_STATISTICS_BYTES_SENT
+	J_STATISTICS_BYTES_SENT,
+	J_STATISTICS_DB_STATEMENTS_HIT,
+	J_STATISTICS_DB_STATEMENTS_MISSED,
+	J_STATISTICS_DB_STATEMENTS_EVICTED
 };
 
 typedef enum JStatisticsType JStatisticsType;
@@ -37,6 +37,7 @@ enum JTransformationType
 	J_TRANSFORMATION_TYPE_XOR,
 	J_TRANSFORMATION_TYPE_RLE,
 	J_TRANSFORMATION_TYPE_LZ4,
+	J_TRANSFORMATION_TYPE_ZSTD,
 };
 
 typedef enum JTransformationType JTransformationType;
@@ -86,6 +87,16 @@ struct JTransformation
 	 **/
 	gboolean partial_access;
 
+	/**
+	 * The compression level, 0 selects the type's default.
+	 **/
+	gint32 level;
+
+	/**
+	 * The ID of the dictionary used for compression, 0 if no dictionary is used.
+	 **/
+	guint32 dictionary;
+
 	/**
 	 * The reference count.
 	 **/
@@ -94,17 +105,22 @@ struct JTransformation
 typedef struct JTransformation JTransformation;
 
 JTransformation* j_transformation_new(JTransformationType, JTransformationMode);
+JTransformation* j_transformation_new_ext(JTransformationType, JTransformationMode, gint32, guint32);
 JTransformation* j_transformation_ref(JTransformation*);
 void j_transformation_unref(JTransformation*);
 
-void j_transformation_apply(JTransformation*, gpointer, guint64, guint64,
-			    gpointer*, guint64*, guint64*, JTransformationCaller);
+gboolean j_transformation_apply(JTransformation*, gpointer, guint64, guint64,
+				gpointer*, guint64*, guint64*, JTransformationCaller);
 void j_transformation_cleanup(JTransformation*, gpointer, guint64, guint64,
 			      JTransformationCaller);
+guint64 j_transformation_get_bound(JTransformation*, gconstpointer, guint64, guint64, JTransformationCaller);
+gboolean j_transformation_apply_into(JTransformation*, gconstpointer, guint64, gpointer, guint64*, JTransformationCaller);
 JTransformationMode j_transformation_get_mode(JTransformation*);
 JTransformationType j_transformation_get_type(JTransformation*);
 gboolean j_transformation_need_whole_object(JTransformation*, JTransformationCaller);
 
+guint32 j_transformation_add_dictionary(gconstpointer, gsize);
+
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(JTransformation, j_transformation_unref)
 
 G_END_DECLS
@@ -98,6 +98,21 @@ gboolean j_db_entry_get_id(JDBEntry* entry, gpointer* value, guint64* length, GE
 
 gboolean j_db_entry_set_field(JDBEntry* entry, gchar const* name, gconstpointer value, guint64 length, GError** error);
 
+/**
+ * Set a field in the given entry using its index
+ *
+ * \param[in] entry the entry to set a value
+ * \param[in] index the index of the field as returned by j_db_schema_get_field_index
+ * \param[in] value the value to set
+ * \param[in] length the length of the value. Only used if the value-type defined in the Schema is binary.
+ * \pre entry != NULL
+ * \pre value != NULL
+ *
+ * \return TRUE on success, FALSE otherwise
+ **/
+
+gboolean j_db_entry_set_field_by_index(JDBEntry* entry, guint32 index, gconstpointer value, guint64 length, GError** error);
+
 /**
  * Save the entry in the backend.
  * All variables defined in the schema, which are not explicitily set, are initialized to NULL.
@@ -47,6 +47,12 @@ struct JDBEntry
 
 	JDBSchema* schema;
 
+	/**
+	 * Whether a field has been set, indexed by schema field index.
+	 * Allows detecting duplicate fields without searching #bson.
+	 **/
+	GArray* fields_set;
+
 	gint ref_count;
 };
 
@@ -59,6 +65,31 @@ struct JDBIterator
 
 	gpointer iterator;
 
+	/**
+	 * The row block containing the current entry, NULL if the entry is stored in #bson.
+	 * The row block is owned by #iterator.
+	 **/
+	JRowBlock* row_block;
+
+	/**
+	 * The current entry's row within #row_block.
+	 **/
+	guint32 row;
+
+	/**
+	 * Maps schema field indexes to columns of #row_block, G_MAXUINT32 for fields that are not part of the result.
+	 * Built once per row block on first positional access.
+	 **/
+	guint32* columns;
+	gboolean columns_valid;
+
+	/**
+	 * The current entry's fields within #bson, indexed by schema field index.
+	 * Built once per entry on first positional access, fields that are not part of the entry have a NULL raw pointer.
+	 **/
+	bson_iter_t* fields;
+	gboolean fields_valid;
+
 	gint ref_count;
 
 	gboolean valid;
@@ -72,6 +103,24 @@ struct JDBSchemaIndex
 	guint variable_count;
 };
 
+/**
+ * The schema's fields in a fixed order, allowing them to be accessed by index.
+ **/
+struct JDBSchemaFieldTable
+{
+	gchar** names;
+	JDBType* types;
+
+	/**
+	 * Maps field names to their indexes.
+	 **/
+	GHashTable* indexes;
+
+	guint32 count;
+};
+
+typedef struct JDBSchemaFieldTable JDBSchemaFieldTable;
+
 struct JDBSchema
 {
 	bson_t bson;
@@ -80,9 +129,19 @@ struct JDBSchema
 	GHashTable* variables; //contains char*
 	GArray* index; //contains GHashTable * which contain char*
 
+	/**
+	 * The field table, built on first positional access.
+	 **/
+	JDBSchemaFieldTable* field_table;
+
 	gchar* namespace;
 	gchar* name;
 
+	/**
+	 * The field used to distribute entries among DB servers, NULL for round-robin.
+	 **/
+	gchar* shard_key;
+
 	guint bson_index_count;
 	gint ref_count;
 
@@ -95,10 +154,38 @@ struct JDBSelector
 {
 	bson_t bson;
 
+	/**
+	 * The fields to return and the sort order.
+	 * Only used by queries, added to the selector's BSON when it is sent.
+	 **/
+	bson_t projection;
+	bson_t order;
+
+	/**
+	 * The aggregates to compute and the fields to group them by.
+	 **/
+	bson_t aggregate;
+	bson_t group;
+
+	/**
+	 * The selector's BSON including its options, built on demand.
+	 **/
+	bson_t bson_query;
+	gboolean bson_query_valid;
+
 	JDBSelectorMode mode;
 	JDBSchema* schema;
 
 	guint bson_count;
+	guint projection_count;
+	guint order_count;
+	guint aggregate_count;
+	guint group_count;
+
+	guint64 limit;
+	guint64 offset;
+	gboolean limit_set;
+
 	gint ref_count;
 };
 
@@ -123,14 +210,20 @@ union JDBTypeValue
 gboolean j_db_internal_schema_create(JDBSchema* j_db_schema, JBatch* batch, GError** error);
 gboolean j_db_internal_schema_get(JDBSchema* j_db_schema, JBatch* batch, GError** error);
 gboolean j_db_internal_schema_delete(JDBSchema* j_db_schema, JBatch* batch, GError** error);
+gboolean j_db_internal_index_create(JDBSchema* j_db_schema, bson_t* index, JBatch* batch, GError** error);
+gboolean j_db_internal_index_delete(JDBSchema* j_db_schema, bson_t* index, JBatch* batch, GError** error);
 gboolean j_db_internal_insert(JDBEntry* j_db_entry, JBatch* batch, GError** error);
 gboolean j_db_internal_update(JDBEntry* j_db_entry, JDBSelector* j_db_selector, JBatch* batch, GError** error);
 gboolean j_db_internal_delete(JDBEntry* j_db_entry, JDBSelector* j_db_selector, JBatch* batch, GError** error);
 gboolean j_db_internal_query(JDBSchema* j_db_schema, JDBSelector* j_db_selector, JDBIterator* j_db_iterator, JBatch* batch, GError** error);
 gboolean j_db_internal_iterate(JDBIterator* j_db_iterator, GError** error);
+gboolean j_db_internal_query_open(JDBIterator* j_db_iterator, GError** error);
+void j_db_internal_iterate_close(JDBIterator* j_db_iterator);
 
 // Client-side additional internal functions
 bson_t* j_db_selector_get_bson(JDBSelector* selector);
+gboolean j_db_selector_get_aggregate_type(JDBSelector* selector, gchar const* alias, JDBType* type);
+JDBSchemaFieldTable* j_db_schema_get_field_table(JDBSchema* schema, GError** error);
 
 G_GNUC_INTERNAL JBackend* j_db_get_backend(void);
 
@@ -115,6 +115,26 @@ gboolean j_db_schema_add_field(JDBSchema* schema, gchar const* name, JDBType typ
 
 gboolean j_db_schema_get_field(JDBSchema* schema, gchar const* name, JDBType* type, GError** error);
 
+/**
+ * query the index of a variable in the schema.
+ *
+ * The index stays the same for the lifetime of the schema and can be used to access fields without looking up their names.
+ * It corresponds to the variable's position in the names returned by j_db_schema_get_all_fields().
+ *
+ * \param[in] schema the schema to query
+ * \param[in] name the name of the variable to query
+ * \param[out] index the index of the queried variable
+ *
+ * \pre schema != NULL
+ * \pre name != NULL
+ * \pre index != NULL
+ * \pre schema contains a variable with the given name
+ *
+ * \return TRUE on success, FALSE otherwise
+ **/
+
+gboolean j_db_schema_get_field_index(JDBSchema* schema, gchar const* name, guint32* index, GError** error);
+
 /**
  * query all variables from the schema.
  *
@@ -152,6 +172,26 @@ guint32 j_db_schema_get_all_fields(JDBSchema* schema, gchar*** names, JDBType**
 
 gboolean j_db_schema_add_index(JDBSchema* schema, gchar const** names, GError** error);
 
+/**
+ * sets the field used to distribute the schema's entries among all DB servers.
+ *
+ * Tables are created on all DB servers.
+ * Each entry is inserted on the server determined by the hash of its shard key field.
+ * Without a shard key, entries are distributed round-robin.
+ * Queries, updates and deletes are sent to all servers, unless they select a certain entry ID.
+ * The shard key is not stored in the backend, every client inserting entries should set it.
+ *
+ * \param[in] schema the schema to set the shard key for
+ * \param[in] name the name of the variable to use as shard key, it has to be a field of the schema
+ *
+ * \pre schema != NULL
+ * \pre name != NULL
+ *
+ * \return TRUE on success, FALSE if the variable is not a field of the schema
+ **/
+
+gboolean j_db_schema_set_shard_key(JDBSchema* schema, gchar const* name, GError** error);
+
 /**
  * stores a schema in the backend.
  *
@@ -197,6 +237,45 @@ gboolean j_db_schema_get(JDBSchema* schema, JBatch* batch, GError** error);
 
 gboolean j_db_schema_delete(JDBSchema* schema, JBatch* batch, GError** error);
 
+/**
+ * creates an index on a schema that already exists in the backend.
+ *
+ * Existing entries are indexed by the backend, which avoids blocking concurrent writers if possible.
+ * Unlike j_db_schema_add_index, the schema does not have to be recreated.
+ *
+ * \param[in] schema the schema to create the index for
+ * \param[in] names the names of the variables to put into the index
+ * \param[in] batch the batch to add this operation to
+ *
+ * \pre schema != NULL
+ * \pre schema exists in the backend
+ * \pre names != NULL
+ * \pre *names is a zero-terminated array of char*
+ * \pre batch != NULL
+ *
+ * \return TRUE on success, FALSE otherwise
+ **/
+
+gboolean j_db_schema_create_index(JDBSchema* schema, gchar const** names, JBatch* batch, GError** error);
+
+/**
+ * deletes an index from a schema that exists in the backend.
+ *
+ * \param[in] schema the schema to delete the index from
+ * \param[in] names the names of the indexed variables, as given when creating the index
+ * \param[in] batch the batch to add this operation to
+ *
+ * \pre schema != NULL
+ * \pre schema exists in the backend
+ * \pre names != NULL
+ * \pre *names is a zero-terminated array of char*
+ * \pre batch != NULL
+ *
+ * \return TRUE on success, FALSE otherwise
+ **/
+
+gboolean j_db_schema_delete_index(JDBSchema* schema, gchar const** names, JBatch* batch, GError** error);
+
 /**
  * compares two schema with each other.
  *
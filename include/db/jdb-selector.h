@@ -52,11 +52,41 @@ enum JDBSelectorOperator
 	// =
 	J_DB_SELECTOR_OPERATOR_EQ,
 	// !=
-	J_DB_SELECTOR_OPERATOR_NE
+	J_DB_SELECTOR_OPERATOR_NE,
+	// IN (...), see j_db_selector_add_field_in
+	J_DB_SELECTOR_OPERATOR_IN,
+	// BETWEEN ... AND ..., see j_db_selector_add_field_between
+	J_DB_SELECTOR_OPERATOR_BETWEEN,
+	// LIKE '...%', only for strings
+	J_DB_SELECTOR_OPERATOR_PREFIX
 };
 
 typedef enum JDBSelectorOperator JDBSelectorOperator;
 
+enum JDBSelectorOrder
+{
+	J_DB_SELECTOR_ORDER_ASCENDING,
+	J_DB_SELECTOR_ORDER_DESCENDING
+};
+
+typedef enum JDBSelectorOrder JDBSelectorOrder;
+
+enum JDBSelectorAggregate
+{
+	// COUNT
+	J_DB_SELECTOR_AGGREGATE_COUNT,
+	// SUM
+	J_DB_SELECTOR_AGGREGATE_SUM,
+	// MIN
+	J_DB_SELECTOR_AGGREGATE_MIN,
+	// MAX
+	J_DB_SELECTOR_AGGREGATE_MAX,
+	// AVG
+	J_DB_SELECTOR_AGGREGATE_AVG
+};
+
+typedef enum JDBSelectorAggregate JDBSelectorAggregate;
+
 struct JDBSelector;
 
 typedef struct JDBSelector JDBSelector;
@@ -114,6 +144,7 @@ G_DEFINE_AUTOPTR_CLEANUP_FUNC(JDBSelector, j_db_selector_unref)
  * \pre name != NULL
  * \pre name must exist in the schema
  * \pre operator must be applyable to the defined type of the variable
+ * \pre operator must not be J_DB_SELECTOR_OPERATOR_IN or J_DB_SELECTOR_OPERATOR_BETWEEN
  * \pre selector including all previously added sub_selectors must not contain more than 500 search fields after applying this operation
  * \post the value may be freed or modified by the caller immediately after calling this function
  *
@@ -122,6 +153,52 @@ G_DEFINE_AUTOPTR_CLEANUP_FUNC(JDBSelector, j_db_selector_unref)
 
 gboolean j_db_selector_add_field(JDBSelector* selector, gchar const* name, JDBSelectorOperator operator_, gconstpointer value, guint64 length, GError** error);
 
+/**
+ * add a search field to the selector that matches if the stored value equals one of the given values.
+ * This is cheaper than adding a sub_selector with one search field per value.
+ *
+ * \param[in] selector to add a search field to
+ * \param[in] name the name of the field to compare
+ * \param[in] values an array of count values, using the same type as the value of j_db_selector_add_field (for example, gchar const* for strings)
+ * \param[in] lengths an array of count lengths. Only used if the values are binary
+ * \param[in] count the number of values
+ *
+ * \pre selector != NULL
+ * \pre name != NULL
+ * \pre name must exist in the schema
+ * \pre values != NULL
+ * \pre count > 0
+ * \pre selector including all previously added sub_selectors must not contain more than 500 search fields after applying this operation, every value counts as one search field
+ * \post the values may be freed or modified by the caller immediately after calling this function
+ *
+ * 
+eturn TRUE on success, FALSE otherwise
+ **/
+
+gboolean j_db_selector_add_field_in(JDBSelector* selector, gchar const* name, gconstpointer values, guint64 const* lengths, guint count, GError** error);
+
+/**
+ * add a search field to the selector that matches if the stored value lies between the given values, including both.
+ *
+ * \param[in] selector to add a search field to
+ * \param[in] name the name of the field to compare
+ * \param[in] lower the lower bound
+ * \param[in] lower_length the length of the lower bound. Only used if value is binary
+ * \param[in] upper the upper bound
+ * \param[in] upper_length the length of the upper bound. Only used if value is binary
+ *
+ * \pre selector != NULL
+ * \pre name != NULL
+ * \pre name must exist in the schema
+ * \pre selector including all previously added sub_selectors must not contain more than 500 search fields after applying this operation, the bounds count as two search fields
+ * \post the values may be freed or modified by the caller immediately after calling this function
+ *
+ * 
+eturn TRUE on success, FALSE otherwise
+ **/
+
+gboolean j_db_selector_add_field_between(JDBSelector* selector, gchar const* name, gconstpointer lower, guint64 lower_length, gconstpointer upper, guint64 upper_length, GError** error);
+
 /**
  * add a search field to the selector.
  *
@@ -138,6 +215,106 @@ gboolean j_db_selector_add_field(JDBSelector* selector, gchar const* name, JDBSe
 
 gboolean j_db_selector_add_selector(JDBSelector* selector, JDBSelector* sub_selector, GError** error);
 
+/**
+ * Restrict the fields returned by queries using the selector.
+ * The ID is always returned.
+ *
+ * \param[in] selector to restrict
+ * \param[in] names the names of the fields to return, terminated by NULL
+ *
+ * \pre selector != NULL
+ * \pre names != NULL
+ * \pre all names must exist in the schema
+ * \pre the projection must not have been set before
+ *
+ * \return TRUE on success, FALSE otherwise
+ **/
+
+gboolean j_db_selector_set_projection(JDBSelector* selector, gchar const* const* names, GError** error);
+
+/**
+ * Sort the results of queries using the selector by a field.
+ * Fields added first take precedence over fields added later.
+ * If multiple DB servers are used, the servers' sorted results are merged.
+ *
+ * \param[in] selector to add the sort order to
+ * \param[in] name the name of the field to sort by
+ * \param[in] order whether to sort in ascending or descending order
+ *
+ * \pre selector != NULL
+ * \pre name != NULL
+ * \pre name must exist in the schema or be the name of an aggregate added before
+ *
+ * \return TRUE on success, FALSE otherwise
+ **/
+
+gboolean j_db_selector_add_order(JDBSelector* selector, gchar const* name, JDBSelectorOrder order, GError** error);
+
+/**
+ * Limit the number of results of queries using the selector.
+ * If multiple DB servers are used, limit and offset apply to the combined results of all servers.
+ *
+ * \param[in] selector to limit
+ * \param[in] limit the maximum number of results to return
+ * \param[in] offset the number of results to skip
+ *
+ * \pre selector != NULL
+ * \pre the limit must not have been set before
+ *
+ * \return TRUE on success, FALSE otherwise
+ **/
+
+gboolean j_db_selector_set_limit(JDBSelector* selector, guint64 limit, guint64 offset, GError** error);
+
+/**
+ * Compute an aggregate over the entries matching the selector.
+ * Queries using a selector with aggregates return one entry per group instead of the matching entries.
+ * Each entry contains the aggregates and the fields used for grouping, it does not have an ID.
+ * The aggregates are computed by the DB server, the projection is ignored.
+ * If multiple DB servers are used, their aggregates are combined, so each group is returned once.
+ *
+ * The aggregate's type depends on the function:
+ * COUNT returns an unsigned 64-bit integer, AVG returns a double.
+ * SUM returns a double for floating-point fields, an unsigned 64-bit integer for unsigned 64-bit fields and a signed 64-bit integer otherwise.
+ * MIN and MAX return the field's type.
+ *
+ * \code
+ * j_db_selector_add_aggregate(selector, "total", J_DB_SELECTOR_AGGREGATE_SUM, "size", &error);
+ * \endcode
+ *
+ * \param[in] selector to add the aggregate to
+ * \param[in] alias the name of the aggregate in the results
+ * \param[in] aggregate the function to compute
+ * \param[in] name the name of the field to aggregate, NULL to count all entries
+ *
+ * \pre selector != NULL
+ * \pre alias != NULL
+ * \pre alias must only contain letters, digits and underscores and start with a letter
+ * \pre alias must neither exist in the schema nor be used by another aggregate
+ * \pre name must exist in the schema, it may only be NULL for COUNT
+ * \pre SUM and AVG require a numeric field
+ *
+ * \return TRUE on success, FALSE otherwise
+ **/
+
+gboolean j_db_selector_add_aggregate(JDBSelector* selector, gchar const* alias, JDBSelectorAggregate aggregate, gchar const* name, GError** error);
+
+/**
+ * Group the aggregates computed by queries using the selector by a field.
+ * Without aggregates, one entry is returned per distinct value of the grouping fields.
+ *
+ * \param[in] selector to add the grouping field to
+ * \param[in] name the name of the field to group by
+ *
+ * \pre selector != NULL
+ * \pre name != NULL
+ * \pre name must exist in the schema
+ *
+ * \return TRUE on success, FALSE otherwise
+ **/
+
+gboolean j_db_selector_add_group(JDBSelector* selector, gchar const* name, GError** error);
+
 G_END_DECLS
 
 #endif
@@ -24,6 +24,8 @@
 #define JULEA_KV_H
 
 #include <kv/jkv.h>
+#include <kv/jkv-cache.h>
+#include <kv/jkv-compression.h>
 #include <kv/jkv-iterator.h>
 #include <kv/jkv-uri.h>
 
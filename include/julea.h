@@ -47,6 +47,7 @@
 #include <core/jmemory-chunk.h>
 #include <core/jmessage.h>
 #include <core/joperation.h>
+#include <core/jrow-block.h>
 #include <core/jsemantics.h>
 #include <core/jstatistics.h>
 #include <core/jtrace.h>
@@ -35,6 +35,13 @@ G_BEGIN_DECLS
 
 G_GNUC_INTERNAL JBackend* j_kv_get_backend(void);
 
+G_GNUC_INTERNAL gboolean j_kv_cache_get(gchar const*, gchar const*, JSemantics*, gpointer*, guint32*);
+G_GNUC_INTERNAL void j_kv_cache_put(gchar const*, gchar const*, gconstpointer, guint32);
+G_GNUC_INTERNAL void j_kv_cache_delete(gchar const*, gchar const*);
+
+G_GNUC_INTERNAL gpointer j_kv_compression_encode(gchar const*, gconstpointer, guint32, guint32*);
+G_GNUC_INTERNAL gboolean j_kv_compression_decode(gchar const*, gconstpointer, guint32, gpointer*, guint32*);
+
 G_END_DECLS
 
 #endif
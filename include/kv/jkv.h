@@ -52,6 +52,7 @@ void j_kv_unref(JKV*);
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(JKV, j_kv_unref)
 
 void j_kv_put(JKV*, gpointer, guint32, GDestroyNotify, JBatch*);
+void j_kv_bulk_put(JKV*, gpointer, guint32, GDestroyNotify, JBatch*);
 void j_kv_delete(JKV*, JBatch*);
 
 void j_kv_get(JKV*, gpointer*, guint32*, JBatch*);
@@ -62,6 +62,22 @@ j_backend_operation_unwrap_db_schema_delete(JBackend* backend, gpointer batch, J
 	return j_backend_db_schema_delete(backend, batch, data->in_param[1].ptr, data->out_param[0].ptr);
 }
 
+gboolean
+j_backend_operation_unwrap_db_index_create(JBackend* backend, gpointer batch, JBackendOperation* data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	return j_backend_db_index_create(backend, batch, data->in_param[1].ptr, data->in_param[2].ptr, data->out_param[0].ptr);
+}
+
+gboolean
+j_backend_operation_unwrap_db_index_delete(JBackend* backend, gpointer batch, JBackendOperation* data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	return j_backend_db_index_delete(backend, batch, data->in_param[1].ptr, data->in_param[2].ptr, data->out_param[0].ptr);
+}
+
 gboolean
 j_backend_operation_unwrap_db_insert(JBackend* backend, gpointer batch, JBackendOperation* data)
 {
@@ -182,6 +182,13 @@ j_backend_load(gchar const* name, JBackendComponent component, JBackendType type
 		{
 			goto error;
 		}
+
+		// Bulk functions are optional but have to be implemented together
+		if ((tmp_backend->kv.backend_bulk_start == NULL) != (tmp_backend->kv.backend_bulk_put == NULL)
+		    || (tmp_backend->kv.backend_bulk_start == NULL) != (tmp_backend->kv.backend_bulk_execute == NULL))
+		{
+			goto error;
+		}
 	}
 
 	if (type == J_BACKEND_TYPE_DB)
@@ -462,13 +469,14 @@ j_backend_transformation_object_read(JBackend* backend, gpointer data, gpointer
 		gpointer transformed_data = malloc(*transformed_size);
 		gpointer whole_data_buf = NULL;
 		guint64 off = 0;
-		guint64 data_size = 0;
+		guint64 data_size = *original_size;
 		guint64 nread = 0;
 		// First read all object data
 		ret = j_backend_object_read(backend, data, transformed_data, *transformed_size, 0, &nread);
 
-		j_transformation_apply(transformation, transformed_data, *transformed_size, off,
-				       &whole_data_buf, &data_size, &off, J_TRANSFORMATION_CALLER_SERVER_READ);
+		ret = j_transformation_apply(transformation, transformed_data, *transformed_size, off,
+					     &whole_data_buf, &data_size, &off, J_TRANSFORMATION_CALLER_SERVER_READ)
+		      && ret;
 		*bytes_read = nread;
 
 		memcpy(buffer, ((char*)whole_data_buf) + offset, length);
@@ -481,17 +489,12 @@ j_backend_transformation_object_read(JBackend* backend, gpointer data, gpointer
 	else
 	{
 		guint64 nread = 0;
-		gpointer original_data = NULL;
 		ret = j_backend_object_read(backend, data, buffer, length, offset, &nread);
 		*bytes_read = nread;
 
-		j_transformation_apply(transformation, buffer, length, offset, &original_data, &length,
-				       &offset, J_TRANSFORMATION_CALLER_SERVER_READ);
-
-		memcpy(buffer, (gchar*)original_data, length);
-
-		j_transformation_cleanup(transformation, original_data, length, offset,
-					 J_TRANSFORMATION_CALLER_SERVER_READ);
+		// Transformations with partial access can be applied in place
+		j_transformation_apply_into(transformation, buffer, length, buffer, &length,
+					    J_TRANSFORMATION_CALLER_SERVER_READ);
 	}
 
 	return ret;
@@ -558,6 +561,13 @@ j_backend_transformation_object_write(JBackend* backend, gpointer data, gpointer
 			whole_data_buf = malloc(new_size);
 			ret = j_backend_transformation_object_read(backend, data, whole_data_buf,
 								   *original_size, 0, &nread, transformation, original_size, transformed_size);
+
+			// Writing the object would overwrite the data that could not be read
+			if (!ret)
+			{
+				free(whole_data_buf);
+				return FALSE;
+			}
 		}
 		else
 		{
@@ -597,6 +607,9 @@ j_backend_transformation_object_write(JBackend* backend, gpointer data, gpointer
 
 		ret = j_backend_object_write(backend, data, buffer, length, offset, bytes_written);
 
+		j_transformation_cleanup(transformation, buffer, length, offset,
+					 J_TRANSFORMATION_CALLER_SERVER_WRITE);
+
 		if (*original_size < offset + length)
 		{
 			*original_size = offset + length;
@@ -805,6 +818,82 @@ j_backend_kv_iterate(JBackend* backend, gpointer iterator, gchar const** key, gc
 	return ret;
 }
 
+gboolean
+j_backend_kv_bulk_start(JBackend* backend, gchar const* namespace, JSemantics* semantics, gpointer* bulk)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_KV, FALSE);
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+	g_return_val_if_fail(bulk != NULL, FALSE);
+
+	if (backend->kv.backend_bulk_start == NULL)
+	{
+		return j_backend_kv_batch_start(backend, namespace, semantics, bulk);
+	}
+
+	{
+		J_TRACE("backend_bulk_start", "%s, %p, %p", namespace, (gpointer)semantics, (gpointer)bulk);
+		ret = backend->kv.backend_bulk_start(backend->data, namespace, semantics, bulk);
+	}
+
+	return ret;
+}
+
+gboolean
+j_backend_kv_bulk_put(JBackend* backend, gpointer bulk, gchar const* key, gconstpointer value, guint32 value_len)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_KV, FALSE);
+	g_return_val_if_fail(bulk != NULL, FALSE);
+	g_return_val_if_fail(key != NULL, FALSE);
+	g_return_val_if_fail(value != NULL, FALSE);
+
+	if (backend->kv.backend_bulk_put == NULL)
+	{
+		return j_backend_kv_put(backend, bulk, key, value, value_len);
+	}
+
+	{
+		J_TRACE("backend_bulk_put", "%p, %s, %p, %u", bulk, key, (gconstpointer)value, value_len);
+		ret = backend->kv.backend_bulk_put(backend->data, bulk, key, value, value_len);
+	}
+
+	return ret;
+}
+
+gboolean
+j_backend_kv_bulk_execute(JBackend* backend, gpointer bulk)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_KV, FALSE);
+	g_return_val_if_fail(bulk != NULL, FALSE);
+
+	if (backend->kv.backend_bulk_execute == NULL)
+	{
+		return j_backend_kv_batch_execute(backend, bulk);
+	}
+
+	{
+		J_TRACE("backend_bulk_execute", "%p", bulk);
+		ret = backend->kv.backend_bulk_execute(backend->data, bulk);
+	}
+
+	return ret;
+}
+
 gboolean
 j_backend_db_init(JBackend* backend, gchar const* path)
 {
@@ -944,6 +1033,153 @@ j_backend_db_schema_delete(JBackend* backend, gpointer batch, gchar const* name,
 	return ret;
 }
 
+gboolean
+j_backend_db_index_create(JBackend* backend, gpointer batch, gchar const* name, bson_t const* index, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_DB, FALSE);
+	g_return_val_if_fail(batch != NULL, FALSE);
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(index != NULL, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	if (backend->db.backend_index_create == NULL)
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_FAILED, "backend does not support index management");
+		return FALSE;
+	}
+
+	{
+		J_TRACE("backend_index_create", "%p, %s, %p, %p", batch, name, (gconstpointer)index, (gpointer)error);
+		ret = backend->db.backend_index_create(backend->data, batch, name, index, error);
+	}
+
+	return ret;
+}
+
+gboolean
+j_backend_db_index_delete(JBackend* backend, gpointer batch, gchar const* name, bson_t const* index, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_DB, FALSE);
+	g_return_val_if_fail(batch != NULL, FALSE);
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(index != NULL, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	if (backend->db.backend_index_delete == NULL)
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_FAILED, "backend does not support index management");
+		return FALSE;
+	}
+
+	{
+		J_TRACE("backend_index_delete", "%p, %s, %p, %p", batch, name, (gconstpointer)index, (gpointer)error);
+		ret = backend->db.backend_index_delete(backend->data, batch, name, index, error);
+	}
+
+	return ret;
+}
+
+gboolean
+j_backend_db_statistics(JBackend* backend, JStatistics* statistics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_DB, FALSE);
+	g_return_val_if_fail(statistics != NULL, FALSE);
+
+	if (backend->db.backend_statistics == NULL)
+	{
+		return FALSE;
+	}
+
+	{
+		J_TRACE("backend_statistics", "%p", (gpointer)statistics);
+		ret = backend->db.backend_statistics(backend->data, statistics);
+	}
+
+	return ret;
+}
+
+/**
+ * Returns the first entry ID of a DB server.
+ * Every DB server assigns IDs from its own range, the ranges stay below G_MAXINT32 since some databases use signed IDs.
+ *
+ * \param index The server's index.
+ * \param count The number of DB servers.
+ *
+ * \return The first ID.
+ **/
+guint32
+j_backend_db_id_base(guint32 index, guint32 count)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(count > 0, 1);
+	g_return_val_if_fail(index < count, 1);
+
+	return index * (G_MAXINT32 / count) + 1;
+}
+
+/**
+ * Returns the DB server that assigned an entry ID.
+ *
+ * \param id    The ID.
+ * \param count The number of DB servers.
+ *
+ * \return The server's index.
+ **/
+guint32
+j_backend_db_id_server(guint32 id, guint32 count)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(count > 0, 0);
+
+	if (id == 0)
+	{
+		return 0;
+	}
+
+	return MIN((id - 1) / (G_MAXINT32 / count), count - 1);
+}
+
+gboolean
+j_backend_db_set_id_base(JBackend* backend, guint32 id_base)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_DB, FALSE);
+	g_return_val_if_fail(id_base > 0, FALSE);
+
+	if (backend->db.backend_set_id_base == NULL)
+	{
+		return (id_base == 1);
+	}
+
+	{
+		J_TRACE("backend_set_id_base", "%u", id_base);
+		ret = backend->db.backend_set_id_base(backend->data, id_base);
+	}
+
+	return ret;
+}
+
 gboolean
 j_backend_db_insert(JBackend* backend, gpointer batch, gchar const* name, bson_t const* metadata, bson_t* id, GError** error)
 {
@@ -967,6 +1203,39 @@ j_backend_db_insert(JBackend* backend, gpointer batch, gchar const* name, bson_t
 	return ret;
 }
 
+gboolean
+j_backend_db_insert_many(JBackend* backend, gpointer batch, gchar const* name, bson_t const* metadata, guint count, bson_t* ids, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	g_return_val_if_fail(backend != NULL, FALSE);
+	g_return_val_if_fail(backend->type == J_BACKEND_TYPE_DB, FALSE);
+	g_return_val_if_fail(batch != NULL, FALSE);
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(metadata != NULL, FALSE);
+	g_return_val_if_fail(ids != NULL, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	if (backend->db.backend_insert_many == NULL)
+	{
+		for (guint i = 0; i < count && ret; i++)
+		{
+			ret = j_backend_db_insert(backend, batch, name, &metadata[i], &ids[i], error);
+		}
+
+		return ret;
+	}
+
+	{
+		J_TRACE("backend_insert_many", "%p, %s, %p, %u, %p, %p", batch, name, (gconstpointer)metadata, count, (gpointer)ids, (gpointer)error);
+		ret = backend->db.backend_insert_many(backend->data, batch, name, metadata, count, ids, error);
+	}
+
+	return ret;
+}
+
 gboolean
 j_backend_db_update(JBackend* backend, gpointer batch, gchar const* name, bson_t const* selector, bson_t const* metadata, GError** error)
 {
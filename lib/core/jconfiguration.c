@@ -115,6 +115,11 @@ struct JConfiguration
 		 * The path.
 		 */
 		gchar* path;
+
+		/**
+		 * The time in microseconds servers wait to group durable commits.
+		 */
+		guint64 group_commit_window;
 	} kv;
 
 	/**
@@ -279,6 +284,7 @@ j_configuration_new_for_data(GKeyFile* key_file)
 	gchar* kv_backend;
 	gchar* kv_component;
 	gchar* kv_path;
+	guint64 kv_group_commit_window;
 	gchar* db_backend;
 	gchar* db_component;
 	gchar* db_path;
@@ -300,6 +306,7 @@ j_configuration_new_for_data(GKeyFile* key_file)
 	kv_backend = g_key_file_get_string(key_file, "kv", "backend", NULL);
 	kv_component = g_key_file_get_string(key_file, "kv", "component", NULL);
 	kv_path = g_key_file_get_string(key_file, "kv", "path", NULL);
+	kv_group_commit_window = g_key_file_get_uint64(key_file, "kv", "group-commit-window", NULL);
 	db_backend = g_key_file_get_string(key_file, "db", "backend", NULL);
 	db_component = g_key_file_get_string(key_file, "db", "component", NULL);
 	db_path = g_key_file_get_string(key_file, "db", "path", NULL);
@@ -346,6 +353,7 @@ j_configuration_new_for_data(GKeyFile* key_file)
 	configuration->kv.backend = kv_backend;
 	configuration->kv.component = kv_component;
 	configuration->kv.path = kv_path;
+	configuration->kv.group_commit_window = kv_group_commit_window;
 	configuration->db.backend = db_backend;
 	configuration->db.component = db_component;
 	configuration->db.path = db_path;
@@ -578,6 +586,16 @@ j_configuration_get_stripe_size(JConfiguration* configuration)
 	return configuration->stripe_size;
 }
 
+guint64
+j_configuration_get_kv_group_commit_window(JConfiguration* configuration)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(configuration != NULL, 0);
+
+	return configuration->kv.group_commit_window;
+}
+
 /**
  * @}
  **/
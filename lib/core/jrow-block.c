@@ -0,0 +1,703 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2020 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ **/
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <string.h>
+
+#include <bson.h>
+
+#include <jrow-block.h>
+
+#include <jtrace.h>
+
+/**
+ * \defgroup JRowBlock Row Block
+ *
+ * A compact binary encoding for rows that share the same columns.
+ *
+ * Instead of one BSON document per row, the column names and types are stored once in a header.
+ * Each row consists of a bitmap marking its NULL columns followed by the remaining values:
+ * Integers and doubles are stored as fixed-width little-endian values, strings and binaries are prefixed with their length.
+ *
+ * \code
+ * guint32  column count
+ * {
+ *   guint8 BSON type
+ *   gchar  name[] (NUL-terminated)
+ * }        columns
+ * guint32  row count
+ * {
+ *   guint8 NULL bitmap[(column count + 7) / 8]
+ *   ...    values
+ * }        rows
+ * \endcode
+ *
+ * When decoding, the offsets of all values are determined once, so every value can be accessed directly.
+ *
+ * @{
+ **/
+
+/**
+ * A decoded row block.
+ **/
+struct JRowBlock
+{
+	/**
+	 * The encoded data.
+	 **/
+	guint8* data;
+
+	/**
+	 * The encoded data's length.
+	 **/
+	guint32 length;
+
+	guint32 column_count;
+	guint32 row_count;
+
+	/**
+	 * The columns' names, pointing into #data.
+	 **/
+	gchar const** names;
+
+	/**
+	 * The columns' BSON types.
+	 **/
+	guint8* types;
+
+	/**
+	 * Maps column names to their indexes.
+	 **/
+	GHashTable* columns;
+
+	/**
+	 * The values' offsets within #data, G_MAXUINT32 for NULL values.
+	 * The offset of a row's column is stored at row * #column_count + column.
+	 **/
+	guint32* offsets;
+};
+
+static gboolean
+j_row_block_type_supported(bson_iter_t const* iter)
+{
+	switch (bson_iter_type(iter))
+	{
+		case BSON_TYPE_INT32:
+		case BSON_TYPE_INT64:
+		case BSON_TYPE_DOUBLE:
+		case BSON_TYPE_UTF8:
+		case BSON_TYPE_NULL:
+			return TRUE;
+		case BSON_TYPE_BINARY:
+			{
+				bson_subtype_t subtype;
+				guint32 len;
+				guint8 const* data;
+
+				bson_iter_binary(iter, &subtype, &len, &data);
+
+				return (subtype == BSON_SUBTYPE_BINARY);
+			}
+		default:
+			return FALSE;
+	}
+}
+
+static void
+j_row_block_append_4(GByteArray* block, guint32 value)
+{
+	guint32 value_le;
+
+	value_le = GUINT32_TO_LE(value);
+	g_byte_array_append(block, (guint8 const*)&value_le, sizeof(value_le));
+}
+
+static void
+j_row_block_append_8(GByteArray* block, guint64 value)
+{
+	guint64 value_le;
+
+	value_le = GUINT64_TO_LE(value);
+	g_byte_array_append(block, (guint8 const*)&value_le, sizeof(value_le));
+}
+
+static void
+j_row_block_append_value(GByteArray* block, bson_iter_t const* iter)
+{
+	switch (bson_iter_type(iter))
+	{
+		case BSON_TYPE_INT32:
+			j_row_block_append_4(block, (guint32)bson_iter_int32(iter));
+			break;
+		case BSON_TYPE_INT64:
+			j_row_block_append_8(block, (guint64)bson_iter_int64(iter));
+			break;
+		case BSON_TYPE_DOUBLE:
+			{
+				gdouble value;
+				guint64 bits;
+
+				value = bson_iter_double(iter);
+				memcpy(&bits, &value, sizeof(bits));
+				j_row_block_append_8(block, bits);
+			}
+			break;
+		case BSON_TYPE_UTF8:
+			{
+				gchar const* value;
+				guint32 len;
+
+				value = bson_iter_utf8(iter, &len);
+				j_row_block_append_4(block, len);
+				// Keep the terminating NUL so strings can be returned without copying them
+				g_byte_array_append(block, (guint8 const*)value, len + 1);
+			}
+			break;
+		case BSON_TYPE_BINARY:
+			{
+				guint8 const* value;
+				guint32 len;
+
+				bson_iter_binary(iter, NULL, &len, &value);
+				j_row_block_append_4(block, len);
+				g_byte_array_append(block, value, len);
+			}
+			break;
+		case BSON_TYPE_NULL:
+		default:
+			g_assert_not_reached();
+	}
+}
+
+/**
+ * Checks whether a position is within a row block and advances it.
+ *
+ * \private
+ *
+ * \param row_block A row block.
+ * \param position  A position, advanced by size.
+ * \param size      The number of bytes to consume.
+ *
+ * \return TRUE if the bytes are within the row block, FALSE otherwise.
+ **/
+static gboolean
+j_row_block_consume(JRowBlock* row_block, guint32* position, guint64 size)
+{
+	if (*position + size > row_block->length)
+	{
+		return FALSE;
+	}
+
+	*position += size;
+
+	return TRUE;
+}
+
+static guint32
+j_row_block_read_4(JRowBlock* row_block, guint32 position)
+{
+	guint32 value_le;
+
+	memcpy(&value_le, row_block->data + position, sizeof(value_le));
+
+	return GUINT32_FROM_LE(value_le);
+}
+
+static guint64
+j_row_block_read_8(JRowBlock* row_block, guint32 position)
+{
+	guint64 value_le;
+
+	memcpy(&value_le, row_block->data + position, sizeof(value_le));
+
+	return GUINT64_FROM_LE(value_le);
+}
+
+/**
+ * Encodes rows into a row block.
+ *
+ * All rows have to contain the same fields in the same order.
+ * Each field may only be NULL or hold values of one type.
+ *
+ * \code
+ * gpointer data;
+ * guint32 length;
+ *
+ * data = j_row_block_encode(rows, &length);
+ * \endcode
+ *
+ * \param rows   A BSON document containing the rows as sub-documents.
+ * \param length A pointer that receives the row block's length.
+ *
+ * \return The row block, NULL if the rows cannot be encoded. Should be freed with g_free().
+ **/
+gpointer
+j_row_block_encode(bson_t const* rows, guint32* length)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(GPtrArray) names = NULL;
+	g_autoptr(GByteArray) types = NULL;
+	GByteArray* block;
+	bson_iter_t iter;
+	guint32 row_count = 0;
+	guint32 bitmap_size;
+
+	g_return_val_if_fail(rows != NULL, NULL);
+	g_return_val_if_fail(length != NULL, NULL);
+
+	names = g_ptr_array_new();
+	types = g_byte_array_new();
+
+	// The first pass determines the columns and checks whether all rows fit them
+	if (!bson_iter_init(&iter, rows))
+	{
+		return NULL;
+	}
+
+	while (bson_iter_next(&iter))
+	{
+		bson_iter_t row;
+		guint32 column = 0;
+
+		if (!BSON_ITER_HOLDS_DOCUMENT(&iter) || !bson_iter_recurse(&iter, &row))
+		{
+			return NULL;
+		}
+
+		while (bson_iter_next(&row))
+		{
+			gchar const* key;
+			guint8 type;
+
+			key = bson_iter_key(&row);
+			type = bson_iter_type(&row);
+
+			if (!j_row_block_type_supported(&row))
+			{
+				return NULL;
+			}
+
+			if (row_count == 0)
+			{
+				g_ptr_array_add(names, (gpointer)key);
+				g_byte_array_append(types, &type, 1);
+			}
+			else if (column >= names->len || g_strcmp0(key, g_ptr_array_index(names, column)) != 0)
+			{
+				return NULL;
+			}
+
+			if (type != BSON_TYPE_NULL)
+			{
+				if (types->data[column] == BSON_TYPE_NULL)
+				{
+					types->data[column] = type;
+				}
+				else if (types->data[column] != type)
+				{
+					return NULL;
+				}
+			}
+
+			column++;
+		}
+
+		if (column != names->len)
+		{
+			return NULL;
+		}
+
+		row_count++;
+	}
+
+	if (names->len == 0 && row_count > 0)
+	{
+		return NULL;
+	}
+
+	block = g_byte_array_new();
+	bitmap_size = (names->len + 7) / 8;
+
+	j_row_block_append_4(block, names->len);
+
+	for (guint32 i = 0; i < names->len; i++)
+	{
+		gchar const* name = g_ptr_array_index(names, i);
+
+		g_byte_array_append(block, &(types->data[i]), 1);
+		g_byte_array_append(block, (guint8 const*)name, strlen(name) + 1);
+	}
+
+	j_row_block_append_4(block, row_count);
+
+	bson_iter_init(&iter, rows);
+
+	while (bson_iter_next(&iter))
+	{
+		bson_iter_t row;
+		guint32 bitmap;
+		guint32 column = 0;
+
+		bson_iter_recurse(&iter, &row);
+
+		bitmap = block->len;
+		g_byte_array_set_size(block, block->len + bitmap_size);
+		memset(block->data + bitmap, 0, bitmap_size);
+
+		while (bson_iter_next(&row))
+		{
+			if (BSON_ITER_HOLDS_NULL(&row))
+			{
+				block->data[bitmap + column / 8] |= (1 << (column % 8));
+			}
+			else
+			{
+				j_row_block_append_value(block, &row);
+			}
+
+			column++;
+		}
+	}
+
+	*length = block->len;
+
+	return g_byte_array_free(block, FALSE);
+}
+
+/**
+ * Decodes a row block.
+ *
+ * \code
+ * JRowBlock* row_block;
+ *
+ * row_block = j_row_block_new(data, length);
+ * \endcode
+ *
+ * \param data   A row block returned by j_row_block_encode(). It is copied.
+ * \param length The row block's length.
+ *
+ * \return A new row block, NULL if the data is malformed. Should be freed with j_row_block_free().
+ **/
+JRowBlock*
+j_row_block_new(gconstpointer data, guint32 length)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JRowBlock* row_block;
+	guint32 position = 0;
+	guint32 bitmap_size;
+
+	g_return_val_if_fail(data != NULL || length == 0, NULL);
+
+	row_block = g_slice_new0(JRowBlock);
+	row_block->data = g_memdup(data, length);
+	row_block->length = length;
+	row_block->columns = g_hash_table_new(g_str_hash, g_str_equal);
+
+	if (!j_row_block_consume(row_block, &position, 4))
+	{
+		goto _error;
+	}
+
+	row_block->column_count = j_row_block_read_4(row_block, 0);
+
+	// Every column needs at least its type and the name's terminating NUL
+	if (row_block->column_count > length / 2)
+	{
+		goto _error;
+	}
+
+	row_block->names = g_new(gchar const*, row_block->column_count);
+	row_block->types = g_new(guint8, row_block->column_count);
+
+	for (guint32 i = 0; i < row_block->column_count; i++)
+	{
+		gchar const* name;
+		guint8 const* end;
+
+		if (!j_row_block_consume(row_block, &position, 1))
+		{
+			goto _error;
+		}
+
+		row_block->types[i] = row_block->data[position - 1];
+		name = (gchar const*)(row_block->data + position);
+		end = memchr(name, '\0', length - position);
+
+		if (end == NULL)
+		{
+			goto _error;
+		}
+
+		row_block->names[i] = name;
+		g_hash_table_insert(row_block->columns, (gpointer)name, GUINT_TO_POINTER(i));
+		position += (end - (guint8 const*)name) + 1;
+	}
+
+	if (!j_row_block_consume(row_block, &position, 4))
+	{
+		goto _error;
+	}
+
+	row_block->row_count = j_row_block_read_4(row_block, position - 4);
+
+	// Every value needs at least one bit in its row's bitmap
+	if ((guint64)row_block->row_count * row_block->column_count > (guint64)length * 8 || (row_block->column_count == 0 && row_block->row_count > 0))
+	{
+		goto _error;
+	}
+
+	bitmap_size = (row_block->column_count + 7) / 8;
+	row_block->offsets = g_new(guint32, row_block->row_count * row_block->column_count);
+
+	for (guint32 row = 0; row < row_block->row_count; row++)
+	{
+		guint32 bitmap = position;
+
+		if (!j_row_block_consume(row_block, &position, bitmap_size))
+		{
+			goto _error;
+		}
+
+		for (guint32 column = 0; column < row_block->column_count; column++)
+		{
+			guint32* offset = &(row_block->offsets[row * row_block->column_count + column]);
+			gboolean valid;
+
+			if (row_block->data[bitmap + column / 8] & (1 << (column % 8)))
+			{
+				*offset = G_MAXUINT32;
+				continue;
+			}
+
+			*offset = position;
+
+			switch (row_block->types[column])
+			{
+				case BSON_TYPE_INT32:
+					valid = j_row_block_consume(row_block, &position, 4);
+					break;
+				case BSON_TYPE_INT64:
+				case BSON_TYPE_DOUBLE:
+					valid = j_row_block_consume(row_block, &position, 8);
+					break;
+				case BSON_TYPE_UTF8:
+					valid = j_row_block_consume(row_block, &position, 4);
+					valid = valid && j_row_block_consume(row_block, &position, (guint64)j_row_block_read_4(row_block, *offset) + 1);
+					valid = valid && row_block->data[position - 1] == '\0';
+					break;
+				case BSON_TYPE_BINARY:
+					valid = j_row_block_consume(row_block, &position, 4);
+					valid = valid && j_row_block_consume(row_block, &position, j_row_block_read_4(row_block, *offset));
+					break;
+				default:
+					valid = FALSE;
+			}
+
+			if (!valid)
+			{
+				goto _error;
+			}
+		}
+	}
+
+	if (position != length)
+	{
+		goto _error;
+	}
+
+	return row_block;
+
+_error:
+	j_row_block_free(row_block);
+
+	return NULL;
+}
+
+/**
+ * Frees a row block.
+ *
+ * \param row_block A row block.
+ **/
+void
+j_row_block_free(JRowBlock* row_block)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(row_block != NULL);
+
+	g_hash_table_unref(row_block->columns);
+
+	g_free(row_block->offsets);
+	g_free(row_block->types);
+	g_free(row_block->names);
+	g_free(row_block->data);
+
+	g_slice_free(JRowBlock, row_block);
+}
+
+/**
+ * Returns a row block's number of rows.
+ *
+ * \param row_block A row block.
+ *
+ * \return The number of rows.
+ **/
+guint32
+j_row_block_get_row_count(JRowBlock* row_block)
+{
+	g_return_val_if_fail(row_block != NULL, 0);
+
+	return row_block->row_count;
+}
+
+/**
+ * Returns a row block's number of columns.
+ *
+ * \param row_block A row block.
+ *
+ * \return The number of columns.
+ **/
+guint32
+j_row_block_get_column_count(JRowBlock* row_block)
+{
+	g_return_val_if_fail(row_block != NULL, 0);
+
+	return row_block->column_count;
+}
+
+/**
+ * Returns a column's name.
+ *
+ * \param row_block A row block.
+ * \param column    A column index.
+ *
+ * \return The column's name.
+ **/
+gchar const*
+j_row_block_get_column_name(JRowBlock* row_block, guint32 column)
+{
+	g_return_val_if_fail(row_block != NULL, NULL);
+	g_return_val_if_fail(column < row_block->column_count, NULL);
+
+	return row_block->names[column];
+}
+
+/**
+ * Looks up a column's index.
+ *
+ * \param row_block A row block.
+ * \param name      A column name.
+ * \param column    A pointer that receives the column index.
+ *
+ * \return TRUE if the column exists, FALSE otherwise.
+ **/
+gboolean
+j_row_block_get_column_index(JRowBlock* row_block, gchar const* name, guint32* column)
+{
+	gpointer value;
+
+	g_return_val_if_fail(row_block != NULL, FALSE);
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(column != NULL, FALSE);
+
+	if (!g_hash_table_lookup_extended(row_block->columns, name, NULL, &value))
+	{
+		return FALSE;
+	}
+
+	*column = GPOINTER_TO_UINT(value);
+
+	return TRUE;
+}
+
+/**
+ * Returns a value.
+ * Strings and binaries point into the row block and are valid as long as it exists.
+ *
+ * \param row_block A row block.
+ * \param row       A row index.
+ * \param column    A column index.
+ * \param value     A pointer that receives the value, its type is BSON_TYPE_NULL for NULL values.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+gboolean
+j_row_block_get_value(JRowBlock* row_block, guint32 row, guint32 column, bson_value_t* value)
+{
+	guint32 offset;
+
+	g_return_val_if_fail(row_block != NULL, FALSE);
+	g_return_val_if_fail(row < row_block->row_count, FALSE);
+	g_return_val_if_fail(column < row_block->column_count, FALSE);
+	g_return_val_if_fail(value != NULL, FALSE);
+
+	offset = row_block->offsets[row * row_block->column_count + column];
+
+	if (offset == G_MAXUINT32)
+	{
+		value->value_type = BSON_TYPE_NULL;
+
+		return TRUE;
+	}
+
+	value->value_type = row_block->types[column];
+
+	switch (value->value_type)
+	{
+		case BSON_TYPE_INT32:
+			value->value.v_int32 = (gint32)j_row_block_read_4(row_block, offset);
+			break;
+		case BSON_TYPE_INT64:
+			value->value.v_int64 = (gint64)j_row_block_read_8(row_block, offset);
+			break;
+		case BSON_TYPE_DOUBLE:
+			{
+				guint64 bits;
+
+				bits = j_row_block_read_8(row_block, offset);
+				memcpy(&(value->value.v_double), &bits, sizeof(bits));
+			}
+			break;
+		case BSON_TYPE_UTF8:
+			value->value.v_utf8.len = j_row_block_read_4(row_block, offset);
+			value->value.v_utf8.str = (gchar*)(row_block->data + offset + 4);
+			break;
+		case BSON_TYPE_BINARY:
+			value->value.v_binary.subtype = BSON_SUBTYPE_BINARY;
+			value->value.v_binary.data_len = j_row_block_read_4(row_block, offset);
+			value->value.v_binary.data = row_block->data + offset + 4;
+			break;
+		default:
+			return FALSE;
+	}
+
+	return TRUE;
+}
+
+/**
+ * @}
+ **/
@@ -82,6 +82,21 @@ struct JStatistics
 	 * The number of sent bytes.
 	 **/
 	guint64 bytes_sent;
+
+	/**
+	 * The number of DB statements found in the statement cache.
+	 **/
+	guint64 db_statements_hit;
+
+	/**
+	 * The number of DB statements not found in the statement cache.
+	 **/
+	guint64 db_statements_missed;
+
+	/**
+	 * The number of DB statements evicted from the statement cache.
+	 **/
+	guint64 db_statements_evicted;
 };
 
 static gchar const*
@@ -107,6 +122,12 @@ j_statistics_get_type_name(JStatisticsType type)
 			return "bytes_received";
 		case J_STATISTICS_BYTES_SENT:
 			return "bytes_sent";
+		case J_STATISTICS_DB_STATEMENTS_HIT:
+			return "db_statements_hit";
+		case J_STATISTICS_DB_STATEMENTS_MISSED:
+			return "db_statements_missed";
+		case J_STATISTICS_DB_STATEMENTS_EVICTED:
+			return "db_statements_evicted";
 		default:
 			g_warn_if_reached();
 			return NULL;
@@ -143,6 +164,9 @@ j_statistics_new(gboolean trace)
 	statistics->bytes_written = 0;
 	statistics->bytes_received = 0;
 	statistics->bytes_sent = 0;
+	statistics->db_statements_hit = 0;
+	statistics->db_statements_missed = 0;
+	statistics->db_statements_evicted = 0;
 
 	return statistics;
 }
@@ -202,6 +226,15 @@ j_statistics_get(JStatistics* statistics, JStatisticsType type)
 		case J_STATISTICS_BYTES_SENT:
 			value = statistics->bytes_sent;
 			break;
+		case J_STATISTICS_DB_STATEMENTS_HIT:
+			value = statistics->db_statements_hit;
+			break;
+		case J_STATISTICS_DB_STATEMENTS_MISSED:
+			value = statistics->db_statements_missed;
+			break;
+		case J_STATISTICS_DB_STATEMENTS_EVICTED:
+			value = statistics->db_statements_evicted;
+			break;
 		default:
 			g_warn_if_reached();
 			break;
@@ -243,6 +276,15 @@ j_statistics_add(JStatistics* statistics, JStatisticsType type, guint64 value)
 		case J_STATISTICS_BYTES_SENT:
 			statistics->bytes_sent += value;
 			break;
+		case J_STATISTICS_DB_STATEMENTS_HIT:
+			statistics->db_statements_hit += value;
+			break;
+		case J_STATISTICS_DB_STATEMENTS_MISSED:
+			statistics->db_statements_missed += value;
+			break;
+		case J_STATISTICS_DB_STATEMENTS_EVICTED:
+			statistics->db_statements_evicted += value;
+			break;
 		default:
 			g_warn_if_reached();
 			break;
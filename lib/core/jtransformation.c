@@ -26,91 +26,163 @@
 
 #include <glib.h>
 
+#include <string.h>
+
 /* #ifdef HAVE_LZ4 */
 #include <lz4.h>
 /* #endif */
 
+#include <zstd.h>
+
 /**
  * \defgroup JTransformation Transformation
  * @{
  **/
 
+#ifndef ZSTD_CLEVEL_DEFAULT
+#define ZSTD_CLEVEL_DEFAULT 3
+#endif
+
 /**
- * XOR with 1 for each bit
- */
-static void
-j_transformation_apply_xor(gpointer input, gpointer* output,
-			   guint64* length)
+ * A dictionary registered with j_transformation_add_dictionary().
+ **/
+struct JTransformationDictionary
 {
-	guint8* in;
-	guint8* out;
+	gpointer data;
+	gsize length;
 
-	in = input;
-	out = g_slice_alloc(*length);
+	/**
+	 * The digested dictionary for decompression.
+	 **/
+	ZSTD_DDict* ddict;
 
-	for (guint i = 0; i < *length; i++)
-	{
-		out[i] = in[i] ^ 255;
-	}
+	/**
+	 * The digested dictionaries for compression, they depend on the level (level -> ZSTD_CDict*).
+	 **/
+	GHashTable* cdicts;
+};
+
+typedef struct JTransformationDictionary JTransformationDictionary;
+
+/**
+ * The registered dictionaries (ID -> JTransformationDictionary*).
+ * Dictionaries are never removed, so they can be used without holding the mutex.
+ **/
+static GHashTable* j_transformation_dictionaries = NULL;
+static GMutex j_transformation_dictionaries_mutex;
 
-	*output = out;
+static void
+j_transformation_zstd_cctx_free(gpointer cctx)
+{
+	ZSTD_freeCCtx(cctx);
 }
 
 static void
-j_transformation_apply_xor_inverse(gpointer input, gpointer* output,
-				   guint64* length)
+j_transformation_zstd_dctx_free(gpointer dctx)
 {
-	j_transformation_apply_xor(input, output, length);
+	ZSTD_freeDCtx(dctx);
 }
 
 /**
- * Simple run length encoding
- */
+ * Contexts are expensive to create, every thread reuses its own.
+ **/
+static GPrivate j_transformation_zstd_cctx = G_PRIVATE_INIT(j_transformation_zstd_cctx_free);
+static GPrivate j_transformation_zstd_dctx = G_PRIVATE_INIT(j_transformation_zstd_dctx_free);
+
+/**
+ * A growing buffer for intermediate results.
+ **/
+struct JTransformationScratch
+{
+	gpointer data;
+	gsize size;
+};
+
+typedef struct JTransformationScratch JTransformationScratch;
+
 static void
-j_transformation_apply_rle(gpointer input, gpointer* output,
-			   guint64* length)
+j_transformation_scratch_free(gpointer data)
 {
-	guint8* in;
-	guint8* out;
-	guint8 value, copies;
-	guint64 outpos;
+	JTransformationScratch* scratch = data;
 
-	in = input;
+	g_free(scratch->data);
+	g_slice_free(JTransformationScratch, scratch);
+}
 
-	// dry run to get the size of output buffer
-	// alternative:
-	// temp allocate 2*length and memcpy into final buffer with exact size
-	outpos = 0;
-	if (*length > 0)
+/**
+ * Every thread reuses its own scratch buffer, so transformations do not allocate memory once it is large enough.
+ **/
+static GPrivate j_transformation_scratch = G_PRIVATE_INIT(j_transformation_scratch_free);
+
+static gpointer
+j_transformation_get_scratch(gsize size)
+{
+	JTransformationScratch* scratch;
+
+	if ((scratch = g_private_get(&j_transformation_scratch)) == NULL)
 	{
-		copies = 0;
-		value = in[0];
+		scratch = g_slice_new0(JTransformationScratch);
+		g_private_set(&j_transformation_scratch, scratch);
+	}
 
-		for (guint64 i = 1; i < *length; i++)
-		{
-			if (in[i] == value && copies < 255)
-			{
-				copies++;
-			}
-			else
-			{
-				outpos += 2;
-			}
-		}
-		outpos += 2;
+	if (scratch->size < size)
+	{
+		// The old contents do not have to be preserved
+		g_free(scratch->data);
+		scratch->data = g_malloc(size);
+		scratch->size = size;
 	}
 
-	// allocate buffer that fits to transformed data
-	out = g_slice_alloc(outpos);
+	return scratch->data;
+}
+
+/*
+ * The kernels write into an output buffer of at least j_transformation_get_bound() bytes and return the output's length.
+ * Kernels that can fail return whether they succeeded and store the output's length in outlength instead.
+ */
+
+/**
+ * XOR with 1 for each bit, output may be input
+ */
+static guint64
+j_transformation_apply_xor(gconstpointer input, gpointer output, guint64 length)
+{
+	guint8 const* in = input;
+	guint8* out = output;
+
+	for (guint64 i = 0; i < length; i++)
+	{
+		out[i] = in[i] ^ 255;
+	}
+
+	return length;
+}
+
+static guint64
+j_transformation_apply_xor_inverse(gconstpointer input, gpointer output, guint64 length)
+{
+	return j_transformation_apply_xor(input, output, length);
+}
+
+/**
+ * Simple run length encoding, needs at most two bytes per input byte
+ */
+static guint64
+j_transformation_apply_rle(gconstpointer input, gpointer output, guint64 length)
+{
+	guint8 const* in = input;
+	guint8* out = output;
+	guint8 value, copies;
+	guint64 outpos;
 
-	// run again and store the transform
 	outpos = 0;
-	if (*length > 0)
+
+	if (length > 0)
 	{
 		copies = 0; // this means count = 1, storing a 0 makes no sense
 		value = in[0];
 
-		for (guint64 i = 1; i < *length; i++)
+		for (guint64 i = 1; i < length; i++)
 		{
 			if (in[i] == value && copies < 255)
 			{
@@ -133,102 +205,364 @@ j_transformation_apply_rle(gpointer input, gpointer* output,
 		outpos += 2;
 	}
 
-	*output = out;
-	*length = outpos;
+	return outpos;
 }
 
-static void
-j_transformation_apply_rle_inverse(gpointer input, gpointer* output,
-				   guint64* length)
+static guint64
+j_transformation_get_rle_inverse_length(gconstpointer input, guint64 length)
 {
-	guint8* in;
-	guint8* out;
-	guint8 value;
-	guint16 count;
-	guint64 outpos;
-
-	in = input;
+	guint8 const* in = input;
+	guint64 outlength = 0;
 
-	// dry run to get the size of output buffer
-	outpos = 0;
-	for (guint64 i = 1; i < *length; i += 2)
+	for (guint64 i = 1; i < length; i += 2)
 	{
-		count = (guint16)in[i - 1] + 1;
-		outpos += count;
+		outlength += (guint16)in[i - 1] + 1;
 	}
 
-	// allocate buffer that fits to transformed data
-	out = g_slice_alloc(outpos);
+	return outlength;
+}
+
+static guint64
+j_transformation_apply_rle_inverse(gconstpointer input, gpointer output, guint64 length, guint64 capacity)
+{
+	guint8 const* in = input;
+	guint8* out = output;
+	guint16 count;
+	guint64 outpos;
 
-	// run again and store the transform
 	outpos = 0;
-	for (guint64 i = 1; i < *length; i += 2)
+
+	// Stop when the output is full, callers might only want the beginning of the data
+	for (guint64 i = 1; i < length && outpos < capacity; i += 2)
 	{
-		count = (guint16)in[i - 1] + 1; // count = copies + 1
-		value = in[i];
-		memset(out + outpos, value, count);
+		count = MIN((guint16)in[i - 1] + 1, capacity - outpos); // count = copies + 1
+		memset(out + outpos, in[i], count);
 		outpos += count;
 	}
 
-	*output = out;
-	*length = outpos;
+	return outpos;
 }
 
 /**
  * Use LZ4 compression with "lz4" library, https://github.com/lz4/lz4
+ * Fails if the data is too large for LZ4.
  */
-static void
-j_transformation_apply_lz4(gpointer input, gpointer* output,
-			   guint64* length)
+static gboolean
+j_transformation_apply_lz4(gconstpointer input, gpointer output, guint64 length, guint64 capacity, guint64* outlength)
 {
 	/* #ifdef HAVE_LZ4 */
-	char* out;
-	guint64 max_out_len;
-	gint64 lz4_compression_result;
+	gint lz4_compression_result;
+
+	if (length > LZ4_MAX_INPUT_SIZE)
+	{
+		g_warning("Data can not be compressed: %" G_GUINT64_FORMAT " bytes exceed LZ4's maximum input size", length);
+		return FALSE;
+	}
 
-	// LZ4 has a function to estimate the output (upper bound)
-	max_out_len = LZ4_compressBound(*length);
-	out = g_slice_alloc(max_out_len);
+	lz4_compression_result = LZ4_compress_default(input, output, length, MIN(capacity, G_MAXINT));
 
-	// Compression
-	lz4_compression_result = LZ4_compress_default(input, out, *length, max_out_len);
-	g_assert(lz4_compression_result > 0);
+	if (lz4_compression_result <= 0)
+	{
+		g_warning("Data can not be compressed");
+		return FALSE;
+	}
 
-	// Copy the used part only
-	*output = g_slice_alloc(lz4_compression_result);
-	*length = lz4_compression_result;
-	memcpy(*output, out, lz4_compression_result);
+	*outlength = lz4_compression_result;
 
-	g_slice_free1(max_out_len, out);
+	return TRUE;
 	/* #endif */
 }
 
-static void
-j_transformation_apply_lz4_inverse(gpointer input, gpointer* output,
-				   guint64* inlength, guint64* outlength)
+/**
+ * Fails if the data is corrupt.
+ */
+static gboolean
+j_transformation_apply_lz4_inverse(gconstpointer input, gpointer output, guint64 length, guint64 capacity, guint64* outlength)
 {
 	/* #ifdef HAVE_LZ4 */
-	char* out;
-	guint64 max_out_len;
-	gint64 lz4_decompression_result;
+	gint lz4_decompression_result;
 
-	// TODO Estimatedmaximum size of output as good as possible
-	max_out_len = *outlength;
-	out = g_slice_alloc(max_out_len);
+	if (length > G_MAXINT)
+	{
+		g_warning("Data can not be decompressed: %" G_GUINT64_FORMAT " bytes exceed LZ4's maximum input size", length);
+		return FALSE;
+	}
 
-	// Decompression
-	lz4_decompression_result = LZ4_decompress_safe(input, out, *inlength, max_out_len);
-	g_assert(lz4_decompression_result > 0);
+	// Decompression stops when the output is full, callers might only want the beginning of the data
+	lz4_decompression_result = LZ4_decompress_safe_partial(input, output, length, MIN(capacity, G_MAXINT), MIN(capacity, G_MAXINT));
+
+	if (lz4_decompression_result < 0)
+	{
+		g_warning("Data can not be decompressed");
+		return FALSE;
+	}
 
-	// Copy the used part only
-	*output = g_slice_alloc(lz4_decompression_result);
 	*outlength = lz4_decompression_result;
-	memcpy(*output, out, *outlength);
 
-	g_slice_free1(max_out_len, out);
+	return TRUE;
 	/* #endif */
 }
 
+/**
+ * Returns the ID of a trained dictionary, 0 for raw content dictionaries.
+ * ZSTD_getDictID_fromDict() is only part of the stable API since zstd 1.4.0.
+ */
+static guint32
+j_transformation_get_zstd_dictionary_id(gconstpointer data, gsize length)
+{
+	guint8 const* dictionary = data;
+
+	// Trained dictionaries start with a magic number (0xEC30A437) followed by their ID, both little-endian
+	if (length < 8 || dictionary[0] != 0x37 || dictionary[1] != 0xa4 || dictionary[2] != 0x30 || dictionary[3] != 0xec)
+	{
+		return 0;
+	}
+
+	return (guint32)dictionary[4] | ((guint32)dictionary[5] << 8) | ((guint32)dictionary[6] << 16) | ((guint32)dictionary[7] << 24);
+}
+
+/**
+ * Returns the ID of the dictionary a frame has been compressed with, 0 if there is none.
+ * ZSTD_getDictID_fromFrame() is only part of the stable API since zstd 1.4.0.
+ */
+static guint32
+j_transformation_get_zstd_frame_dictionary_id(gconstpointer input, guint64 length)
+{
+	static guint const id_sizes[] = { 0, 1, 2, 4 };
+
+	guint8 const* frame = input;
+	guint64 position;
+	guint32 id = 0;
+	guint size;
+
+	// Frames start with a magic number (0xFD2FB528) followed by the frame header descriptor
+	if (length < 5 || frame[0] != 0x28 || frame[1] != 0xb5 || frame[2] != 0x2f || frame[3] != 0xfd)
+	{
+		return 0;
+	}
+
+	// The window descriptor is omitted for single segment frames
+	position = ((frame[4] & 0x20) != 0) ? 5 : 6;
+	size = id_sizes[frame[4] & 0x03];
+
+	if (position + size > length)
+	{
+		return 0;
+	}
+
+	for (guint i = size; i > 0; i--)
+	{
+		id = (id << 8) | frame[position + i - 1];
+	}
+
+	return id;
+}
+
+static ZSTD_CDict*
+j_transformation_get_zstd_cdict(guint32 id, gint level)
+{
+	JTransformationDictionary* dictionary;
+	ZSTD_CDict* cdict = NULL;
+
+	g_mutex_lock(&j_transformation_dictionaries_mutex);
+
+	if (j_transformation_dictionaries != NULL && (dictionary = g_hash_table_lookup(j_transformation_dictionaries, GUINT_TO_POINTER(id))) != NULL)
+	{
+		if ((cdict = g_hash_table_lookup(dictionary->cdicts, GINT_TO_POINTER(level))) == NULL)
+		{
+			cdict = ZSTD_createCDict(dictionary->data, dictionary->length, level);
+			g_hash_table_insert(dictionary->cdicts, GINT_TO_POINTER(level), cdict);
+		}
+	}
+
+	g_mutex_unlock(&j_transformation_dictionaries_mutex);
+
+	return cdict;
+}
+
+static ZSTD_DDict*
+j_transformation_get_zstd_ddict(guint32 id)
+{
+	JTransformationDictionary* dictionary = NULL;
+
+	g_mutex_lock(&j_transformation_dictionaries_mutex);
+
+	if (j_transformation_dictionaries != NULL)
+	{
+		dictionary = g_hash_table_lookup(j_transformation_dictionaries, GUINT_TO_POINTER(id));
+	}
+
+	g_mutex_unlock(&j_transformation_dictionaries_mutex);
+
+	return (dictionary != NULL) ? dictionary->ddict : NULL;
+}
+
+/**
+ * Use Zstandard compression with "zstd" library, https://github.com/facebook/zstd
+ */
+static gboolean
+j_transformation_apply_zstd(JTransformation* trafo, gconstpointer input, gpointer output, guint64 length, guint64 capacity, guint64* outlength)
+{
+	ZSTD_CCtx* cctx;
+	ZSTD_CDict* cdict = NULL;
+	gsize zstd_compression_result;
+	gint level;
+
+	level = (trafo->level != 0) ? trafo->level : ZSTD_CLEVEL_DEFAULT;
+
+	if ((cctx = g_private_get(&j_transformation_zstd_cctx)) == NULL)
+	{
+		cctx = ZSTD_createCCtx();
+		g_private_set(&j_transformation_zstd_cctx, cctx);
+	}
+
+	if (trafo->dictionary != 0 && (cdict = j_transformation_get_zstd_cdict(trafo->dictionary, level)) == NULL)
+	{
+		g_warning("Dictionary %u is not registered, compressing without dictionary", trafo->dictionary);
+	}
+
+	// Compression, the frame contains the original size and the dictionary ID
+	if (cdict != NULL)
+	{
+		zstd_compression_result = ZSTD_compress_usingCDict(cctx, output, capacity, input, length, cdict);
+	}
+	else
+	{
+		zstd_compression_result = ZSTD_compressCCtx(cctx, output, capacity, input, length, level);
+	}
+
+	if (ZSTD_isError(zstd_compression_result))
+	{
+		g_warning("Data can not be compressed: %s", ZSTD_getErrorName(zstd_compression_result));
+		return FALSE;
+	}
+
+	*outlength = zstd_compression_result;
+
+	return TRUE;
+}
+
+static guint64
+j_transformation_get_zstd_inverse_length(gconstpointer input, guint64 length, guint64 outlength)
+{
+	guint64 content_size;
+
+	// The original size is stored in the frame, but the stored data can not be trusted to allocate buffers
+	content_size = ZSTD_getFrameContentSize(input, length);
+
+	return (content_size != ZSTD_CONTENTSIZE_UNKNOWN && content_size != ZSTD_CONTENTSIZE_ERROR) ? MIN(content_size, outlength) : outlength;
+}
+
+/**
+ * Fails if the data is corrupt or its dictionary is not registered.
+ *
+ * Only the streaming and bulk APIs of zstd 1.3 are used.
+ * Frames without dictionary are decompressed as a stream, which stops when the output is full.
+ * zstd 1.3 can only use digested dictionaries to decompress whole frames, so frames with dictionary are decompressed into a temporary buffer if the output is smaller than the frame's content.
+ */
+static gboolean
+j_transformation_apply_zstd_inverse(gconstpointer input, gpointer output, guint64 length, guint64 capacity, guint64* outlength)
+{
+	ZSTD_DCtx* dctx;
+	ZSTD_DDict* ddict;
+	gsize zstd_decompression_result;
+	guint32 dictionary;
+
+	if ((dctx = g_private_get(&j_transformation_zstd_dctx)) == NULL)
+	{
+		dctx = ZSTD_createDCtx();
+		g_private_set(&j_transformation_zstd_dctx, dctx);
+	}
+
+	if ((dictionary = j_transformation_get_zstd_frame_dictionary_id(input, length)) == 0)
+	{
+		ZSTD_inBuffer in = { input, length, 0 };
+		ZSTD_outBuffer out = { output, capacity, 0 };
+
+		// Decompression contexts are also streams since zstd 1.3.0
+		zstd_decompression_result = ZSTD_initDStream(dctx);
+
+		// Decompression stops when the output is full, callers might only want the beginning of the data
+		while (!ZSTD_isError(zstd_decompression_result))
+		{
+			zstd_decompression_result = ZSTD_decompressStream(dctx, &out, &in);
+
+			if (zstd_decompression_result == 0 || out.pos == out.size || in.pos == in.size)
+			{
+				break;
+			}
+		}
+
+		if (ZSTD_isError(zstd_decompression_result))
+		{
+			g_warning("Data can not be decompressed: %s", ZSTD_getErrorName(zstd_decompression_result));
+			return FALSE;
+		}
+
+		// The frame is incomplete
+		if (zstd_decompression_result != 0 && out.pos < out.size)
+		{
+			g_warning("Data can not be decompressed: truncated frame");
+			return FALSE;
+		}
+
+		*outlength = out.pos;
+	}
+	else
+	{
+		g_autofree gpointer buffer = NULL;
+		guint64 content_size;
+
+		if ((ddict = j_transformation_get_zstd_ddict(dictionary)) == NULL)
+		{
+			g_warning("Dictionary %u is not registered, data can not be decompressed", dictionary);
+			return FALSE;
+		}
+
+		// Frames are always compressed with their content size
+		content_size = ZSTD_getFrameContentSize(input, length);
+
+		if (content_size == ZSTD_CONTENTSIZE_UNKNOWN || content_size == ZSTD_CONTENTSIZE_ERROR)
+		{
+			g_warning("Data can not be decompressed: unknown content size");
+			return FALSE;
+		}
+
+		// The content size can not be trusted, so the temporary buffer's allocation may fail
+		if (content_size > capacity && (buffer = g_try_malloc(content_size)) == NULL)
+		{
+			g_warning("Data can not be decompressed: content size %" G_GUINT64_FORMAT " is too large", content_size);
+			return FALSE;
+		}
+
+		if (buffer != NULL)
+		{
+			zstd_decompression_result = ZSTD_decompress_usingDDict(dctx, buffer, content_size, input, length, ddict);
+		}
+		else
+		{
+			zstd_decompression_result = ZSTD_decompress_usingDDict(dctx, output, capacity, input, length, ddict);
+		}
+
+		if (ZSTD_isError(zstd_decompression_result))
+		{
+			g_warning("Data can not be decompressed: %s", ZSTD_getErrorName(zstd_decompression_result));
+			return FALSE;
+		}
+
+		if (buffer != NULL)
+		{
+			// Callers only want the beginning of the data
+			zstd_decompression_result = MIN(zstd_decompression_result, capacity);
+			memcpy(output, buffer, zstd_decompression_result);
+		}
+
+		*outlength = zstd_decompression_result;
+	}
+
+	return TRUE;
+}
+
 static gboolean
 j_transformation_here(JTransformation* trafo,
 		      JTransformationCaller caller)
@@ -291,6 +625,8 @@ j_transformation_new(JTransformationType type,
 
 	trafo->type = type;
 	trafo->mode = mode;
+	trafo->level = 0;
+	trafo->dictionary = 0;
 	trafo->ref_count = 1;
 
 	switch (type)
@@ -308,11 +644,45 @@ j_transformation_new(JTransformationType type,
 		case J_TRANSFORMATION_TYPE_LZ4:
 			trafo->partial_access = FALSE;
 			break;
+		case J_TRANSFORMATION_TYPE_ZSTD:
+			trafo->partial_access = FALSE;
+			break;
 	}
 
 	return trafo;
 }
 
+/**
+ * Get a JTransformation object from type with a compression level and dictionary.
+ * Only J_TRANSFORMATION_TYPE_ZSTD uses them currently.
+ *
+ * Dictionaries have to be registered using j_transformation_add_dictionary() in every process that applies the transformation.
+ * Servers can not register dictionaries, so they are only supported with J_TRANSFORMATION_MODE_CLIENT.
+ *
+ * \param level The compression level, 0 selects the default level.
+ * \param dictionary The ID of a registered dictionary, 0 disables dictionaries.
+ **/
+JTransformation*
+j_transformation_new_ext(JTransformationType type,
+			 JTransformationMode mode, gint32 level, guint32 dictionary)
+{
+	JTransformation* trafo;
+
+	trafo = j_transformation_new(type, mode);
+
+	trafo->level = level;
+
+	if (dictionary != 0 && mode != J_TRANSFORMATION_MODE_CLIENT)
+	{
+		g_warning("Dictionaries are only supported with J_TRANSFORMATION_MODE_CLIENT, no dictionary used");
+		dictionary = 0;
+	}
+
+	trafo->dictionary = dictionary;
+
+	return trafo;
+}
+
 JTransformation*
 j_transformation_ref(JTransformation* item)
 {
@@ -335,94 +705,247 @@ j_transformation_unref(JTransformation* item)
 }
 
 /**
- * Applies a transformation (inverse) on the data with length and offset.
- * This is done inplace (with an internal copy if necessary).
- * Does support trafo == NULL
+ * Returns the size of the buffer required by j_transformation_apply_into().
+ *
+ * \param input The input, only needed for inverse transformations.
+ * \param length The input's length.
+ * \param outlength The expected length of the inverse transformation's output, this is usually the original size.
+ *
+ * \return The maximum output length.
  **/
-void
-j_transformation_apply(JTransformation* trafo, gpointer input,
-		       guint64 inlength, guint64 inoffset, gpointer* output,
-		       guint64* outlength, guint64* outoffset, JTransformationCaller caller)
+guint64
+j_transformation_get_bound(JTransformation* trafo, gconstpointer input,
+			   guint64 length, guint64 outlength, JTransformationCaller caller)
 {
-	// Buffer for output of transformation, needs to be allocated by every method
-	// because only there the size is known / estimated
-	gpointer buffer;
-	guint64 length;
-	guint64 offset;
 	gboolean inverse;
 
-	length = inlength;
-	offset = inoffset;
+	if (trafo == NULL || !j_transformation_here(trafo, caller))
+		return length;
 
-	// not g_return_if_fail(trafo != NULL);
-	g_return_if_fail(input != NULL);
-	g_return_if_fail(output != NULL);
-	g_return_if_fail(outlength != NULL);
-	g_return_if_fail(outoffset != NULL);
+	inverse = j_transformation_inverse(trafo, caller);
 
-	if (trafo == NULL || !j_transformation_here(trafo, caller))
+	switch (trafo->type)
+	{
+		default:
+		case J_TRANSFORMATION_TYPE_NONE:
+		case J_TRANSFORMATION_TYPE_XOR:
+			return length;
+		case J_TRANSFORMATION_TYPE_RLE:
+			if (inverse)
+			{
+				g_return_val_if_fail(input != NULL, 0);
+				return j_transformation_get_rle_inverse_length(input, length);
+			}
+			else
+			{
+				return 2 * length;
+			}
+		case J_TRANSFORMATION_TYPE_LZ4:
+			// LZ4 does not store the original size
+			return inverse ? outlength : (guint64)LZ4_compressBound(length);
+		case J_TRANSFORMATION_TYPE_ZSTD:
+			if (inverse)
+			{
+				g_return_val_if_fail(input != NULL, 0);
+				return j_transformation_get_zstd_inverse_length(input, length, outlength);
+			}
+			else
+			{
+				return ZSTD_compressBound(length);
+			}
+	}
+}
+
+/**
+ * Applies a transformation (inverse) on the data and writes the result into the caller's buffer.
+ * Nothing is allocated, so this can be used with reusable buffers.
+ * Transformations with partial access can be applied in place by passing input as output.
+ *
+ * \param output A buffer for the result, usually of j_transformation_get_bound() bytes.
+ * \param outlength The size of output, returns the length of the result.
+ *                  Inverse transformations stop early when output is smaller than the result.
+ *
+ * \return TRUE on success, FALSE if the input is corrupt or can not be detransformed.
+ **/
+gboolean
+j_transformation_apply_into(JTransformation* trafo, gconstpointer input,
+			    guint64 inlength, gpointer output, guint64* outlength, JTransformationCaller caller)
+{
+	guint64 capacity;
+	gboolean inverse;
+
+	g_return_val_if_fail(input != NULL || inlength == 0, FALSE);
+	g_return_val_if_fail(outlength != NULL, FALSE);
+	g_return_val_if_fail(output != NULL || *outlength == 0, FALSE);
+
+	capacity = *outlength;
+
+	if (trafo == NULL || !j_transformation_here(trafo, caller) || trafo->type == J_TRANSFORMATION_TYPE_NONE)
 	{
 		// nothing to do here, but make sure output is usable
-		*output = input;
-		*outlength = inlength;
-		*outoffset = inoffset;
-		return;
+		*outlength = MIN(inlength, capacity);
+
+		if (output != input)
+		{
+			memcpy(output, input, *outlength);
+		}
+
+		return TRUE;
 	}
 
 	inverse = j_transformation_inverse(trafo, caller);
 
 	switch (trafo->type)
 	{
-		case J_TRANSFORMATION_TYPE_NONE:
-			return;
 		case J_TRANSFORMATION_TYPE_XOR:
+			g_return_val_if_fail(capacity >= inlength, FALSE);
+
 			if (inverse)
-				j_transformation_apply_xor_inverse(input, &buffer, &length);
+				*outlength = j_transformation_apply_xor_inverse(input, output, inlength);
 			else
-				j_transformation_apply_xor(input, &buffer, &length);
+				*outlength = j_transformation_apply_xor(input, output, inlength);
 			break;
 		case J_TRANSFORMATION_TYPE_RLE:
 			if (inverse)
-				j_transformation_apply_rle_inverse(input, &buffer, &length);
+			{
+				*outlength = j_transformation_apply_rle_inverse(input, output, inlength, capacity);
+			}
 			else
-				j_transformation_apply_rle(input, &buffer, &length);
+			{
+				g_return_val_if_fail(capacity >= 2 * inlength, FALSE);
+				*outlength = j_transformation_apply_rle(input, output, inlength);
+			}
 			break;
 		case J_TRANSFORMATION_TYPE_LZ4:
 			if (inverse)
-				j_transformation_apply_lz4_inverse(input, &buffer, &inlength, outlength);
+				return j_transformation_apply_lz4_inverse(input, output, inlength, capacity, outlength);
 			else
-				j_transformation_apply_lz4(input, &buffer, &length);
-			break;
+				return j_transformation_apply_lz4(input, output, inlength, capacity, outlength);
+		case J_TRANSFORMATION_TYPE_ZSTD:
+			if (inverse)
+				return j_transformation_apply_zstd_inverse(input, output, inlength, capacity, outlength);
+			else
+				return j_transformation_apply_zstd(trafo, input, output, inlength, capacity, outlength);
 		default:
-			return;
+			return FALSE;
 	}
 
+	return TRUE;
+}
+
+/**
+ * Applies a transformation (inverse) on the data with length and offset.
+ * This is done inplace (with an internal copy if necessary).
+ * Does support trafo == NULL
+ *
+ * \return TRUE on success, FALSE if the input can not be detransformed, the output is zeroed in this case.
+ **/
+gboolean
+j_transformation_apply(JTransformation* trafo, gpointer input,
+		       guint64 inlength, guint64 inoffset, gpointer* output,
+		       guint64* outlength, guint64* outoffset, JTransformationCaller caller)
+{
+	gpointer buffer;
+	guint64 bound;
+	guint64 length;
+	guint64 offset;
+	gboolean ret;
+
+	// not g_return_val_if_fail(trafo != NULL, FALSE);
+	g_return_val_if_fail(input != NULL, FALSE);
+	g_return_val_if_fail(output != NULL, FALSE);
+	g_return_val_if_fail(outlength != NULL, FALSE);
+	g_return_val_if_fail(outoffset != NULL, FALSE);
+
+	if (trafo == NULL || !j_transformation_here(trafo, caller))
+	{
+		// nothing to do here, but make sure output is usable
+		*output = input;
+		*outlength = inlength;
+		*outoffset = inoffset;
+		return TRUE;
+	}
+
+	if (trafo->type == J_TRANSFORMATION_TYPE_NONE)
+		return TRUE;
+
 	// when !trafo->partial_access both input and output need to be the whole
 	// object, which is realized by the caller
-	if (!trafo->partial_access)
+	offset = (trafo->partial_access) ? inoffset : 0;
+
+	// for client read we have user app memory as output given, we need to
+	// fill it with the requested part
+	if (caller == J_TRANSFORMATION_CALLER_CLIENT_READ && *output != NULL)
 	{
-		offset = 0;
+		// the result can be the whole object while output only wants a
+		// small part of it, only the part up to its end is needed
+		g_return_val_if_fail(*outoffset >= offset, FALSE);
+		length = *outoffset - offset + *outlength;
+		bound = j_transformation_get_bound(trafo, input, inlength, length, caller);
+
+		if (*outoffset == offset && bound <= *outlength)
+		{
+			length = *outlength;
+			ret = j_transformation_apply_into(trafo, input, inlength, *output, &length, caller);
+		}
+		else
+		{
+			buffer = j_transformation_get_scratch(bound);
+
+			ret = j_transformation_apply_into(trafo, input, inlength, buffer, &bound, caller) && bound >= length;
+
+			if (ret)
+			{
+				memcpy(*output, (gchar*)buffer + *outoffset - offset, *outlength);
+			}
+		}
+
+		if (!ret)
+		{
+			memset(*output, 0, *outlength);
+		}
+
+		return ret;
 	}
 
-	// output buffer is always created by the method, but for client read we have
-	// user app memory as output given, we need to copy the requested part
-	// and free the output buffer (cleanup does free the input buffer)
-	if (caller == J_TRANSFORMATION_CALLER_CLIENT_READ && *output != NULL)
+	// otherwise the output buffer is created here and has to be freed with
+	// j_transformation_cleanup(), so it must have the exact size
+	bound = j_transformation_get_bound(trafo, input, inlength, *outlength, caller);
+	length = bound;
+
+	if (trafo->partial_access || j_transformation_inverse(trafo, caller))
 	{
-		g_return_if_fail(buffer != NULL);
-		// buffer can now be the whole tranformed object while output
-		// only wanted a small part of it
-		g_return_if_fail(length - offset + *outoffset >= *outlength);
-		memcpy(*output, (gchar*)buffer - offset + *outoffset, *outlength);
-		g_slice_free1(length, buffer);
+		// the result usually has the bound's size
+		buffer = g_slice_alloc(bound);
+
+		if (!(ret = j_transformation_apply_into(trafo, input, inlength, buffer, &length, caller)))
+		{
+			memset(buffer, 0, bound);
+			length = bound;
+		}
+
+		if (length != bound)
+		{
+			gpointer result;
+
+			result = g_slice_copy(length, buffer);
+			g_slice_free1(bound, buffer);
+			buffer = result;
+		}
 	}
 	else
 	{
-		g_return_if_fail(buffer != NULL);
-		*output = buffer;
-		*outlength = length;
-		*outoffset = offset;
+		// compress into the scratch buffer to not waste the bound's space
+		buffer = j_transformation_get_scratch(bound);
+		ret = j_transformation_apply_into(trafo, input, inlength, buffer, &length, caller);
+		buffer = g_slice_copy(length, buffer);
 	}
+
+	*output = buffer;
+	*outlength = length;
+	*outoffset = offset;
+
+	return ret;
 }
 
 /**
@@ -433,6 +956,7 @@ j_transformation_apply(JTransformation* trafo, gpointer input,
  * For read operations this can be called directly after the transformation was
  * applied and the parameters must be the temp buffer prepared by
  * prep_read_buffer()
+ * Client reads into user app memory do not need a cleanup.
  * Does support trafo == NULL
  **/
 void
@@ -443,24 +967,12 @@ j_transformation_cleanup(JTransformation* trafo, gpointer data,
 
 	g_return_if_fail(data != NULL);
 
-	if (trafo == NULL || !j_transformation_here(trafo, caller))
+	if (trafo == NULL || !j_transformation_here(trafo, caller) || trafo->type == J_TRANSFORMATION_TYPE_NONE)
 		return;
 
-	// client read only needs a buffer if transformation can't be done inplace
-	// write always needs a temp buffer to not interfer with user app memory
-	// but with !partial_access aka. need_whole_object the caller is responsible
-	// to cleanup once the memory block for the wohle object, this method
-	// gets called per operation
-	if (caller == J_TRANSFORMATION_CALLER_CLIENT_READ || J_TRANSFORMATION_CALLER_CLIENT_WRITE)
-	{
-		if (!trafo->partial_access)
-			g_slice_free1(length, data);
-	}
-	//
-	else if (trafo->partial_access)
-	{
-		g_slice_free1(length, data);
-	}
+	// every buffer returned by j_transformation_apply has been allocated
+	// with its exact length
+	g_slice_free1(length, data);
 }
 
 JTransformationMode
@@ -491,6 +1003,52 @@ j_transformation_need_whole_object(JTransformation* trafo,
 		return !trafo->partial_access;
 }
 
+/**
+ * Registers a dictionary trained using zstd's dictionary builder (for example, "zstd --train").
+ * Dictionaries considerably improve the compression ratio of small objects.
+ *
+ * \param data The dictionary, it is copied.
+ * \param length The dictionary's length.
+ *
+ * \return The dictionary's ID to be passed to j_transformation_new_ext(), 0 if data is not a trained dictionary.
+ **/
+guint32
+j_transformation_add_dictionary(gconstpointer data, gsize length)
+{
+	JTransformationDictionary* dictionary;
+	guint32 id;
+
+	g_return_val_if_fail(data != NULL, 0);
+
+	// Raw content dictionaries do not have an ID, which is needed to find the dictionary when decompressing
+	if ((id = j_transformation_get_zstd_dictionary_id(data, length)) == 0)
+	{
+		return 0;
+	}
+
+	g_mutex_lock(&j_transformation_dictionaries_mutex);
+
+	if (j_transformation_dictionaries == NULL)
+	{
+		j_transformation_dictionaries = g_hash_table_new(NULL, NULL);
+	}
+
+	if (!g_hash_table_contains(j_transformation_dictionaries, GUINT_TO_POINTER(id)))
+	{
+		dictionary = g_new(JTransformationDictionary, 1);
+		dictionary->data = g_memdup(data, length);
+		dictionary->length = length;
+		dictionary->ddict = ZSTD_createDDict(dictionary->data, dictionary->length);
+		dictionary->cdicts = g_hash_table_new(NULL, NULL);
+
+		g_hash_table_insert(j_transformation_dictionaries, GUINT_TO_POINTER(id), dictionary);
+	}
+
+	g_mutex_unlock(&j_transformation_dictionaries_mutex);
+
+	return id;
+}
+
 /**
  * @}
  **/
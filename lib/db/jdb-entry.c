@@ -56,6 +56,7 @@ j_db_entry_new(JDBSchema* schema, GError** error)
 	}
 
 	entry->ref_count = 1;
+	entry->fields_set = g_array_new(FALSE, TRUE, sizeof(guint8));
 	entry->schema = j_db_schema_ref(schema);
 
 	if (G_UNLIKELY(!entry->schema))
@@ -93,6 +94,7 @@ j_db_entry_unref(JDBEntry* entry)
 	if (g_atomic_int_dec_and_test(&entry->ref_count))
 	{
 		j_db_schema_unref(entry->schema);
+		g_array_unref(entry->fields_set);
 		j_bson_destroy(&entry->bson);
 		j_bson_destroy(&entry->id);
 		g_free(entry);
@@ -104,30 +106,61 @@ j_db_entry_set_field(JDBEntry* entry, gchar const* name, gconstpointer value, gu
 {
 	J_TRACE_FUNCTION(NULL);
 
+	guint32 index;
+
+	g_return_val_if_fail(entry != NULL, FALSE);
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	if (G_UNLIKELY(!j_db_schema_get_field_index(entry->schema, name, &index, error)))
+	{
+		goto _error;
+	}
+
+	return j_db_entry_set_field_by_index(entry, index, value, length, error);
+
+_error:
+	return FALSE;
+}
+
+gboolean
+j_db_entry_set_field_by_index(JDBEntry* entry, guint32 index, gconstpointer value, guint64 length, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBSchemaFieldTable* field_table;
 	JDBType type;
-	gboolean ret;
 	JDBTypeValue val;
 
 	g_return_val_if_fail(entry != NULL, FALSE);
-	g_return_val_if_fail(name != NULL, FALSE);
 	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
 
-	if (G_UNLIKELY(!j_db_schema_get_field(entry->schema, name, &type, error)))
+	field_table = j_db_schema_get_field_table(entry->schema, error);
+
+	if (G_UNLIKELY(field_table == NULL))
 	{
 		goto _error;
 	}
 
-	if (G_UNLIKELY(!j_bson_has_field(&entry->bson, name, &ret, error)))
+	if (G_UNLIKELY(index >= field_table->count))
 	{
+		g_set_error_literal(error, J_DB_ERROR, J_DB_ERROR_VARIABLE_NOT_FOUND, "variable not found");
 		goto _error;
 	}
 
-	if (G_UNLIKELY(ret))
+	if (entry->fields_set->len < field_table->count)
+	{
+		g_array_set_size(entry->fields_set, field_table->count);
+	}
+
+	if (G_UNLIKELY(g_array_index(entry->fields_set, guint8, index)))
 	{
 		g_set_error_literal(error, J_DB_ERROR, J_DB_ERROR_VARIABLE_ALREADY_SET, "variable value must not be set more than once");
 		goto _error;
 	}
 
+	type = field_table->types[index];
+
 	switch (type)
 	{
 		case J_DB_TYPE_SINT32:
@@ -160,11 +193,13 @@ j_db_entry_set_field(JDBEntry* entry, gchar const* name, gconstpointer value, gu
 			g_assert_not_reached();
 	}
 
-	if (G_UNLIKELY(!j_bson_append_value(&entry->bson, name, type, &val, error)))
+	if (G_UNLIKELY(!j_bson_append_value(&entry->bson, field_table->names[index], type, &val, error)))
 	{
 		goto _error;
 	}
 
+	g_array_index(entry->fields_set, guint8, index) = TRUE;
+
 	return TRUE;
 
 _error:
@@ -196,17 +231,14 @@ j_db_entry_update(JDBEntry* entry, JDBSelector* selector, JBatch* batch, GError*
 {
 	J_TRACE_FUNCTION(NULL);
 
-	bson_t* bson;
-
 	g_return_val_if_fail(entry != NULL, FALSE);
 	g_return_val_if_fail(batch != NULL, FALSE);
 	g_return_val_if_fail(selector != NULL, FALSE);
 	g_return_val_if_fail(selector->schema == entry->schema, FALSE);
 	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
 
-	bson = j_db_selector_get_bson(selector);
-
-	if (G_UNLIKELY(!bson))
+	// Options like the projection do not select anything on their own
+	if (G_UNLIKELY(selector->bson_count == 0))
 	{
 		g_set_error_literal(error, J_DB_ERROR, J_DB_ERROR_SELECTOR_EMPTY, "selector must not be empty");
 		goto _error;
@@ -34,21 +34,549 @@
 #include <julea.h>
 #include "../../backend/db/jbson.c"
 
+GQuark
+j_db_error_quark(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	return g_quark_from_static_string("j-db-error-quark");
+}
+
+/**
+ * The messages of one DB server.
+ **/
+struct JDBServerMessage
+{
+	guint32 index;
+	JMessage* message;
+	JMessage* reply;
+};
+
+typedef struct JDBServerMessage JDBServerMessage;
+
+/**
+ * The number of entries requested per page when iterating over query results.
+ **/
+#define J_DB_PAGE_SIZE 500
+
+/**
+ * A paged query on one DB server.
+ **/
+struct JDBPagedQuery
+{
+	/**
+	 * The request for the next page.
+	 * Its index is the query's server.
+	 **/
+	JDBServerMessage request;
+
+	/**
+	 * The background operation sending the request, NULL if no page has been requested.
+	 **/
+	JBackgroundOperation* prefetch;
+
+	/**
+	 * Whether the query has been sent to its server.
+	 **/
+	gboolean opened;
+
+	/**
+	 * The server's cursor and whether it has more pages.
+	 **/
+	guint64 cursor;
+	gboolean more;
+
+	/**
+	 * The connection the query was opened on, NULL if it has no open cursor.
+	 * Cursors can only be used by the connection they were opened on, so it is kept until the cursor is done.
+	 **/
+	GSocketConnection* connection;
+
+	/**
+	 * The current page if it was sent as BSON, zeroed otherwise.
+	 **/
+	bson_t bson;
+	bson_iter_t iter;
+	gboolean initialized;
+
+	/**
+	 * The current page if it was sent as a row block, NULL otherwise.
+	 **/
+	JRowBlock* row_block;
+
+	/**
+	 * The index of the next row within #row_block.
+	 **/
+	guint32 row;
+
+	/**
+	 * The query's next entry when merging sorted results, NULL if there are no more entries.
+	 **/
+	bson_t* entry;
+};
+
+typedef struct JDBPagedQuery JDBPagedQuery;
+
+/**
+ * A field that merged results are sorted by.
+ **/
+struct JDBOrderField
+{
+	gchar* name;
+	JDBType type;
+	gboolean descending;
+};
+
+typedef struct JDBOrderField JDBOrderField;
+
+/**
+ * An aggregate whose results of multiple DB servers are combined.
+ **/
+struct JDBAggregate
+{
+	gchar* name;
+
+	/**
+	 * The name of the count an average is computed from, NULL for other functions.
+	 **/
+	gchar* count_name;
+
+	JDBSelectorAggregate function;
+	JDBType type;
+};
+
+typedef struct JDBAggregate JDBAggregate;
+
+/**
+ * The combined value of an aggregate within one group.
+ * Sums are stored in the member matching the aggregate's type, counts in #uint64.
+ * An average is computed from #float64 and #uint64.
+ **/
+struct JDBAggregateValue
+{
+	gboolean set;
+	gint64 sint64;
+	guint64 uint64;
+	gdouble float64;
+	bson_value_t extreme;
+};
+
+typedef struct JDBAggregateValue JDBAggregateValue;
+
+/**
+ * A group whose aggregates are combined.
+ **/
+struct JDBAggregateGroup
+{
+	/**
+	 * The group's fields, also used as the group's key.
+	 **/
+	bson_t* fields;
+
+	JDBAggregateValue* values;
+	guint value_count;
+};
+
+typedef struct JDBAggregateGroup JDBAggregateGroup;
+
 struct JDBIteratorHelper
 {
 	bson_t bson;
 	bson_iter_t iter;
 	gboolean initialized;
+
+	/**
+	 * Whether the results are fetched page by page from the DB servers.
+	 **/
+	gboolean paged;
+
+	/**
+	 * The queries on the DB servers.
+	 * There is one query per server unless the selector requires a certain entry ID.
+	 **/
+	JDBPagedQuery* queries;
+	guint32 query_count;
+
+	/**
+	 * The query whose results are returned next if the results are not merged.
+	 **/
+	guint32 current;
+
+	/**
+	 * The selector sent to the servers, NULL if it is the iterator's selector.
+	 **/
+	bson_t* selector;
+
+	/**
+	 * The sort order if the sorted results of all queries are merged, NULL otherwise.
+	 **/
+	GArray* order;
+
+	/**
+	 * The number of results still to skip and to return if the results of multiple queries are limited.
+	 **/
+	guint64 offset;
+	guint64 limit;
+	gboolean limit_set;
+
+	/**
+	 * The combined results if the aggregates of multiple queries are combined, NULL otherwise.
+	 **/
+	GPtrArray* entries;
+
+	/**
+	 * The index of the next entry within #entries.
+	 **/
+	guint entry;
 };
 
 typedef struct JDBIteratorHelper JDBIteratorHelper;
 
-GQuark
-j_db_error_quark(void)
+static gpointer
+j_db_send_background_operation(gpointer data)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	return g_quark_from_static_string("j-db-error-quark");
+	JDBServerMessage* server_message = data;
+	GSocketConnection* db_connection;
+
+	db_connection = j_connection_pool_pop(J_BACKEND_TYPE_DB, server_message->index);
+	j_message_send(server_message->message, db_connection);
+	server_message->reply = j_message_new_reply(server_message->message);
+	j_message_receive(server_message->reply, db_connection);
+	j_connection_pool_push(J_BACKEND_TYPE_DB, server_message->index, db_connection);
+
+	return data;
+}
+
+/**
+ * Sends a paged query's request and receives its reply.
+ * The connection is kept for the following requests.
+ *
+ * \private
+ *
+ * \param data A paged query.
+ *
+ * \return The paged query.
+ **/
+static gpointer
+j_db_page_send_background_operation(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBPagedQuery* query = data;
+
+	if (query->connection == NULL)
+	{
+		query->connection = j_connection_pool_pop(J_BACKEND_TYPE_DB, query->request.index);
+	}
+
+	j_message_send(query->request.message, query->connection);
+	query->request.reply = j_message_new_reply(query->request.message);
+	j_message_receive(query->request.reply, query->connection);
+
+	return data;
+}
+
+/**
+ * Returns the server an insert is routed to.
+ * Entries are distributed by the hash of their shard key or round-robin if the schema has none.
+ *
+ * \private
+ *
+ * \param entry        The entry to insert.
+ * \param server_count The number of DB servers.
+ *
+ * \return The server index.
+ **/
+static guint32
+j_db_internal_insert_route(JDBEntry* entry, guint32 server_count)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	static gint counter = 0;
+	bson_iter_t iter;
+
+	if (server_count == 1)
+	{
+		return 0;
+	}
+
+	if (entry->schema->shard_key != NULL && bson_iter_init_find(&iter, &entry->bson, entry->schema->shard_key))
+	{
+		guint8 const* value = NULL;
+		guint32 len = 0;
+		guint32 hash = 5381;
+
+		switch (bson_iter_type(&iter))
+		{
+			case BSON_TYPE_UTF8:
+				value = (guint8 const*)bson_iter_utf8(&iter, &len);
+				break;
+			case BSON_TYPE_BINARY:
+				bson_iter_binary(&iter, NULL, &len, &value);
+				break;
+			case BSON_TYPE_INT32:
+				value = (guint8 const*)&(bson_iter_value(&iter)->value.v_int32);
+				len = sizeof(gint32);
+				break;
+			case BSON_TYPE_INT64:
+				value = (guint8 const*)&(bson_iter_value(&iter)->value.v_int64);
+				len = sizeof(gint64);
+				break;
+			case BSON_TYPE_DOUBLE:
+				value = (guint8 const*)&(bson_iter_value(&iter)->value.v_double);
+				len = sizeof(gdouble);
+				break;
+			default:
+				// NULL values all end up on the same server
+				break;
+		}
+
+		for (guint32 i = 0; i < len; i++)
+		{
+			hash = (hash << 5) + hash + value[i];
+		}
+
+		return hash % server_count;
+	}
+
+	return (guint32)g_atomic_int_add(&counter, 1) % server_count;
+}
+
+/**
+ * Returns the server that stores the entries matched by a selector.
+ * Entry IDs are assigned from per-server ranges, so selectors requiring a certain ID only have to be sent to one server.
+ *
+ * \private
+ *
+ * \param selector     The selector, may be NULL.
+ * \param server_count The number of DB servers.
+ *
+ * \return The server index or server_count if the entries may be stored on any server.
+ **/
+static guint32
+j_db_internal_selector_route(bson_t const* selector, guint32 server_count)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	bson_iter_t iter;
+	guint32 mode = J_DB_SELECTOR_MODE_AND;
+	guint32 conditions = 0;
+	guint32 route = server_count;
+
+	if (selector == NULL || server_count == 1 || !bson_iter_init(&iter, selector))
+	{
+		return server_count;
+	}
+
+	while (bson_iter_next(&iter))
+	{
+		bson_iter_t child;
+		gboolean is_id = FALSE;
+		gboolean is_equal = FALSE;
+		gboolean has_value = FALSE;
+		guint32 id = 0;
+
+		if (g_strcmp0(bson_iter_key(&iter), "_mode") == 0)
+		{
+			mode = bson_iter_as_int64(&iter);
+			continue;
+		}
+
+		// Skip options like "_order", only the conditions are numbered
+		if (bson_iter_key(&iter)[0] == '_' || !BSON_ITER_HOLDS_DOCUMENT(&iter))
+		{
+			continue;
+		}
+
+		conditions++;
+
+		if (!bson_iter_recurse(&iter, &child))
+		{
+			continue;
+		}
+
+		while (bson_iter_next(&child))
+		{
+			gchar const* key = bson_iter_key(&child);
+
+			if (g_strcmp0(key, "_name") == 0)
+			{
+				is_id = (BSON_ITER_HOLDS_UTF8(&child) && g_strcmp0(bson_iter_utf8(&child, NULL), "_id") == 0);
+			}
+			else if (g_strcmp0(key, "_operator") == 0)
+			{
+				is_equal = (bson_iter_as_int64(&child) == J_DB_SELECTOR_OPERATOR_EQ);
+			}
+			else if (g_strcmp0(key, "_value") == 0 && (BSON_ITER_HOLDS_INT32(&child) || BSON_ITER_HOLDS_INT64(&child)))
+			{
+				id = bson_iter_as_int64(&child);
+				has_value = TRUE;
+			}
+		}
+
+		if (is_id && is_equal && has_value && route == server_count)
+		{
+			route = j_backend_db_id_server(id, server_count);
+		}
+	}
+
+	// A condition on the ID only restricts the result if all conditions have to match
+	if (mode != J_DB_SELECTOR_MODE_AND && conditions > 1)
+	{
+		return server_count;
+	}
+
+	return route;
+}
+
+/**
+ * Parses an operation's reply from one of the servers it has been sent to.
+ * Query results are appended to the ones of the previous servers.
+ *
+ * \private
+ *
+ * \param reply The reply.
+ * \param data  The operation.
+ * \param type  The message type.
+ * \param error Returns the server's error.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+j_db_internal_merge_from_message(JMessage* reply, JBackendOperation* data, JMessageType type, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBackendOperationParam out_param[G_N_ELEMENTS(data->out_param)];
+	bson_t result[1];
+	gboolean ret;
+
+	memcpy(out_param, data->out_param, sizeof(JBackendOperationParam) * data->out_param_count);
+	out_param[data->out_param_count - 1].ptr = error;
+
+	if (type == J_MESSAGE_DB_QUERY)
+	{
+		memset(result, 0, sizeof(bson_t));
+		out_param[0].ptr = result;
+	}
+
+	ret = j_backend_operation_from_message(reply, out_param, data->out_param_count);
+
+	if (type == J_MESSAGE_DB_QUERY && out_param[0].len > 0)
+	{
+		bson_t* results = data->out_param[0].ptr;
+
+		if (data->out_param[0].len == 0)
+		{
+			bson_copy_to(result, results);
+			data->out_param[0].len = out_param[0].len;
+		}
+		else
+		{
+			bson_iter_t iter;
+			guint32 count;
+
+			count = bson_count_keys(results);
+			bson_iter_init(&iter, result);
+
+			// Renumber the documents so that they follow the ones of the previous servers
+			while (bson_iter_next(&iter))
+			{
+				bson_t document[1];
+				char key_buf[16];
+				const char* key;
+				guint8 const* document_data;
+				guint32 document_len;
+
+				bson_iter_document(&iter, &document_len, &document_data);
+				bson_init_static(document, document_data, document_len);
+				bson_uint32_to_string(count++, &key, key_buf, sizeof(key_buf));
+				bson_append_document(results, key, -1, document);
+			}
+		}
+
+		bson_destroy(result);
+	}
+
+	return ret;
+}
+
+/**
+ * Parses an operation's replies from all servers.
+ * The first error of any server is reported.
+ * Updates and deletes usually only match entries on some of the servers, they only fail with J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS if no server has a matching entry.
+ *
+ * \private
+ *
+ * \param server_messages The servers' messages.
+ * \param server_count    The number of servers.
+ * \param data            The operation.
+ * \param type            The message type.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+j_db_internal_merge_from_messages(JDBServerMessage* server_messages, guint32 server_count, JBackendOperation* data, JMessageType type)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GError** real_error = data->out_param[data->out_param_count - 1].ptr;
+	GError* merged_error = NULL;
+	guint32 no_match = 0;
+	gboolean ret = TRUE;
+
+	for (guint32 i = 0; i < server_count; i++)
+	{
+		GError* server_error = NULL;
+
+		if (!j_db_internal_merge_from_message(server_messages[i].reply, data, type, &server_error) && server_error == NULL)
+		{
+			ret = FALSE;
+		}
+
+		if (server_error == NULL)
+		{
+			continue;
+		}
+
+		if ((type == J_MESSAGE_DB_UPDATE || type == J_MESSAGE_DB_DELETE) && g_error_matches(server_error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS))
+		{
+			no_match++;
+
+			if (no_match < server_count)
+			{
+				g_error_free(server_error);
+				continue;
+			}
+		}
+
+		if (merged_error == NULL)
+		{
+			merged_error = server_error;
+		}
+		else
+		{
+			g_error_free(server_error);
+		}
+	}
+
+	if (merged_error != NULL)
+	{
+		ret = FALSE;
+
+		if (real_error != NULL && *real_error == NULL)
+		{
+			*real_error = merged_error;
+		}
+		else
+		{
+			g_error_free(merged_error);
+		}
+	}
+
+	return ret;
 }
 
 static gboolean
@@ -58,23 +586,53 @@ j_backend_db_func_exec(JList* operations, JSemantics* semantics, JMessageType ty
 
 	JBackendOperation* data = NULL;
 	gboolean ret = TRUE;
-	GSocketConnection* db_connection;
 	g_autoptr(JListIterator) iter_send = NULL;
 	g_autoptr(JListIterator) iter_recieve = NULL;
-	g_autoptr(JMessage) message = NULL;
-	g_autoptr(JMessage) reply = NULL;
+	g_autofree JDBServerMessage* server_messages = NULL;
+	g_autofree gpointer* background_data = NULL;
+	g_autofree guint32* routes = NULL;
 	JBackend* db_backend = j_db_get_backend();
 	gpointer batch = NULL;
 	GError* error = NULL;
+	guint32 server_count = 0;
+	gboolean broadcast = FALSE;
+	gboolean selector = FALSE;
 
 	if (db_backend == NULL)
 	{
-		message = j_message_new(type, 0);
+		server_count = j_configuration_get_server_count(j_configuration(), J_BACKEND_TYPE_DB);
+		server_messages = g_new0(JDBServerMessage, server_count);
+		background_data = g_new0(gpointer, server_count);
+		routes = g_new(guint32, j_list_length(operations));
+
+		for (guint32 i = 0; i < server_count; i++)
+		{
+			server_messages[i].index = i;
+		}
+
+		// Tables exist on all servers, their entries are distributed among them
+		switch (type)
+		{
+			case J_MESSAGE_DB_UPDATE:
+			case J_MESSAGE_DB_DELETE:
+			case J_MESSAGE_DB_QUERY:
+				selector = TRUE;
+				// fallthrough
+			case J_MESSAGE_DB_SCHEMA_CREATE:
+			case J_MESSAGE_DB_SCHEMA_DELETE:
+			case J_MESSAGE_DB_INDEX_CREATE:
+			case J_MESSAGE_DB_INDEX_DELETE:
+				broadcast = TRUE;
+				break;
+			default:
+				broadcast = FALSE;
+				break;
+		}
 	}
 
 	iter_send = j_list_iterator_new(operations);
 
-	while (j_list_iterator_next(iter_send))
+	for (guint i = 0; j_list_iterator_next(iter_send); i++)
 	{
 		data = j_list_iterator_get(iter_send);
 
@@ -96,7 +654,45 @@ j_backend_db_func_exec(JList* operations, JSemantics* semantics, JMessageType ty
 		}
 		else
 		{
-			ret = j_backend_operation_to_message(message, data->in_param, data->in_param_count) && ret;
+			guint32 first = 0;
+			guint32 last = 0;
+
+			if (broadcast)
+			{
+				last = server_count - 1;
+				routes[i] = server_count;
+
+				// Operations on a certain entry only have to be sent to the server storing it
+				if (selector && (routes[i] = j_db_internal_selector_route(data->in_param[2].ptr_const, server_count)) < server_count)
+				{
+					first = last = routes[i];
+				}
+			}
+			else
+			{
+				if (type == J_MESSAGE_DB_INSERT)
+				{
+					// The operation holds a reference to the entry being inserted
+					first = last = j_db_internal_insert_route(data->unref_values[0], server_count);
+				}
+
+				routes[i] = first;
+			}
+
+			for (guint32 j = first; j <= last; j++)
+			{
+				JBackendOperationParam in_param[G_N_ELEMENTS(data->in_param)];
+
+				if (server_messages[j].message == NULL)
+				{
+					server_messages[j].message = j_message_new(type, 0);
+					background_data[j] = &(server_messages[j]);
+				}
+
+				// Serializing resets the parameters, use a copy for every server
+				memcpy(in_param, data->in_param, sizeof(JBackendOperationParam) * data->in_param_count);
+				ret = j_backend_operation_to_message(server_messages[j].message, in_param, data->in_param_count) && ret;
+			}
 		}
 	}
 
@@ -116,19 +712,37 @@ j_backend_db_func_exec(JList* operations, JSemantics* semantics, JMessageType ty
 	}
 	else
 	{
-		db_connection = j_connection_pool_pop(J_BACKEND_TYPE_DB, 0);
-		j_message_send(message, db_connection);
-		reply = j_message_new_reply(message);
-		j_message_receive(reply, db_connection);
+		j_helper_execute_parallel(j_db_send_background_operation, background_data, server_count);
+
 		iter_recieve = j_list_iterator_new(operations);
 
-		while (j_list_iterator_next(iter_recieve))
+		for (guint i = 0; j_list_iterator_next(iter_recieve); i++)
 		{
 			data = j_list_iterator_get(iter_recieve);
-			ret = j_backend_operation_from_message(reply, data->out_param, data->out_param_count) && ret;
+
+			// Operations sent to all servers are routed to server_count
+			if (routes[i] == server_count)
+			{
+				ret = j_db_internal_merge_from_messages(server_messages, server_count, data, type) && ret;
+			}
+			else
+			{
+				ret = j_backend_operation_from_message(server_messages[routes[i]].reply, data->out_param, data->out_param_count) && ret;
+			}
 		}
 
-		j_connection_pool_push(J_BACKEND_TYPE_DB, 0, db_connection);
+		for (guint32 i = 0; i < server_count; i++)
+		{
+			if (server_messages[i].reply != NULL)
+			{
+				j_message_unref(server_messages[i].reply);
+			}
+
+			if (server_messages[i].message != NULL)
+			{
+				j_message_unref(server_messages[i].message);
+			}
+		}
 	}
 
 	return ret;
@@ -274,6 +888,90 @@ j_db_internal_schema_delete(JDBSchema* j_db_schema, JBatch* batch, GError** erro
 	return TRUE;
 }
 
+static gboolean
+j_db_index_create_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	return j_backend_db_func_exec(operations, semantics, J_MESSAGE_DB_INDEX_CREATE);
+}
+
+gboolean
+j_db_internal_index_create(JDBSchema* j_db_schema, bson_t* index, JBatch* batch, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JOperation* op;
+	JBackendOperation* data;
+
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	data = g_slice_new(JBackendOperation);
+	memcpy(data, &j_backend_operation_db_index_create, sizeof(JBackendOperation));
+	data->in_param[0].ptr_const = j_db_schema->namespace;
+	data->in_param[1].ptr_const = j_db_schema->name;
+	data->in_param[2].ptr_const = index;
+	data->out_param[0].ptr_const = error;
+
+	data->unref_func_count = 2;
+	data->unref_funcs[0] = (GDestroyNotify)j_db_schema_unref;
+	data->unref_values[0] = j_db_schema_ref(j_db_schema);
+	data->unref_funcs[1] = (GDestroyNotify)bson_destroy;
+	data->unref_values[1] = index;
+
+	op = j_operation_new();
+	op->key = j_db_schema->namespace;
+	op->data = data;
+	op->exec_func = j_db_index_create_exec;
+	op->free_func = j_backend_db_func_free;
+
+	j_batch_add(batch, op);
+
+	return TRUE;
+}
+
+static gboolean
+j_db_index_delete_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	return j_backend_db_func_exec(operations, semantics, J_MESSAGE_DB_INDEX_DELETE);
+}
+
+gboolean
+j_db_internal_index_delete(JDBSchema* j_db_schema, bson_t* index, JBatch* batch, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JOperation* op;
+	JBackendOperation* data;
+
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	data = g_slice_new(JBackendOperation);
+	memcpy(data, &j_backend_operation_db_index_delete, sizeof(JBackendOperation));
+	data->in_param[0].ptr_const = j_db_schema->namespace;
+	data->in_param[1].ptr_const = j_db_schema->name;
+	data->in_param[2].ptr_const = index;
+	data->out_param[0].ptr_const = error;
+
+	data->unref_func_count = 2;
+	data->unref_funcs[0] = (GDestroyNotify)j_db_schema_unref;
+	data->unref_values[0] = j_db_schema_ref(j_db_schema);
+	data->unref_funcs[1] = (GDestroyNotify)bson_destroy;
+	data->unref_values[1] = index;
+
+	op = j_operation_new();
+	op->key = j_db_schema->namespace;
+	op->data = data;
+	op->exec_func = j_db_index_delete_exec;
+	op->free_func = j_backend_db_func_free;
+
+	j_batch_add(batch, op);
+
+	return TRUE;
+}
+
 static gboolean
 j_db_insert_exec(JList* operations, JSemantics* semantics)
 {
@@ -421,6 +1119,7 @@ j_db_internal_query(JDBSchema* j_db_schema, JDBSelector* j_db_selector, JDBItera
 
 	helper = j_helper_alloc_aligned(128, sizeof(JDBIteratorHelper));
 	helper->initialized = FALSE;
+	helper->paged = FALSE;
 	memset(&helper->bson, 0, sizeof(bson_t));
 	j_db_iterator->iterator = helper;
 
@@ -451,71 +1150,1628 @@ j_db_internal_query(JDBSchema* j_db_schema, JDBSelector* j_db_selector, JDBItera
 	return TRUE;
 }
 
-gboolean
-j_db_internal_iterate(JDBIterator* j_db_iterator, GError** error)
+/**
+ * Requests the next page of a paged query in the background.
+ * Opens the query on its server if it has not been sent yet.
+ *
+ * \private
+ *
+ * \param j_db_iterator An iterator.
+ * \param query         A paged query.
+ *
+ * \return TRUE if a page has been requested, FALSE if there are no more pages.
+ **/
+static gboolean
+j_db_internal_page_request(JDBIterator* j_db_iterator, JDBPagedQuery* query)
 {
 	J_TRACE_FUNCTION(NULL);
 
 	JDBIteratorHelper* helper = j_db_iterator->iterator;
-	gboolean has_next;
-	bson_t zerobson;
-
-	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+	JMessage* message;
+	guint32 page_size = J_DB_PAGE_SIZE;
 
-	memset(&zerobson, 0, sizeof(bson_t));
+	g_return_val_if_fail(query->prefetch == NULL, FALSE);
 
-	if (!helper->initialized)
+	if (query->more)
 	{
-		if (G_UNLIKELY(!memcmp(&helper->bson, &zerobson, sizeof(bson_t))))
+		gchar const* namespace = j_db_iterator->schema->namespace;
+		gsize namespace_len = strlen(namespace) + 1;
+
+		message = j_message_new(J_MESSAGE_DB_QUERY_NEXT, 0);
+		j_message_add_operation(message, 8 + 4 + namespace_len);
+		j_message_append_8(message, &(query->cursor));
+		j_message_append_4(message, &page_size);
+		j_message_append_string(message, namespace);
+	}
+	else
+	{
+		JBackendOperationParam in_param[G_N_ELEMENTS(j_backend_operation_db_query.in_param)];
+
+		if (query->opened)
 		{
-			g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_INVALID, "iterator invalid");
-			goto error2;
+			return FALSE;
 		}
 
-		if (G_UNLIKELY(!j_bson_iter_init(&helper->iter, &helper->bson, error)))
+		query->opened = TRUE;
+
+		message = j_message_new(J_MESSAGE_DB_QUERY_OPEN, 0);
+		j_message_add_operation(message, 4);
+		j_message_append_4(message, &page_size);
+
+		memcpy(in_param, j_backend_operation_db_query.in_param, sizeof(in_param));
+		in_param[0].ptr_const = j_db_iterator->schema->namespace;
+		in_param[1].ptr_const = j_db_iterator->schema->name;
+		in_param[2].ptr_const = (helper->selector != NULL) ? helper->selector : j_db_selector_get_bson(j_db_iterator->selector);
+		j_backend_operation_to_message(message, in_param, j_backend_operation_db_query.in_param_count);
+	}
+
+	query->request.message = message;
+	query->request.reply = NULL;
+	query->prefetch = j_background_operation_new(j_db_page_send_background_operation, query);
+
+	return TRUE;
+}
+
+/**
+ * Waits for the requested page and makes it the query's current one.
+ *
+ * \private
+ *
+ * \param query A paged query.
+ * \param error A GError.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+j_db_internal_page_receive(JDBPagedQuery* query, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBackendOperationParam out_param[G_N_ELEMENTS(j_backend_operation_db_query.out_param)];
+	guint32 block_length;
+	gboolean ret = TRUE;
+
+	g_return_val_if_fail(query->prefetch != NULL, FALSE);
+
+	j_background_operation_wait(query->prefetch);
+	j_background_operation_unref(query->prefetch);
+	query->prefetch = NULL;
+
+	query->cursor = j_message_get_8(query->request.reply);
+	query->more = (j_message_get_4(query->request.reply) != 0);
+	block_length = j_message_get_4(query->request.reply);
+
+	if (!query->more)
+	{
+		j_connection_pool_push(J_BACKEND_TYPE_DB, query->request.index, query->connection);
+		query->connection = NULL;
+	}
+
+	if (block_length > 0)
+	{
+		query->row_block = j_row_block_new(j_message_get_n(query->request.reply, block_length), block_length);
+		query->row = 0;
+
+		if (G_UNLIKELY(query->row_block == NULL))
 		{
-			goto _error;
+			g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_FAILED, "invalid row block");
+			ret = FALSE;
 		}
-
-		helper->initialized = TRUE;
 	}
 
-	if (G_UNLIKELY(!j_bson_iter_next(&helper->iter, &has_next, error)))
+	memcpy(out_param, j_backend_operation_db_query.out_param, sizeof(out_param));
+	out_param[0].ptr = &(query->bson);
+	out_param[1].ptr = error;
+
+	memset(&(query->bson), 0, sizeof(bson_t));
+	query->initialized = FALSE;
+
+	// The BSON page is empty if the page was sent as a row block
+	ret = j_backend_operation_from_message(query->request.reply, out_param, j_backend_operation_db_query.out_param_count) && ret;
+
+	g_clear_pointer(&(query->request.reply), j_message_unref);
+	g_clear_pointer(&(query->request.message), j_message_unref);
+
+	return ret;
+}
+
+/**
+ * Waits for the requested page and requests the following one while the caller processes it.
+ * Once a query has no more pages, the next query is opened unless this has already happened.
+ *
+ * \private
+ *
+ * \param j_db_iterator An iterator.
+ * \param query         A paged query.
+ * \param error         A GError.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+j_db_internal_page_fetch(JDBIterator* j_db_iterator, JDBPagedQuery* query, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBIteratorHelper* helper = j_db_iterator->iterator;
+
+	if (G_UNLIKELY(!j_db_internal_page_receive(query, error)))
 	{
-		goto _error;
+		return FALSE;
 	}
 
-	if (G_UNLIKELY(!has_next))
+	if (!j_db_internal_page_request(j_db_iterator, query) && query + 1 < helper->queries + helper->query_count && !(query + 1)->opened)
 	{
-		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS, "no more elements");
-		goto _error;
+		j_db_internal_page_request(j_db_iterator, query + 1);
 	}
 
-	if (G_UNLIKELY(!j_bson_iter_copy_document(&helper->iter, &j_db_iterator->bson, error)))
+	return TRUE;
+}
+
+/**
+ * Moves to the next row of a paged query, fetching the next page if necessary.
+ * The row is either the row block's next row or the BSON page's current document.
+ *
+ * \private
+ *
+ * \param j_db_iterator An iterator.
+ * \param query         A paged query.
+ * \param has_next      A pointer that receives whether there is another row.
+ * \param error         A GError.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+j_db_internal_page_next(JDBIterator* j_db_iterator, JDBPagedQuery* query, gboolean* has_next, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	bson_t zerobson;
+
+	memset(&zerobson, 0, sizeof(bson_t));
+	*has_next = FALSE;
+
+	while (TRUE)
 	{
-		goto _error;
+		if (query->row_block != NULL)
+		{
+			if (query->row < j_row_block_get_row_count(query->row_block))
+			{
+				*has_next = TRUE;
+				break;
+			}
+
+			if (j_db_iterator->row_block == query->row_block)
+			{
+				j_db_iterator->row_block = NULL;
+			}
+
+			g_clear_pointer(&(query->row_block), j_row_block_free);
+		}
+
+		if (memcmp(&query->bson, &zerobson, sizeof(bson_t)))
+		{
+			if (!query->initialized)
+			{
+				if (G_UNLIKELY(!j_bson_iter_init(&query->iter, &query->bson, error)))
+				{
+					goto _error;
+				}
+
+				query->initialized = TRUE;
+			}
+
+			if (G_UNLIKELY(!j_bson_iter_next(&query->iter, has_next, error)))
+			{
+				goto _error;
+			}
+
+			if (*has_next)
+			{
+				break;
+			}
+
+			j_bson_destroy(&query->bson);
+			memset(&query->bson, 0, sizeof(bson_t));
+		}
+
+		if (query->prefetch == NULL)
+		{
+			break;
+		}
+
+		if (G_UNLIKELY(!j_db_internal_page_fetch(j_db_iterator, query, error)))
+		{
+			goto _error;
+		}
 	}
 
 	return TRUE;
 
 _error:
-	j_bson_destroy(&helper->bson);
+	return FALSE;
+}
 
-error2:
-	g_free(helper);
+/**
+ * Releases the server-side resources of a paged query.
+ *
+ * \private
+ *
+ * \param query A paged query.
+ **/
+static void
+j_db_internal_page_close(JDBPagedQuery* query)
+{
+	J_TRACE_FUNCTION(NULL);
 
-	return FALSE;
+	bson_t zerobson;
+
+	memset(&zerobson, 0, sizeof(bson_t));
+
+	if (query->prefetch != NULL)
+	{
+		j_background_operation_wait(query->prefetch);
+		j_background_operation_unref(query->prefetch);
+		query->prefetch = NULL;
+
+		// Only the cursor's state is needed, the page itself is discarded
+		query->cursor = j_message_get_8(query->request.reply);
+		query->more = (j_message_get_4(query->request.reply) != 0);
+
+		g_clear_pointer(&(query->request.reply), j_message_unref);
+		g_clear_pointer(&(query->request.message), j_message_unref);
+	}
+
+	if (query->more)
+	{
+		g_autoptr(JMessage) message = NULL;
+
+		message = j_message_new(J_MESSAGE_DB_QUERY_CLOSE, 0);
+		j_message_add_operation(message, 8);
+		j_message_append_8(message, &(query->cursor));
+
+		j_message_send(message, query->connection);
+
+		query->more = FALSE;
+	}
+
+	if (query->connection != NULL)
+	{
+		j_connection_pool_push(J_BACKEND_TYPE_DB, query->request.index, query->connection);
+		query->connection = NULL;
+	}
+
+	g_clear_pointer(&(query->row_block), j_row_block_free);
+	g_clear_pointer(&(query->entry), bson_destroy);
+
+	if (memcmp(&query->bson, &zerobson, sizeof(bson_t)))
+	{
+		j_bson_destroy(&query->bson);
+		memset(&query->bson, 0, sizeof(bson_t));
+	}
 }
 
-bson_t*
-j_db_selector_get_bson(JDBSelector* selector)
+/**
+ * Copies the current row of a paged query to a new BSON document and moves to the next one.
+ *
+ * \private
+ *
+ * \param j_db_iterator An iterator.
+ * \param query         A paged query.
+ * \param error         A GError.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+j_db_internal_page_advance(JDBIterator* j_db_iterator, JDBPagedQuery* query, GError** error)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	if (selector && selector->bson_count > 0)
+	gboolean has_next;
+
+	g_clear_pointer(&(query->entry), bson_destroy);
+
+	if (G_UNLIKELY(!j_db_internal_page_next(j_db_iterator, query, &has_next, error)))
 	{
-		return &selector->bson;
+		goto _error;
 	}
 
-	return NULL;
+	if (!has_next)
+	{
+		return TRUE;
+	}
+
+	if (query->row_block != NULL)
+	{
+		query->entry = bson_new();
+
+		for (guint32 i = 0; i < j_row_block_get_column_count(query->row_block); i++)
+		{
+			bson_value_t value;
+
+			if (G_UNLIKELY(!j_row_block_get_value(query->row_block, query->row, i, &value)))
+			{
+				g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_FAILED, "invalid row block");
+				goto _error;
+			}
+
+			bson_append_value(query->entry, j_row_block_get_column_name(query->row_block, i), -1, &value);
+		}
+
+		query->row++;
+	}
+	else
+	{
+		bson_t entry;
+
+		if (G_UNLIKELY(!j_bson_iter_copy_document(&query->iter, &entry, error)))
+		{
+			goto _error;
+		}
+
+		// The entry has to outlive the page
+		query->entry = bson_copy(&entry);
+	}
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
+/**
+ * Compares two values of a field.
+ * Missing and NULL values are sorted first, like the DB backends do.
+ *
+ * \private
+ *
+ * \param a    A value, NULL if it is missing.
+ * \param b    Another value, NULL if it is missing.
+ * \param type The field's type.
+ *
+ * \return A negative value if a is sorted first, a positive value if b is sorted first, 0 otherwise.
+ **/
+static gint
+j_db_internal_compare_values(bson_value_t const* a, bson_value_t const* b, JDBType type)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean a_null = (a == NULL || a->value_type == BSON_TYPE_NULL);
+	gboolean b_null = (b == NULL || b->value_type == BSON_TYPE_NULL);
+
+	if (a_null || b_null)
+	{
+		return b_null - a_null;
+	}
+
+	switch (type)
+	{
+		case J_DB_TYPE_SINT32:
+		case J_DB_TYPE_SINT64:
+		{
+			gint64 a_int = (a->value_type == BSON_TYPE_INT32) ? a->value.v_int32 : a->value.v_int64;
+			gint64 b_int = (b->value_type == BSON_TYPE_INT32) ? b->value.v_int32 : b->value.v_int64;
+
+			return (a_int > b_int) - (a_int < b_int);
+		}
+		case J_DB_TYPE_UINT32:
+		case J_DB_TYPE_UINT64:
+		{
+			// Unsigned values are stored as signed BSON integers of the same size
+			guint64 a_int = (a->value_type == BSON_TYPE_INT32) ? (guint32)a->value.v_int32 : (guint64)a->value.v_int64;
+			guint64 b_int = (b->value_type == BSON_TYPE_INT32) ? (guint32)b->value.v_int32 : (guint64)b->value.v_int64;
+
+			return (a_int > b_int) - (a_int < b_int);
+		}
+		case J_DB_TYPE_FLOAT32:
+		case J_DB_TYPE_FLOAT64:
+			return (a->value.v_double > b->value.v_double) - (a->value.v_double < b->value.v_double);
+		case J_DB_TYPE_STRING:
+			return g_strcmp0(a->value.v_utf8.str, b->value.v_utf8.str);
+		case J_DB_TYPE_BLOB:
+		{
+			guint32 length = MIN(a->value.v_binary.data_len, b->value.v_binary.data_len);
+			gint ret;
+
+			ret = memcmp(a->value.v_binary.data, b->value.v_binary.data, length);
+
+			if (ret != 0)
+			{
+				return ret;
+			}
+
+			return (a->value.v_binary.data_len > b->value.v_binary.data_len) - (a->value.v_binary.data_len < b->value.v_binary.data_len);
+		}
+		case J_DB_TYPE_ID:
+		default:
+			return 0;
+	}
+}
+
+/**
+ * Compares two entries by the iterator's sort order.
+ *
+ * \private
+ *
+ * \param order An array of JDBOrderField.
+ * \param a     An entry.
+ * \param b     Another entry.
+ *
+ * \return A negative value if a is sorted first, a positive value if b is sorted first, 0 otherwise.
+ **/
+static gint
+j_db_internal_compare_entries(GArray* order, bson_t const* a, bson_t const* b)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	for (guint i = 0; i < order->len; i++)
+	{
+		JDBOrderField* field = &g_array_index(order, JDBOrderField, i);
+		bson_iter_t a_iter;
+		bson_iter_t b_iter;
+		gboolean a_found;
+		gboolean b_found;
+		gint ret;
+
+		a_found = bson_iter_init_find(&a_iter, a, field->name);
+		b_found = bson_iter_init_find(&b_iter, b, field->name);
+
+		ret = j_db_internal_compare_values(a_found ? bson_iter_value(&a_iter) : NULL, b_found ? bson_iter_value(&b_iter) : NULL, field->type);
+
+		if (ret != 0)
+		{
+			return field->descending ? -ret : ret;
+		}
+	}
+
+	return 0;
+}
+
+static void
+j_db_internal_order_field_clear(gpointer data)
+{
+	JDBOrderField* field = data;
+
+	g_free(field->name);
+}
+
+/**
+ * Parses the selector's sort order.
+ *
+ * \private
+ *
+ * \param j_db_iterator An iterator.
+ * \param error         A GError.
+ *
+ * \return The sort order as an array of JDBOrderField, NULL on error.
+ **/
+static GArray*
+j_db_internal_order_new(JDBIterator* j_db_iterator, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBSelector* selector = j_db_iterator->selector;
+	GArray* order;
+	bson_iter_t iter;
+
+	order = g_array_new(FALSE, FALSE, sizeof(JDBOrderField));
+	g_array_set_clear_func(order, j_db_internal_order_field_clear);
+
+	if (G_UNLIKELY(!j_bson_iter_init(&iter, &selector->order, error)))
+	{
+		goto _error;
+	}
+
+	while (bson_iter_next(&iter))
+	{
+		JDBOrderField field;
+		bson_iter_t child;
+
+		if (G_UNLIKELY(!bson_iter_recurse(&iter, &child) || !bson_iter_find(&child, "_name")))
+		{
+			g_set_error_literal(error, J_BACKEND_BSON_ERROR, J_BACKEND_BSON_ERROR_ITER_KEY_NOT_FOUND, "bson iter can not find key");
+			goto _error;
+		}
+
+		field.name = g_strdup(bson_iter_utf8(&child, NULL));
+		field.descending = (bson_iter_find(&child, "_order") && bson_iter_int32(&child) == J_DB_SELECTOR_ORDER_DESCENDING);
+
+		// The order has been checked when it was added to the selector
+		if (g_strcmp0(field.name, "_id") == 0)
+		{
+			field.type = J_DB_TYPE_UINT32;
+		}
+		else if (!j_db_selector_get_aggregate_type(selector, field.name, &(field.type)) && G_UNLIKELY(!j_db_schema_get_field(j_db_iterator->schema, field.name, &(field.type), error)))
+		{
+			g_free(field.name);
+			goto _error;
+		}
+
+		g_array_append_val(order, field);
+	}
+
+	return order;
+
+_error:
+	g_array_unref(order);
+
+	return NULL;
+}
+
+/**
+ * Returns the selector sent to each of multiple DB servers if the results are limited.
+ * Each server returns its first offset + limit results, the offset and limit are applied when combining them.
+ *
+ * \private
+ *
+ * \param selector A selector.
+ *
+ * \return A new selector. Should be freed with bson_destroy().
+ **/
+static bson_t*
+j_db_internal_limit_selector(JDBSelector* selector)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	bson_t* bson;
+	guint64 limit = G_MAXINT64;
+
+	if (selector->offset < (guint64)G_MAXINT64 && selector->limit < (guint64)G_MAXINT64 - selector->offset)
+	{
+		limit = selector->offset + selector->limit;
+	}
+
+	bson = bson_new();
+	bson_copy_to_excluding_noinit(j_db_selector_get_bson(selector), bson, "_limit", "_offset", NULL);
+	bson_append_int64(bson, "_limit", -1, limit);
+	bson_append_int64(bson, "_offset", -1, 0);
+
+	return bson;
+}
+
+static void
+j_db_internal_aggregate_clear(gpointer data)
+{
+	JDBAggregate* aggregate = data;
+
+	g_free(aggregate->name);
+	g_free(aggregate->count_name);
+}
+
+/**
+ * Parses the selector's aggregates.
+ * Averages are computed from a sum and a count, the count gets a name that is not used otherwise.
+ *
+ * \private
+ *
+ * \param j_db_iterator An iterator.
+ * \param error         A GError.
+ *
+ * \return The aggregates as an array of JDBAggregate, NULL on error.
+ **/
+static GArray*
+j_db_internal_aggregates_new(JDBIterator* j_db_iterator, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBSelector* selector = j_db_iterator->selector;
+	GArray* aggregates;
+	bson_iter_t iter;
+
+	aggregates = g_array_new(FALSE, FALSE, sizeof(JDBAggregate));
+	g_array_set_clear_func(aggregates, j_db_internal_aggregate_clear);
+
+	if (selector->aggregate_count == 0)
+	{
+		return aggregates;
+	}
+
+	if (G_UNLIKELY(!j_bson_iter_init(&iter, &selector->aggregate, error)))
+	{
+		goto _error;
+	}
+
+	while (bson_iter_next(&iter))
+	{
+		JDBAggregate aggregate;
+		bson_iter_t child;
+
+		if (G_UNLIKELY(!bson_iter_recurse(&iter, &child)))
+		{
+			g_set_error_literal(error, J_BACKEND_BSON_ERROR, J_BACKEND_BSON_ERROR_ITER_INVALID_TYPE, "bson iter invalid type");
+			goto _error;
+		}
+
+		memset(&aggregate, 0, sizeof(JDBAggregate));
+
+		while (bson_iter_next(&child))
+		{
+			if (g_strcmp0(bson_iter_key(&child), "_name") == 0)
+			{
+				aggregate.name = g_strdup(bson_iter_utf8(&child, NULL));
+			}
+			else if (g_strcmp0(bson_iter_key(&child), "_function") == 0)
+			{
+				aggregate.function = bson_iter_int32(&child);
+			}
+			else if (g_strcmp0(bson_iter_key(&child), "_type") == 0)
+			{
+				aggregate.type = bson_iter_int32(&child);
+			}
+		}
+
+		if (G_UNLIKELY(aggregate.name == NULL))
+		{
+			g_set_error_literal(error, J_BACKEND_BSON_ERROR, J_BACKEND_BSON_ERROR_ITER_KEY_NOT_FOUND, "bson iter can not find key");
+			goto _error;
+		}
+
+		if (aggregate.function == J_DB_SELECTOR_AGGREGATE_AVG)
+		{
+			JDBType type;
+			gboolean used = TRUE;
+
+			aggregate.count_name = g_strdup_printf("%s_count", aggregate.name);
+
+			while (used)
+			{
+				used = j_db_selector_get_aggregate_type(selector, aggregate.count_name, &type) || j_db_schema_get_field(j_db_iterator->schema, aggregate.count_name, &type, NULL);
+
+				for (guint i = 0; !used && i < aggregates->len; i++)
+				{
+					used = (g_strcmp0(g_array_index(aggregates, JDBAggregate, i).count_name, aggregate.count_name) == 0);
+				}
+
+				if (used)
+				{
+					gchar* count_name;
+
+					count_name = g_strconcat(aggregate.count_name, "_", NULL);
+					g_free(aggregate.count_name);
+					aggregate.count_name = count_name;
+				}
+			}
+		}
+
+		g_array_append_val(aggregates, aggregate);
+	}
+
+	return aggregates;
+
+_error:
+	g_array_unref(aggregates);
+
+	return NULL;
+}
+
+/**
+ * Returns the selector sent to each of multiple DB servers if the results are aggregated.
+ * Averages are replaced by a sum and a count, sort order, offset and limit are applied after combining the results.
+ *
+ * \private
+ *
+ * \param selector   A selector.
+ * \param aggregates The selector's aggregates.
+ *
+ * \return A new selector. Should be freed with bson_destroy().
+ **/
+static bson_t*
+j_db_internal_aggregate_selector(JDBSelector* selector, GArray* aggregates)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	bson_t* bson;
+	bson_t bson_aggregates;
+	bson_iter_t iter;
+	guint count = 0;
+
+	bson = bson_new();
+	bson_copy_to_excluding_noinit(j_db_selector_get_bson(selector), bson, "_order", "_aggregate", "_limit", "_offset", NULL);
+
+	if (aggregates->len == 0)
+	{
+		return bson;
+	}
+
+	bson_append_document_begin(bson, "_aggregate", -1, &bson_aggregates);
+	bson_iter_init(&iter, &selector->aggregate);
+
+	for (guint i = 0; i < aggregates->len && bson_iter_next(&iter); i++)
+	{
+		JDBAggregate* aggregate = &g_array_index(aggregates, JDBAggregate, i);
+		bson_t bson_aggregate;
+		bson_iter_t child;
+		char buf[20];
+
+		if (aggregate->function != J_DB_SELECTOR_AGGREGATE_AVG)
+		{
+			bson_t document;
+			uint8_t const* data;
+			uint32_t length;
+
+			bson_iter_document(&iter, &length, &data);
+			bson_init_static(&document, data, length);
+
+			snprintf(buf, sizeof(buf), "%u", count++);
+			bson_append_document(&bson_aggregates, buf, -1, &document);
+
+			continue;
+		}
+
+		// An average's field is required
+		bson_iter_recurse(&iter, &child);
+		bson_iter_find(&child, "_field");
+
+		snprintf(buf, sizeof(buf), "%u", count++);
+		bson_append_document_begin(&bson_aggregates, buf, -1, &bson_aggregate);
+		bson_append_utf8(&bson_aggregate, "_name", -1, aggregate->name, -1);
+		bson_append_int32(&bson_aggregate, "_function", -1, J_DB_SELECTOR_AGGREGATE_SUM);
+		bson_append_utf8(&bson_aggregate, "_field", -1, bson_iter_utf8(&child, NULL), -1);
+		bson_append_int32(&bson_aggregate, "_type", -1, J_DB_TYPE_FLOAT64);
+		bson_append_document_end(&bson_aggregates, &bson_aggregate);
+
+		snprintf(buf, sizeof(buf), "%u", count++);
+		bson_append_document_begin(&bson_aggregates, buf, -1, &bson_aggregate);
+		bson_append_utf8(&bson_aggregate, "_name", -1, aggregate->count_name, -1);
+		bson_append_int32(&bson_aggregate, "_function", -1, J_DB_SELECTOR_AGGREGATE_COUNT);
+		bson_append_utf8(&bson_aggregate, "_field", -1, bson_iter_utf8(&child, NULL), -1);
+		bson_append_int32(&bson_aggregate, "_type", -1, J_DB_TYPE_UINT64);
+		bson_append_document_end(&bson_aggregates, &bson_aggregate);
+	}
+
+	bson_append_document_end(bson, &bson_aggregates);
+
+	return bson;
+}
+
+static void
+j_db_internal_aggregate_group_free(gpointer data)
+{
+	JDBAggregateGroup* group = data;
+
+	for (guint i = 0; i < group->value_count; i++)
+	{
+		if (group->values[i].set)
+		{
+			bson_value_destroy(&(group->values[i].extreme));
+		}
+	}
+
+	bson_destroy(group->fields);
+	g_free(group->values);
+	g_free(group);
+}
+
+/**
+ * Returns a numeric value as an integer.
+ *
+ * \private
+ **/
+static gint64
+j_db_internal_value_int(bson_value_t const* value)
+{
+	switch (value->value_type)
+	{
+		case BSON_TYPE_INT32:
+			return value->value.v_int32;
+		case BSON_TYPE_INT64:
+			return value->value.v_int64;
+		case BSON_TYPE_DOUBLE:
+			return value->value.v_double;
+		default:
+			return 0;
+	}
+}
+
+/**
+ * Returns a numeric value as a double.
+ *
+ * \private
+ **/
+static gdouble
+j_db_internal_value_double(bson_value_t const* value)
+{
+	switch (value->value_type)
+	{
+		case BSON_TYPE_INT32:
+			return value->value.v_int32;
+		case BSON_TYPE_INT64:
+			return value->value.v_int64;
+		case BSON_TYPE_DOUBLE:
+			return value->value.v_double;
+		default:
+			return 0.0;
+	}
+}
+
+/**
+ * Adds one server's result to the combined aggregates of its group.
+ * Counts and sums are added, minimums and maximums are compared, averages are computed from their sums and counts.
+ *
+ * \private
+ *
+ * \param selector   A selector.
+ * \param aggregates The selector's aggregates.
+ * \param groups     The groups found so far.
+ * \param group_keys The groups indexed by their fields.
+ * \param entry      A server's result.
+ **/
+static void
+j_db_internal_aggregate_add(JDBSelector* selector, GArray* aggregates, GPtrArray* groups, GHashTable* group_keys, bson_t const* entry)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBAggregateGroup* group;
+	g_autoptr(GBytes) key = NULL;
+	bson_t fields;
+	bson_iter_t iter;
+
+	bson_init(&fields);
+
+	if (selector->group_count > 0 && bson_iter_init(&iter, &selector->group))
+	{
+		while (bson_iter_next(&iter))
+		{
+			gchar const* name = bson_iter_utf8(&iter, NULL);
+			bson_iter_t field;
+
+			if (bson_iter_init_find(&field, entry, name))
+			{
+				bson_append_value(&fields, name, -1, bson_iter_value(&field));
+			}
+			else
+			{
+				bson_append_null(&fields, name, -1);
+			}
+		}
+	}
+
+	key = g_bytes_new_static(bson_get_data(&fields), fields.len);
+	group = g_hash_table_lookup(group_keys, key);
+
+	if (group == NULL)
+	{
+		group = g_new(JDBAggregateGroup, 1);
+		group->fields = bson_copy(&fields);
+		group->values = g_new0(JDBAggregateValue, aggregates->len);
+		group->value_count = aggregates->len;
+
+		g_ptr_array_add(groups, group);
+		g_hash_table_insert(group_keys, g_bytes_new_static(bson_get_data(group->fields), group->fields->len), group);
+	}
+
+	bson_destroy(&fields);
+
+	for (guint i = 0; i < aggregates->len; i++)
+	{
+		JDBAggregate* aggregate = &g_array_index(aggregates, JDBAggregate, i);
+		JDBAggregateValue* value = &(group->values[i]);
+		bson_value_t const* partial;
+		bson_iter_t count;
+		gint ret;
+
+		// Aggregates over no values are NULL
+		if (!bson_iter_init_find(&iter, entry, aggregate->name) || BSON_ITER_HOLDS_NULL(&iter))
+		{
+			continue;
+		}
+
+		partial = bson_iter_value(&iter);
+
+		switch (aggregate->function)
+		{
+			case J_DB_SELECTOR_AGGREGATE_COUNT:
+				value->uint64 += j_db_internal_value_int(partial);
+				break;
+			case J_DB_SELECTOR_AGGREGATE_SUM:
+				if (aggregate->type == J_DB_TYPE_FLOAT64)
+				{
+					value->float64 += j_db_internal_value_double(partial);
+				}
+				else if (aggregate->type == J_DB_TYPE_UINT64)
+				{
+					value->uint64 += (guint64)j_db_internal_value_int(partial);
+				}
+				else
+				{
+					value->sint64 += j_db_internal_value_int(partial);
+				}
+				break;
+			case J_DB_SELECTOR_AGGREGATE_MIN:
+			case J_DB_SELECTOR_AGGREGATE_MAX:
+				ret = (value->set) ? j_db_internal_compare_values(partial, &(value->extreme), aggregate->type) : 0;
+
+				if (!value->set || (aggregate->function == J_DB_SELECTOR_AGGREGATE_MIN && ret < 0) || (aggregate->function == J_DB_SELECTOR_AGGREGATE_MAX && ret > 0))
+				{
+					if (value->set)
+					{
+						bson_value_destroy(&(value->extreme));
+					}
+
+					bson_value_copy(partial, &(value->extreme));
+				}
+				break;
+			case J_DB_SELECTOR_AGGREGATE_AVG:
+				value->float64 += j_db_internal_value_double(partial);
+
+				if (bson_iter_init_find(&count, entry, aggregate->count_name))
+				{
+					value->uint64 += j_db_internal_value_int(bson_iter_value(&count));
+				}
+				break;
+			default:
+				break;
+		}
+
+		value->set = TRUE;
+	}
+}
+
+/**
+ * Returns the combined result of a group.
+ * Like the backends' results, it contains the group's fields followed by the aggregates.
+ *
+ * \private
+ *
+ * \param aggregates The selector's aggregates.
+ * \param group      A group.
+ *
+ * \return A new entry. Should be freed with bson_destroy().
+ **/
+static bson_t*
+j_db_internal_aggregate_finish(GArray* aggregates, JDBAggregateGroup* group)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	bson_t* entry;
+
+	entry = bson_copy(group->fields);
+
+	for (guint i = 0; i < aggregates->len; i++)
+	{
+		JDBAggregate* aggregate = &g_array_index(aggregates, JDBAggregate, i);
+		JDBAggregateValue* value = &(group->values[i]);
+
+		if (!value->set && aggregate->function != J_DB_SELECTOR_AGGREGATE_COUNT)
+		{
+			bson_append_null(entry, aggregate->name, -1);
+			continue;
+		}
+
+		switch (aggregate->function)
+		{
+			case J_DB_SELECTOR_AGGREGATE_COUNT:
+				bson_append_int64(entry, aggregate->name, -1, value->uint64);
+				break;
+			case J_DB_SELECTOR_AGGREGATE_SUM:
+				if (aggregate->type == J_DB_TYPE_FLOAT64)
+				{
+					bson_append_double(entry, aggregate->name, -1, value->float64);
+				}
+				else if (aggregate->type == J_DB_TYPE_UINT64)
+				{
+					bson_append_int64(entry, aggregate->name, -1, value->uint64);
+				}
+				else
+				{
+					bson_append_int64(entry, aggregate->name, -1, value->sint64);
+				}
+				break;
+			case J_DB_SELECTOR_AGGREGATE_MIN:
+			case J_DB_SELECTOR_AGGREGATE_MAX:
+				bson_append_value(entry, aggregate->name, -1, &(value->extreme));
+				break;
+			case J_DB_SELECTOR_AGGREGATE_AVG:
+				if (value->uint64 > 0)
+				{
+					bson_append_double(entry, aggregate->name, -1, value->float64 / value->uint64);
+				}
+				else
+				{
+					bson_append_null(entry, aggregate->name, -1);
+				}
+				break;
+			default:
+				break;
+		}
+	}
+
+	return entry;
+}
+
+static gint
+j_db_internal_compare_entry_pointers(gconstpointer a, gconstpointer b, gpointer order)
+{
+	return j_db_internal_compare_entries(order, *(bson_t* const*)a, *(bson_t* const*)b);
+}
+
+/**
+ * Fetches the aggregated results of all queries and combines the aggregates of each group.
+ * Groups can span multiple servers, so the combined results are sorted and limited afterwards.
+ * Only the groups are kept in memory, the number of entries does not matter.
+ *
+ * \private
+ *
+ * \param j_db_iterator An iterator.
+ * \param error         A GError.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+j_db_internal_query_gather(JDBIterator* j_db_iterator, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBIteratorHelper* helper = j_db_iterator->iterator;
+	g_autoptr(GArray) aggregates = NULL;
+	g_autoptr(GPtrArray) groups = NULL;
+	g_autoptr(GHashTable) group_keys = NULL;
+
+	aggregates = j_db_internal_aggregates_new(j_db_iterator, error);
+
+	if (G_UNLIKELY(aggregates == NULL))
+	{
+		goto _error;
+	}
+
+	groups = g_ptr_array_new_with_free_func(j_db_internal_aggregate_group_free);
+	group_keys = g_hash_table_new_full(g_bytes_hash, g_bytes_equal, (GDestroyNotify)g_bytes_unref, NULL);
+	helper->selector = j_db_internal_aggregate_selector(j_db_iterator->selector, aggregates);
+
+	for (guint32 i = 0; i < helper->query_count; i++)
+	{
+		j_db_internal_page_request(j_db_iterator, &(helper->queries[i]));
+	}
+
+	for (guint32 i = 0; i < helper->query_count; i++)
+	{
+		JDBPagedQuery* query = &(helper->queries[i]);
+
+		while (TRUE)
+		{
+			if (G_UNLIKELY(!j_db_internal_page_advance(j_db_iterator, query, error)))
+			{
+				goto _error;
+			}
+
+			if (query->entry == NULL)
+			{
+				break;
+			}
+
+			j_db_internal_aggregate_add(j_db_iterator->selector, aggregates, groups, group_keys, query->entry);
+		}
+	}
+
+	helper->entries = g_ptr_array_new_full(groups->len, (GDestroyNotify)bson_destroy);
+
+	for (guint i = 0; i < groups->len; i++)
+	{
+		g_ptr_array_add(helper->entries, j_db_internal_aggregate_finish(aggregates, g_ptr_array_index(groups, i)));
+	}
+
+	if (helper->order != NULL)
+	{
+		g_ptr_array_sort_with_data(helper->entries, j_db_internal_compare_entry_pointers, helper->order);
+	}
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
+/**
+ * Runs a query whose results are fetched page by page from the DB servers.
+ * The servers keep cursors for the remaining results, so memory usage does not depend on the number of results.
+ * While the caller processes a page, the next one is already requested in the background.
+ *
+ * With multiple DB servers, the servers are queried one after another.
+ * If the results are sorted, the servers are queried concurrently and their sorted results are merged.
+ * If the results are aggregated, the aggregates of each group are combined before returning them.
+ * Limits and offsets are applied to the combined results.
+ *
+ * \private
+ *
+ * \param j_db_iterator An iterator.
+ * \param error         A GError.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+gboolean
+j_db_internal_query_open(JDBIterator* j_db_iterator, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBIteratorHelper* helper;
+	JDBSelector* selector;
+	guint32 server_count;
+	guint32 route;
+
+	g_return_val_if_fail(j_db_iterator != NULL, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	selector = j_db_iterator->selector;
+	server_count = j_configuration_get_server_count(j_configuration(), J_BACKEND_TYPE_DB);
+
+	helper = j_helper_alloc_aligned(128, sizeof(JDBIteratorHelper));
+	memset(helper, 0, sizeof(JDBIteratorHelper));
+	helper->paged = TRUE;
+	helper->query_count = server_count;
+	j_db_iterator->iterator = helper;
+
+	route = j_db_internal_selector_route(j_db_selector_get_bson(selector), server_count);
+
+	if (route < server_count)
+	{
+		helper->query_count = 1;
+	}
+
+	helper->queries = g_new0(JDBPagedQuery, helper->query_count);
+
+	for (guint32 i = 0; i < helper->query_count; i++)
+	{
+		helper->queries[i].request.index = (route < server_count) ? route : i;
+	}
+
+	if (helper->query_count > 1 && selector != NULL)
+	{
+		if (selector->limit_set)
+		{
+			helper->offset = selector->offset;
+			helper->limit = selector->limit;
+			helper->limit_set = TRUE;
+		}
+
+		if (selector->order_count > 0)
+		{
+			helper->order = j_db_internal_order_new(j_db_iterator, error);
+
+			if (G_UNLIKELY(helper->order == NULL))
+			{
+				goto _error;
+			}
+		}
+
+		if (selector->aggregate_count > 0 || selector->group_count > 0)
+		{
+			if (G_UNLIKELY(!j_db_internal_query_gather(j_db_iterator, error)))
+			{
+				goto _error;
+			}
+
+			return TRUE;
+		}
+
+		if (selector->limit_set)
+		{
+			helper->selector = j_db_internal_limit_selector(selector);
+		}
+	}
+
+	if (helper->order != NULL)
+	{
+		for (guint32 i = 0; i < helper->query_count; i++)
+		{
+			j_db_internal_page_request(j_db_iterator, &(helper->queries[i]));
+		}
+
+		for (guint32 i = 0; i < helper->query_count; i++)
+		{
+			if (G_UNLIKELY(!j_db_internal_page_advance(j_db_iterator, &(helper->queries[i]), error)))
+			{
+				goto _error;
+			}
+		}
+	}
+	else
+	{
+		j_db_internal_page_request(j_db_iterator, &(helper->queries[0]));
+
+		if (G_UNLIKELY(!j_db_internal_page_fetch(j_db_iterator, &(helper->queries[0]), error)))
+		{
+			goto _error;
+		}
+	}
+
+	return TRUE;
+
+_error:
+	j_db_internal_iterate_close(j_db_iterator);
+
+	return FALSE;
+}
+
+/**
+ * Returns the next result of the queries one after another.
+ *
+ * \private
+ *
+ * \param j_db_iterator An iterator.
+ * \param error         A GError.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+j_db_internal_iterate_sequential(JDBIterator* j_db_iterator, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBIteratorHelper* helper = j_db_iterator->iterator;
+	JDBPagedQuery* query;
+	gboolean has_next;
+
+	while (TRUE)
+	{
+		query = &(helper->queries[helper->current]);
+
+		if (G_UNLIKELY(!j_db_internal_page_next(j_db_iterator, query, &has_next, error)))
+		{
+			goto _error;
+		}
+
+		if (has_next)
+		{
+			break;
+		}
+
+		helper->current++;
+
+		if (helper->current >= helper->query_count)
+		{
+			g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS, "no more elements");
+			goto _error;
+		}
+
+		if (!helper->queries[helper->current].opened)
+		{
+			j_db_internal_page_request(j_db_iterator, &(helper->queries[helper->current]));
+		}
+	}
+
+	if (query->row_block != NULL)
+	{
+		// Fields are read from the row block directly, the BSON document stays empty
+		// The columns have to be mapped again for every row block
+		if (query->row == 0)
+		{
+			j_db_iterator->columns_valid = FALSE;
+		}
+
+		j_db_iterator->row_block = query->row_block;
+		j_db_iterator->row = query->row;
+		query->row++;
+
+		bson_init(&j_db_iterator->bson);
+
+		return TRUE;
+	}
+
+	if (G_UNLIKELY(!j_bson_iter_copy_document(&query->iter, &j_db_iterator->bson, error)))
+	{
+		goto _error;
+	}
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
+/**
+ * Returns the next result of the merged sorted results of all queries.
+ *
+ * \private
+ *
+ * \param j_db_iterator An iterator.
+ * \param error         A GError.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+j_db_internal_iterate_merged(JDBIterator* j_db_iterator, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBIteratorHelper* helper = j_db_iterator->iterator;
+	JDBPagedQuery* next = NULL;
+
+	for (guint32 i = 0; i < helper->query_count; i++)
+	{
+		JDBPagedQuery* query = &(helper->queries[i]);
+
+		if (query->entry == NULL)
+		{
+			continue;
+		}
+
+		// Equal entries are returned in the order of their servers
+		if (next == NULL || j_db_internal_compare_entries(helper->order, query->entry, next->entry) < 0)
+		{
+			next = query;
+		}
+	}
+
+	if (next == NULL)
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS, "no more elements");
+		goto _error;
+	}
+
+	bson_copy_to(next->entry, &j_db_iterator->bson);
+
+	if (G_UNLIKELY(!j_db_internal_page_advance(j_db_iterator, next, error)))
+	{
+		bson_destroy(&j_db_iterator->bson);
+		goto _error;
+	}
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
+/**
+ * Returns the next combined result of aggregated queries.
+ *
+ * \private
+ *
+ * \param j_db_iterator An iterator.
+ * \param error         A GError.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+j_db_internal_iterate_gathered(JDBIterator* j_db_iterator, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBIteratorHelper* helper = j_db_iterator->iterator;
+
+	if (helper->entry >= helper->entries->len)
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS, "no more elements");
+		return FALSE;
+	}
+
+	bson_copy_to(g_ptr_array_index(helper->entries, helper->entry), &j_db_iterator->bson);
+	helper->entry++;
+
+	return TRUE;
+}
+
+/**
+ * Returns the next result of a paged query without applying offset and limit.
+ *
+ * \private
+ *
+ * \param j_db_iterator An iterator.
+ * \param error         A GError.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+j_db_internal_iterate_next(JDBIterator* j_db_iterator, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBIteratorHelper* helper = j_db_iterator->iterator;
+
+	if (helper->entries != NULL)
+	{
+		return j_db_internal_iterate_gathered(j_db_iterator, error);
+	}
+
+	if (helper->order != NULL)
+	{
+		return j_db_internal_iterate_merged(j_db_iterator, error);
+	}
+
+	return j_db_internal_iterate_sequential(j_db_iterator, error);
+}
+
+static gboolean
+j_db_internal_iterate_paged(JDBIterator* j_db_iterator, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBIteratorHelper* helper = j_db_iterator->iterator;
+
+	// Skip the offset of the combined results, the servers do not apply it
+	while (helper->offset > 0)
+	{
+		if (G_UNLIKELY(!j_db_internal_iterate_next(j_db_iterator, error)))
+		{
+			goto _error;
+		}
+
+		j_bson_destroy(&j_db_iterator->bson);
+		helper->offset--;
+	}
+
+	if (helper->limit_set)
+	{
+		if (helper->limit == 0)
+		{
+			g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS, "no more elements");
+			goto _error;
+		}
+
+		helper->limit--;
+	}
+
+	if (G_UNLIKELY(!j_db_internal_iterate_next(j_db_iterator, error)))
+	{
+		goto _error;
+	}
+
+	return TRUE;
+
+_error:
+	j_db_internal_iterate_close(j_db_iterator);
+
+	return FALSE;
+}
+
+/**
+ * Frees an iterator's results before all of them have been iterated over.
+ *
+ * \private
+ *
+ * \param j_db_iterator An iterator.
+ **/
+void
+j_db_internal_iterate_close(JDBIterator* j_db_iterator)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBIteratorHelper* helper = j_db_iterator->iterator;
+	bson_t zerobson;
+
+	if (helper == NULL)
+	{
+		return;
+	}
+
+	memset(&zerobson, 0, sizeof(bson_t));
+	j_db_iterator->row_block = NULL;
+
+	if (helper->paged)
+	{
+		for (guint32 i = 0; i < helper->query_count; i++)
+		{
+			j_db_internal_page_close(&(helper->queries[i]));
+		}
+
+		g_free(helper->queries);
+		g_clear_pointer(&(helper->selector), bson_destroy);
+		g_clear_pointer(&(helper->order), g_array_unref);
+		g_clear_pointer(&(helper->entries), g_ptr_array_unref);
+	}
+
+	if (memcmp(&helper->bson, &zerobson, sizeof(bson_t)))
+	{
+		j_bson_destroy(&helper->bson);
+	}
+
+	g_free(helper);
+	j_db_iterator->iterator = NULL;
+}
+
+gboolean
+j_db_internal_iterate(JDBIterator* j_db_iterator, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBIteratorHelper* helper = j_db_iterator->iterator;
+	gboolean has_next;
+	bson_t zerobson;
+
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	if (helper->paged)
+	{
+		return j_db_internal_iterate_paged(j_db_iterator, error);
+	}
+
+	memset(&zerobson, 0, sizeof(bson_t));
+
+	if (!helper->initialized)
+	{
+		if (G_UNLIKELY(!memcmp(&helper->bson, &zerobson, sizeof(bson_t))))
+		{
+			g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_INVALID, "iterator invalid");
+			goto error2;
+		}
+
+		if (G_UNLIKELY(!j_bson_iter_init(&helper->iter, &helper->bson, error)))
+		{
+			goto _error;
+		}
+
+		helper->initialized = TRUE;
+	}
+
+	if (G_UNLIKELY(!j_bson_iter_next(&helper->iter, &has_next, error)))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!has_next))
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS, "no more elements");
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!j_bson_iter_copy_document(&helper->iter, &j_db_iterator->bson, error)))
+	{
+		goto _error;
+	}
+
+	return TRUE;
+
+_error:
+	j_bson_destroy(&helper->bson);
+
+error2:
+	g_free(helper);
+	j_db_iterator->iterator = NULL;
+
+	return FALSE;
+}
+
+bson_t*
+j_db_selector_get_bson(JDBSelector* selector)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	if (selector == NULL)
+	{
+		return NULL;
+	}
+
+	if (selector->projection_count == 0 && selector->order_count == 0 && !selector->limit_set && selector->aggregate_count == 0 && selector->group_count == 0)
+	{
+		if (selector->bson_count > 0)
+		{
+			return &selector->bson;
+		}
+
+		return NULL;
+	}
+
+	if (!selector->bson_query_valid)
+	{
+		bson_copy_to(&selector->bson, &selector->bson_query);
+
+		if (selector->projection_count > 0)
+		{
+			bson_append_document(&selector->bson_query, "_projection", -1, &selector->projection);
+		}
+
+		if (selector->order_count > 0)
+		{
+			bson_append_document(&selector->bson_query, "_order", -1, &selector->order);
+		}
+
+		if (selector->aggregate_count > 0)
+		{
+			bson_append_document(&selector->bson_query, "_aggregate", -1, &selector->aggregate);
+		}
+
+		if (selector->group_count > 0)
+		{
+			bson_append_document(&selector->bson_query, "_group", -1, &selector->group);
+		}
+
+		if (selector->limit_set)
+		{
+			bson_append_int64(&selector->bson_query, "_limit", -1, selector->limit);
+			bson_append_int64(&selector->bson_query, "_offset", -1, selector->offset);
+		}
+
+		selector->bson_query_valid = TRUE;
+	}
+
+	return &selector->bson_query;
 }
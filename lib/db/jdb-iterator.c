@@ -70,9 +70,29 @@ j_db_iterator_new(JDBSchema* schema, JDBSelector* selector, GError** error)
 	}
 
 	iterator->iterator = NULL;
+	iterator->row_block = NULL;
+	iterator->row = 0;
+	iterator->columns = NULL;
+	iterator->columns_valid = FALSE;
+	iterator->fields = NULL;
+	iterator->fields_valid = FALSE;
 	iterator->ref_count = 1;
 	iterator->valid = FALSE;
 	iterator->bson_valid = FALSE;
+
+	if (j_db_get_backend() == NULL)
+	{
+		// Results are fetched page by page, the servers keep the remaining ones
+		if (G_UNLIKELY(!j_db_internal_query_open(iterator, error)))
+		{
+			goto _error;
+		}
+
+		iterator->valid = TRUE;
+
+		return iterator;
+	}
+
 	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
 	ret2 = j_db_internal_query(schema, selector, iterator, batch, error);
 	ret = ret2 && j_batch_execute(batch);
@@ -122,9 +142,9 @@ j_db_iterator_unref(JDBIterator* iterator)
 
 	if (g_atomic_int_dec_and_test(&iterator->ref_count))
 	{
-		while (iterator->valid)
+		if (iterator->valid)
 		{
-			j_db_iterator_next(iterator, NULL);
+			j_db_internal_iterate_close(iterator);
 		}
 
 		j_db_schema_unref(iterator->schema);
@@ -139,6 +159,8 @@ j_db_iterator_unref(JDBIterator* iterator)
 			j_bson_destroy(&iterator->bson);
 		}
 
+		g_free(iterator->columns);
+		g_free(iterator->fields);
 		g_free(iterator);
 	}
 }
@@ -157,6 +179,8 @@ j_db_iterator_next(JDBIterator* iterator, GError** error)
 		j_bson_destroy(&iterator->bson);
 	}
 
+	iterator->fields_valid = FALSE;
+
 	if (G_UNLIKELY(!j_db_internal_iterate(iterator, error)))
 	{
 		goto _error;
@@ -173,84 +197,59 @@ _error:
 	return FALSE;
 }
 
-gboolean
-j_db_iterator_get_field(JDBIterator* iterator, gchar const* name, JDBType* type, gpointer* value, guint64* length, GError** error)
+/**
+ * Copies a value so it can be returned to the caller.
+ *
+ * \param type   The value's type.
+ * \param val    The value.
+ * \param value  A pointer that receives the copy.
+ * \param length A pointer that receives the copy's length.
+ **/
+static void
+j_db_iterator_copy_value(JDBType type, JDBTypeValue const* val, gpointer* value, guint64* length)
 {
-	J_TRACE_FUNCTION(NULL);
-
-	JDBTypeValue val;
-	bson_iter_t iter;
-
-	g_return_val_if_fail(iterator != NULL, FALSE);
-	g_return_val_if_fail(iterator->bson_valid, FALSE);
-	g_return_val_if_fail(name != NULL, FALSE);
-	g_return_val_if_fail(type != NULL, FALSE);
-	g_return_val_if_fail(value != NULL, FALSE);
-	g_return_val_if_fail(length != NULL, FALSE);
-	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
-
-	if (G_UNLIKELY(!j_db_schema_get_field(iterator->schema, name, type, error)))
-	{
-		goto _error;
-	}
-
-	if (G_UNLIKELY(!j_bson_iter_init(&iter, &iterator->bson, error)))
-	{
-		goto _error;
-	}
-
-	if (G_UNLIKELY(!j_bson_iter_find(&iter, name, error)))
-	{
-		goto _error;
-	}
-
-	if (G_UNLIKELY(!j_bson_iter_value(&iter, *type, &val, error)))
-	{
-		goto _error;
-	}
-
-	switch (*type)
+	switch (type)
 	{
 		case J_DB_TYPE_SINT32:
 			*value = g_new(gint32, 1);
-			*((gint32*)*value) = val.val_sint32;
+			*((gint32*)*value) = val->val_sint32;
 			*length = sizeof(gint32);
 			break;
 		case J_DB_TYPE_UINT32:
 			*value = g_new(guint32, 1);
-			*((guint32*)*value) = val.val_uint32;
+			*((guint32*)*value) = val->val_uint32;
 			*length = sizeof(guint32);
 			break;
 		case J_DB_TYPE_FLOAT32:
 			*value = g_new(gfloat, 1);
-			*((gfloat*)*value) = val.val_float32;
+			*((gfloat*)*value) = val->val_float32;
 			*length = sizeof(gfloat);
 			break;
 		case J_DB_TYPE_SINT64:
 			*value = g_new(gint64, 1);
-			*((gint64*)*value) = val.val_sint64;
+			*((gint64*)*value) = val->val_sint64;
 			*length = sizeof(gint64);
 			break;
 		case J_DB_TYPE_UINT64:
 			*value = g_new(guint64, 1);
-			*((guint64*)*value) = val.val_uint64;
+			*((guint64*)*value) = val->val_uint64;
 			*length = sizeof(guint64);
 			break;
 		case J_DB_TYPE_FLOAT64:
 			*value = g_new(gdouble, 1);
-			*((gdouble*)*value) = val.val_float64;
+			*((gdouble*)*value) = val->val_float64;
 			*length = sizeof(gdouble);
 			break;
 		case J_DB_TYPE_STRING:
-			*value = g_strdup(val.val_string);
-			*length = strlen(val.val_string);
+			*value = g_strdup(val->val_string);
+			*length = strlen(val->val_string);
 			break;
 		case J_DB_TYPE_BLOB:
-			if (val.val_blob && val.val_blob_length)
+			if (val->val_blob && val->val_blob_length)
 			{
-				*value = g_new(gchar, val.val_blob_length);
-				memcpy(*value, val.val_blob, val.val_blob_length);
-				*length = val.val_blob_length;
+				*value = g_new(gchar, val->val_blob_length);
+				memcpy(*value, val->val_blob, val->val_blob_length);
+				*length = val->val_blob_length;
 			}
 			else
 			{
@@ -262,6 +261,239 @@ j_db_iterator_get_field(JDBIterator* iterator, gchar const* name, JDBType* type,
 		default:
 			g_assert_not_reached();
 	}
+}
+
+/**
+ * Looks up a value of the current entry by its name.
+ *
+ * \param iterator   An iterator.
+ * \param name       The value's name.
+ * \param bson_value A pointer that receives the value.
+ * \param error      A GError.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+j_db_iterator_get_value_by_name(JDBIterator* iterator, gchar const* name, bson_value_t* bson_value, GError** error)
+{
+	bson_iter_t iter;
+
+	if (iterator->row_block != NULL)
+	{
+		guint32 column;
+
+		if (G_UNLIKELY(!j_row_block_get_column_index(iterator->row_block, name, &column)))
+		{
+			g_set_error_literal(error, J_BACKEND_BSON_ERROR, J_BACKEND_BSON_ERROR_ITER_KEY_NOT_FOUND, "bson iter can not find key");
+			goto _error;
+		}
+
+		if (G_UNLIKELY(!j_row_block_get_value(iterator->row_block, iterator->row, column, bson_value)))
+		{
+			g_set_error_literal(error, J_BACKEND_BSON_ERROR, J_BACKEND_BSON_ERROR_ITER_INVALID_TYPE, "bson iter invalid type");
+			goto _error;
+		}
+
+		return TRUE;
+	}
+
+	if (G_UNLIKELY(!j_bson_iter_init(&iter, &iterator->bson, error)))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!j_bson_iter_find(&iter, name, error)))
+	{
+		goto _error;
+	}
+
+	*bson_value = *bson_iter_value(&iter);
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
+/**
+ * Looks up a value of the current entry by its schema index.
+ *
+ * The positions of all fields are determined once per row block or entry, so that each lookup only requires an array access.
+ *
+ * \param iterator    An iterator.
+ * \param field_table The schema's field table.
+ * \param index       The value's schema index.
+ * \param bson_value  A pointer that receives the value.
+ * \param error       A GError.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+j_db_iterator_get_value_by_index(JDBIterator* iterator, JDBSchemaFieldTable* field_table, guint32 index, bson_value_t* bson_value, GError** error)
+{
+	if (iterator->row_block != NULL)
+	{
+		guint32 column;
+
+		if (!iterator->columns_valid)
+		{
+			iterator->columns = g_renew(guint32, iterator->columns, field_table->count);
+
+			for (guint32 i = 0; i < field_table->count; i++)
+			{
+				if (!j_row_block_get_column_index(iterator->row_block, field_table->names[i], &(iterator->columns[i])))
+				{
+					iterator->columns[i] = G_MAXUINT32;
+				}
+			}
+
+			iterator->columns_valid = TRUE;
+		}
+
+		column = iterator->columns[index];
+
+		if (G_UNLIKELY(column == G_MAXUINT32))
+		{
+			g_set_error_literal(error, J_BACKEND_BSON_ERROR, J_BACKEND_BSON_ERROR_ITER_KEY_NOT_FOUND, "bson iter can not find key");
+			goto _error;
+		}
+
+		if (G_UNLIKELY(!j_row_block_get_value(iterator->row_block, iterator->row, column, bson_value)))
+		{
+			g_set_error_literal(error, J_BACKEND_BSON_ERROR, J_BACKEND_BSON_ERROR_ITER_INVALID_TYPE, "bson iter invalid type");
+			goto _error;
+		}
+
+		return TRUE;
+	}
+
+	if (!iterator->fields_valid)
+	{
+		bson_iter_t iter;
+
+		iterator->fields = g_renew(bson_iter_t, iterator->fields, field_table->count);
+		memset(iterator->fields, 0, field_table->count * sizeof(bson_iter_t));
+
+		if (G_UNLIKELY(!j_bson_iter_init(&iter, &iterator->bson, error)))
+		{
+			goto _error;
+		}
+
+		while (bson_iter_next(&iter))
+		{
+			gpointer position;
+
+			if (g_hash_table_lookup_extended(field_table->indexes, bson_iter_key(&iter), NULL, &position))
+			{
+				iterator->fields[GPOINTER_TO_UINT(position)] = iter;
+			}
+		}
+
+		iterator->fields_valid = TRUE;
+	}
+
+	if (G_UNLIKELY(iterator->fields[index].raw == NULL))
+	{
+		g_set_error_literal(error, J_BACKEND_BSON_ERROR, J_BACKEND_BSON_ERROR_ITER_KEY_NOT_FOUND, "bson iter can not find key");
+		goto _error;
+	}
+
+	*bson_value = *bson_iter_value(&(iterator->fields[index]));
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
+gboolean
+j_db_iterator_get_field(JDBIterator* iterator, gchar const* name, JDBType* type, gpointer* value, guint64* length, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBTypeValue val;
+	bson_value_t bson_value;
+	guint32 index;
+
+	g_return_val_if_fail(iterator != NULL, FALSE);
+	g_return_val_if_fail(iterator->bson_valid, FALSE);
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(type != NULL, FALSE);
+	g_return_val_if_fail(value != NULL, FALSE);
+	g_return_val_if_fail(length != NULL, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	// Aggregates are not part of the schema, their types are defined by the selector
+	if (iterator->selector == NULL || !j_db_selector_get_aggregate_type(iterator->selector, name, type))
+	{
+		if (G_UNLIKELY(!j_db_schema_get_field_index(iterator->schema, name, &index, error)))
+		{
+			goto _error;
+		}
+
+		return j_db_iterator_get_field_by_index(iterator, index, type, value, length, error);
+	}
+
+	if (G_UNLIKELY(!j_db_iterator_get_value_by_name(iterator, name, &bson_value, error)))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!j_bson_value_get(&bson_value, *type, &val, error)))
+	{
+		goto _error;
+	}
+
+	j_db_iterator_copy_value(*type, &val, value, length);
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
+gboolean
+j_db_iterator_get_field_by_index(JDBIterator* iterator, guint32 index, JDBType* type, gpointer* value, guint64* length, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBSchemaFieldTable* field_table;
+	JDBTypeValue val;
+	bson_value_t bson_value;
+
+	g_return_val_if_fail(iterator != NULL, FALSE);
+	g_return_val_if_fail(iterator->bson_valid, FALSE);
+	g_return_val_if_fail(type != NULL, FALSE);
+	g_return_val_if_fail(value != NULL, FALSE);
+	g_return_val_if_fail(length != NULL, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	field_table = j_db_schema_get_field_table(iterator->schema, error);
+
+	if (G_UNLIKELY(field_table == NULL))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(index >= field_table->count))
+	{
+		g_set_error_literal(error, J_DB_ERROR, J_DB_ERROR_VARIABLE_NOT_FOUND, "variable not found");
+		goto _error;
+	}
+
+	*type = field_table->types[index];
+
+	if (G_UNLIKELY(!j_db_iterator_get_value_by_index(iterator, field_table, index, &bson_value, error)))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!j_bson_value_get(&bson_value, *type, &val, error)))
+	{
+		goto _error;
+	}
+
+	j_db_iterator_copy_value(*type, &val, value, length);
 
 	return TRUE;
 
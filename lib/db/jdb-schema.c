@@ -33,6 +33,15 @@
 #include <julea-db.h>
 #include "../../backend/db/jbson.c"
 
+static void
+j_db_schema_field_table_free(JDBSchemaFieldTable* field_table)
+{
+	g_hash_table_unref(field_table->indexes);
+	g_strfreev(field_table->names);
+	g_free(field_table->types);
+	g_free(field_table);
+}
+
 JDBSchema*
 j_db_schema_new(gchar const* namespace, gchar const* name, GError** error)
 {
@@ -49,8 +58,10 @@ j_db_schema_new(gchar const* namespace, gchar const* name, GError** error)
 	schema = j_helper_alloc_aligned(128, sizeof(JDBSchema));
 	schema->namespace = g_strdup(namespace);
 	schema->name = g_strdup(name);
+	schema->shard_key = NULL;
 	schema->variables = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
 	schema->index = g_array_new(FALSE, FALSE, sizeof(JDBSchemaIndex));
+	schema->field_table = NULL;
 	schema->bson_initialized = FALSE;
 	schema->bson_index_initialized = FALSE;
 	schema->ref_count = 1;
@@ -87,6 +98,7 @@ j_db_schema_unref(JDBSchema* schema)
 	{
 		g_free(schema->namespace);
 		g_free(schema->name);
+		g_free(schema->shard_key);
 		g_hash_table_unref(schema->variables);
 
 		for (i = 0; i < schema->index->len; i++)
@@ -97,6 +109,11 @@ j_db_schema_unref(JDBSchema* schema)
 
 		g_array_unref(schema->index);
 
+		if (schema->field_table != NULL)
+		{
+			j_db_schema_field_table_free(schema->field_table);
+		}
+
 		if (schema->bson_initialized)
 		{
 			bson_destroy(&schema->bson);
@@ -152,6 +169,9 @@ j_db_schema_add_field(JDBSchema* schema, gchar const* name, JDBType type, GError
 
 	g_hash_table_insert(schema->variables, g_strdup(name), GINT_TO_POINTER(type));
 
+	// Fields are only added before the schema is shared, the table is rebuilt on demand
+	g_clear_pointer(&(schema->field_table), j_db_schema_field_table_free);
+
 	return TRUE;
 
 _error:
@@ -196,6 +216,40 @@ _error:
 	return FALSE;
 }
 
+gboolean
+j_db_schema_get_field_index(JDBSchema* schema, gchar const* name, guint32* index, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBSchemaFieldTable* field_table;
+	gpointer value;
+
+	g_return_val_if_fail(schema != NULL, FALSE);
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(index != NULL, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	field_table = j_db_schema_get_field_table(schema, error);
+
+	if (G_UNLIKELY(field_table == NULL))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!g_hash_table_lookup_extended(field_table->indexes, name, NULL, &value)))
+	{
+		g_set_error_literal(error, J_DB_ERROR, J_DB_ERROR_VARIABLE_NOT_FOUND, "variable not found");
+		goto _error;
+	}
+
+	*index = GPOINTER_TO_UINT(value);
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
 guint32
 j_db_schema_get_all_fields(JDBSchema* schema, gchar*** names, JDBType** types, GError** error)
 {
@@ -399,6 +453,31 @@ _error:
 	return FALSE;
 }
 
+gboolean
+j_db_schema_set_shard_key(JDBSchema* schema, gchar const* name, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBType type;
+
+	g_return_val_if_fail(schema != NULL, FALSE);
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(schema->bson_initialized, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	// Entries missing the shard key would all be inserted on the same server
+	if (G_UNLIKELY(g_strcmp0(name, "_index") == 0 || !j_db_schema_get_field(schema, name, &type, NULL)))
+	{
+		g_set_error(error, J_DB_ERROR, J_DB_ERROR_VARIABLE_NOT_FOUND, "variable %s not found", name);
+		return FALSE;
+	}
+
+	g_free(schema->shard_key);
+	schema->shard_key = g_strdup(name);
+
+	return TRUE;
+}
+
 gboolean
 j_db_schema_create(JDBSchema* schema, JBatch* batch, GError** error)
 {
@@ -444,6 +523,7 @@ j_db_schema_get(JDBSchema* schema, JBatch* batch, GError** error)
 
 	schema->server_side = TRUE;
 	schema->bson_initialized = TRUE;
+	g_clear_pointer(&(schema->field_table), j_db_schema_field_table_free);
 
 	if (G_UNLIKELY(!j_db_internal_schema_get(schema, batch, error)))
 	{
@@ -476,6 +556,105 @@ _error:
 	return FALSE;
 }
 
+/**
+ * Returns a new BSON array containing an index's field names.
+ **/
+static bson_t*
+j_db_schema_index_new(gchar const** names, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	bson_t* index;
+	JDBTypeValue val;
+	const char* key;
+	char buf[20];
+
+	index = bson_new();
+
+	for (guint i = 0; names[i] != NULL; i++)
+	{
+		if (G_UNLIKELY(!j_bson_array_generate_key(i, &key, buf, sizeof(buf), error)))
+		{
+			goto _error;
+		}
+
+		val.val_string = names[i];
+
+		if (G_UNLIKELY(!j_bson_append_value(index, key, J_DB_TYPE_STRING, &val, error)))
+		{
+			goto _error;
+		}
+	}
+
+	return index;
+
+_error:
+	bson_destroy(index);
+
+	return NULL;
+}
+
+gboolean
+j_db_schema_create_index(JDBSchema* schema, gchar const** names, JBatch* batch, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	bson_t* index;
+
+	g_return_val_if_fail(schema != NULL, FALSE);
+	g_return_val_if_fail(names != NULL, FALSE);
+	g_return_val_if_fail(*names != NULL, FALSE);
+	g_return_val_if_fail(batch != NULL, FALSE);
+	g_return_val_if_fail(schema->server_side, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	if (G_UNLIKELY((index = j_db_schema_index_new(names, error)) == NULL))
+	{
+		goto _error;
+	}
+
+	// The operation owns the index
+	if (G_UNLIKELY(!j_db_internal_index_create(schema, index, batch, error)))
+	{
+		goto _error;
+	}
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
+gboolean
+j_db_schema_delete_index(JDBSchema* schema, gchar const** names, JBatch* batch, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	bson_t* index;
+
+	g_return_val_if_fail(schema != NULL, FALSE);
+	g_return_val_if_fail(names != NULL, FALSE);
+	g_return_val_if_fail(*names != NULL, FALSE);
+	g_return_val_if_fail(batch != NULL, FALSE);
+	g_return_val_if_fail(schema->server_side, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	if (G_UNLIKELY((index = j_db_schema_index_new(names, error)) == NULL))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!j_db_internal_index_delete(schema, index, batch, error)))
+	{
+		goto _error;
+	}
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
 gboolean
 j_db_schema_equals(JDBSchema* schema1, JDBSchema* schema2, gboolean* equal, GError** error)
 {
@@ -596,3 +775,88 @@ j_db_schema_equals(JDBSchema* schema1, JDBSchema* schema2, gboolean* equal, GErr
 _error:
 	return FALSE;
 }
+
+/**
+ * Returns a schema's field table, building it on first use.
+ *
+ * \param schema A schema.
+ * \param error  A GError.
+ *
+ * \return The field table, NULL on failure. It is owned by the schema.
+ **/
+JDBSchemaFieldTable*
+j_db_schema_get_field_table(JDBSchema* schema, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBSchemaFieldTable* field_table;
+	JDBTypeValue val;
+	bson_iter_t iter;
+	guint32 count = 0;
+
+	g_return_val_if_fail(schema != NULL, NULL);
+
+	field_table = g_atomic_pointer_get(&(schema->field_table));
+
+	if (field_table != NULL)
+	{
+		return field_table;
+	}
+
+	if (G_UNLIKELY(!schema->bson_initialized))
+	{
+		g_set_error_literal(error, J_DB_ERROR, J_DB_ERROR_SCHEMA_NOT_INITIALIZED, "schema not initialized");
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!j_bson_count_keys(&schema->bson, &count, error)))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!j_bson_iter_init(&iter, &schema->bson, error)))
+	{
+		goto _error;
+	}
+
+	field_table = g_new(JDBSchemaFieldTable, 1);
+	field_table->names = g_new0(gchar*, count + 1);
+	field_table->types = g_new(JDBType, count);
+	field_table->indexes = g_hash_table_new(g_str_hash, g_str_equal);
+	field_table->count = 0;
+
+	while (bson_iter_next(&iter))
+	{
+		gchar const* key;
+
+		key = bson_iter_key(&iter);
+
+		if (g_strcmp0(key, "_index") == 0)
+		{
+			continue;
+		}
+
+		if (G_UNLIKELY(!j_bson_iter_value(&iter, J_DB_TYPE_UINT32, &val, error)))
+		{
+			j_db_schema_field_table_free(field_table);
+			goto _error;
+		}
+
+		field_table->names[field_table->count] = g_strdup(key);
+		field_table->types[field_table->count] = val.val_uint32;
+		g_hash_table_insert(field_table->indexes, field_table->names[field_table->count], GUINT_TO_POINTER(field_table->count));
+		field_table->count++;
+	}
+
+	// Another thread might have built the table concurrently
+	if (!g_atomic_pointer_compare_and_exchange(&(schema->field_table), NULL, field_table))
+	{
+		j_db_schema_field_table_free(field_table);
+		field_table = g_atomic_pointer_get(&(schema->field_table));
+	}
+
+	return field_table;
+
+_error:
+	return NULL;
+}
@@ -33,6 +33,19 @@
 #include <julea-db.h>
 #include "../../backend/db/jbson.c"
 
+/**
+ * Drops the selector's BSON including its options after it has been modified.
+ **/
+static void
+j_db_selector_invalidate(JDBSelector* selector)
+{
+	if (selector->bson_query_valid)
+	{
+		bson_destroy(&selector->bson_query);
+		selector->bson_query_valid = FALSE;
+	}
+}
+
 JDBSelector*
 j_db_selector_new(JDBSchema* schema, JDBSelectorMode mode, GError** error)
 {
@@ -47,7 +60,19 @@ j_db_selector_new(JDBSchema* schema, JDBSelectorMode mode, GError** error)
 	selector->ref_count = 1;
 	selector->mode = mode;
 	selector->bson_count = 0;
+	selector->projection_count = 0;
+	selector->order_count = 0;
+	selector->aggregate_count = 0;
+	selector->group_count = 0;
+	selector->limit = 0;
+	selector->offset = 0;
+	selector->limit_set = FALSE;
+	selector->bson_query_valid = FALSE;
 	bson_init(&selector->bson);
+	bson_init(&selector->projection);
+	bson_init(&selector->order);
+	bson_init(&selector->aggregate);
+	bson_init(&selector->group);
 	selector->schema = j_db_schema_ref(schema);
 
 	if (G_UNLIKELY(!selector->schema))
@@ -92,16 +117,163 @@ j_db_selector_unref(JDBSelector* selector)
 	{
 		j_db_schema_unref(selector->schema);
 		bson_destroy(&selector->bson);
+		bson_destroy(&selector->projection);
+		bson_destroy(&selector->order);
+		bson_destroy(&selector->aggregate);
+		bson_destroy(&selector->group);
+
+		if (selector->bson_query_valid)
+		{
+			bson_destroy(&selector->bson_query);
+		}
 		g_free(selector);
 	}
 }
 
+/**
+ * Converts a value passed by the user.
+ **/
+static void
+j_db_selector_value(JDBType type, gconstpointer value, guint64 length, JDBTypeValue* val)
+{
+	switch (type)
+	{
+		case J_DB_TYPE_SINT32:
+			val->val_sint32 = *(gint32 const*)value;
+			break;
+		case J_DB_TYPE_UINT32:
+			val->val_uint32 = *(guint32 const*)value;
+			break;
+		case J_DB_TYPE_FLOAT32:
+			val->val_float32 = *(gfloat const*)value;
+			break;
+		case J_DB_TYPE_SINT64:
+			val->val_sint64 = *(gint64 const*)value;
+			break;
+		case J_DB_TYPE_UINT64:
+			val->val_sint64 = *(gint64 const*)value;
+			break;
+		case J_DB_TYPE_FLOAT64:
+			val->val_float64 = *(gdouble const*)value;
+			break;
+		case J_DB_TYPE_STRING:
+			val->val_string = value;
+			break;
+		case J_DB_TYPE_BLOB:
+			val->val_blob = value;
+			val->val_blob_length = length;
+			break;
+		case J_DB_TYPE_ID:
+		default:
+			g_assert_not_reached();
+	}
+}
+
+/**
+ * Returns a pointer to the value at position index of an array passed by the user.
+ * Strings and blobs are passed as arrays of pointers, all other types as arrays of values.
+ **/
+static gconstpointer
+j_db_selector_array_value(JDBType type, gconstpointer values, guint index)
+{
+	switch (type)
+	{
+		case J_DB_TYPE_SINT32:
+			return (gint32 const*)values + index;
+		case J_DB_TYPE_UINT32:
+			return (guint32 const*)values + index;
+		case J_DB_TYPE_FLOAT32:
+			return (gfloat const*)values + index;
+		case J_DB_TYPE_SINT64:
+			return (gint64 const*)values + index;
+		case J_DB_TYPE_UINT64:
+			return (guint64 const*)values + index;
+		case J_DB_TYPE_FLOAT64:
+			return (gdouble const*)values + index;
+		case J_DB_TYPE_STRING:
+		case J_DB_TYPE_BLOB:
+			return ((gconstpointer const*)values)[index];
+		case J_DB_TYPE_ID:
+		default:
+			g_assert_not_reached();
+	}
+
+	return NULL;
+}
+
+/**
+ * Starts a search field, which counts as cost search fields.
+ * The field's value has to be appended to bson before calling j_db_selector_add_field_end.
+ **/
+static gboolean
+j_db_selector_add_field_begin(JDBSelector* selector, gchar const* name, JDBSelectorOperator operator, guint cost, JDBType* type, bson_t* bson, GError** error)
+{
+	char buf[20];
+	JDBTypeValue val;
+
+	if (G_UNLIKELY(selector->bson_count + cost > 500))
+	{
+		g_set_error_literal(error, J_DB_ERROR, J_DB_ERROR_SELECTOR_TOO_COMPLEX, "selector too complex");
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!j_db_schema_get_field(selector->schema, name, type, error)))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(operator == J_DB_SELECTOR_OPERATOR_PREFIX && *type != J_DB_TYPE_STRING))
+	{
+		g_set_error_literal(error, J_DB_ERROR, J_DB_ERROR_TYPE_INVALID, "type invalid");
+		goto _error;
+	}
+
+	snprintf(buf, sizeof(buf), "%d", selector->bson_count);
+
+	if (G_UNLIKELY(!j_bson_append_document_begin(&selector->bson, buf, bson, error)))
+	{
+		goto _error;
+	}
+
+	val.val_string = name;
+
+	if (G_UNLIKELY(!j_bson_append_value(bson, "_name", J_DB_TYPE_STRING, &val, error)))
+	{
+		goto _error;
+	}
+
+	val.val_uint32 = operator;
+
+	if (G_UNLIKELY(!j_bson_append_value(bson, "_operator", J_DB_TYPE_UINT32, &val, error)))
+	{
+		goto _error;
+	}
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
+static gboolean
+j_db_selector_add_field_end(JDBSelector* selector, guint cost, bson_t* bson, GError** error)
+{
+	if (G_UNLIKELY(!j_bson_append_document_end(&selector->bson, bson, error)))
+	{
+		return FALSE;
+	}
+
+	selector->bson_count += cost;
+	j_db_selector_invalidate(selector);
+
+	return TRUE;
+}
+
 gboolean
 j_db_selector_add_field(JDBSelector* selector, gchar const* name, JDBSelectorOperator operator, gconstpointer value, guint64 length, GError** error)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	char buf[20];
 	bson_t bson;
 	JDBType type;
 	JDBTypeValue val;
@@ -109,81 +281,136 @@ j_db_selector_add_field(JDBSelector* selector, gchar const* name, JDBSelectorOpe
 	g_return_val_if_fail(selector != NULL, FALSE);
 	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
 
-	if (G_UNLIKELY(selector->bson_count + 1 > 500))
+	// Lists and ranges have their own functions
+	if (G_UNLIKELY(operator == J_DB_SELECTOR_OPERATOR_IN || operator == J_DB_SELECTOR_OPERATOR_BETWEEN || operator > J_DB_SELECTOR_OPERATOR_PREFIX))
 	{
-		g_set_error_literal(error, J_DB_ERROR, J_DB_ERROR_SELECTOR_TOO_COMPLEX, "selector too complex");
+		g_set_error_literal(error, J_DB_ERROR, J_DB_ERROR_OPERATOR_INVALID, "operator invalid");
 		goto _error;
 	}
 
-	if (G_UNLIKELY(!j_db_schema_get_field(selector->schema, name, &type, error)))
+	if (G_UNLIKELY(!j_db_selector_add_field_begin(selector, name, operator, 1, &type, &bson, error)))
 	{
 		goto _error;
 	}
 
-	snprintf(buf, sizeof(buf), "%d", selector->bson_count);
+	j_db_selector_value(type, value, length, &val);
 
-	if (G_UNLIKELY(!j_bson_append_document_begin(&selector->bson, buf, &bson, error)))
+	if (G_UNLIKELY(!j_bson_append_value(&bson, "_value", type, &val, error)))
 	{
 		goto _error;
 	}
 
-	val.val_string = name;
+	if (G_UNLIKELY(!j_db_selector_add_field_end(selector, 1, &bson, error)))
+	{
+		goto _error;
+	}
 
-	if (G_UNLIKELY(!j_bson_append_value(&bson, "_name", J_DB_TYPE_STRING, &val, error)))
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
+gboolean
+j_db_selector_add_field_in(JDBSelector* selector, gchar const* name, gconstpointer values, guint64 const* lengths, guint count, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	bson_t bson;
+	bson_t array;
+	JDBType type;
+	JDBTypeValue val;
+	const char* key;
+	char buf[20];
+
+	g_return_val_if_fail(selector != NULL, FALSE);
+	g_return_val_if_fail(values != NULL, FALSE);
+	g_return_val_if_fail(count > 0, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	if (G_UNLIKELY(j_db_schema_get_field(selector->schema, name, &type, NULL) && type == J_DB_TYPE_BLOB && lengths == NULL))
 	{
+		g_set_error_literal(error, J_DB_ERROR, J_DB_ERROR_TYPE_INVALID, "type invalid");
 		goto _error;
 	}
 
-	val.val_uint32 = operator;
+	// Every value is a parameter of the backend's statement, so it counts as a search field
+	if (G_UNLIKELY(!j_db_selector_add_field_begin(selector, name, J_DB_SELECTOR_OPERATOR_IN, count, &type, &bson, error)))
+	{
+		goto _error;
+	}
 
-	if (G_UNLIKELY(!j_bson_append_value(&bson, "_operator", J_DB_TYPE_UINT32, &val, error)))
+	if (G_UNLIKELY(!j_bson_append_array_begin(&bson, "_value", &array, error)))
 	{
 		goto _error;
 	}
 
-	switch (type)
+	for (guint i = 0; i < count; i++)
 	{
-		case J_DB_TYPE_SINT32:
-			val.val_sint32 = *(gint32 const*)value;
-			break;
-		case J_DB_TYPE_UINT32:
-			val.val_uint32 = *(guint32 const*)value;
-			break;
-		case J_DB_TYPE_FLOAT32:
-			val.val_float32 = *(gfloat const*)value;
-			break;
-		case J_DB_TYPE_SINT64:
-			val.val_sint64 = *(gint64 const*)value;
-			break;
-		case J_DB_TYPE_UINT64:
-			val.val_sint64 = *(gint64 const*)value;
-			break;
-		case J_DB_TYPE_FLOAT64:
-			val.val_float64 = *(gdouble const*)value;
-			break;
-		case J_DB_TYPE_STRING:
-			val.val_string = value;
-			break;
-		case J_DB_TYPE_BLOB:
-			val.val_blob = value;
-			val.val_blob_length = length;
-			break;
-		case J_DB_TYPE_ID:
-		default:
-			g_assert_not_reached();
+		if (G_UNLIKELY(!j_bson_array_generate_key(i, &key, buf, sizeof(buf), error)))
+		{
+			goto _error;
+		}
+
+		j_db_selector_value(type, j_db_selector_array_value(type, values, i), (lengths != NULL) ? lengths[i] : 0, &val);
+
+		if (G_UNLIKELY(!j_bson_append_value(&array, key, type, &val, error)))
+		{
+			goto _error;
+		}
+	}
+
+	if (G_UNLIKELY(!j_bson_append_array_end(&bson, &array, error)))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!j_db_selector_add_field_end(selector, count, &bson, error)))
+	{
+		goto _error;
+	}
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
+gboolean
+j_db_selector_add_field_between(JDBSelector* selector, gchar const* name, gconstpointer lower, guint64 lower_length, gconstpointer upper, guint64 upper_length, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	bson_t bson;
+	JDBType type;
+	JDBTypeValue val;
+
+	g_return_val_if_fail(selector != NULL, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	if (G_UNLIKELY(!j_db_selector_add_field_begin(selector, name, J_DB_SELECTOR_OPERATOR_BETWEEN, 2, &type, &bson, error)))
+	{
+		goto _error;
 	}
 
+	j_db_selector_value(type, lower, lower_length, &val);
+
 	if (G_UNLIKELY(!j_bson_append_value(&bson, "_value", type, &val, error)))
 	{
 		goto _error;
 	}
 
-	if (G_UNLIKELY(!j_bson_append_document_end(&selector->bson, &bson, error)))
+	j_db_selector_value(type, upper, upper_length, &val);
+
+	if (G_UNLIKELY(!j_bson_append_value(&bson, "_upper", type, &val, error)))
 	{
 		goto _error;
 	}
 
-	selector->bson_count++;
+	if (G_UNLIKELY(!j_db_selector_add_field_end(selector, 2, &bson, error)))
+	{
+		goto _error;
+	}
 
 	return TRUE;
 
@@ -202,6 +429,8 @@ j_db_selector_add_selector(JDBSelector* selector, JDBSelector* sub_selector, GEr
 	g_return_val_if_fail(sub_selector != NULL, FALSE);
 	g_return_val_if_fail(selector != sub_selector, FALSE);
 	g_return_val_if_fail(selector->schema == sub_selector->schema, FALSE);
+	g_return_val_if_fail(sub_selector->projection_count == 0 && sub_selector->order_count == 0 && !sub_selector->limit_set, FALSE);
+	g_return_val_if_fail(sub_selector->aggregate_count == 0 && sub_selector->group_count == 0, FALSE);
 	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
 
 	if (G_UNLIKELY(!sub_selector->bson_count))
@@ -224,9 +453,367 @@ j_db_selector_add_selector(JDBSelector* selector, JDBSelector* sub_selector, GEr
 	}
 
 	selector->bson_count += sub_selector->bson_count;
+	j_db_selector_invalidate(selector);
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
+gboolean
+j_db_selector_set_projection(JDBSelector* selector, gchar const* const* names, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JDBType type;
+	JDBTypeValue val;
+	char buf[20];
+
+	g_return_val_if_fail(selector != NULL, FALSE);
+	g_return_val_if_fail(names != NULL, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	if (G_UNLIKELY(selector->projection_count > 0))
+	{
+		g_set_error_literal(error, J_DB_ERROR, J_DB_ERROR_VARIABLE_ALREADY_SET, "variable already set");
+		goto _error;
+	}
+
+	for (guint i = 0; names[i] != NULL; i++)
+	{
+		if (g_strcmp0(names[i], "_id") != 0 && G_UNLIKELY(!j_db_schema_get_field(selector->schema, names[i], &type, error)))
+		{
+			goto _error;
+		}
+	}
+
+	for (guint i = 0; names[i] != NULL; i++)
+	{
+		snprintf(buf, sizeof(buf), "%d", i);
+		val.val_string = names[i];
+
+		if (G_UNLIKELY(!j_bson_append_value(&selector->projection, buf, J_DB_TYPE_STRING, &val, error)))
+		{
+			goto _error;
+		}
+
+		selector->projection_count++;
+	}
+
+	j_db_selector_invalidate(selector);
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
+gboolean
+j_db_selector_add_order(JDBSelector* selector, gchar const* name, JDBSelectorOrder order, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	char buf[20];
+	bson_t bson;
+	JDBType type;
+	JDBTypeValue val;
+
+	g_return_val_if_fail(selector != NULL, FALSE);
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	// The ID can be used to sort by insertion order, aggregates can be used to sort groups
+	if (g_strcmp0(name, "_id") != 0 && !j_db_selector_get_aggregate_type(selector, name, &type) && G_UNLIKELY(!j_db_schema_get_field(selector->schema, name, &type, error)))
+	{
+		goto _error;
+	}
+
+	snprintf(buf, sizeof(buf), "%d", selector->order_count);
+
+	if (G_UNLIKELY(!j_bson_append_document_begin(&selector->order, buf, &bson, error)))
+	{
+		goto _error;
+	}
+
+	val.val_string = name;
+
+	if (G_UNLIKELY(!j_bson_append_value(&bson, "_name", J_DB_TYPE_STRING, &val, error)))
+	{
+		goto _error;
+	}
+
+	val.val_uint32 = order;
+
+	if (G_UNLIKELY(!j_bson_append_value(&bson, "_order", J_DB_TYPE_UINT32, &val, error)))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!j_bson_append_document_end(&selector->order, &bson, error)))
+	{
+		goto _error;
+	}
+
+	selector->order_count++;
+	j_db_selector_invalidate(selector);
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
+gboolean
+j_db_selector_set_limit(JDBSelector* selector, guint64 limit, guint64 offset, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_val_if_fail(selector != NULL, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	if (G_UNLIKELY(selector->limit_set))
+	{
+		g_set_error_literal(error, J_DB_ERROR, J_DB_ERROR_VARIABLE_ALREADY_SET, "variable already set");
+		goto _error;
+	}
+
+	selector->limit = limit;
+	selector->offset = offset;
+	selector->limit_set = TRUE;
+	j_db_selector_invalidate(selector);
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
+/**
+ * Returns the type of an aggregate's result.
+ *
+ * \param aggregate  The aggregate function.
+ * \param field_type The aggregated field's type.
+ * \param type       A pointer that receives the result's type.
+ *
+ * \return TRUE if the function can be applied to the field, FALSE otherwise.
+ **/
+static gboolean
+j_db_selector_aggregate_type(JDBSelectorAggregate aggregate, JDBType field_type, JDBType* type)
+{
+	gboolean numeric;
+
+	numeric = (field_type != J_DB_TYPE_STRING && field_type != J_DB_TYPE_BLOB && field_type != J_DB_TYPE_ID);
+
+	switch (aggregate)
+	{
+		case J_DB_SELECTOR_AGGREGATE_COUNT:
+			*type = J_DB_TYPE_UINT64;
+			return TRUE;
+		case J_DB_SELECTOR_AGGREGATE_SUM:
+			if (field_type == J_DB_TYPE_FLOAT32 || field_type == J_DB_TYPE_FLOAT64)
+			{
+				*type = J_DB_TYPE_FLOAT64;
+			}
+			else if (field_type == J_DB_TYPE_UINT64)
+			{
+				*type = J_DB_TYPE_UINT64;
+			}
+			else
+			{
+				*type = J_DB_TYPE_SINT64;
+			}
+
+			return numeric;
+		case J_DB_SELECTOR_AGGREGATE_MIN:
+		case J_DB_SELECTOR_AGGREGATE_MAX:
+			*type = field_type;
+			return (field_type != J_DB_TYPE_BLOB && field_type != J_DB_TYPE_ID);
+		case J_DB_SELECTOR_AGGREGATE_AVG:
+			*type = J_DB_TYPE_FLOAT64;
+			return numeric;
+		default:
+			return FALSE;
+	}
+}
+
+gboolean
+j_db_selector_add_aggregate(JDBSelector* selector, gchar const* alias, JDBSelectorAggregate aggregate, gchar const* name, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	char buf[20];
+	bson_t bson;
+	JDBType field_type = J_DB_TYPE_UINT64;
+	JDBType type;
+	JDBTypeValue val;
+
+	g_return_val_if_fail(selector != NULL, FALSE);
+	g_return_val_if_fail(alias != NULL, FALSE);
+	g_return_val_if_fail(name != NULL || aggregate == J_DB_SELECTOR_AGGREGATE_COUNT, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	// The alias is inserted into the backend's statements, so it has to be a plain identifier
+	if (G_UNLIKELY(!g_ascii_isalpha(alias[0])))
+	{
+		g_set_error_literal(error, J_DB_ERROR, J_DB_ERROR_VARIABLE_NOT_FOUND, "invalid aggregate name");
+		goto _error;
+	}
+
+	for (guint i = 0; alias[i] != '\0'; i++)
+	{
+		if (G_UNLIKELY(!g_ascii_isalnum(alias[i]) && alias[i] != '_'))
+		{
+			g_set_error_literal(error, J_DB_ERROR, J_DB_ERROR_VARIABLE_NOT_FOUND, "invalid aggregate name");
+			goto _error;
+		}
+	}
+
+	if (G_UNLIKELY(j_db_selector_get_aggregate_type(selector, alias, &type) || j_db_schema_get_field(selector->schema, alias, &type, NULL)))
+	{
+		g_set_error_literal(error, J_DB_ERROR, J_DB_ERROR_VARIABLE_ALREADY_SET, "variable already set");
+		goto _error;
+	}
+
+	if (name != NULL && G_UNLIKELY(!j_db_schema_get_field(selector->schema, name, &field_type, error)))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!j_db_selector_aggregate_type(aggregate, field_type, &type)))
+	{
+		g_set_error_literal(error, J_DB_ERROR, J_DB_ERROR_TYPE_INVALID, "type invalid");
+		goto _error;
+	}
+
+	snprintf(buf, sizeof(buf), "%d", selector->aggregate_count);
+
+	if (G_UNLIKELY(!j_bson_append_document_begin(&selector->aggregate, buf, &bson, error)))
+	{
+		goto _error;
+	}
+
+	val.val_string = alias;
+
+	if (G_UNLIKELY(!j_bson_append_value(&bson, "_name", J_DB_TYPE_STRING, &val, error)))
+	{
+		goto _error;
+	}
+
+	val.val_uint32 = aggregate;
+
+	if (G_UNLIKELY(!j_bson_append_value(&bson, "_function", J_DB_TYPE_UINT32, &val, error)))
+	{
+		goto _error;
+	}
+
+	if (name != NULL)
+	{
+		val.val_string = name;
+
+		if (G_UNLIKELY(!j_bson_append_value(&bson, "_field", J_DB_TYPE_STRING, &val, error)))
+		{
+			goto _error;
+		}
+	}
+
+	// The result's type is determined here so that all backends agree on it
+	val.val_uint32 = type;
+
+	if (G_UNLIKELY(!j_bson_append_value(&bson, "_type", J_DB_TYPE_UINT32, &val, error)))
+	{
+		goto _error;
+	}
+
+	if (G_UNLIKELY(!j_bson_append_document_end(&selector->aggregate, &bson, error)))
+	{
+		goto _error;
+	}
+
+	selector->aggregate_count++;
+	j_db_selector_invalidate(selector);
+
+	return TRUE;
+
+_error:
+	return FALSE;
+}
+
+gboolean
+j_db_selector_add_group(JDBSelector* selector, gchar const* name, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	char buf[20];
+	JDBType type;
+	JDBTypeValue val;
+
+	g_return_val_if_fail(selector != NULL, FALSE);
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(error == NULL || *error == NULL, FALSE);
+
+	if (G_UNLIKELY(!j_db_schema_get_field(selector->schema, name, &type, error)))
+	{
+		goto _error;
+	}
+
+	snprintf(buf, sizeof(buf), "%d", selector->group_count);
+	val.val_string = name;
+
+	if (G_UNLIKELY(!j_bson_append_value(&selector->group, buf, J_DB_TYPE_STRING, &val, error)))
+	{
+		goto _error;
+	}
+
+	selector->group_count++;
+	j_db_selector_invalidate(selector);
 
 	return TRUE;
 
 _error:
 	return FALSE;
 }
+
+/**
+ * Returns the result type of an aggregate.
+ *
+ * \param selector A selector.
+ * \param alias    The aggregate's name.
+ * \param type     A pointer that receives the aggregate's type.
+ *
+ * \return TRUE if the selector contains the aggregate, FALSE otherwise.
+ **/
+gboolean
+j_db_selector_get_aggregate_type(JDBSelector* selector, gchar const* alias, JDBType* type)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	bson_iter_t iter;
+	bson_iter_t child;
+
+	g_return_val_if_fail(selector != NULL, FALSE);
+	g_return_val_if_fail(alias != NULL, FALSE);
+	g_return_val_if_fail(type != NULL, FALSE);
+
+	if (selector->aggregate_count == 0 || !bson_iter_init(&iter, &selector->aggregate))
+	{
+		return FALSE;
+	}
+
+	while (bson_iter_next(&iter))
+	{
+		if (!bson_iter_recurse(&iter, &child) || !bson_iter_find(&child, "_name") || g_strcmp0(bson_iter_utf8(&child, NULL), alias) != 0)
+		{
+			continue;
+		}
+
+		if (bson_iter_recurse(&iter, &child) && bson_iter_find(&child, "_type"))
+		{
+			*type = bson_iter_int32(&child);
+
+			return TRUE;
+		}
+	}
+
+	return FALSE;
+}
@@ -0,0 +1,453 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2020 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ **/
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <string.h>
+
+#include <kv/jkv-cache.h>
+#include <kv/jkv-internal.h>
+
+#include <julea.h>
+
+/**
+ * \defgroup JKVCache KV Cache
+ *
+ * A client-side read cache for key-value pairs.
+ *
+ * Caching is enabled per namespace using j_kv_cache_enable().
+ * Each namespace has its own size limit and evicts the least recently used entries first.
+ * Puts and deletes issued by this client update the cache directly.
+ *
+ * Cached values are only returned for batches using J_SEMANTICS_CONSISTENCY_EVENTUAL or J_SEMANTICS_CONSISTENCY_NONE.
+ * Batches with J_SEMANTICS_CONSISTENCY_IMMEDIATE always contact the server but refresh the cache with the returned values.
+ *
+ * @{
+ **/
+
+/**
+ * A cached value.
+ **/
+struct JKVCacheEntry
+{
+	/**
+	 * The key.
+	 **/
+	gchar* key;
+
+	/**
+	 * The value.
+	 **/
+	gpointer value;
+
+	/**
+	 * The value's length.
+	 **/
+	guint32 value_len;
+
+	/**
+	 * The monotonic time after which the entry is stale, 0 if it never expires.
+	 **/
+	gint64 expires;
+
+	/**
+	 * The entry's link in the namespace's LRU queue.
+	 **/
+	GList* link;
+};
+
+typedef struct JKVCacheEntry JKVCacheEntry;
+
+/**
+ * The cache of one namespace.
+ **/
+struct JKVCacheNamespace
+{
+	/**
+	 * The entries, indexed by key.
+	 * Contains #JKVCacheEntry elements.
+	 **/
+	GHashTable* entries;
+
+	/**
+	 * The entries in LRU order, most recently used first.
+	 **/
+	GQueue* lru;
+
+	/**
+	 * The maximum size in bytes.
+	 **/
+	guint64 size;
+
+	/**
+	 * The used size in bytes.
+	 **/
+	guint64 used;
+
+	/**
+	 * The time to live in microseconds, 0 if entries never expire.
+	 **/
+	gint64 ttl;
+};
+
+typedef struct JKVCacheNamespace JKVCacheNamespace;
+
+/**
+ * The namespace caches, indexed by namespace.
+ * Contains #JKVCacheNamespace elements.
+ **/
+static GHashTable* j_kv_caches = NULL;
+
+/**
+ * The number of namespaces with enabled caching.
+ * Allows skipping the lock if caching is not used at all.
+ **/
+static gint j_kv_cache_count = 0;
+
+G_LOCK_DEFINE_STATIC(j_kv_caches);
+
+static guint64
+j_kv_cache_entry_size(JKVCacheEntry const* entry)
+{
+	return strlen(entry->key) + 1 + entry->value_len;
+}
+
+static void
+j_kv_cache_entry_free(gpointer data)
+{
+	JKVCacheEntry* entry = data;
+
+	g_free(entry->value);
+	g_free(entry->key);
+
+	g_slice_free(JKVCacheEntry, entry);
+}
+
+static void
+j_kv_cache_namespace_free(gpointer data)
+{
+	JKVCacheNamespace* cache = data;
+
+	// Frees the links, the entries themselves are freed by the hash table
+	g_queue_free(cache->lru);
+	g_hash_table_unref(cache->entries);
+
+	g_slice_free(JKVCacheNamespace, cache);
+}
+
+static void
+j_kv_cache_namespace_remove(JKVCacheNamespace* cache, JKVCacheEntry* entry)
+{
+	g_queue_unlink(cache->lru, entry->link);
+	g_list_free_1(entry->link);
+	cache->used -= j_kv_cache_entry_size(entry);
+
+	g_hash_table_remove(cache->entries, entry->key);
+}
+
+static void
+j_kv_cache_namespace_evict(JKVCacheNamespace* cache)
+{
+	while (cache->used > cache->size)
+	{
+		GList* link;
+
+		link = g_queue_peek_tail_link(cache->lru);
+		g_assert(link != NULL);
+
+		j_kv_cache_namespace_remove(cache, link->data);
+	}
+}
+
+/**
+ * Returns a namespace's cache.
+ * Must be called with the lock held.
+ *
+ * \private
+ *
+ * \param namespace A namespace.
+ *
+ * \return The namespace's cache, NULL if caching is disabled for it.
+ **/
+static JKVCacheNamespace*
+j_kv_cache_lookup(gchar const* namespace)
+{
+	if (j_kv_caches == NULL)
+	{
+		return NULL;
+	}
+
+	return g_hash_table_lookup(j_kv_caches, namespace);
+}
+
+/**
+ * Enables caching for a namespace.
+ * If caching is already enabled, the namespace's limits are updated.
+ *
+ * \code
+ * j_kv_cache_enable("collections", 16 * 1024 * 1024, 0);
+ * \endcode
+ *
+ * \param namespace A namespace.
+ * \param size      The maximum size of the cached keys and values in bytes.
+ * \param ttl       The time in milliseconds after which entries are considered stale, 0 if they never expire.
+ **/
+void
+j_kv_cache_enable(gchar const* namespace, guint64 size, guint64 ttl)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JKVCacheNamespace* cache;
+
+	g_return_if_fail(namespace != NULL);
+	g_return_if_fail(size > 0);
+
+	G_LOCK(j_kv_caches);
+
+	if (j_kv_caches == NULL)
+	{
+		j_kv_caches = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, j_kv_cache_namespace_free);
+	}
+
+	cache = g_hash_table_lookup(j_kv_caches, namespace);
+
+	if (cache == NULL)
+	{
+		cache = g_slice_new(JKVCacheNamespace);
+		cache->entries = g_hash_table_new_full(g_str_hash, g_str_equal, NULL, j_kv_cache_entry_free);
+		cache->lru = g_queue_new();
+		cache->used = 0;
+
+		g_hash_table_insert(j_kv_caches, g_strdup(namespace), cache);
+		g_atomic_int_inc(&j_kv_cache_count);
+	}
+
+	cache->size = size;
+	cache->ttl = ttl * G_TIME_SPAN_MILLISECOND;
+
+	j_kv_cache_namespace_evict(cache);
+
+	G_UNLOCK(j_kv_caches);
+}
+
+/**
+ * Disables caching for a namespace and drops all of its cached entries.
+ *
+ * \code
+ * j_kv_cache_disable("collections");
+ * \endcode
+ *
+ * \param namespace A namespace.
+ **/
+void
+j_kv_cache_disable(gchar const* namespace)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(namespace != NULL);
+
+	G_LOCK(j_kv_caches);
+
+	if (j_kv_caches != NULL && g_hash_table_remove(j_kv_caches, namespace))
+	{
+		g_atomic_int_add(&j_kv_cache_count, -1);
+	}
+
+	G_UNLOCK(j_kv_caches);
+}
+
+/* Internal */
+
+/**
+ * Looks up a value in the cache.
+ *
+ * \private
+ *
+ * \param namespace A namespace.
+ * \param key       A key.
+ * \param semantics A semantics object.
+ * \param value     A pointer that receives a copy of the value. Should be freed with g_free().
+ * \param value_len A pointer that receives the value's length.
+ *
+ * \return TRUE if a usable value was found, FALSE otherwise.
+ **/
+gboolean
+j_kv_cache_get(gchar const* namespace, gchar const* key, JSemantics* semantics, gpointer* value, guint32* value_len)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JKVCacheNamespace* cache;
+	JKVCacheEntry* entry;
+	gboolean ret = FALSE;
+
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(key != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+	g_return_val_if_fail(value != NULL, FALSE);
+	g_return_val_if_fail(value_len != NULL, FALSE);
+
+	if (g_atomic_int_get(&j_kv_cache_count) == 0)
+	{
+		return FALSE;
+	}
+
+	// Immediate consistency requires the current value from the server
+	if (j_semantics_get(semantics, J_SEMANTICS_CONSISTENCY) == J_SEMANTICS_CONSISTENCY_IMMEDIATE)
+	{
+		return FALSE;
+	}
+
+	G_LOCK(j_kv_caches);
+
+	if ((cache = j_kv_cache_lookup(namespace)) == NULL)
+	{
+		goto end;
+	}
+
+	if ((entry = g_hash_table_lookup(cache->entries, key)) == NULL)
+	{
+		goto end;
+	}
+
+	if (entry->expires != 0 && entry->expires < g_get_monotonic_time())
+	{
+		j_kv_cache_namespace_remove(cache, entry);
+		goto end;
+	}
+
+	g_queue_unlink(cache->lru, entry->link);
+	g_queue_push_head_link(cache->lru, entry->link);
+
+	*value = g_memdup(entry->value, entry->value_len);
+	*value_len = entry->value_len;
+
+	ret = TRUE;
+
+end:
+	G_UNLOCK(j_kv_caches);
+
+	return ret;
+}
+
+/**
+ * Stores a value in the cache, replacing an existing one.
+ * Does nothing if caching is disabled for the namespace.
+ *
+ * \private
+ *
+ * \param namespace A namespace.
+ * \param key       A key.
+ * \param value     A value. Will be copied.
+ * \param value_len The value's length.
+ **/
+void
+j_kv_cache_put(gchar const* namespace, gchar const* key, gconstpointer value, guint32 value_len)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JKVCacheNamespace* cache;
+	JKVCacheEntry* entry;
+
+	g_return_if_fail(namespace != NULL);
+	g_return_if_fail(key != NULL);
+
+	if (g_atomic_int_get(&j_kv_cache_count) == 0)
+	{
+		return;
+	}
+
+	G_LOCK(j_kv_caches);
+
+	if ((cache = j_kv_cache_lookup(namespace)) == NULL)
+	{
+		goto end;
+	}
+
+	if ((entry = g_hash_table_lookup(cache->entries, key)) != NULL)
+	{
+		j_kv_cache_namespace_remove(cache, entry);
+	}
+
+	entry = g_slice_new(JKVCacheEntry);
+	entry->key = g_strdup(key);
+	entry->value = g_memdup(value, value_len);
+	entry->value_len = value_len;
+	entry->expires = (cache->ttl > 0) ? g_get_monotonic_time() + cache->ttl : 0;
+
+	if (j_kv_cache_entry_size(entry) > cache->size)
+	{
+		j_kv_cache_entry_free(entry);
+		goto end;
+	}
+
+	entry->link = g_list_alloc();
+	entry->link->data = entry;
+
+	g_hash_table_insert(cache->entries, entry->key, entry);
+	g_queue_push_head_link(cache->lru, entry->link);
+	cache->used += j_kv_cache_entry_size(entry);
+
+	j_kv_cache_namespace_evict(cache);
+
+end:
+	G_UNLOCK(j_kv_caches);
+}
+
+/**
+ * Removes a value from the cache.
+ *
+ * \private
+ *
+ * \param namespace A namespace.
+ * \param key       A key.
+ **/
+void
+j_kv_cache_delete(gchar const* namespace, gchar const* key)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JKVCacheNamespace* cache;
+	JKVCacheEntry* entry;
+
+	g_return_if_fail(namespace != NULL);
+	g_return_if_fail(key != NULL);
+
+	if (g_atomic_int_get(&j_kv_cache_count) == 0)
+	{
+		return;
+	}
+
+	G_LOCK(j_kv_caches);
+
+	if ((cache = j_kv_cache_lookup(namespace)) != NULL && (entry = g_hash_table_lookup(cache->entries, key)) != NULL)
+	{
+		j_kv_cache_namespace_remove(cache, entry);
+	}
+
+	G_UNLOCK(j_kv_caches);
+}
+
+/**
+ * @}
+ **/
@@ -0,0 +1,343 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2020 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+/**
+ * \file
+ **/
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <string.h>
+
+#include <lz4.h>
+
+#include <kv/jkv-compression.h>
+#include <kv/jkv-internal.h>
+
+#include <julea.h>
+
+/**
+ * \defgroup JKVCompression KV Compression
+ *
+ * Transparent compression of key-value pairs' values.
+ *
+ * Compression is enabled per namespace using j_kv_compression_enable().
+ * Values are compressed with LZ4 on the client before being sent and decompressed on get and iteration.
+ *
+ * Encoded values start with a header containing a magic number, a flag and the original length.
+ * Values without this header are returned unchanged, so compressed and raw values can coexist.
+ * Raw values that happen to start with the magic number are stored with a header to keep them unambiguous, regardless of the namespace.
+ * Since the header is self-describing, values are always decoded, even by clients that have not enabled compression themselves.
+ *
+ * @{
+ **/
+
+enum JKVCompressionFlag
+{
+	J_KV_COMPRESSION_FLAG_RAW,
+	J_KV_COMPRESSION_FLAG_LZ4
+};
+
+typedef enum JKVCompressionFlag JKVCompressionFlag;
+
+/**
+ * The magic number marking encoded values.
+ * Interpreted as the length prefix of a BSON document, it would be larger than 1.5 GiB.
+ **/
+static guint8 const j_kv_compression_magic[4] = { 0x89, 'J', 'K', 'Z' };
+
+/**
+ * The header's size: the magic number, the flag and the original length.
+ **/
+#define J_KV_COMPRESSION_HEADER_SIZE (sizeof(j_kv_compression_magic) + 1 + 4)
+
+/**
+ * The namespaces with enabled compression and their thresholds.
+ **/
+static GHashTable* j_kv_compression_namespaces = NULL;
+
+/**
+ * The number of namespaces whose values are compressed.
+ * Allows skipping the lock if compression is not used at all.
+ **/
+static gint j_kv_compression_count = 0;
+
+G_LOCK_DEFINE_STATIC(j_kv_compression_namespaces);
+
+static gboolean
+j_kv_compression_has_magic(gconstpointer value, guint32 len)
+{
+	return (len >= J_KV_COMPRESSION_HEADER_SIZE && memcmp(value, j_kv_compression_magic, sizeof(j_kv_compression_magic)) == 0);
+}
+
+/**
+ * Returns a namespace's compression threshold.
+ *
+ * \private
+ *
+ * \param namespace A namespace.
+ * \param threshold A pointer that receives the threshold.
+ *
+ * \return TRUE if compression is enabled for the namespace, FALSE otherwise.
+ **/
+static gboolean
+j_kv_compression_lookup(gchar const* namespace, guint32* threshold)
+{
+	gpointer value;
+	gboolean ret = FALSE;
+
+	if (g_atomic_int_get(&j_kv_compression_count) == 0)
+	{
+		return FALSE;
+	}
+
+	G_LOCK(j_kv_compression_namespaces);
+
+	if (j_kv_compression_namespaces != NULL && g_hash_table_lookup_extended(j_kv_compression_namespaces, namespace, NULL, &value))
+	{
+		*threshold = GPOINTER_TO_UINT(value);
+		ret = TRUE;
+	}
+
+	G_UNLOCK(j_kv_compression_namespaces);
+
+	return ret;
+}
+
+static gpointer
+j_kv_compression_header(JKVCompressionFlag flag, guint32 len, guint32 payload_len)
+{
+	guint8* buffer;
+	guint32 len_le;
+
+	buffer = g_malloc(J_KV_COMPRESSION_HEADER_SIZE + payload_len);
+	len_le = GUINT32_TO_LE(len);
+
+	memcpy(buffer, j_kv_compression_magic, sizeof(j_kv_compression_magic));
+	buffer[sizeof(j_kv_compression_magic)] = flag;
+	memcpy(buffer + sizeof(j_kv_compression_magic) + 1, &len_le, sizeof(len_le));
+
+	return buffer;
+}
+
+/**
+ * Enables compression for a namespace.
+ * If compression is already enabled, the namespace's threshold is updated.
+ *
+ * \code
+ * j_kv_compression_enable("items", 256);
+ * \endcode
+ *
+ * \param namespace A namespace.
+ * \param threshold The minimum length of values to compress.
+ **/
+void
+j_kv_compression_enable(gchar const* namespace, guint32 threshold)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(namespace != NULL);
+
+	G_LOCK(j_kv_compression_namespaces);
+
+	if (j_kv_compression_namespaces == NULL)
+	{
+		j_kv_compression_namespaces = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, NULL);
+	}
+
+	if (!g_hash_table_contains(j_kv_compression_namespaces, namespace))
+	{
+		g_atomic_int_inc(&j_kv_compression_count);
+	}
+
+	g_hash_table_insert(j_kv_compression_namespaces, g_strdup(namespace), GUINT_TO_POINTER(threshold));
+
+	G_UNLOCK(j_kv_compression_namespaces);
+}
+
+/**
+ * Disables compression for a namespace.
+ * Values that have already been stored compressed can still be read, new values are stored uncompressed.
+ *
+ * \code
+ * j_kv_compression_disable("items");
+ * \endcode
+ *
+ * \param namespace A namespace.
+ **/
+void
+j_kv_compression_disable(gchar const* namespace)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_return_if_fail(namespace != NULL);
+
+	G_LOCK(j_kv_compression_namespaces);
+
+	if (j_kv_compression_namespaces != NULL && g_hash_table_remove(j_kv_compression_namespaces, namespace))
+	{
+		g_atomic_int_add(&j_kv_compression_count, -1);
+	}
+
+	G_UNLOCK(j_kv_compression_namespaces);
+}
+
+/* Internal */
+
+/**
+ * Encodes a value before it is stored.
+ *
+ * \private
+ *
+ * \param namespace   A namespace.
+ * \param value       A value.
+ * \param len         The value's length.
+ * \param encoded_len A pointer that receives the encoded value's length.
+ *
+ * \return The encoded value, NULL if the value can be stored unchanged. Should be freed with g_free().
+ **/
+gpointer
+j_kv_compression_encode(gchar const* namespace, gconstpointer value, guint32 len, guint32* encoded_len)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gpointer encoded;
+	guint32 threshold;
+
+	g_return_val_if_fail(namespace != NULL, NULL);
+	g_return_val_if_fail(encoded_len != NULL, NULL);
+
+	if (j_kv_compression_lookup(namespace, &threshold) && len >= threshold && len <= LZ4_MAX_INPUT_SIZE)
+	{
+		gint bound;
+		gint compressed_len;
+
+		bound = LZ4_compressBound(len);
+		encoded = j_kv_compression_header(J_KV_COMPRESSION_FLAG_LZ4, len, bound);
+		compressed_len = LZ4_compress_default(value, (gchar*)encoded + J_KV_COMPRESSION_HEADER_SIZE, len, bound);
+
+		// Only keep the compressed value if it is actually smaller
+		if (compressed_len > 0 && J_KV_COMPRESSION_HEADER_SIZE + (guint32)compressed_len < len)
+		{
+			*encoded_len = J_KV_COMPRESSION_HEADER_SIZE + compressed_len;
+
+			return encoded;
+		}
+
+		g_free(encoded);
+	}
+
+	// Values of all namespaces are decoded, so raw values that look encoded have to be escaped everywhere
+	if (j_kv_compression_has_magic(value, len))
+	{
+		encoded = j_kv_compression_header(J_KV_COMPRESSION_FLAG_RAW, len, len);
+		memcpy((gchar*)encoded + J_KV_COMPRESSION_HEADER_SIZE, value, len);
+		*encoded_len = J_KV_COMPRESSION_HEADER_SIZE + len;
+
+		return encoded;
+	}
+
+	return NULL;
+}
+
+/**
+ * Decodes a stored value.
+ *
+ * \private
+ *
+ * \param namespace   A namespace.
+ * \param value       A value.
+ * \param len         The value's length.
+ * \param decoded     A pointer that receives the decoded value, NULL if the value can be used unchanged. Should be freed with g_free().
+ * \param decoded_len A pointer that receives the decoded value's length.
+ *
+ * \return TRUE on success, FALSE if the value is corrupt.
+ **/
+gboolean
+j_kv_compression_decode(gchar const* namespace, gconstpointer value, guint32 len, gpointer* decoded, guint32* decoded_len)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	guint8 const* header = value;
+	gchar const* payload;
+	guint32 payload_len;
+	guint32 original_len;
+	guint32 len_le;
+
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(decoded != NULL, FALSE);
+	g_return_val_if_fail(decoded_len != NULL, FALSE);
+
+	*decoded = NULL;
+
+	// The header is self-describing, so values are decoded even if compression is not enabled for the namespace
+	if (value == NULL || !j_kv_compression_has_magic(value, len))
+	{
+		return TRUE;
+	}
+
+	memcpy(&len_le, header + sizeof(j_kv_compression_magic) + 1, sizeof(len_le));
+	original_len = GUINT32_FROM_LE(len_le);
+	payload = (gchar const*)value + J_KV_COMPRESSION_HEADER_SIZE;
+	payload_len = len - J_KV_COMPRESSION_HEADER_SIZE;
+
+	switch (header[sizeof(j_kv_compression_magic)])
+	{
+		case J_KV_COMPRESSION_FLAG_RAW:
+			if (original_len != payload_len)
+			{
+				goto error;
+			}
+
+			*decoded = g_memdup(payload, payload_len);
+			*decoded_len = payload_len;
+			break;
+		case J_KV_COMPRESSION_FLAG_LZ4:
+			// Only values up to LZ4's maximum input size are compressed and LZ4 can not compress better than 255:1
+			if (original_len > LZ4_MAX_INPUT_SIZE || original_len > (guint64)payload_len * 255)
+			{
+				goto error;
+			}
+
+			*decoded = g_malloc(original_len);
+
+			if (LZ4_decompress_safe(payload, *decoded, payload_len, original_len) != (gint)original_len)
+			{
+				g_clear_pointer(decoded, g_free);
+				goto error;
+			}
+
+			*decoded_len = original_len;
+			break;
+		default:
+			goto error;
+	}
+
+	return TRUE;
+
+error:
+	g_warning("Could not decode value in namespace %s.", namespace);
+
+	return FALSE;
+}
+
+/**
+ * @}
+ **/
@@ -43,6 +43,11 @@ struct JKVIterator
 {
 	JBackend* kv_backend;
 
+	/**
+	 * The namespace.
+	 **/
+	gchar* namespace;
+
 	/**
 	 * The iterate cursor.
 	 **/
@@ -59,6 +64,11 @@ struct JKVIterator
 	gconstpointer value;
 	guint32 len;
 
+	/**
+	 * The current value if it had to be decompressed.
+	 **/
+	gpointer decoded;
+
 	JMessage** replies;
 	guint32 replies_n;
 	guint32 replies_cur;
@@ -131,10 +141,12 @@ j_kv_iterator_new(gchar const* namespace, gchar const* prefix)
 
 	iterator = g_slice_new(JKVIterator);
 	iterator->kv_backend = j_kv_get_backend();
+	iterator->namespace = g_strdup(namespace);
 	iterator->cursor = NULL;
 	iterator->key = NULL;
 	iterator->value = NULL;
 	iterator->len = 0;
+	iterator->decoded = NULL;
 	iterator->replies_n = j_configuration_get_server_count(configuration, J_BACKEND_TYPE_KV);
 	iterator->replies = g_new0(JMessage*, iterator->replies_n);
 	iterator->replies_cur = 0;
@@ -178,10 +190,12 @@ j_kv_iterator_new_for_index(guint32 index, gchar const* namespace, gchar const*
 
 	iterator = g_slice_new(JKVIterator);
 	iterator->kv_backend = j_kv_get_backend();
+	iterator->namespace = g_strdup(namespace);
 	iterator->cursor = NULL;
 	iterator->key = NULL;
 	iterator->value = NULL;
 	iterator->len = 0;
+	iterator->decoded = NULL;
 	iterator->replies_n = 1;
 	iterator->replies = g_new0(JMessage*, 1);
 	iterator->replies_cur = 0;
@@ -226,6 +240,8 @@ j_kv_iterator_free(JKVIterator* iterator)
 	}
 
 	g_free(iterator->replies);
+	g_free(iterator->decoded);
+	g_free(iterator->namespace);
 
 	g_slice_free(JKVIterator, iterator);
 }
@@ -249,6 +265,9 @@ j_kv_iterator_next(JKVIterator* iterator)
 
 	g_return_val_if_fail(iterator != NULL, FALSE);
 
+	g_clear_pointer(&(iterator->decoded), g_free);
+
+next:
 	if (iterator->kv_backend != NULL)
 	{
 		ret = j_backend_kv_iterate(iterator->kv_backend, iterator->cursor, &(iterator->key), &(iterator->value), &(iterator->len));
@@ -272,6 +291,21 @@ j_kv_iterator_next(JKVIterator* iterator)
 		}
 	}
 
+	if (ret)
+	{
+		if (!j_kv_compression_decode(iterator->namespace, iterator->value, iterator->len, &(iterator->decoded), &(iterator->len)))
+		{
+			// Corrupt values are skipped
+			ret = FALSE;
+			goto next;
+		}
+
+		if (iterator->decoded != NULL)
+		{
+			iterator->value = iterator->decoded;
+		}
+	}
+
 	return ret;
 }
 
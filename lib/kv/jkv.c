@@ -64,6 +64,34 @@ struct JKVOperation
 
 typedef struct JKVOperation JKVOperation;
 
+/**
+ * Operations of one batch that share a server index and a namespace.
+ **/
+struct JKVGroup
+{
+	/**
+	 * The data server index.
+	 **/
+	guint32 index;
+
+	/**
+	 * The namespace.
+	 * Belongs to one of the operations' key-value pairs.
+	 **/
+	gchar const* namespace;
+
+	/**
+	 * The operations, in batch order.
+	 **/
+	JList* operations;
+
+	JMessage* message;
+	JMessage* reply;
+	JSemantics* semantics;
+};
+
+typedef struct JKVGroup JKVGroup;
+
 /**
  * A JKV.
  **/
@@ -188,193 +216,559 @@ j_kv_get_free(gpointer data)
 	g_slice_free(JKVOperation, operation);
 }
 
+static JKV*
+j_kv_put_get_kv(gpointer data)
+{
+	JKVOperation* operation = data;
+
+	return operation->put.kv;
+}
+
+static JKV*
+j_kv_delete_get_kv(gpointer data)
+{
+	return data;
+}
+
+static JKV*
+j_kv_get_get_kv(gpointer data)
+{
+	JKVOperation* operation = data;
+
+	return operation->get.kv;
+}
+
+static guint
+j_kv_group_hash(gconstpointer key)
+{
+	JKVGroup const* group = key;
+
+	return g_str_hash(group->namespace) ^ group->index;
+}
+
 static gboolean
-j_kv_put_exec(JList* operations, JSemantics* semantics)
+j_kv_group_equal(gconstpointer a, gconstpointer b)
+{
+	JKVGroup const* group_a = a;
+	JKVGroup const* group_b = b;
+
+	return (group_a->index == group_b->index && g_strcmp0(group_a->namespace, group_b->namespace) == 0);
+}
+
+static void
+j_kv_group_free(gpointer data)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	gboolean ret = TRUE;
+	JKVGroup* group = data;
 
-	JBackend* kv_backend;
+	if (group->reply != NULL)
+	{
+		j_message_unref(group->reply);
+	}
+
+	if (group->message != NULL)
+	{
+		j_message_unref(group->message);
+	}
+
+	j_list_unref(group->operations);
+
+	g_slice_free(JKVGroup, group);
+}
+
+/**
+ * Splits a list of operations into groups that share a server index and a namespace.
+ *
+ * \private
+ *
+ * \param operations A list of operations.
+ * \param get_kv     A function returning the key-value pair of an operation.
+ * \param semantics  A semantics object.
+ *
+ * \return An array of #JKVGroup elements, in the order of their first operation.
+ **/
+static GPtrArray*
+j_kv_group_operations(JList* operations, JKV* (*get_kv)(gpointer), JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(GHashTable) lookup = NULL;
 	g_autoptr(JListIterator) it = NULL;
-	g_autoptr(JMessage) message = NULL;
+	GPtrArray* groups;
+
+	groups = g_ptr_array_new_with_free_func(j_kv_group_free);
+	lookup = g_hash_table_new(j_kv_group_hash, j_kv_group_equal);
+	it = j_list_iterator_new(operations);
+
+	while (j_list_iterator_next(it))
+	{
+		gpointer data = j_list_iterator_get(it);
+		JKV* kv = get_kv(data);
+		JKVGroup key;
+		JKVGroup* group;
+
+		key.index = kv->index;
+		key.namespace = kv->namespace;
+
+		group = g_hash_table_lookup(lookup, &key);
+
+		if (group == NULL)
+		{
+			group = g_slice_new(JKVGroup);
+			group->index = kv->index;
+			group->namespace = kv->namespace;
+			group->operations = j_list_new(NULL);
+			group->message = NULL;
+			group->reply = NULL;
+			group->semantics = semantics;
+
+			g_hash_table_add(lookup, group);
+			g_ptr_array_add(groups, group);
+		}
+
+		j_list_append(group->operations, data);
+	}
+
+	return groups;
+}
+
+/**
+ * Sends a group's message and receives the reply in a background operation.
+ *
+ * \private
+ *
+ * \param data Background data.
+ *
+ * \return #data.
+ **/
+static gpointer
+j_kv_send_background_operation(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JKVGroup* group = data;
 	JSemanticsSafety safety;
-	gchar const* namespace;
-	gpointer kv_batch = NULL;
-	gsize namespace_len;
-	guint32 index;
+	gpointer kv_connection;
 
-	g_return_val_if_fail(operations != NULL, FALSE);
-	g_return_val_if_fail(semantics != NULL, FALSE);
+	safety = j_semantics_get(group->semantics, J_SEMANTICS_SAFETY);
+
+	kv_connection = j_connection_pool_pop(J_BACKEND_TYPE_KV, group->index);
+	j_message_send(group->message, kv_connection);
 
+	if (j_message_get_type(group->message) == J_MESSAGE_KV_GET || safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
 	{
-		JKVOperation* kop;
+		group->reply = j_message_new_reply(group->message);
+		j_message_receive(group->reply, kv_connection);
+	}
+
+	j_connection_pool_push(J_BACKEND_TYPE_KV, group->index, kv_connection);
 
-		kop = j_list_get_first(operations);
-		g_assert(kop != NULL);
+	return data;
+}
+
+/**
+ * Sends the messages of all groups, one per server and namespace, in parallel.
+ *
+ * \private
+ *
+ * \param groups An array of #JKVGroup elements.
+ **/
+static void
+j_kv_send_groups(GPtrArray* groups)
+{
+	J_TRACE_FUNCTION(NULL);
 
-		namespace = kop->put.kv->namespace;
-		namespace_len = strlen(namespace) + 1;
-		index = kop->put.kv->index;
+	g_autofree gpointer* background_data = NULL;
+
+	background_data = g_new(gpointer, groups->len);
+
+	for (guint i = 0; i < groups->len; i++)
+	{
+		background_data[i] = g_ptr_array_index(groups, i);
 	}
 
-	safety = j_semantics_get(semantics, J_SEMANTICS_SAFETY);
-	it = j_list_iterator_new(operations);
-	kv_backend = j_kv_get_backend();
+	j_helper_execute_parallel(j_kv_send_background_operation, background_data, groups->len);
+}
+
+/**
+ * Updates the read cache after a put.
+ * Values that might not have been stored are removed from the cache instead.
+ *
+ * \private
+ *
+ * \param namespace A namespace.
+ * \param kop       A put operation.
+ * \param stored    Whether the value has been stored.
+ **/
+static void
+j_kv_put_cache_update(gchar const* namespace, JKVOperation const* kop, gboolean stored)
+{
+	J_TRACE_FUNCTION(NULL);
 
-	if (kv_backend != NULL)
+	if (stored)
 	{
-		ret = j_backend_kv_batch_start(kv_backend, namespace, semantics, &kv_batch);
+		j_kv_cache_put(namespace, kop->put.kv->key, kop->put.value, kop->put.value_len);
 	}
 	else
 	{
-		/**
-		 * Force safe semantics to make the server send a reply.
-		 * Otherwise, nasty races can occur when using unsafe semantics:
-		 * - The client creates the item and sends its first write.
-		 * - The client sends another operation using another connection from the pool.
-		 * - The second operation is executed first and fails because the item does not exist.
-		 * This does not completely eliminate all races but fixes the common case of create, write, write, ...
-		 **/
-		message = j_message_new(J_MESSAGE_KV_PUT, namespace_len);
-		j_message_set_semantics(message, semantics);
-		j_message_append_n(message, namespace, namespace_len);
+		j_kv_cache_delete(namespace, kop->put.kv->key);
 	}
+}
 
-	while (j_list_iterator_next(it))
+static gboolean
+j_kv_put_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	JBackend* kv_backend;
+	g_autoptr(GPtrArray) groups = NULL;
+
+	g_return_val_if_fail(operations != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	groups = j_kv_group_operations(operations, j_kv_put_get_kv, semantics);
+	kv_backend = j_kv_get_backend();
+
+	for (guint i = 0; i < groups->len; i++)
 	{
-		JKVOperation* kop = j_list_iterator_get(it);
+		JKVGroup* group = g_ptr_array_index(groups, i);
+		g_autoptr(JListIterator) it = NULL;
+		gpointer kv_batch = NULL;
+		gsize namespace_len;
+		gboolean stored = TRUE;
+
+		namespace_len = strlen(group->namespace) + 1;
+		it = j_list_iterator_new(group->operations);
 
 		if (kv_backend != NULL)
 		{
-			ret = j_backend_kv_put(kv_backend, kv_batch, kop->put.kv->key, kop->put.value, kop->put.value_len) && ret;
+			stored = j_backend_kv_batch_start(kv_backend, group->namespace, semantics, &kv_batch);
 		}
 		else
 		{
-			gsize key_len;
+			/**
+			 * Force safe semantics to make the server send a reply.
+			 * Otherwise, nasty races can occur when using unsafe semantics:
+			 * - The client creates the item and sends its first write.
+			 * - The client sends another operation using another connection from the pool.
+			 * - The second operation is executed first and fails because the item does not exist.
+			 * This does not completely eliminate all races but fixes the common case of create, write, write, ...
+			 **/
+			group->message = j_message_new(J_MESSAGE_KV_PUT, namespace_len);
+			j_message_set_semantics(group->message, semantics);
+			j_message_append_n(group->message, group->namespace, namespace_len);
+		}
 
-			key_len = strlen(kop->put.kv->key) + 1;
+		while (j_list_iterator_next(it))
+		{
+			JKVOperation* kop = j_list_iterator_get(it);
+			g_autofree gpointer encoded = NULL;
+			gconstpointer value;
+			guint32 value_len;
 
-			j_message_add_operation(message, key_len + 4 + kop->put.value_len);
-			j_message_append_n(message, kop->put.kv->key, key_len);
-			j_message_append_4(message, &(kop->put.value_len));
-			j_message_append_n(message, kop->put.value, kop->put.value_len);
+			encoded = j_kv_compression_encode(group->namespace, kop->put.value, kop->put.value_len, &value_len);
+			value = (encoded != NULL) ? encoded : kop->put.value;
+			value_len = (encoded != NULL) ? value_len : kop->put.value_len;
+
+			if (kv_backend != NULL)
+			{
+				stored = j_backend_kv_put(kv_backend, kv_batch, kop->put.kv->key, value, value_len) && stored;
+			}
+			else
+			{
+				gsize key_len;
+
+				key_len = strlen(kop->put.kv->key) + 1;
+
+				j_message_add_operation(group->message, key_len + 4 + value_len);
+				j_message_append_n(group->message, kop->put.kv->key, key_len);
+				j_message_append_4(group->message, &value_len);
+				j_message_append_n(group->message, value, value_len);
+			}
 		}
-	}
 
-	if (kv_backend != NULL)
-	{
-		ret = j_backend_kv_batch_execute(kv_backend, kv_batch) && ret;
+		if (kv_backend != NULL)
+		{
+			stored = j_backend_kv_batch_execute(kv_backend, kv_batch) && stored;
+			ret = stored && ret;
+
+			// The batch is only stored as a whole
+			j_list_iterator_free(it);
+			it = j_list_iterator_new(group->operations);
+
+			while (j_list_iterator_next(it))
+			{
+				j_kv_put_cache_update(group->namespace, j_list_iterator_get(it), stored);
+			}
+		}
 	}
-	else
-	{
-		gpointer kv_connection;
 
-		kv_connection = j_connection_pool_pop(J_BACKEND_TYPE_KV, index);
-		j_message_send(message, kv_connection);
+	if (kv_backend == NULL)
+	{
+		j_kv_send_groups(groups);
 
-		if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+		for (guint i = 0; i < groups->len; i++)
 		{
-			g_autoptr(JMessage) reply = NULL;
+			JKVGroup* group = g_ptr_array_index(groups, i);
+			g_autoptr(JListIterator) it = NULL;
+			guint32 operation_count = 0;
 
-			reply = j_message_new_reply(message);
-			j_message_receive(reply, kv_connection);
+			if (group->reply != NULL)
+			{
+				operation_count = j_message_get_count(group->reply);
+			}
 
-			/* FIXME do something with reply */
-		}
+			it = j_list_iterator_new(group->operations);
 
-		j_connection_pool_push(J_BACKEND_TYPE_KV, index, kv_connection);
+			for (guint j = 0; j_list_iterator_next(it); j++)
+			{
+				// Without a reply, it is unknown whether the value has been stored
+				gboolean stored = (j < operation_count && j_message_get_4(group->reply) == 1);
+
+				ret = (stored || group->reply == NULL) && ret;
+				j_kv_put_cache_update(group->namespace, j_list_iterator_get(it), stored);
+			}
+		}
 	}
 
 	return ret;
 }
 
-static gboolean
-j_kv_delete_exec(JList* operations, JSemantics* semantics)
+static gint
+j_kv_bulk_put_compare(gconstpointer a, gconstpointer b)
 {
-	J_TRACE_FUNCTION(NULL);
+	JKVOperation const* kop_a = *((JKVOperation const* const*)a);
+	JKVOperation const* kop_b = *((JKVOperation const* const*)b);
 
-	gboolean ret = TRUE;
+	return g_strcmp0(kop_a->put.kv->key, kop_b->put.kv->key);
+}
 
-	JBackend* kv_backend;
+/**
+ * Returns a group's put operations sorted by key.
+ * If a key is put multiple times, only the last put is kept.
+ *
+ * \private
+ *
+ * \param group A group.
+ *
+ * \return An array of #JKVOperation elements. Should be freed with g_ptr_array_unref().
+ **/
+static GPtrArray*
+j_kv_bulk_put_sort(JKVGroup* group)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(GHashTable) latest = NULL;
 	g_autoptr(JListIterator) it = NULL;
-	g_autoptr(JMessage) message = NULL;
-	JSemanticsSafety safety;
-	gchar const* namespace;
-	gpointer kv_batch = NULL;
-	gsize namespace_len;
-	guint32 index;
+	GPtrArray* sorted;
+	GHashTableIter iter;
+	gpointer value;
 
-	g_return_val_if_fail(operations != NULL, FALSE);
-	g_return_val_if_fail(semantics != NULL, FALSE);
+	latest = g_hash_table_new(g_str_hash, g_str_equal);
+	it = j_list_iterator_new(group->operations);
 
+	while (j_list_iterator_next(it))
 	{
-		JKV* object;
-
-		object = j_list_get_first(operations);
-		g_assert(object != NULL);
+		JKVOperation* kop = j_list_iterator_get(it);
 
-		namespace = object->namespace;
-		namespace_len = strlen(namespace) + 1;
-		index = object->index;
+		g_hash_table_insert(latest, kop->put.kv->key, kop);
 	}
 
-	safety = j_semantics_get(semantics, J_SEMANTICS_SAFETY);
-	it = j_list_iterator_new(operations);
-	kv_backend = j_kv_get_backend();
+	sorted = g_ptr_array_sized_new(g_hash_table_size(latest));
+	g_hash_table_iter_init(&iter, latest);
 
-	if (kv_backend != NULL)
+	while (g_hash_table_iter_next(&iter, NULL, &value))
 	{
-		ret = j_backend_kv_batch_start(kv_backend, namespace, semantics, &kv_batch);
-	}
-	else
-	{
-		message = j_message_new(J_MESSAGE_KV_DELETE, namespace_len);
-		j_message_set_semantics(message, semantics);
-		j_message_append_n(message, namespace, namespace_len);
+		g_ptr_array_add(sorted, value);
 	}
 
-	while (j_list_iterator_next(it))
+	g_ptr_array_sort(sorted, j_kv_bulk_put_compare);
+
+	return sorted;
+}
+
+static gboolean
+j_kv_bulk_put_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	JBackend* kv_backend;
+	g_autoptr(GPtrArray) groups = NULL;
+
+	g_return_val_if_fail(operations != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	groups = j_kv_group_operations(operations, j_kv_put_get_kv, semantics);
+	kv_backend = j_kv_get_backend();
+
+	for (guint i = 0; i < groups->len; i++)
 	{
-		JKV* kv = j_list_iterator_get(it);
+		JKVGroup* group = g_ptr_array_index(groups, i);
+		g_autoptr(GPtrArray) sorted = NULL;
+		gpointer kv_bulk = NULL;
+		gsize namespace_len;
+		gboolean stored = TRUE;
+
+		namespace_len = strlen(group->namespace) + 1;
+		sorted = j_kv_bulk_put_sort(group);
 
 		if (kv_backend != NULL)
 		{
-			ret = j_backend_kv_delete(kv_backend, kv_batch, kv->key) && ret;
+			stored = j_backend_kv_bulk_start(kv_backend, group->namespace, semantics, &kv_bulk);
 		}
 		else
 		{
-			gsize key_len;
+			group->message = j_message_new(J_MESSAGE_KV_BULK_PUT, namespace_len);
+			j_message_set_semantics(group->message, semantics);
+			j_message_append_n(group->message, group->namespace, namespace_len);
+		}
+
+		for (guint j = 0; j < sorted->len; j++)
+		{
+			JKVOperation* kop = g_ptr_array_index(sorted, j);
+			g_autofree gpointer encoded = NULL;
+			gconstpointer value;
+			guint32 value_len;
 
-			key_len = strlen(kv->key) + 1;
+			encoded = j_kv_compression_encode(group->namespace, kop->put.value, kop->put.value_len, &value_len);
+			value = (encoded != NULL) ? encoded : kop->put.value;
+			value_len = (encoded != NULL) ? value_len : kop->put.value_len;
 
-			j_message_add_operation(message, key_len);
-			j_message_append_n(message, kv->key, key_len);
+			if (kv_backend != NULL)
+			{
+				stored = j_backend_kv_bulk_put(kv_backend, kv_bulk, kop->put.kv->key, value, value_len) && stored;
+			}
+			else
+			{
+				gsize key_len;
+
+				key_len = strlen(kop->put.kv->key) + 1;
+
+				j_message_add_operation(group->message, key_len + 4 + value_len);
+				j_message_append_n(group->message, kop->put.kv->key, key_len);
+				j_message_append_4(group->message, &value_len);
+				j_message_append_n(group->message, value, value_len);
+			}
+		}
+
+		if (kv_backend != NULL)
+		{
+			stored = j_backend_kv_bulk_execute(kv_backend, kv_bulk) && stored;
+			ret = stored && ret;
+
+			for (guint j = 0; j < sorted->len; j++)
+			{
+				j_kv_put_cache_update(group->namespace, g_ptr_array_index(sorted, j), stored);
+			}
 		}
 	}
 
-	if (kv_backend != NULL)
+	if (kv_backend == NULL)
 	{
-		ret = j_backend_kv_batch_execute(kv_backend, kv_batch) && ret;
+		j_kv_send_groups(groups);
+
+		for (guint i = 0; i < groups->len; i++)
+		{
+			JKVGroup* group = g_ptr_array_index(groups, i);
+			g_autoptr(GPtrArray) sorted = NULL;
+			guint32 operation_count = 0;
+
+			// The replies are in the order of the sorted operations
+			sorted = j_kv_bulk_put_sort(group);
+
+			if (group->reply != NULL)
+			{
+				operation_count = j_message_get_count(group->reply);
+			}
+
+			for (guint j = 0; j < sorted->len; j++)
+			{
+				// Without a reply, it is unknown whether the value has been stored
+				gboolean stored = (j < operation_count && j_message_get_4(group->reply) == 1);
+
+				ret = (stored || group->reply == NULL) && ret;
+				j_kv_put_cache_update(group->namespace, g_ptr_array_index(sorted, j), stored);
+			}
+		}
 	}
-	else
+
+	return ret;
+}
+
+static gboolean
+j_kv_delete_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	JBackend* kv_backend;
+	g_autoptr(GPtrArray) groups = NULL;
+
+	g_return_val_if_fail(operations != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	groups = j_kv_group_operations(operations, j_kv_delete_get_kv, semantics);
+	kv_backend = j_kv_get_backend();
+
+	for (guint i = 0; i < groups->len; i++)
 	{
-		gpointer kv_connection;
+		JKVGroup* group = g_ptr_array_index(groups, i);
+		g_autoptr(JListIterator) it = NULL;
+		gpointer kv_batch = NULL;
+		gsize namespace_len;
 
-		kv_connection = j_connection_pool_pop(J_BACKEND_TYPE_KV, index);
-		j_message_send(message, kv_connection);
+		namespace_len = strlen(group->namespace) + 1;
+		it = j_list_iterator_new(group->operations);
+
+		if (kv_backend != NULL)
+		{
+			ret = j_backend_kv_batch_start(kv_backend, group->namespace, semantics, &kv_batch) && ret;
+		}
+		else
+		{
+			group->message = j_message_new(J_MESSAGE_KV_DELETE, namespace_len);
+			j_message_set_semantics(group->message, semantics);
+			j_message_append_n(group->message, group->namespace, namespace_len);
+		}
 
-		if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+		while (j_list_iterator_next(it))
 		{
-			g_autoptr(JMessage) reply = NULL;
+			JKV* kv = j_list_iterator_get(it);
+
+			j_kv_cache_delete(group->namespace, kv->key);
 
-			reply = j_message_new_reply(message);
-			j_message_receive(reply, kv_connection);
+			if (kv_backend != NULL)
+			{
+				ret = j_backend_kv_delete(kv_backend, kv_batch, kv->key) && ret;
+			}
+			else
+			{
+				gsize key_len;
+
+				key_len = strlen(kv->key) + 1;
+
+				j_message_add_operation(group->message, key_len);
+				j_message_append_n(group->message, kv->key, key_len);
+			}
+		}
 
-			/* FIXME do something with reply */
+		if (kv_backend != NULL)
+		{
+			ret = j_backend_kv_batch_execute(kv_backend, kv_batch) && ret;
 		}
+	}
 
-		j_connection_pool_push(J_BACKEND_TYPE_KV, index, kv_connection);
+	if (kv_backend == NULL)
+	{
+		j_kv_send_groups(groups);
+
+		/* FIXME do something with replies */
 	}
 
 	return ret;
@@ -388,133 +782,193 @@ j_kv_get_exec(JList* operations, JSemantics* semantics)
 	gboolean ret = TRUE;
 
 	JBackend* kv_backend;
-	g_autoptr(JListIterator) it = NULL;
-	g_autoptr(JMessage) message = NULL;
-	gchar const* namespace;
-	gpointer kv_batch = NULL;
-	gsize namespace_len;
-	guint32 index;
+	g_autoptr(GPtrArray) groups = NULL;
+	g_autoptr(JList) misses = NULL;
+	g_autoptr(JListIterator) cache_it = NULL;
 
 	g_return_val_if_fail(operations != NULL, FALSE);
 	g_return_val_if_fail(semantics != NULL, FALSE);
 
+	misses = j_list_new(NULL);
+	cache_it = j_list_iterator_new(operations);
+
+	while (j_list_iterator_next(cache_it))
 	{
-		JKVOperation* kop;
+		JKVOperation* kop = j_list_iterator_get(cache_it);
+		gpointer value;
+		guint32 len;
 
-		kop = j_list_get_first(operations);
-		g_assert(kop != NULL);
+		if (!j_kv_cache_get(kop->get.kv->namespace, kop->get.kv->key, semantics, &value, &len))
+		{
+			j_list_append(misses, kop);
+			continue;
+		}
 
-		namespace = kop->get.kv->namespace;
-		namespace_len = strlen(namespace) + 1;
-		index = kop->get.kv->index;
+		if (kop->get.func != NULL)
+		{
+			kop->get.func(value, len, kop->get.data);
+		}
+		else
+		{
+			*(kop->get.value) = value;
+			*(kop->get.value_len) = len;
+		}
 	}
 
-	it = j_list_iterator_new(operations);
-	kv_backend = j_kv_get_backend();
-
-	if (kv_backend != NULL)
+	if (j_list_length(misses) == 0)
 	{
-		ret = j_backend_kv_batch_start(kv_backend, namespace, semantics, &kv_batch);
-	}
-	else
-	{
-		/**
-		 * Force safe semantics to make the server send a reply.
-		 * Otherwise, nasty races can occur when using unsafe semantics:
-		 * - The client creates the item and sends its first write.
-		 * - The client sends another operation using another connection from the pool.
-		 * - The second operation is executed first and fails because the item does not exist.
-		 * This does not completely eliminate all races but fixes the common case of create, write, write, ...
-		 **/
-		message = j_message_new(J_MESSAGE_KV_GET, namespace_len);
-		j_message_set_semantics(message, semantics);
-		j_message_append_n(message, namespace, namespace_len);
+		return ret;
 	}
 
-	while (j_list_iterator_next(it))
+	groups = j_kv_group_operations(misses, j_kv_get_get_kv, semantics);
+	kv_backend = j_kv_get_backend();
+
+	for (guint i = 0; i < groups->len; i++)
 	{
-		JKVOperation* kop = j_list_iterator_get(it);
+		JKVGroup* group = g_ptr_array_index(groups, i);
+		g_autoptr(JListIterator) it = NULL;
+		gpointer kv_batch = NULL;
+		gsize namespace_len;
+
+		namespace_len = strlen(group->namespace) + 1;
+		it = j_list_iterator_new(group->operations);
 
 		if (kv_backend != NULL)
 		{
-			if (kop->get.func != NULL)
+			ret = j_backend_kv_batch_start(kv_backend, group->namespace, semantics, &kv_batch) && ret;
+		}
+		else
+		{
+			group->message = j_message_new(J_MESSAGE_KV_GET, namespace_len);
+			j_message_set_semantics(group->message, semantics);
+			j_message_append_n(group->message, group->namespace, namespace_len);
+		}
+
+		while (j_list_iterator_next(it))
+		{
+			JKVOperation* kop = j_list_iterator_get(it);
+
+			if (kv_backend != NULL)
 			{
 				gpointer value;
 				guint32 len;
+				gboolean found;
+
+				gpointer decoded = NULL;
+				guint32 decoded_len;
+
+				found = j_backend_kv_get(kv_backend, kv_batch, kop->get.kv->key, &value, &len);
+
+				// The get fails for corrupt values
+				if (found && !j_kv_compression_decode(group->namespace, value, len, &decoded, &decoded_len))
+				{
+					g_free(value);
+					found = FALSE;
+				}
 
-				ret = j_backend_kv_get(kv_backend, kv_batch, kop->get.kv->key, &value, &len) && ret;
+				ret = found && ret;
 
-				if (ret)
+				if (found)
 				{
+					if (decoded != NULL)
+					{
+						g_free(value);
+						value = decoded;
+						len = decoded_len;
+					}
+
+					j_kv_cache_put(group->namespace, kop->get.kv->key, value, len);
+
 					// j_backend_kv_get returns a new copy, pass it along
-					kop->get.func(value, len, kop->get.data);
+					if (kop->get.func != NULL)
+					{
+						kop->get.func(value, len, kop->get.data);
+					}
+					else
+					{
+						*(kop->get.value) = value;
+						*(kop->get.value_len) = len;
+					}
 				}
 			}
 			else
 			{
-				ret = j_backend_kv_get(kv_backend, kv_batch, kop->get.kv->key, kop->get.value, kop->get.value_len) && ret;
+				gsize key_len;
+
+				key_len = strlen(kop->get.kv->key) + 1;
+
+				j_message_add_operation(group->message, key_len);
+				j_message_append_n(group->message, kop->get.kv->key, key_len);
 			}
 		}
-		else
-		{
-			gsize key_len;
-
-			key_len = strlen(kop->get.kv->key) + 1;
 
-			j_message_add_operation(message, key_len);
-			j_message_append_n(message, kop->get.kv->key, key_len);
+		if (kv_backend != NULL)
+		{
+			ret = j_backend_kv_batch_execute(kv_backend, kv_batch) && ret;
 		}
 	}
 
-	if (kv_backend != NULL)
-	{
-		ret = j_backend_kv_batch_execute(kv_backend, kv_batch) && ret;
-	}
-	else
+	if (kv_backend == NULL)
 	{
-		g_autoptr(JListIterator) iter = NULL;
-		g_autoptr(JMessage) reply = NULL;
-		gpointer kv_connection;
-
-		kv_connection = j_connection_pool_pop(J_BACKEND_TYPE_KV, index);
-		j_message_send(message, kv_connection);
-
-		reply = j_message_new_reply(message);
-		j_message_receive(reply, kv_connection);
+		j_kv_send_groups(groups);
 
-		iter = j_list_iterator_new(operations);
-
-		while (j_list_iterator_next(iter))
+		/**
+		 * Replies are processed here instead of in the background operations.
+		 * This makes sure that callbacks are never run concurrently.
+		 **/
+		for (guint i = 0; i < groups->len; i++)
 		{
-			JKVOperation* kop = j_list_iterator_get(iter);
-			guint32 len;
+			JKVGroup* group = g_ptr_array_index(groups, i);
+			g_autoptr(JListIterator) it = NULL;
 
-			len = j_message_get_4(reply);
-			ret = (len > 0) && ret;
+			it = j_list_iterator_new(group->operations);
 
-			if (len > 0)
+			while (j_list_iterator_next(it))
 			{
-				gconstpointer data;
+				JKVOperation* kop = j_list_iterator_get(it);
+				guint32 len;
 
-				data = j_message_get_n(reply, len);
+				len = j_message_get_4(group->reply);
+				ret = (len > 0) && ret;
 
-				if (kop->get.func != NULL)
+				if (len > 0)
 				{
+					gconstpointer data;
 					gpointer value;
 
-					// data belongs to the message, create a copy for the callback
-					value = g_memdup(data, len);
-					kop->get.func(value, len, kop->get.data);
+					data = j_message_get_n(group->reply, len);
+
+					// The get fails for corrupt values
+					if (!j_kv_compression_decode(group->namespace, data, len, &value, &len))
+					{
+						ret = FALSE;
+						continue;
+					}
+
+					// data belongs to the message, create a copy for the caller
+					if (value == NULL)
+					{
+						value = g_memdup(data, len);
+					}
+
+					j_kv_cache_put(group->namespace, kop->get.kv->key, value, len);
+
+					if (kop->get.func != NULL)
+					{
+						kop->get.func(value, len, kop->get.data);
+					}
+					else
+					{
+						*(kop->get.value) = value;
+						*(kop->get.value_len) = len;
+					}
 				}
 				else
 				{
-					*(kop->get.value) = g_memdup(data, len);
-					*(kop->get.value_len) = len;
+					j_kv_cache_delete(group->namespace, kop->get.kv->key);
 				}
 			}
 		}
-
-		j_connection_pool_push(J_BACKEND_TYPE_KV, index, kv_connection);
 	}
 
 	return ret;
@@ -666,8 +1120,11 @@ j_kv_put(JKV* kv, gpointer value, guint32 value_len, GDestroyNotify value_destro
 	kop->put.value_destroy = value_destroy;
 
 	operation = j_operation_new();
-	// FIXME key = index + namespace
-	operation->key = kv;
+	/**
+	 * All KV operations share the same key.
+	 * j_kv_put_exec() groups them by server index and namespace.
+	 **/
+	operation->key = NULL;
 	operation->data = kop;
 	operation->exec_func = j_kv_put_exec;
 	operation->free_func = j_kv_put_free;
@@ -675,6 +1132,49 @@ j_kv_put(JKV* kv, gpointer value, guint32 value_len, GDestroyNotify value_destro
 	j_batch_add(batch, operation);
 }
 
+/**
+ * Creates a key-value pair as part of a bulk load.
+ *
+ * Bulk puts are sorted by key before being sent to the server.
+ * Backends that support it load them without going through their regular write path,
+ * which is considerably faster when importing large numbers of key-value pairs.
+ * Backends without bulk support store them like regular puts.
+ * If a key is put multiple times within the same batch, the last value wins.
+ *
+ * \code
+ * \endcode
+ *
+ * \param kv            A KV.
+ * \param value         A value.
+ * \param value_len     The value's length.
+ * \param value_destroy A function to free the value, or NULL.
+ * \param batch         A batch.
+ **/
+void
+j_kv_bulk_put(JKV* kv, gpointer value, guint32 value_len, GDestroyNotify value_destroy, JBatch* batch)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JKVOperation* kop;
+	JOperation* operation;
+
+	g_return_if_fail(kv != NULL);
+
+	kop = g_slice_new(JKVOperation);
+	kop->put.kv = j_kv_ref(kv);
+	kop->put.value = value;
+	kop->put.value_len = value_len;
+	kop->put.value_destroy = value_destroy;
+
+	operation = j_operation_new();
+	operation->key = NULL;
+	operation->data = kop;
+	operation->exec_func = j_kv_bulk_put_exec;
+	operation->free_func = j_kv_put_free;
+
+	j_batch_add(batch, operation);
+}
+
 /**
  * Deletes a key-value pair.
  *
@@ -694,7 +1194,7 @@ j_kv_delete(JKV* kv, JBatch* batch)
 	g_return_if_fail(kv != NULL);
 
 	operation = j_operation_new();
-	operation->key = kv;
+	operation->key = NULL;
 	operation->data = j_kv_ref(kv);
 	operation->exec_func = j_kv_delete_exec;
 	operation->free_func = j_kv_delete_free;
@@ -729,7 +1229,7 @@ j_kv_get(JKV* kv, gpointer* value, guint32* value_len, JBatch* batch)
 	kop->get.data = NULL;
 
 	operation = j_operation_new();
-	operation->key = kv;
+	operation->key = NULL;
 	operation->data = kop;
 	operation->exec_func = j_kv_get_exec;
 	operation->free_func = j_kv_get_free;
@@ -765,7 +1265,7 @@ j_kv_get_callback(JKV* kv, JKVGetFunc func, gpointer data, JBatch* batch)
 	kop->get.data = data;
 
 	operation = j_operation_new();
-	operation->key = kv;
+	operation->key = NULL;
 	operation->data = kop;
 	operation->exec_func = j_kv_get_exec;
 	operation->free_func = j_kv_get_free;
@@ -113,6 +113,12 @@ struct JChunkedTransformationObject
      **/
 	JTransformationMode transformation_mode;
 
+	/**
+	 * The compression level and dictionary used for all chunks.
+	 **/
+	gint32 transformation_level;
+	guint32 transformation_dictionary;
+
 	/**
      * KV Object which stores transformation metadata
      **/
@@ -127,6 +133,17 @@ struct JChunkedTransformationObject
      * Maximum original data size for each chunk
      **/
 	guint64 chunk_size;
+
+	/**
+	 * Whether the metadata is cached.
+	 * It is kept up to date by our own writes, other writers' changes are only seen by batches with J_SEMANTICS_CONSISTENCY_IMMEDIATE.
+	 **/
+	gboolean metadata_loaded;
+
+	/**
+	 * The handles of the chunks, they cache their own metadata.
+	 **/
+	GPtrArray* chunks;
 };
 
 /**
@@ -139,6 +156,12 @@ struct JChunkedTransformationObjectMetadata
 	gint32 transformation_mode;
 	guint64 chunk_count;
 	guint64 chunk_size;
+
+	/**
+	 * The compression level and dictionary, they are missing from the metadata of older objects.
+	 **/
+	gint32 transformation_level;
+	guint32 transformation_dictionary;
 };
 
 typedef struct JChunkedTransformationObjectMetadata JChunkedTransformationObjectMetadata;
@@ -199,55 +222,105 @@ j_chunked_transformation_object_write_free(gpointer data)
 	g_slice_free(JChunkedTransformationObjectOperation, operation);
 }
 
-static gboolean
-j_chunked_transformation_object_store_metadata(JChunkedTransformationObject* object, JSemantics* semantics)
+static void
+j_chunked_transformation_object_chunk_free(gpointer data)
+{
+	JTransformationObject* chunk_object = data;
+
+	// Handles are created lazily, so there may be gaps
+	if (chunk_object != NULL)
+	{
+		j_transformation_object_unref(chunk_object);
+	}
+}
+
+/**
+ * Stores the metadata with the given number of chunks.
+ * The cached chunk count is only updated once the batch has been executed successfully, so callers have to do this afterwards.
+ **/
+static void
+j_chunked_transformation_object_store_metadata(JChunkedTransformationObject* object, guint64 chunk_count, JBatch* batch)
 {
-	gboolean ret = false;
-	g_autoptr(JBatch) kv_batch = NULL;
 	JChunkedTransformationObjectMetadata* mdata = NULL;
 
-	kv_batch = j_batch_new(semantics);
 	mdata = g_new(JChunkedTransformationObjectMetadata, 1);
 
 	mdata->transformation_type = object->transformation_type;
 	mdata->transformation_mode = object->transformation_mode;
-	mdata->chunk_count = object->chunk_count;
+	mdata->chunk_count = chunk_count;
 	mdata->chunk_size = object->chunk_size;
+	mdata->transformation_level = object->transformation_level;
+	mdata->transformation_dictionary = object->transformation_dictionary;
 
-	j_kv_put(object->metadata, mdata, sizeof(JChunkedTransformationObjectMetadata), g_free, kv_batch);
-	ret = j_batch_execute(kv_batch);
-
-	return ret;
+	j_kv_put(object->metadata, mdata, sizeof(JChunkedTransformationObjectMetadata), g_free, batch);
 }
 
 static gboolean
-j_chunked_transformation_object_load_metadata(JChunkedTransformationObject* object)
+j_chunked_transformation_object_load_metadata(JChunkedTransformationObject* object, JSemantics* semantics)
 {
-	bool ret = false;
+	gboolean ret = FALSE;
+	g_autoptr(JBatch) kv_batch = NULL;
+	gpointer value = NULL;
+	guint32 len = 0;
 
-	g_autoptr(JKVIterator) kv_iter = NULL;
-	kv_iter = j_kv_iterator_new(object->namespace, object->name);
-	while (j_kv_iterator_next(kv_iter))
+	// Immediate consistency requires the current metadata, which might have been changed by other handles
+	if (object->metadata_loaded && j_semantics_get(semantics, J_SEMANTICS_CONSISTENCY) != J_SEMANTICS_CONSISTENCY_IMMEDIATE)
 	{
-		gchar const* key;
-		gconstpointer value;
-		guint32 len;
+		return TRUE;
+	}
 
-		key = j_kv_iterator_get(kv_iter, &value, &len);
+	kv_batch = j_batch_new(semantics);
+	j_kv_get(object->metadata, &value, &len, kv_batch);
+
+	if (j_batch_execute(kv_batch))
+	{
+		JChunkedTransformationObjectMetadata const* mdata = value;
 
-		if (g_strcmp0(key, object->name) == 0)
+		object->transformation_type = mdata->transformation_type;
+		object->transformation_mode = mdata->transformation_mode;
+		object->chunk_count = mdata->chunk_count;
+		object->chunk_size = mdata->chunk_size;
+		object->transformation_level = 0;
+		object->transformation_dictionary = 0;
+
+		if (len >= sizeof(JChunkedTransformationObjectMetadata))
 		{
-			JChunkedTransformationObjectMetadata const* mdata = (JChunkedTransformationObjectMetadata const*)value;
-			object->transformation_type = mdata->transformation_type;
-			object->transformation_mode = mdata->transformation_mode;
-			object->chunk_count = mdata->chunk_count;
-			object->chunk_size = mdata->chunk_size;
-			ret = true;
+			object->transformation_level = mdata->transformation_level;
+			object->transformation_dictionary = mdata->transformation_dictionary;
 		}
+
+		object->metadata_loaded = TRUE;
+		ret = TRUE;
+
+		g_free(value);
 	}
+
 	return ret;
 }
 
+/**
+ * Returns the handle of a chunk.
+ * Handles are kept for the object's lifetime, so that chunks do not have to load their metadata again.
+ **/
+static JTransformationObject*
+j_chunked_transformation_object_get_chunk(JChunkedTransformationObject* object, guint64 chunk_id)
+{
+	if (chunk_id >= object->chunks->len)
+	{
+		g_ptr_array_set_size(object->chunks, chunk_id + 1);
+	}
+
+	if (g_ptr_array_index(object->chunks, chunk_id) == NULL)
+	{
+		g_autofree gchar* chunk_name = NULL;
+
+		chunk_name = g_strdup_printf("%s_%" G_GUINT64_FORMAT, object->name, chunk_id);
+		g_ptr_array_index(object->chunks, chunk_id) = j_transformation_object_new(object->namespace, chunk_name);
+	}
+
+	return g_ptr_array_index(object->chunks, chunk_id);
+}
+
 static gboolean
 j_chunked_transformation_object_create_exec(JList* operations, JSemantics* semantics)
 {
@@ -267,25 +340,27 @@ j_chunked_transformation_object_create_exec(JList* operations, JSemantics* seman
 	{
 		JChunkedTransformationObject* object = j_list_iterator_get(it);
 		g_autoptr(JBatch) batch = NULL;
-		g_autoptr(JTransformationObject) transformation_object = NULL;
-		g_autofree gchar* chunk_name = NULL;
-		gboolean created = FALSE;
 
 		batch = j_batch_new(semantics);
 
-		chunk_name = g_strdup_printf("%s_%d", object->name, 0);
-		transformation_object = j_transformation_object_new(object->namespace, chunk_name);
+		// Handles of a previous incarnation of the object are stale
+		g_ptr_array_set_size(object->chunks, 0);
 
-		j_transformation_object_create(transformation_object, batch, object->transformation_type,
-					       object->transformation_mode);
+		j_transformation_object_create_ext(j_chunked_transformation_object_get_chunk(object, 0), batch,
+						   object->transformation_type, object->transformation_mode,
+						   object->transformation_level, object->transformation_dictionary);
 
-		created = j_batch_execute(batch);
+		// The metadata is stored together with the first chunk
+		j_chunked_transformation_object_store_metadata(object, 1, batch);
 
-		if (created)
+		object->metadata_loaded = j_batch_execute(batch);
+
+		if (object->metadata_loaded)
 		{
 			object->chunk_count = 1;
-			j_chunked_transformation_object_store_metadata(object, semantics);
 		}
+
+		ret = object->metadata_loaded && ret;
 	}
 
 	return ret;
@@ -310,33 +385,124 @@ j_chunked_transformation_object_delete_exec(JList* operations, JSemantics* seman
 	{
 		JChunkedTransformationObject* object = j_list_iterator_get(it);
 		g_autoptr(JBatch) batch = NULL;
-		g_autoptr(JBatch) kv_batch = NULL;
-		gboolean deleted = FALSE;
 
-		j_chunked_transformation_object_load_metadata(object);
+		j_chunked_transformation_object_load_metadata(object, semantics);
 
 		batch = j_batch_new(semantics);
 
 		for (guint64 i = 0; i < object->chunk_count; i++)
 		{
-			g_autofree gchar* chunk_name = g_strdup_printf("%s_%ld", object->name, i);
-			g_autoptr(JTransformationObject) chunk_object = j_transformation_object_new(
-				object->namespace, chunk_name);
-
-			j_transformation_object_delete(chunk_object, batch);
+			j_transformation_object_delete(j_chunked_transformation_object_get_chunk(object, i), batch);
 		}
 
-		deleted = j_batch_execute(batch);
+		// The metadata is deleted together with the chunks
+		j_kv_delete(object->metadata, batch);
+
+		ret = j_batch_execute(batch);
+
+		object->chunk_count = 0;
+		object->metadata_loaded = FALSE;
+		g_ptr_array_set_size(object->chunks, 0);
+	}
+
+	return ret;
+}
+
+/**
+ * The chunk operations executed by one worker.
+ **/
+struct JChunkedTransformationObjectBackgroundData
+{
+	JBatch* batch;
+	gboolean ret;
+};
+
+typedef struct JChunkedTransformationObjectBackgroundData JChunkedTransformationObjectBackgroundData;
 
-		if (deleted)
+static gpointer
+j_chunked_transformation_object_background_operation(gpointer data)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JChunkedTransformationObjectBackgroundData* background_data = data;
+
+	background_data->ret = j_batch_execute(background_data->batch);
+
+	return background_data;
+}
+
+/**
+ * Returns the number of workers for an access, one per chunk but at most one per processor.
+ **/
+static guint
+j_chunked_transformation_object_get_worker_count(guint64 length, guint64 offset, guint64 chunk_size)
+{
+	guint64 chunk_count;
+
+	if (length == 0)
+	{
+		return 1;
+	}
+
+	chunk_count = (offset + length - 1) / chunk_size - offset / chunk_size + 1;
+
+	return MIN(chunk_count, g_get_num_processors());
+}
+
+/**
+ * Returns the batch of the worker responsible for the given chunk.
+ * Chunks are assigned round-robin, so that consecutive chunks are transformed and transferred concurrently.
+ **/
+static JBatch*
+j_chunked_transformation_object_get_worker_batch(gpointer* workers, guint worker_count, guint64 counter, JSemantics* semantics)
+{
+	JChunkedTransformationObjectBackgroundData* background_data;
+	guint worker = counter % worker_count;
+
+	if (workers[worker] == NULL)
+	{
+		background_data = g_slice_new(JChunkedTransformationObjectBackgroundData);
+		background_data->batch = j_batch_new(semantics);
+		background_data->ret = FALSE;
+
+		workers[worker] = background_data;
+	}
+
+	background_data = workers[worker];
+
+	return background_data->batch;
+}
+
+/**
+ * Executes the workers' batches in parallel and frees the workers.
+ * Every worker transforms its chunks and sends them to their servers, overlapping transformation and network transfer.
+ **/
+static gboolean
+j_chunked_transformation_object_execute_workers(gpointer* workers, guint worker_count)
+{
+	gboolean ret = TRUE;
+	gboolean executed = FALSE;
+
+	j_helper_execute_parallel(j_chunked_transformation_object_background_operation, workers, worker_count);
+
+	for (guint i = 0; i < worker_count; i++)
+	{
+		JChunkedTransformationObjectBackgroundData* background_data = workers[i];
+
+		if (background_data == NULL)
 		{
-			kv_batch = j_batch_new(semantics);
-			j_kv_delete(object->metadata, kv_batch);
-			ret = j_batch_execute(kv_batch);
+			continue;
 		}
+
+		ret = background_data->ret && ret;
+		executed = TRUE;
+
+		j_batch_unref(background_data->batch);
+		g_slice_free(JChunkedTransformationObjectBackgroundData, background_data);
 	}
 
-	return ret;
+	// Like an empty batch, an access without chunks fails
+	return ret && executed;
 }
 
 static gboolean
@@ -363,22 +529,22 @@ j_chunked_transformation_object_read_exec(JList* operations, JSemantics* semanti
 		guint64 chunk_size;
 		guint64* local_bytes_read;
 		guint64 counter = 0;
-		g_autoptr(JBatch) batch = NULL;
+		g_autofree gpointer* workers = NULL;
+		guint worker_count;
 
-		j_chunked_transformation_object_load_metadata(object);
+		j_chunked_transformation_object_load_metadata(object, semantics);
 
 		chunk_size = object->chunk_size;
 		local_bytes_read = g_slice_alloc0(((length / chunk_size) + 2) * sizeof(guint64));
 
-		batch = j_batch_new(semantics);
+		worker_count = j_chunked_transformation_object_get_worker_count(length, offset, chunk_size);
+		workers = g_new0(gpointer, worker_count);
 
 		while (length > 0)
 		{
 			guint64 chunk_id = offset / chunk_size;
 			guint64 local_offset = offset % chunk_size;
 			guint64 local_length = chunk_size - local_offset;
-			g_autofree gchar* chunk_name = NULL;
-			g_autoptr(JTransformationObject) chunk_object = NULL;
 
 			if (local_length > length)
 			{
@@ -390,11 +556,9 @@ j_chunked_transformation_object_read_exec(JList* operations, JSemantics* semanti
 				break;
 			}
 
-			chunk_name = g_strdup_printf("%s_%ld", object->name, chunk_id);
-			chunk_object = j_transformation_object_new(object->namespace, chunk_name);
-
-			j_transformation_object_read(chunk_object, data, local_length, local_offset,
-						     &local_bytes_read[counter], batch);
+			j_transformation_object_read(j_chunked_transformation_object_get_chunk(object, chunk_id), data,
+						     local_length, local_offset, &local_bytes_read[counter],
+						     j_chunked_transformation_object_get_worker_batch(workers, worker_count, counter, semantics));
 
 			counter++;
 			data += local_length;
@@ -402,7 +566,7 @@ j_chunked_transformation_object_read_exec(JList* operations, JSemantics* semanti
 			offset += local_length;
 		}
 
-		ret = j_batch_execute(batch);
+		ret = j_chunked_transformation_object_execute_workers(workers, worker_count);
 
 		for (guint64 i = 0; i < counter; i++)
 		{
@@ -439,36 +603,44 @@ j_chunked_transformation_object_write_exec(JList* operations, JSemantics* semant
 		guint64 chunk_size;
 		guint64* local_bytes_written;
 		guint64 counter = 0;
-		g_autoptr(JBatch) batch = NULL;
-		g_autoptr(JTransformationObject) chunk_object = NULL;
+		g_autofree gpointer* workers = NULL;
+		guint worker_count;
+		guint64 chunk_count;
 
-		j_chunked_transformation_object_load_metadata(object);
+		j_chunked_transformation_object_load_metadata(object, semantics);
 
+		// The new chunk count is only cached once the chunks have been written
+		chunk_count = object->chunk_count;
 		chunk_size = object->chunk_size;
 		local_bytes_written = g_slice_alloc0(((length / chunk_size) + 2) * sizeof(guint64));
 
-		batch = j_batch_new(semantics);
+		worker_count = j_chunked_transformation_object_get_worker_count(length, offset, chunk_size);
+		workers = g_new0(gpointer, worker_count);
 
 		while (length > 0)
 		{
 			guint64 chunk_id = offset / chunk_size;
 			guint64 local_offset = offset % chunk_size;
 			guint64 local_length = chunk_size - local_offset;
-			g_autofree gchar* chunk_name = NULL;
+			JTransformationObject* chunk_object;
+			JBatch* batch;
 
 			if (local_length > length)
 			{
 				local_length = length;
 			}
 
-			chunk_name = g_strdup_printf("%s_%ld", object->name, chunk_id);
-			chunk_object = j_transformation_object_new(object->namespace, chunk_name);
+			chunk_object = j_chunked_transformation_object_get_chunk(object, chunk_id);
 
-			if (chunk_id > (object->chunk_count - 1))
+			// A new chunk is created by the worker that writes it
+			batch = j_chunked_transformation_object_get_worker_batch(workers, worker_count, counter, semantics);
+
+			if (chunk_id > (chunk_count - 1))
 			{
-				j_transformation_object_create(chunk_object, batch, object->transformation_type,
-							       object->transformation_mode);
-				object->chunk_count += 1;
+				j_transformation_object_create_ext(chunk_object, batch, object->transformation_type,
+								   object->transformation_mode, object->transformation_level,
+								   object->transformation_dictionary);
+				chunk_count += 1;
 			}
 
 			j_transformation_object_write(chunk_object, data, local_length,
@@ -480,16 +652,30 @@ j_chunked_transformation_object_write_exec(JList* operations, JSemantics* semant
 			offset += local_length;
 		}
 
-		ret = j_batch_execute(batch);
+		// New chunks are recorded by the worker that writes the last one, after its data
+		if (chunk_count != object->chunk_count)
+		{
+			j_chunked_transformation_object_store_metadata(object, chunk_count,
+								       j_chunked_transformation_object_get_worker_batch(workers, worker_count, counter - 1, semantics));
+		}
+
+		if (j_chunked_transformation_object_execute_workers(workers, worker_count))
+		{
+			object->chunk_count = chunk_count;
+		}
+		else
+		{
+			// Some chunks or the metadata might not have been stored, so the metadata has to be loaded again
+			object->metadata_loaded = FALSE;
+			ret = FALSE;
+		}
 
 		for (guint64 i = 0; i < counter; i++)
 		{
 			*(op->write.bytes_written) += local_bytes_written[i];
 		}
 
-		j_chunked_transformation_object_store_metadata(object, semantics);
-
-		g_slice_free1(((length / chunk_size) + 2) * sizeof(guint64), local_bytes_written);
+		g_slice_free1(((op->write.length / chunk_size) + 2) * sizeof(guint64), local_bytes_written);
 	}
 
 	return ret;
@@ -519,7 +705,7 @@ j_chunked_transformation_object_status_exec(JList* operations, JSemantics* seman
 		guint64* local_transformed_size = NULL;
 		g_autoptr(JBatch) batch = NULL;
 
-		j_chunked_transformation_object_load_metadata(object);
+		j_chunked_transformation_object_load_metadata(object, semantics);
 
 		local_mod_time = g_slice_alloc0(object->chunk_count * sizeof(gint64));
 		local_original_size = g_slice_alloc0(object->chunk_count * sizeof(guint64));
@@ -529,12 +715,8 @@ j_chunked_transformation_object_status_exec(JList* operations, JSemantics* seman
 
 		for (guint64 i = 0; i < object->chunk_count; i++)
 		{
-			g_autofree gchar* chunk_name = g_strdup_printf("%s_%ld", object->name, i);
-			g_autoptr(JTransformationObject) chunk_object = j_transformation_object_new(
-				object->namespace, chunk_name);
-
-			j_transformation_object_status_ext(chunk_object, &local_mod_time[i],
-							   &local_original_size[i], &local_transformed_size[i],
+			j_transformation_object_status_ext(j_chunked_transformation_object_get_chunk(object, i),
+							   &local_mod_time[i], &local_original_size[i], &local_transformed_size[i],
 							   op->status.transformation_type, batch);
 		}
 
@@ -613,6 +795,8 @@ j_chunked_transformation_object_new(gchar const* namespace, gchar const* name)
 	object->ref_count = 1;
 
 	object->metadata = j_kv_new(namespace, name);
+	object->metadata_loaded = FALSE;
+	object->chunks = g_ptr_array_new_with_free_func(j_chunked_transformation_object_chunk_free);
 
 	return object;
 }
@@ -653,6 +837,8 @@ j_chunked_transformation_object_new_for_index(guint32 index, gchar const* namesp
 	object->ref_count = 1;
 
 	object->metadata = j_kv_new(namespace, name);
+	object->metadata_loaded = FALSE;
+	object->chunks = g_ptr_array_new_with_free_func(j_chunked_transformation_object_chunk_free);
 
 	return object;
 }
@@ -704,6 +890,9 @@ j_chunked_transformation_object_unref(JChunkedTransformationObject* object)
 
 	if (g_atomic_int_dec_and_test(&(object->ref_count)))
 	{
+		g_ptr_array_unref(object->chunks);
+		j_kv_unref(object->metadata);
+
 		g_free(object->name);
 		g_free(object->namespace);
 
@@ -732,12 +921,36 @@ j_chunked_transformation_object_create(JChunkedTransformationObject* object, JBa
 {
 	J_TRACE_FUNCTION(NULL);
 
+	j_chunked_transformation_object_create_ext(object, batch, type, mode, chunk_size, 0, 0);
+}
+
+/**
+ * Creates an object with a compression level and dictionary.
+ *
+ * \code
+ * \endcode
+ *
+ * \param object A pointer to the created object
+ * \param batch A batch
+ * \param type The transformation type
+ * \param mode The transformation mode
+ * \param chunk_size The maximum chunk size for each chunk
+ * \param level The compression level, 0 selects the default level
+ * \param dictionary The ID returned by j_transformation_add_dictionary(), 0 disables dictionaries
+ **/
+void
+j_chunked_transformation_object_create_ext(JChunkedTransformationObject* object, JBatch* batch, JTransformationType type, JTransformationMode mode, guint64 chunk_size, gint32 level, guint32 dictionary)
+{
+	J_TRACE_FUNCTION(NULL);
+
 	JOperation* operation;
 
 	g_return_if_fail(object != NULL);
 
 	object->transformation_type = type;
 	object->transformation_mode = mode;
+	object->transformation_level = level;
+	object->transformation_dictionary = dictionary;
 	object->chunk_size = chunk_size;
 
 	operation = j_operation_new();
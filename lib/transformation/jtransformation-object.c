@@ -119,8 +119,74 @@ struct JTransformationObject
      * The size of the object in its transformed state
      **/
 	guint64 transformed_size;
+
+	/**
+	 * Whether the transformation and sizes are cached.
+	 * They are kept up to date by our own writes, other writers' changes are only seen by batches with J_SEMANTICS_CONSISTENCY_IMMEDIATE.
+	 **/
+	gboolean metadata_loaded;
+
+	/**
+	 * The size of the independently transformed blocks, 0 if the object is transformed as a whole.
+	 **/
+	guint64 block_size;
+
+	/**
+	 * The index of the transformed blocks.
+	 **/
+	GArray* blocks;
+
+	/**
+	 * The unused space of the transformed object left behind by moved blocks, sorted by offset.
+	 **/
+	GArray* free_extents;
+
+	/**
+	 * The segments of the block index that have been changed since it was stored.
+	 **/
+	GHashTable* dirty_segments;
+};
+
+/**
+ * The location of a transformed block within the object.
+ **/
+struct JTransformationObjectBlock
+{
+	guint64 offset;
+	guint64 length;
+
+	/**
+	 * The space reserved for the block, a rewritten block is stored in place if it fits.
+	 **/
+	guint64 capacity;
+};
+
+typedef struct JTransformationObjectBlock JTransformationObjectBlock;
+
+/**
+ * A contiguous part of the transformed object.
+ **/
+struct JTransformationObjectExtent
+{
+	guint64 offset;
+	guint64 length;
+};
+
+typedef struct JTransformationObjectExtent JTransformationObjectExtent;
+
+/**
+ * A range of the transformed object that is accessed without any transformation.
+ **/
+struct JTransformationObjectRange
+{
+	gpointer data;
+	guint64 length;
+	guint64 offset;
+	guint64 bytes;
 };
 
+typedef struct JTransformationObjectRange JTransformationObjectRange;
+
 /**
  * Metadata fields needed for object management. 
  * The metadata for each object will be in the kv-store
@@ -131,10 +197,28 @@ struct JTransformationObjectMetadata
 	gint32 transformation_mode;
 	guint64 original_size;
 	guint64 transformed_size;
+
+	/**
+	 * The compression level and dictionary, they are missing from the metadata of older objects.
+	 **/
+	gint32 transformation_level;
+	guint32 transformation_dictionary;
+
+	/**
+	 * The block size, it is missing from the metadata of older objects.
+	 * The block index is stored in segments, older objects store it after the block size.
+	 **/
+	guint64 block_size;
 };
 
 typedef struct JTransformationObjectMetadata JTransformationObjectMetadata;
 
+/**
+ * The number of blocks per segment of the block index.
+ * Every segment is a kv entry of its own, so writes only have to store the segments of the blocks they changed.
+ **/
+#define J_TRANSFORMATION_OBJECT_SEGMENT_BLOCKS 1024
+
 static JBackend* j_object_backend = NULL;
 static GModule* j_object_module = NULL;
 
@@ -254,6 +338,384 @@ j_transformation_object_write_free(gpointer data)
 	g_slice_free(JTransformationObjectOperation, operation);
 }
 
+static void
+j_transformation_object_set_transformation(JTransformationObject* object, JTransformationType type, JTransformationMode mode, gint32 level, guint32 dictionary)
+{
+	if (object->transformation != NULL)
+	{
+		j_transformation_unref(object->transformation);
+	}
+
+	object->transformation = j_transformation_new_ext(type, mode, level, dictionary);
+}
+
+static JKV*
+j_transformation_object_segment_new(JTransformationObject* object, guint64 segment)
+{
+	g_autofree gchar* key = NULL;
+
+	key = g_strdup_printf("%s/index/%" G_GUINT64_FORMAT, object->name, segment);
+
+	return j_kv_new(object->namespace, key);
+}
+
+static guint64
+j_transformation_object_segment_count(guint64 block_count)
+{
+	return (block_count + J_TRANSFORMATION_OBJECT_SEGMENT_BLOCKS - 1) / J_TRANSFORMATION_OBJECT_SEGMENT_BLOCKS;
+}
+
+/**
+ * Changes or appends an entry of the block index.
+ **/
+static void
+j_transformation_object_set_block(JTransformationObject* object, guint64 index, JTransformationObjectBlock const* block)
+{
+	g_return_if_fail(index <= object->blocks->len);
+
+	if (index < object->blocks->len)
+	{
+		g_array_index(object->blocks, JTransformationObjectBlock, index) = *block;
+	}
+	else
+	{
+		g_array_append_vals(object->blocks, block, 1);
+	}
+
+	g_hash_table_add(object->dirty_segments, GUINT_TO_POINTER(index / J_TRANSFORMATION_OBJECT_SEGMENT_BLOCKS));
+}
+
+static gint
+j_transformation_object_extent_compare(gconstpointer a, gconstpointer b)
+{
+	JTransformationObjectExtent const* extent_a = a;
+	JTransformationObjectExtent const* extent_b = b;
+
+	if (extent_a->offset < extent_b->offset)
+	{
+		return -1;
+	}
+
+	return (extent_a->offset > extent_b->offset) ? 1 : 0;
+}
+
+/**
+ * Finds the space of the transformed object that is not reserved by any block.
+ **/
+static void
+j_transformation_object_find_free_extents(JTransformationObject* object)
+{
+	g_autoptr(GArray) used = NULL;
+	guint64 end = 0;
+
+	g_array_set_size(object->free_extents, 0);
+	used = g_array_sized_new(FALSE, FALSE, sizeof(JTransformationObjectExtent), object->blocks->len);
+
+	for (guint i = 0; i < object->blocks->len; i++)
+	{
+		JTransformationObjectBlock const* block = &g_array_index(object->blocks, JTransformationObjectBlock, i);
+		JTransformationObjectExtent extent = { block->offset, block->capacity };
+
+		// Holes do not reserve any space
+		if (extent.length > 0)
+		{
+			g_array_append_val(used, extent);
+		}
+	}
+
+	g_array_sort(used, j_transformation_object_extent_compare);
+
+	for (guint i = 0; i < used->len; i++)
+	{
+		JTransformationObjectExtent const* extent = &g_array_index(used, JTransformationObjectExtent, i);
+
+		if (extent->offset > end)
+		{
+			JTransformationObjectExtent free_extent = { end, extent->offset - end };
+
+			g_array_append_val(object->free_extents, free_extent);
+		}
+
+		end = MAX(end, extent->offset + extent->length);
+	}
+
+	if (end < object->transformed_size)
+	{
+		JTransformationObjectExtent free_extent = { end, object->transformed_size - end };
+
+		g_array_append_val(object->free_extents, free_extent);
+	}
+}
+
+/**
+ * Marks space of the transformed object as unused, adjacent extents are merged.
+ **/
+static void
+j_transformation_object_release_extent(JTransformationObject* object, JTransformationObjectExtent const* extent)
+{
+	GArray* extents = object->free_extents;
+	guint i;
+
+	if (extent->length == 0)
+	{
+		return;
+	}
+
+	for (i = 0; i < extents->len && g_array_index(extents, JTransformationObjectExtent, i).offset < extent->offset; i++)
+	{
+	}
+
+	g_array_insert_vals(extents, i, extent, 1);
+
+	if (i + 1 < extents->len)
+	{
+		JTransformationObjectExtent* current = &g_array_index(extents, JTransformationObjectExtent, i);
+		JTransformationObjectExtent const* next = &g_array_index(extents, JTransformationObjectExtent, i + 1);
+
+		if (current->offset + current->length == next->offset)
+		{
+			current->length += next->length;
+			g_array_remove_index(extents, i + 1);
+		}
+	}
+
+	if (i > 0)
+	{
+		JTransformationObjectExtent* previous = &g_array_index(extents, JTransformationObjectExtent, i - 1);
+		JTransformationObjectExtent const* current = &g_array_index(extents, JTransformationObjectExtent, i);
+
+		if (previous->offset + previous->length == current->offset)
+		{
+			previous->length += current->length;
+			g_array_remove_index(extents, i);
+		}
+	}
+}
+
+/**
+ * Reserves space for a block, unused space of the transformed object is reused if possible.
+ *
+ * \return The offset of the reserved space.
+ **/
+static guint64
+j_transformation_object_allocate_extent(JTransformationObject* object, guint64 length)
+{
+	GArray* extents = object->free_extents;
+	guint64 offset;
+
+	// First fit keeps the blocks close to the beginning of the object
+	for (guint i = 0; i < extents->len; i++)
+	{
+		JTransformationObjectExtent* extent = &g_array_index(extents, JTransformationObjectExtent, i);
+
+		if (extent->length >= length)
+		{
+			offset = extent->offset;
+			extent->offset += length;
+			extent->length -= length;
+
+			if (extent->length == 0)
+			{
+				g_array_remove_index(extents, i);
+			}
+
+			return offset;
+		}
+	}
+
+	// Unused space at the end of the object is extended
+	if (extents->len > 0)
+	{
+		JTransformationObjectExtent const* last = &g_array_index(extents, JTransformationObjectExtent, extents->len - 1);
+
+		if (last->offset + last->length == object->transformed_size)
+		{
+			offset = last->offset;
+			object->transformed_size = offset + length;
+			g_array_remove_index(extents, extents->len - 1);
+
+			return offset;
+		}
+	}
+
+	offset = object->transformed_size;
+	object->transformed_size += length;
+
+	return offset;
+}
+
+/**
+ * Loads the segments of the block index.
+ * Every block up to the end of the object has an entry, including holes.
+ **/
+static gboolean
+j_transformation_object_load_index(JTransformationObject* object, JSemantics* semantics)
+{
+	g_autoptr(JBatch) kv_batch = NULL;
+	g_autoptr(GPtrArray) segments = NULL;
+	g_autofree gpointer* values = NULL;
+	g_autofree guint32* lengths = NULL;
+	guint64 block_count;
+	guint64 segment_count;
+	gboolean ret;
+
+	block_count = (object->original_size + object->block_size - 1) / object->block_size;
+	segment_count = j_transformation_object_segment_count(block_count);
+
+	if (segment_count == 0)
+	{
+		return TRUE;
+	}
+
+	kv_batch = j_batch_new(semantics);
+	segments = g_ptr_array_new_with_free_func((GDestroyNotify)j_kv_unref);
+	values = g_new0(gpointer, segment_count);
+	lengths = g_new0(guint32, segment_count);
+
+	// All segments are fetched at once
+	for (guint64 i = 0; i < segment_count; i++)
+	{
+		JKV* segment;
+
+		segment = j_transformation_object_segment_new(object, i);
+		j_kv_get(segment, &(values[i]), &(lengths[i]), kv_batch);
+		g_ptr_array_add(segments, segment);
+	}
+
+	ret = j_batch_execute(kv_batch);
+
+	for (guint64 i = 0; i < segment_count; i++)
+	{
+		if (ret)
+		{
+			g_array_append_vals(object->blocks, values[i], lengths[i] / sizeof(JTransformationObjectBlock));
+		}
+
+		g_free(values[i]);
+	}
+
+	return ret && object->blocks->len == block_count;
+}
+
+static gboolean
+j_transformation_object_load_metadata(JTransformationObject* object, JSemantics* semantics)
+{
+	gboolean ret = FALSE;
+	g_autoptr(JBatch) kv_batch = NULL;
+	gpointer value = NULL;
+	guint32 len = 0;
+
+	// Immediate consistency requires the current metadata, which might have been changed by other handles
+	if (object->metadata_loaded && j_semantics_get(semantics, J_SEMANTICS_CONSISTENCY) != J_SEMANTICS_CONSISTENCY_IMMEDIATE)
+	{
+		return TRUE;
+	}
+
+	kv_batch = j_batch_new(semantics);
+	j_kv_get(object->metadata, &value, &len, kv_batch);
+
+	if (j_batch_execute(kv_batch))
+	{
+		JTransformationObjectMetadata const* mdata = value;
+		gboolean has_level = (len >= G_STRUCT_OFFSET(JTransformationObjectMetadata, block_size));
+		gboolean has_blocks = (len >= sizeof(JTransformationObjectMetadata));
+
+		if (object->transformation == NULL)
+		{
+			j_transformation_object_set_transformation(object, mdata->transformation_type,
+								   mdata->transformation_mode,
+								   (has_level) ? mdata->transformation_level : 0,
+								   (has_level) ? mdata->transformation_dictionary : 0);
+		}
+
+		object->original_size = mdata->original_size;
+		object->transformed_size = mdata->transformed_size;
+		object->block_size = (has_blocks) ? mdata->block_size : 0;
+
+		g_array_set_size(object->blocks, 0);
+		g_hash_table_remove_all(object->dirty_segments);
+		ret = TRUE;
+
+		if (len > sizeof(JTransformationObjectMetadata))
+		{
+			// Older objects store the whole block index with the metadata, it is split into segments the next time it is stored
+			g_array_append_vals(object->blocks, mdata + 1, (len - sizeof(JTransformationObjectMetadata)) / sizeof(JTransformationObjectBlock));
+
+			for (guint64 i = 0; i < j_transformation_object_segment_count(object->blocks->len); i++)
+			{
+				g_hash_table_add(object->dirty_segments, GUINT_TO_POINTER(i));
+			}
+		}
+		else if (object->block_size > 0)
+		{
+			ret = j_transformation_object_load_index(object, semantics);
+		}
+
+		j_transformation_object_find_free_extents(object);
+
+		object->metadata_loaded = ret;
+
+		g_free(value);
+	}
+
+	return ret;
+}
+
+/**
+ * Stores the metadata and the changed segments of the block index.
+ * The cached metadata is only valid once the batch has been executed successfully, so callers have to update metadata_loaded afterwards.
+ **/
+static void
+j_transformation_object_store_metadata(JTransformationObject* object, JBatch* batch)
+{
+	JTransformationObjectMetadata* mdata = NULL;
+	GHashTableIter iter;
+	gpointer key;
+
+	mdata = g_new(JTransformationObjectMetadata, 1);
+
+	mdata->transformation_type = object->transformation->type;
+	mdata->transformation_mode = object->transformation->mode;
+	mdata->original_size = object->original_size;
+	mdata->transformed_size = object->transformed_size;
+	mdata->transformation_level = object->transformation->level;
+	mdata->transformation_dictionary = object->transformation->dictionary;
+	mdata->block_size = object->block_size;
+
+	j_kv_put(object->metadata, mdata, sizeof(JTransformationObjectMetadata), g_free, batch);
+
+	g_hash_table_iter_init(&iter, object->dirty_segments);
+
+	while (g_hash_table_iter_next(&iter, &key, NULL))
+	{
+		g_autoptr(JKV) segment = NULL;
+		guint64 first = (guint64)GPOINTER_TO_UINT(key) * J_TRANSFORMATION_OBJECT_SEGMENT_BLOCKS;
+		guint32 len;
+
+		segment = j_transformation_object_segment_new(object, GPOINTER_TO_UINT(key));
+		len = MIN(J_TRANSFORMATION_OBJECT_SEGMENT_BLOCKS, object->blocks->len - first) * sizeof(JTransformationObjectBlock);
+
+		j_kv_put(segment, g_memdup(&g_array_index(object->blocks, JTransformationObjectBlock, first), len), len, g_free, batch);
+	}
+
+	g_hash_table_remove_all(object->dirty_segments);
+}
+
+/**
+ * Deletes the segments of the block index.
+ **/
+static void
+j_transformation_object_delete_index(JTransformationObject* object, JBatch* batch)
+{
+	for (guint64 i = 0; i < j_transformation_object_segment_count(object->blocks->len); i++)
+	{
+		g_autoptr(JKV) segment = NULL;
+
+		segment = j_transformation_object_segment_new(object, i);
+		j_kv_delete(segment, batch);
+	}
+}
+
 static gboolean
 j_transformation_object_create_exec(JList* operations, JSemantics* semantics)
 {
@@ -263,11 +725,14 @@ j_transformation_object_create_exec(JList* operations, JSemantics* semantics)
 	gboolean ret = TRUE;
 
 	JBackend* object_backend;
+	g_autoptr(JBatch) kv_batch = NULL;
 	g_autoptr(JListIterator) it = NULL;
+	g_autoptr(JListIterator) stored_it = NULL;
 	g_autoptr(JMessage) message = NULL;
 	gchar const* namespace;
 	gsize namespace_len;
 	guint32 index;
+	gboolean stored;
 
 	g_return_val_if_fail(operations != NULL, FALSE);
 	g_return_val_if_fail(semantics != NULL, FALSE);
@@ -301,11 +766,11 @@ j_transformation_object_create_exec(JList* operations, JSemantics* semantics)
 		j_message_append_n(message, namespace, namespace_len);
 	}
 
+	kv_batch = j_batch_new(semantics);
+
 	while (j_list_iterator_next(it))
 	{
 		JTransformationObject* object = j_list_iterator_get(it);
-		JTransformationObjectMetadata* mdata = NULL;
-		g_autoptr(JBatch) kv_batch = NULL;
 
 		if (object_backend != NULL)
 		{
@@ -324,214 +789,767 @@ j_transformation_object_create_exec(JList* operations, JSemantics* semantics)
 			j_message_append_n(message, object->name, name_len);
 		}
 
-		kv_batch = j_batch_new(semantics);
+		j_transformation_object_store_metadata(object, kv_batch);
+	}
+
+	// Store the metadata of all objects at once
+	stored = j_batch_execute(kv_batch);
+	ret = stored && ret;
+
+	stored_it = j_list_iterator_new(operations);
+
+	while (j_list_iterator_next(stored_it))
+	{
+		JTransformationObject* object = j_list_iterator_get(stored_it);
+
+		object->metadata_loaded = stored;
+	}
+
+	if (object_backend == NULL)
+	{
+		JSemanticsSafety safety;
+
+		gpointer object_connection;
+
+		safety = j_semantics_get(semantics, J_SEMANTICS_SAFETY);
+		object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, index);
+		j_message_send(message, object_connection);
+
+		if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+		{
+			g_autoptr(JMessage) reply = NULL;
+
+			reply = j_message_new_reply(message);
+			j_message_receive(reply, object_connection);
+
+			/* FIXME do something with reply */
+		}
+
+		j_connection_pool_push(J_BACKEND_TYPE_OBJECT, index, object_connection);
+	}
+
+	return ret;
+}
+
+static gboolean
+j_transformation_object_delete_exec(JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	// FIXME check return value for messages
+	gboolean ret = TRUE;
+
+	JBackend* object_backend;
+	g_autoptr(JBatch) kv_batch = NULL;
+	g_autoptr(JListIterator) it = NULL;
+	g_autoptr(JMessage) message = NULL;
+	gchar const* namespace;
+	gsize namespace_len;
+	guint32 index;
+
+	g_return_val_if_fail(operations != NULL, FALSE);
+	g_return_val_if_fail(semantics != NULL, FALSE);
+
+	{
+		JTransformationObject* object;
+
+		object = j_list_get_first(operations);
+		g_assert(object != NULL);
+
+		namespace = object->namespace;
+		namespace_len = strlen(namespace) + 1;
+		index = object->index;
+	}
+
+	it = j_list_iterator_new(operations);
+	object_backend = j_object_get_backend();
+
+	if (object_backend == NULL)
+	{
+		message = j_message_new(J_MESSAGE_TRANSFORMATION_OBJECT_DELETE, namespace_len);
+		j_message_set_semantics(message, semantics);
+		j_message_append_n(message, namespace, namespace_len);
+	}
+
+	kv_batch = j_batch_new(semantics);
+
+	while (j_list_iterator_next(it))
+	{
+		JTransformationObject* object = j_list_iterator_get(it);
+
+		// The block index is stored in entries of its own, their number depends on the object's size
+		if (j_transformation_object_load_metadata(object, semantics))
+		{
+			j_transformation_object_delete_index(object, kv_batch);
+		}
+
+		// Delete the metadata entry in the kv-store
+		j_kv_delete(object->metadata, kv_batch);
+
+		object->original_size = 0;
+		object->transformed_size = 0;
+		object->metadata_loaded = FALSE;
+		g_array_set_size(object->blocks, 0);
+		g_array_set_size(object->free_extents, 0);
+		g_hash_table_remove_all(object->dirty_segments);
+
+		if (object_backend != NULL)
+		{
+			gpointer object_handle;
+
+			ret = j_backend_object_open(object_backend, object->namespace, object->name, &object_handle) && ret;
+			ret = j_backend_object_delete(object_backend, object_handle) && ret;
+		}
+		else
+		{
+			gsize name_len;
+
+			name_len = strlen(object->name) + 1;
+
+			j_message_add_operation(message, name_len);
+			j_message_append_n(message, object->name, name_len);
+		}
+	}
+
+	// Delete the metadata of all objects at once
+	ret = j_batch_execute(kv_batch) && ret;
+
+	if (object_backend == NULL)
+	{
+		JSemanticsSafety safety;
+
+		gpointer object_connection;
+
+		safety = j_semantics_get(semantics, J_SEMANTICS_SAFETY);
+		object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, index);
+		j_message_send(message, object_connection);
+
+		if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+		{
+			g_autoptr(JMessage) reply = NULL;
+
+			reply = j_message_new_reply(message);
+			j_message_receive(reply, object_connection);
+
+			/* FIXME do something with reply */
+		}
+
+		j_connection_pool_push(J_BACKEND_TYPE_OBJECT, index, object_connection);
+	}
+
+	return ret;
+}
+
+/**
+ * Reads ranges of the transformed object.
+ * The number of bytes read is stored in each range.
+ **/
+static gboolean
+j_transformation_object_read_ranges(JTransformationObject* object, JSemantics* semantics, JTransformationObjectRange* ranges, guint count)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	JBackend* object_backend;
+
+	if (count == 0)
+	{
+		return TRUE;
+	}
+
+	object_backend = j_object_get_backend();
+
+	if (object_backend != NULL)
+	{
+		gpointer object_handle;
+
+		if (!j_backend_object_open(object_backend, object->namespace, object->name, &object_handle))
+		{
+			return FALSE;
+		}
+
+		for (guint i = 0; i < count; i++)
+		{
+			ranges[i].bytes = 0;
+			ret = j_backend_object_read(object_backend, object_handle, ranges[i].data, ranges[i].length, ranges[i].offset, &(ranges[i].bytes)) && ret;
+		}
+
+		ret = j_backend_object_close(object_backend, object_handle) && ret;
+	}
+	else
+	{
+		g_autoptr(JMessage) message = NULL;
+		g_autoptr(JMessage) reply = NULL;
+		gpointer object_connection;
+		gsize name_len;
+		gsize namespace_len;
+		guint32 operations_done;
+		guint i;
+
+		namespace_len = strlen(object->namespace) + 1;
+		name_len = strlen(object->name) + 1;
+
+		message = j_message_new(J_MESSAGE_TRANSFORMATION_OBJECT_READ, namespace_len + name_len);
+		j_message_set_semantics(message, semantics);
+		j_message_append_n(message, object->namespace, namespace_len);
+		j_message_append_n(message, object->name, name_len);
+
+		for (i = 0; i < count; i++)
+		{
+			j_message_add_operation(message, sizeof(guint64) + sizeof(guint64)
+								 + sizeof(JTransformation) + sizeof(guint64) + sizeof(guint64));
+			j_message_append_8(message, &(ranges[i].length));
+			j_message_append_8(message, &(ranges[i].offset));
+			j_message_append_n(message, object->transformation, sizeof(JTransformation));
+			j_message_append_8(message, &object->original_size);
+			j_message_append_8(message, &object->transformed_size);
+		}
+
+		object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, object->index);
+		j_message_send(message, object_connection);
+
+		reply = j_message_new_reply(message);
+
+		operations_done = 0;
+		i = 0;
+
+		// The server might send multiple replies per message
+		while (operations_done < count)
+		{
+			guint32 reply_operation_count;
+
+			j_message_receive(reply, object_connection);
+
+			reply_operation_count = j_message_get_count(reply);
+
+			for (guint j = 0; j < reply_operation_count && i < count; i++, j++)
+			{
+				ranges[i].bytes = j_message_get_8(reply);
+
+				if (ranges[i].bytes > 0)
+				{
+					GInputStream* input;
+
+					input = g_io_stream_get_input_stream(G_IO_STREAM(object_connection));
+					g_input_stream_read_all(input, ranges[i].data, ranges[i].bytes, NULL, NULL, NULL);
+				}
+			}
+
+			operations_done += reply_operation_count;
+		}
+
+		j_connection_pool_push(J_BACKEND_TYPE_OBJECT, object->index, object_connection);
+	}
+
+	return ret;
+}
+
+/**
+ * Writes ranges of the transformed object.
+ * The number of bytes written is stored in each range.
+ **/
+static gboolean
+j_transformation_object_write_ranges(JTransformationObject* object, JSemantics* semantics, JTransformationObjectRange* ranges, guint count)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	JBackend* object_backend;
+
+	if (count == 0)
+	{
+		return TRUE;
+	}
+
+	object_backend = j_object_get_backend();
+
+	if (object_backend != NULL)
+	{
+		gpointer object_handle;
+
+		if (!j_backend_object_open(object_backend, object->namespace, object->name, &object_handle))
+		{
+			return FALSE;
+		}
+
+		for (guint i = 0; i < count; i++)
+		{
+			ranges[i].bytes = 0;
+			ret = j_backend_object_write(object_backend, object_handle, ranges[i].data, ranges[i].length, ranges[i].offset, &(ranges[i].bytes)) && ret;
+		}
+
+		ret = j_backend_object_close(object_backend, object_handle) && ret;
+	}
+	else
+	{
+		g_autoptr(JMessage) message = NULL;
+		JSemanticsSafety safety;
+		gpointer object_connection;
+		gsize name_len;
+		gsize namespace_len;
+
+		namespace_len = strlen(object->namespace) + 1;
+		name_len = strlen(object->name) + 1;
+
+		message = j_message_new(J_MESSAGE_TRANSFORMATION_OBJECT_WRITE, namespace_len + name_len);
+		j_message_set_semantics(message, semantics);
+		j_message_append_n(message, object->namespace, namespace_len);
+		j_message_append_n(message, object->name, name_len);
+
+		for (guint i = 0; i < count; i++)
+		{
+			j_message_add_operation(message, sizeof(guint64) + sizeof(guint64)
+								 + sizeof(JTransformation) + sizeof(guint64) + sizeof(guint64));
+			j_message_append_8(message, &(ranges[i].length));
+			j_message_append_8(message, &(ranges[i].offset));
+			j_message_append_n(message, object->transformation, sizeof(JTransformation));
+			j_message_append_8(message, &object->original_size);
+			j_message_append_8(message, &object->transformed_size);
+			j_message_add_send(message, ranges[i].data, ranges[i].length);
+
+			// Fake the number of bytes written if there is no reply
+			ranges[i].bytes = ranges[i].length;
+		}
+
+		safety = j_semantics_get(semantics, J_SEMANTICS_SAFETY);
+		object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, object->index);
+		j_message_send(message, object_connection);
+
+		if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+		{
+			g_autoptr(JMessage) reply = NULL;
+
+			reply = j_message_new_reply(message);
+			j_message_receive(reply, object_connection);
+
+			for (guint i = 0; i < count; i++)
+			{
+				ranges[i].bytes = j_message_get_8(reply);
+			}
+		}
+
+		j_connection_pool_push(J_BACKEND_TYPE_OBJECT, object->index, object_connection);
+	}
+
+	return ret;
+}
+
+/**
+ * Detransforms a block and copies the requested part of it.
+ * Fails if the block is corrupt.
+ **/
+static gboolean
+j_transformation_object_block_detransform(JTransformation* transformation, gpointer input, guint64 input_length, gchar* output, guint64 output_offset, guint64 output_length)
+{
+	gpointer buffer = output;
+	guint64 length = output_length;
+	guint64 offset = output_offset;
+
+	// Whole blocks are detransformed directly into the output, parts of blocks use an internal buffer
+	return j_transformation_apply(transformation, input, input_length, 0, &buffer, &length, &offset, J_TRANSFORMATION_CALLER_CLIENT_READ);
+}
+
+/**
+ * Detransforms a whole object and copies the part requested by a read operation.
+ * The read is limited to the object's size.
+ **/
+static gboolean
+j_transformation_object_whole_detransform(JTransformationObject* object, gpointer input, guint64 input_length, JTransformationObjectOperation* operation, guint64* bytes_read)
+{
+	guint64 length = operation->read.length;
+	guint64 offset = operation->read.offset;
+
+	length = (offset < object->original_size) ? MIN(length, object->original_size - offset) : 0;
+	*bytes_read = length;
+
+	if (length == 0)
+	{
+		return TRUE;
+	}
+
+	return j_transformation_object_block_detransform(object->transformation, input, input_length, operation->read.data, offset, length);
+}
+
+/**
+ * Reads from an object whose blocks are transformed independently.
+ * Only the blocks covering a read are fetched and detransformed.
+ **/
+static gboolean
+j_transformation_object_read_blocks_exec(JTransformationObject* object, JList* operations, JSemantics* semantics)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gboolean ret = TRUE;
+
+	g_autoptr(JListIterator) it = NULL;
+	guint64 block_size = object->block_size;
+
+	it = j_list_iterator_new(operations);
+
+	while (j_list_iterator_next(it))
+	{
+		JTransformationObjectOperation* operation = j_list_iterator_get(it);
+		gchar* data = operation->read.data;
+		guint64 length = operation->read.length;
+		guint64 offset = operation->read.offset;
+		guint64* bytes_read = operation->read.bytes_read;
+		g_autofree JTransformationObjectRange* ranges = NULL;
+		g_autofree gchar* transformed = NULL;
+		guint64 transformed_length = 0;
+		guint64 first;
+		guint count;
+		guint range_count = 0;
+
+		j_trace_file_begin(object->name, J_TRACE_FILE_READ);
+
+		// Only the existing part of the object can be read
+		length = (offset < object->original_size) ? MIN(length, object->original_size - offset) : 0;
+
+		if (length == 0)
+		{
+			j_trace_file_end(object->name, J_TRACE_FILE_READ, 0, offset);
+			continue;
+		}
+
+		first = offset / block_size;
+		count = (offset + length - 1) / block_size - first + 1;
+		g_assert(first + count <= object->blocks->len);
+
+		ranges = g_new(JTransformationObjectRange, count);
+
+		// All blocks are read into one buffer
+		for (guint i = 0; i < count; i++)
+		{
+			transformed_length += g_array_index(object->blocks, JTransformationObjectBlock, first + i).length;
+		}
+
+		transformed = g_malloc(transformed_length);
+		transformed_length = 0;
 
-		mdata = g_new(JTransformationObjectMetadata, 1);
-		mdata->transformation_type = object->transformation->type;
-		mdata->transformation_mode = object->transformation->mode;
-		mdata->original_size = object->original_size;
-		mdata->transformed_size = object->transformed_size;
+		for (guint i = 0; i < count; i++)
+		{
+			JTransformationObjectBlock* block = &g_array_index(object->blocks, JTransformationObjectBlock, first + i);
 
-		j_kv_put(object->metadata, mdata, sizeof(JTransformationObjectMetadata), g_free, kv_batch);
-		ret = j_batch_execute(kv_batch);
-	}
+			// Holes are not stored
+			if (block->length == 0)
+			{
+				continue;
+			}
 
-	if (object_backend == NULL)
-	{
-		JSemanticsSafety safety;
+			ranges[range_count].data = transformed + transformed_length;
+			ranges[range_count].length = block->length;
+			ranges[range_count].offset = block->offset;
+			ranges[range_count].bytes = 0;
+			range_count++;
 
-		gpointer object_connection;
+			transformed_length += block->length;
+		}
 
-		safety = j_semantics_get(semantics, J_SEMANTICS_SAFETY);
-		object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, index);
-		j_message_send(message, object_connection);
+		ret = j_transformation_object_read_ranges(object, semantics, ranges, range_count) && ret;
+		range_count = 0;
 
-		if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+		for (guint i = 0; i < count; i++)
 		{
-			g_autoptr(JMessage) reply = NULL;
+			JTransformationObjectBlock* block = &g_array_index(object->blocks, JTransformationObjectBlock, first + i);
+			JTransformationObjectRange* range;
+			guint64 block_offset = (first + i) * block_size;
+			guint64 block_length = MIN(block_size, object->original_size - block_offset);
+			guint64 part_offset = MAX(offset, block_offset);
+			guint64 part_length = MIN(offset + length, block_offset + block_length) - part_offset;
+
+			if (block->length == 0)
+			{
+				memset(data + (part_offset - offset), 0, part_length);
+				j_helper_atomic_add(bytes_read, part_length);
+				continue;
+			}
 
-			reply = j_message_new_reply(message);
-			j_message_receive(reply, object_connection);
+			range = &(ranges[range_count]);
+			range_count++;
 
-			/* FIXME do something with reply */
+			if (range->bytes == range->length
+			    && j_transformation_object_block_detransform(object->transformation, range->data, range->length,
+									 data + (part_offset - offset), part_offset - block_offset, part_length))
+			{
+				j_helper_atomic_add(bytes_read, part_length);
+			}
+			else
+			{
+				ret = FALSE;
+			}
 		}
 
-		j_connection_pool_push(J_BACKEND_TYPE_OBJECT, index, object_connection);
+		j_trace_file_end(object->name, J_TRACE_FILE_READ, length, offset);
 	}
 
 	return ret;
 }
 
+/**
+ * Writes to an object whose blocks are transformed independently.
+ * Only the blocks covering a write are rewritten, partially written blocks are read first.
+ * Rewritten blocks are stored in place if they fit into their space, otherwise they are moved to unused space or appended to the object.
+ * Writing beyond the end of the object leaves holes that are neither transformed nor stored.
+ **/
 static gboolean
-j_transformation_object_delete_exec(JList* operations, JSemantics* semantics)
+j_transformation_object_write_blocks_exec(JTransformationObject* object, JList* operations, JSemantics* semantics)
 {
 	J_TRACE_FUNCTION(NULL);
 
-	// FIXME check return value for messages
 	gboolean ret = TRUE;
 
-	JBackend* object_backend;
 	g_autoptr(JListIterator) it = NULL;
-	g_autoptr(JMessage) message = NULL;
-	gchar const* namespace;
-	gsize namespace_len;
-	guint32 index;
+	g_autoptr(JBatch) kv_batch = NULL;
+	g_autoptr(GArray) released = NULL;
+	guint64 block_size = object->block_size;
+	gboolean metadata_changed = FALSE;
 
-	g_return_val_if_fail(operations != NULL, FALSE);
-	g_return_val_if_fail(semantics != NULL, FALSE);
+	it = j_list_iterator_new(operations);
+	released = g_array_new(FALSE, FALSE, sizeof(JTransformationObjectExtent));
 
+	while (j_list_iterator_next(it))
 	{
-		JTransformationObject* object;
+		JTransformationObjectOperation* operation = j_list_iterator_get(it);
+		gchar const* data = operation->write.data;
+		guint64 length = operation->write.length;
+		guint64 offset = operation->write.offset;
+		guint64* bytes_written = operation->write.bytes_written;
+		g_autofree gchar const** inputs = NULL;
+		g_autofree gchar* partial = NULL;
+		g_autofree JTransformationObjectRange* old_ranges = NULL;
+		g_autofree gchar* old_data = NULL;
+		g_autofree guint* old_blocks = NULL;
+		g_autofree JTransformationObjectRange* new_ranges = NULL;
+		g_autofree gchar* new_data = NULL;
+		gboolean written = TRUE;
+		guint64 first;
+		guint64 new_size;
+		guint64 old_data_length = 0;
+		guint64 bound;
+		guint count;
+		guint partial_count = 0;
+		guint old_count = 0;
+		guint new_count = 0;
+
+		if (length == 0)
+		{
+			continue;
+		}
 
-		object = j_list_get_first(operations);
-		g_assert(object != NULL);
+		j_trace_file_begin(object->name, J_TRACE_FILE_WRITE);
 
-		namespace = object->namespace;
-		namespace_len = strlen(namespace) + 1;
-		index = object->index;
-	}
+		// Writing beyond the end of the object also covers its last block, which becomes larger, and the holes in between
+		new_size = MAX(object->original_size, offset + length);
+		first = MIN(offset, object->original_size) / block_size;
+		count = (offset + length - 1) / block_size - first + 1;
 
-	it = j_list_iterator_new(operations);
-	object_backend = j_object_get_backend();
+		inputs = g_new0(gchar const*, count);
+		old_ranges = g_new(JTransformationObjectRange, count);
+		old_blocks = g_new(guint, count);
+		new_ranges = g_new(JTransformationObjectRange, count);
 
-	if (object_backend == NULL)
-	{
-		message = j_message_new(J_MESSAGE_TRANSFORMATION_OBJECT_DELETE, namespace_len);
-		j_message_set_semantics(message, semantics);
-		j_message_append_n(message, namespace, namespace_len);
-	}
+		// Blocks that are only partially written need a buffer, all others are transformed from the caller's data directly
+		for (guint i = 0; i < count; i++)
+		{
+			guint64 block_offset = (first + i) * block_size;
+			guint64 block_end = MIN(block_offset + block_size, new_size);
 
-	while (j_list_iterator_next(it))
-	{
-		JTransformationObject* object = j_list_iterator_get(it);
+			if (block_offset >= object->original_size && block_end <= offset)
+			{
+				continue;
+			}
 
-		// Delete the metadata entry in the kv-store
-		g_autoptr(JBatch) kv_batch = NULL;
-		kv_batch = j_batch_new(semantics);
-		j_kv_delete(object->metadata, kv_batch);
-		ret = j_batch_execute(kv_batch);
+			if (offset > block_offset || offset + length < block_end)
+			{
+				partial_count++;
+			}
 
-		if (object_backend != NULL)
+			new_count++;
+		}
+
+		bound = j_transformation_get_bound(object->transformation, NULL, block_size, 0, J_TRANSFORMATION_CALLER_CLIENT_WRITE);
+		partial = g_malloc0(partial_count * block_size);
+		new_data = g_malloc(new_count * bound);
+		partial_count = 0;
+
+		for (guint i = 0; i < count; i++)
 		{
-			gpointer object_handle;
+			guint64 block_offset = (first + i) * block_size;
+			guint64 block_end = MIN(block_offset + block_size, new_size);
+			guint64 block_length = (block_offset < object->original_size) ? MIN(block_size, object->original_size - block_offset) : 0;
+			gchar* buffer;
 
-			ret = j_backend_object_open(object_backend, object->namespace, object->name, &object_handle) && ret;
-			ret = j_backend_object_delete(object_backend, object_handle) && ret;
+			if (block_offset >= object->original_size && block_end <= offset)
+			{
+				continue;
+			}
+
+			if (offset <= block_offset && offset + length >= block_end)
+			{
+				inputs[i] = data + (block_offset - offset);
+				continue;
+			}
+
+			buffer = partial + partial_count * block_size;
+			partial_count++;
+			inputs[i] = buffer;
+
+			// Partially written blocks that already contain data have to be read
+			if (block_length > 0 && g_array_index(object->blocks, JTransformationObjectBlock, first + i).length > 0)
+			{
+				JTransformationObjectBlock* block = &g_array_index(object->blocks, JTransformationObjectBlock, first + i);
+
+				old_ranges[old_count].data = buffer;
+				old_ranges[old_count].length = block->length;
+				old_ranges[old_count].offset = block->offset;
+				old_ranges[old_count].bytes = 0;
+				old_blocks[old_count] = i;
+				old_count++;
+
+				old_data_length += block->length;
+			}
 		}
-		else
+
+		old_data = g_malloc(old_data_length);
+		old_data_length = 0;
+
+		// The old versions are read into one buffer and detransformed into the blocks' buffers
+		for (guint i = 0; i < old_count; i++)
 		{
-			gsize name_len;
+			old_ranges[i].data = old_data + old_data_length;
+			old_data_length += old_ranges[i].length;
+		}
 
-			name_len = strlen(object->name) + 1;
+		written = j_transformation_object_read_ranges(object, semantics, old_ranges, old_count);
 
-			j_message_add_operation(message, name_len);
-			j_message_append_n(message, object->name, name_len);
+		for (guint i = 0; i < old_count; i++)
+		{
+			guint64 block_offset = (first + old_blocks[i]) * block_size;
+			guint64 old_length = MIN(block_size, object->original_size - block_offset);
+
+			if (old_ranges[i].bytes != old_ranges[i].length
+			    || !j_transformation_object_block_detransform(object->transformation, old_ranges[i].data, old_ranges[i].length,
+									  (gchar*)inputs[old_blocks[i]], 0, old_length))
+			{
+				written = FALSE;
+			}
 		}
-	}
 
-	if (object_backend == NULL)
-	{
-		JSemanticsSafety safety;
+		if (!written)
+		{
+			ret = FALSE;
 
-		gpointer object_connection;
+			j_trace_file_end(object->name, J_TRACE_FILE_WRITE, 0, offset);
+			continue;
+		}
 
-		safety = j_semantics_get(semantics, J_SEMANTICS_SAFETY);
-		object_connection = j_connection_pool_pop(J_BACKEND_TYPE_OBJECT, index);
-		j_message_send(message, object_connection);
+		new_count = 0;
 
-		if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+		for (guint i = 0; i < count; i++)
 		{
-			g_autoptr(JMessage) reply = NULL;
+			JTransformationObjectBlock new_block = { 0, 0, 0 };
+			JTransformationObjectBlock const* old_block = NULL;
+			guint64 block_offset = (first + i) * block_size;
+			guint64 block_length = MIN(block_size, new_size - block_offset);
+			gpointer transformed_data = new_data + new_count * bound;
+			guint64 transformed_length = bound;
+
+			if (first + i < object->blocks->len)
+			{
+				old_block = &g_array_index(object->blocks, JTransformationObjectBlock, first + i);
+			}
 
-			reply = j_message_new_reply(message);
-			j_message_receive(reply, object_connection);
+			if (inputs[i] == NULL)
+			{
+				j_transformation_object_set_block(object, first + i, &new_block);
+				continue;
+			}
 
-			/* FIXME do something with reply */
-		}
+			// Partially written blocks contain the old data by now
+			if (offset > block_offset || offset + length < block_offset + block_length)
+			{
+				guint64 part_offset = MAX(offset, block_offset);
+				guint64 part_length = MIN(offset + length, block_offset + block_length) - part_offset;
 
-		j_connection_pool_push(J_BACKEND_TYPE_OBJECT, index, object_connection);
-	}
+				memcpy((gchar*)inputs[i] + (part_offset - block_offset), data + (part_offset - offset), part_length);
+			}
 
-	return ret;
-}
+			j_transformation_apply_into(object->transformation, inputs[i], block_length,
+						    transformed_data, &transformed_length, J_TRANSFORMATION_CALLER_CLIENT_WRITE);
 
-static void
-j_transformation_object_set_transformation(JTransformationObject* object, JTransformationType type, JTransformationMode mode)
-{
-	object->transformation = j_transformation_new(type, mode);
-}
+			new_block.length = transformed_length;
 
-static bool
-j_transformation_object_load_transformation(JTransformationObject* object)
-{
-	bool ret = false;
+			if (old_block != NULL && transformed_length <= old_block->capacity)
+			{
+				new_block.offset = old_block->offset;
+				new_block.capacity = old_block->capacity;
+			}
+			else
+			{
+				if (old_block != NULL)
+				{
+					JTransformationObjectExtent extent = { old_block->offset, old_block->capacity };
 
-	g_autoptr(JKVIterator) kv_iter = NULL;
-	kv_iter = j_kv_iterator_new(object->namespace, object->name);
-	while (j_kv_iterator_next(kv_iter))
-	{
-		gchar const* key;
-		gconstpointer value;
-		guint32 len;
+					// The old version might still be referenced by the stored index until the new one has been stored
+					g_array_append_val(released, extent);
+				}
 
-		key = j_kv_iterator_get(kv_iter, &value, &len);
+				new_block.offset = j_transformation_object_allocate_extent(object, transformed_length);
+				new_block.capacity = transformed_length;
+			}
 
-		if (g_strcmp0(key, object->name) == 0)
-		{
-			JTransformationObjectMetadata const* mdata = (JTransformationObjectMetadata const*)value;
-			j_transformation_object_set_transformation(object, mdata->transformation_type,
-								   mdata->transformation_mode);
-			object->original_size = mdata->original_size;
-			object->transformed_size = mdata->transformed_size;
-			ret = true;
+			j_transformation_object_set_block(object, first + i, &new_block);
+
+			new_ranges[new_count].data = transformed_data;
+			new_ranges[new_count].length = new_block.length;
+			new_ranges[new_count].offset = new_block.offset;
+			new_ranges[new_count].bytes = 0;
+			new_count++;
 		}
-	}
-	return ret;
-}
 
-static bool
-j_transformation_object_load_object_size(JTransformationObject* object)
-{
-	bool ret = false;
+		object->original_size = new_size;
+		metadata_changed = TRUE;
 
-	g_autoptr(JKVIterator) kv_iter = NULL;
-	kv_iter = j_kv_iterator_new(object->namespace, object->name);
-	while (j_kv_iterator_next(kv_iter))
-	{
-		gchar const* key;
-		gconstpointer value;
-		guint32 len;
+		written = j_transformation_object_write_ranges(object, semantics, new_ranges, new_count);
 
-		key = j_kv_iterator_get(kv_iter, &value, &len);
+		for (guint i = 0; i < new_count; i++)
+		{
+			written = written && (new_ranges[i].bytes == new_ranges[i].length);
+		}
 
-		if (g_strcmp0(key, object->name) == 0)
+		if (written)
 		{
-			JTransformationObjectMetadata const* mdata = (JTransformationObjectMetadata const*)value;
-			object->original_size = mdata->original_size;
-			object->transformed_size = mdata->transformed_size;
-			ret = true;
+			j_helper_atomic_add(bytes_written, length);
 		}
-	}
-	return ret;
-}
 
-static gboolean
-j_transformation_object_update_stored_metadata(JTransformationObject* object, JSemantics* semantics)
-{
-	gboolean ret = FALSE;
-	g_autoptr(JBatch) kv_batch = NULL;
-	JTransformationObjectMetadata* mdata = NULL;
+		ret = written && ret;
 
-	kv_batch = j_batch_new(semantics);
-	mdata = g_new(JTransformationObjectMetadata, 1);
+		j_trace_file_end(object->name, J_TRACE_FILE_WRITE, length, offset);
+	}
 
-	mdata->transformation_type = object->transformation->type;
-	mdata->transformation_mode = object->transformation->mode;
-	mdata->original_size = object->original_size;
-	mdata->transformed_size = object->transformed_size;
+	// Store the new sizes and the changed parts of the block index once for all operations
+	if (metadata_changed)
+	{
+		kv_batch = j_batch_new(semantics);
+		j_transformation_object_store_metadata(object, kv_batch);
 
-	j_kv_put(object->metadata, mdata, sizeof(JTransformationObjectMetadata), g_free, kv_batch);
-	ret = j_batch_execute(kv_batch);
+		object->metadata_loaded = j_batch_execute(kv_batch);
+
+		if (object->metadata_loaded)
+		{
+			// The space of the blocks' old versions can only be reused once they are not referenced anymore
+			for (guint i = 0; i < released->len; i++)
+			{
+				j_transformation_object_release_extent(object, &g_array_index(released, JTransformationObjectExtent, i));
+			}
+		}
+		else
+		{
+			ret = FALSE;
+		}
+	}
 
 	return ret;
 }
@@ -565,14 +1583,14 @@ j_transformation_object_read_exec(JList* operations, JSemantics* semantics)
 		g_assert(operation != NULL);
 		g_assert(object != NULL);
 
+		j_transformation_object_load_metadata(object, semantics);
 		transformation = object->transformation;
+		g_assert(transformation != NULL);
+	}
 
-		if (transformation == NULL)
-		{
-			j_transformation_object_load_transformation(object);
-			transformation = object->transformation;
-			g_assert(transformation != NULL);
-		}
+	if (object->block_size > 0)
+	{
+		return j_transformation_object_read_blocks_exec(object, operations, semantics);
 	}
 
 	it = j_list_iterator_new(operations);
@@ -613,8 +1631,6 @@ j_transformation_object_read_exec(JList* operations, JSemantics* semantics)
 			guint64 offset;
 			guint64* bytes_read;
 
-			j_transformation_object_load_object_size(object);
-
 			operation = j_list_iterator_get(it);
 			transformed_length = object->transformed_size;
 			offset = 0;
@@ -625,28 +1641,25 @@ j_transformation_object_read_exec(JList* operations, JSemantics* semantics)
 			if (object_backend != NULL)
 			{
 				guint64 nbytes = 0;
-				gpointer whole_data_buf = NULL;
-				guint64 data_size = object->transformed_size;
+				guint64 read_length;
                 transformed_data = malloc(object->transformed_size);
 
 				ret = j_backend_object_read(object_backend, object_handle, transformed_data,
 							    transformed_length, offset, &nbytes)
 				      && ret;
-                
 
-                //TODO wip
-				j_transformation_apply(transformation, transformed_data, transformed_length,
-						       offset, &whole_data_buf, &data_size, &offset,
-						       J_TRANSFORMATION_CALLER_CLIENT_READ);
-				memcpy(operation->read.data, ((char*)whole_data_buf) + operation->read.offset,
-				       operation->read.length);
-
-                // Add the number of read bytes that will be returned to the user
-                j_helper_atomic_add(bytes_read, operation->read.length);
+				// Only the requested part of the object is copied into the user's buffer
+				if (j_transformation_object_whole_detransform(object, transformed_data, transformed_length, operation, &read_length))
+				{
+					// Add the number of read bytes that will be returned to the user
+					j_helper_atomic_add(bytes_read, read_length);
+				}
+				else
+				{
+					ret = FALSE;
+				}
 
 				free(transformed_data);
-				j_transformation_cleanup(transformation, whole_data_buf, data_size, offset,
-							 J_TRANSFORMATION_CALLER_CLIENT_READ);
 			}
 			else
 			{
@@ -702,16 +1715,12 @@ j_transformation_object_read_exec(JList* operations, JSemantics* semantics)
 				{
 					JTransformationObjectOperation* operation;
 					guint64 transformed_length;
-					guint64 offset;
 					guint64 nbytes;
 					guint64* bytes_read;
 					gpointer transformed_data;
 
-					j_transformation_object_load_object_size(object);
-
 					operation = j_list_iterator_get(it);
 					transformed_length = object->transformed_size;
-					offset = 0;
 					bytes_read = operation->read.bytes_read;
 					transformed_data = malloc(object->transformed_size);
 
@@ -720,24 +1729,24 @@ j_transformation_object_read_exec(JList* operations, JSemantics* semantics)
 					if (nbytes > 0)
 					{
 						GInputStream* input;
-						gpointer whole_data_buf = NULL;
-						guint64 data_size = object->original_size;
+						guint64 read_length;
 
 						input = g_io_stream_get_input_stream(G_IO_STREAM(object_connection));
 						g_input_stream_read_all(input, transformed_data, nbytes, NULL, NULL, NULL);
 
-						j_transformation_apply(transformation, transformed_data,
-                                transformed_length, offset, &whole_data_buf, &data_size,
-                                &offset, J_TRANSFORMATION_CALLER_CLIENT_READ);
-						memcpy(operation->read.data, ((char*)whole_data_buf) + operation->read.offset, operation->read.length);
-
-                        // Add the number of read bytes that will be returned to the user
-                        j_helper_atomic_add(bytes_read, operation->read.length);
-
-						free(transformed_data);
-						j_transformation_cleanup(transformation, whole_data_buf, data_size, offset,
-									 J_TRANSFORMATION_CALLER_CLIENT_READ);
+						// Only the requested part of the object is copied into the user's buffer
+						if (j_transformation_object_whole_detransform(object, transformed_data, transformed_length, operation, &read_length))
+						{
+							// Add the number of read bytes that will be returned to the user
+							j_helper_atomic_add(bytes_read, read_length);
+						}
+						else
+						{
+							ret = FALSE;
+						}
 					}
+
+					free(transformed_data);
 				}
 
 				operations_done += reply_operation_count;
@@ -980,6 +1989,7 @@ j_transformation_object_write_exec(JList* operations, JSemantics* semantics)
 	JTransformationObject* object;
 	JTransformation* transformation;
 	gpointer object_handle;
+	gboolean metadata_changed = FALSE;
 
 	// FIXME
 	//JLock* lock = NULL;
@@ -991,17 +2001,18 @@ j_transformation_object_write_exec(JList* operations, JSemantics* semantics)
 		JTransformationObjectOperation* operation = j_list_get_first(operations);
 
 		object = operation->write.object;
-		transformation = object->transformation;
 
 		g_assert(operation != NULL);
 		g_assert(object != NULL);
 
-		if (transformation == NULL)
-		{
-			j_transformation_object_load_transformation(object);
-			transformation = object->transformation;
-			g_assert(transformation != NULL);
-		}
+		j_transformation_object_load_metadata(object, semantics);
+		transformation = object->transformation;
+		g_assert(transformation != NULL);
+	}
+
+	if (object->block_size > 0)
+	{
+		return j_transformation_object_write_blocks_exec(object, operations, semantics);
 	}
 
 	it = j_list_iterator_new(operations);
@@ -1048,8 +2059,6 @@ j_transformation_object_write_exec(JList* operations, JSemantics* semantics)
 			gpointer whole_data_buf = NULL;
 			gpointer transformed_data = NULL;
 
-			j_transformation_object_load_object_size(object);
-
 			//If the object is not empty we need to read all of the transformed data
 			if (object->original_size != 0)
 			{
@@ -1105,8 +2114,9 @@ j_transformation_object_write_exec(JList* operations, JSemantics* semantics)
 			// Store a pointer to the newly created buffer from jtransformation_apply in the operation
 			// so that it can be freed in _write_free
 			operation->write.data = transformed_data;
+			operation->write.length = data_size;
 			object->transformed_size = data_size;
-			j_transformation_object_update_stored_metadata(object, semantics);
+			metadata_changed = TRUE;
 
 			if (object_backend != NULL)
 			{
@@ -1116,7 +2126,6 @@ j_transformation_object_write_exec(JList* operations, JSemantics* semantics)
 							     off, &nbytes)
 				      && ret;
 				j_helper_atomic_add(bytes_written, nbytes);
-                g_slice_free1(data_size, transformed_data);
 			}
 			else
 			{
@@ -1235,12 +2244,11 @@ j_transformation_object_write_exec(JList* operations, JSemantics* semantics)
 			}
 
 			// If neccessary update original_size and transformed_size
-			j_transformation_object_load_object_size(object);
 			if (offset + length > object->original_size)
 			{
 				object->original_size = offset + length;
 				object->transformed_size = offset + length;
-				j_transformation_object_update_stored_metadata(object, semantics);
+				metadata_changed = TRUE;
 			}
 
 			j_trace_file_end(object->name, J_TRACE_FILE_WRITE, length, offset);
@@ -1297,8 +2305,6 @@ j_transformation_object_write_exec(JList* operations, JSemantics* semantics)
 			guint64 offset = operation->write.offset;
 			guint64* bytes_written = operation->write.bytes_written;
 
-			j_transformation_object_load_object_size(object);
-
 			j_trace_file_begin(object->name, J_TRACE_FILE_WRITE);
 
 			/*
@@ -1315,7 +2321,7 @@ j_transformation_object_write_exec(JList* operations, JSemantics* semantics)
 				ret = j_backend_transformation_object_write(object_backend, object_handle, data, length, offset, &nbytes, transformation, &object->original_size, &object->transformed_size) && ret;
 				j_helper_atomic_add(bytes_written, nbytes);
 
-				j_transformation_object_update_stored_metadata(object, semantics);
+				metadata_changed = TRUE;
 			}
 			else
 			{
@@ -1374,7 +2380,7 @@ j_transformation_object_write_exec(JList* operations, JSemantics* semantics)
 
 					object->original_size = j_message_get_8(reply);
 					object->transformed_size = j_message_get_8(reply);
-					j_transformation_object_update_stored_metadata(object, semantics);
+					metadata_changed = TRUE;
 				}
 
 				j_list_iterator_free(it);
@@ -1394,6 +2400,19 @@ j_transformation_object_write_exec(JList* operations, JSemantics* semantics)
 	}
 	*/
 
+	// Store the new sizes once for all operations
+	if (metadata_changed)
+	{
+		g_autoptr(JBatch) kv_batch = NULL;
+
+		kv_batch = j_batch_new(semantics);
+		j_transformation_object_store_metadata(object, kv_batch);
+
+		// The cached sizes are reloaded if they could not be stored
+		object->metadata_loaded = j_batch_execute(kv_batch);
+		ret = object->metadata_loaded && ret;
+	}
+
 	return ret;
 }
 
@@ -1490,7 +2509,7 @@ j_transformation_object_status_exec(JList* operations, JSemantics* semantics)
 			modification_time_ = j_message_get_8(reply);
 
 			// Update the object from the kv-store metadata
-			j_transformation_object_load_transformation(operation->status.object);
+			j_transformation_object_load_metadata(operation->status.object, semantics);
 
 			if (modification_time != NULL)
 			{
@@ -1558,6 +2577,11 @@ j_transformation_object_new(gchar const* namespace, gchar const* name)
 	object->original_size = 0;
 	object->transformed_size = 0;
 	object->transformation = NULL;
+	object->metadata_loaded = FALSE;
+	object->block_size = 0;
+	object->blocks = g_array_new(FALSE, FALSE, sizeof(JTransformationObjectBlock));
+	object->free_extents = g_array_new(FALSE, FALSE, sizeof(JTransformationObjectExtent));
+	object->dirty_segments = g_hash_table_new(NULL, NULL);
 
 	return object;
 }
@@ -1597,6 +2621,12 @@ j_transformation_object_new_for_index(guint32 index, gchar const* namespace, gch
 	object->metadata = j_kv_new(namespace, name);
 	object->original_size = 0;
 	object->transformed_size = 0;
+	object->transformation = NULL;
+	object->metadata_loaded = FALSE;
+	object->block_size = 0;
+	object->blocks = g_array_new(FALSE, FALSE, sizeof(JTransformationObjectBlock));
+	object->free_extents = g_array_new(FALSE, FALSE, sizeof(JTransformationObjectExtent));
+	object->dirty_segments = g_hash_table_new(NULL, NULL);
 
 	return object;
 }
@@ -1648,6 +2678,16 @@ j_transformation_object_unref(JTransformationObject* object)
 
 	if (g_atomic_int_dec_and_test(&(object->ref_count)))
 	{
+		if (object->transformation != NULL)
+		{
+			j_transformation_unref(object->transformation);
+		}
+
+		j_kv_unref(object->metadata);
+		g_array_unref(object->blocks);
+		g_array_unref(object->free_extents);
+		g_hash_table_unref(object->dirty_segments);
+
 		g_free(object->name);
 		g_free(object->namespace);
 
@@ -1675,13 +2715,75 @@ j_transformation_object_create(JTransformationObject* object, JBatch* batch, JTr
 {
 	J_TRACE_FUNCTION(NULL);
 
+	j_transformation_object_create_ext(object, batch, type, mode, 0, 0);
+}
+
+/**
+ * Creates an object with a compression level and dictionary.
+ *
+ * \code
+ * \endcode
+ *
+ * \param object A pointer to the created object
+ * \param batch A batch
+ * \param type The transformation type
+ * \param mode The transformation mode
+ * \param level The compression level, 0 selects the default level
+ * \param dictionary The ID returned by j_transformation_add_dictionary(), 0 disables dictionaries
+ **/
+void
+j_transformation_object_create_ext(JTransformationObject* object, JBatch* batch, JTransformationType type, JTransformationMode mode, gint32 level, guint32 dictionary)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	j_transformation_object_create_indexed(object, batch, type, mode, level, dictionary, 0);
+}
+
+/**
+ * Creates an object whose data is transformed in independent blocks.
+ * The blocks' locations are stored in an index, so reads and writes only have to access the blocks they cover.
+ * This allows random access to compressed objects.
+ *
+ * Blocks are only used for transformations that do not support partial access in J_TRANSFORMATION_MODE_CLIENT.
+ *
+ * \code
+ * \endcode
+ *
+ * \param object A pointer to the created object
+ * \param batch A batch
+ * \param type The transformation type
+ * \param mode The transformation mode
+ * \param level The compression level, 0 selects the default level
+ * \param dictionary The ID returned by j_transformation_add_dictionary(), 0 disables dictionaries
+ * \param block_size The size of the untransformed blocks, 0 transforms the object as a whole
+ **/
+void
+j_transformation_object_create_indexed(JTransformationObject* object, JBatch* batch, JTransformationType type, JTransformationMode mode, gint32 level, guint32 dictionary, guint64 block_size)
+{
+	J_TRACE_FUNCTION(NULL);
+
 	JOperation* operation;
 
 	g_return_if_fail(object != NULL);
 
 	object->original_size = 0;
 	object->transformed_size = 0;
-	j_transformation_object_set_transformation(object, type, mode);
+	j_transformation_object_set_transformation(object, type, mode, level, dictionary);
+
+	if (block_size > 0 && (mode != J_TRANSFORMATION_MODE_CLIENT || !j_transformation_need_whole_object(object->transformation, J_TRANSFORMATION_CALLER_CLIENT_WRITE)))
+	{
+		if (mode != J_TRANSFORMATION_MODE_CLIENT)
+		{
+			g_warning("Blocks are only supported with J_TRANSFORMATION_MODE_CLIENT, object is transformed as a whole");
+		}
+
+		block_size = 0;
+	}
+
+	object->block_size = block_size;
+	g_array_set_size(object->blocks, 0);
+	g_array_set_size(object->free_extents, 0);
+	g_hash_table_remove_all(object->dirty_segments);
 
 	operation = j_operation_new();
 	// FIXME key = index + namespace
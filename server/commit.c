@@ -0,0 +1,321 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2020 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <julea.h>
+
+#include "server.h"
+
+/**
+ * A durable KV put or delete message waiting to be committed.
+ * Keys and values point into the message, which is kept alive by the waiting thread.
+ **/
+struct JdKVCommitRequest
+{
+	JMessageType type;
+	gchar const* namespace;
+	JSemantics* semantics;
+
+	guint32 count;
+	gchar const** keys;
+	gconstpointer* values;
+	guint32* lens;
+	gboolean* results;
+
+	gboolean done;
+};
+
+typedef struct JdKVCommitRequest JdKVCommitRequest;
+
+/**
+ * The requests of a group commit for one namespace, committed with one backend batch.
+ **/
+struct JdKVCommitBatch
+{
+	gchar const* namespace;
+	JSemantics* semantics;
+	GPtrArray* requests;
+};
+
+typedef struct JdKVCommitBatch JdKVCommitBatch;
+
+static GMutex jd_kv_commit_mutex[1];
+static GCond jd_kv_commit_cond[1];
+
+/**
+ * The requests waiting for the next group commit.
+ **/
+static GQueue* jd_kv_commit_pending = NULL;
+
+/**
+ * Whether a thread is currently collecting and committing requests.
+ **/
+static gboolean jd_kv_commit_leader = FALSE;
+
+/**
+ * The time in microseconds the leader waits for further requests.
+ **/
+static guint64 jd_kv_commit_window = 0;
+
+static void
+jd_kv_commit_batch_free(gpointer data)
+{
+	JdKVCommitBatch* commit_batch = data;
+
+	g_ptr_array_unref(commit_batch->requests);
+	g_slice_free(JdKVCommitBatch, commit_batch);
+}
+
+static void
+jd_kv_commit_batch_fail(JdKVCommitBatch* commit_batch)
+{
+	for (guint i = 0; i < commit_batch->requests->len; i++)
+	{
+		JdKVCommitRequest* request = g_ptr_array_index(commit_batch->requests, i);
+
+		for (guint32 j = 0; j < request->count; j++)
+		{
+			request->results[j] = FALSE;
+		}
+	}
+}
+
+/**
+ * Executes all requests using one backend batch per namespace.
+ * The requests of a namespace are applied in arrival order.
+ * The namespaces' batches are started and executed one after another, because backends like LMDB and SQLite only allow one write transaction at a time.
+ *
+ * \param requests The requests.
+ **/
+static void
+jd_kv_commit_execute(GQueue* requests)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_autoptr(GHashTable) lookup = NULL;
+	g_autoptr(GPtrArray) commit_batches = NULL;
+
+	lookup = g_hash_table_new(g_str_hash, g_str_equal);
+	commit_batches = g_ptr_array_new_with_free_func(jd_kv_commit_batch_free);
+
+	for (GList* l = requests->head; l != NULL; l = l->next)
+	{
+		JdKVCommitRequest* request = l->data;
+		JdKVCommitBatch* commit_batch;
+
+		commit_batch = g_hash_table_lookup(lookup, request->namespace);
+
+		if (commit_batch == NULL)
+		{
+			commit_batch = g_slice_new(JdKVCommitBatch);
+			commit_batch->namespace = request->namespace;
+			commit_batch->semantics = request->semantics;
+			commit_batch->requests = g_ptr_array_new();
+
+			g_hash_table_insert(lookup, (gpointer)request->namespace, commit_batch);
+			g_ptr_array_add(commit_batches, commit_batch);
+		}
+
+		g_ptr_array_add(commit_batch->requests, request);
+	}
+
+	for (guint i = 0; i < commit_batches->len; i++)
+	{
+		JdKVCommitBatch* commit_batch = g_ptr_array_index(commit_batches, i);
+		gpointer batch = NULL;
+
+		if (!j_backend_kv_batch_start(jd_kv_backend, commit_batch->namespace, commit_batch->semantics, &batch))
+		{
+			jd_kv_commit_batch_fail(commit_batch);
+			continue;
+		}
+
+		for (guint j = 0; j < commit_batch->requests->len; j++)
+		{
+			JdKVCommitRequest* request = g_ptr_array_index(commit_batch->requests, j);
+
+			for (guint32 k = 0; k < request->count; k++)
+			{
+				if (request->type == J_MESSAGE_KV_PUT)
+				{
+					request->results[k] = j_backend_kv_put(jd_kv_backend, batch, request->keys[k], request->values[k], request->lens[k]);
+				}
+				else
+				{
+					request->results[k] = j_backend_kv_delete(jd_kv_backend, batch, request->keys[k]);
+				}
+			}
+		}
+
+		if (!j_backend_kv_batch_execute(jd_kv_backend, batch))
+		{
+			// Nothing of the batch is guaranteed to be on storage
+			jd_kv_commit_batch_fail(commit_batch);
+		}
+	}
+}
+
+/**
+ * Initializes group commits.
+ *
+ * \param window The time in microseconds to wait for further requests before committing.
+ **/
+void
+jd_kv_commit_init(guint64 window)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_mutex_init(jd_kv_commit_mutex);
+	g_cond_init(jd_kv_commit_cond);
+
+	jd_kv_commit_pending = g_queue_new();
+	jd_kv_commit_leader = FALSE;
+	jd_kv_commit_window = window;
+}
+
+/**
+ * Shuts down group commits.
+ **/
+void
+jd_kv_commit_fini(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_assert(g_queue_is_empty(jd_kv_commit_pending));
+
+	g_queue_free(jd_kv_commit_pending);
+	jd_kv_commit_pending = NULL;
+
+	g_cond_clear(jd_kv_commit_cond);
+	g_mutex_clear(jd_kv_commit_mutex);
+}
+
+/**
+ * Commits a durable KV put or delete message together with concurrent messages from other connections.
+ *
+ * The first thread to arrive becomes the leader.
+ * It waits for the commit window to pass, takes all pending requests and commits them with a single backend batch per namespace.
+ * All other threads wait until their requests have been committed.
+ * This way, concurrent clients share the synchronous write instead of serializing on it.
+ *
+ * \param message   A J_MESSAGE_KV_PUT or J_MESSAGE_KV_DELETE message.
+ * \param semantics The message's semantics.
+ * \param reply     The reply, the results of all operations are appended.
+ **/
+void
+jd_kv_commit(JMessage* message, JSemantics* semantics, JMessage* reply)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JdKVCommitRequest request;
+	g_autofree gchar const** keys = NULL;
+	g_autofree gconstpointer* values = NULL;
+	g_autofree guint32* lens = NULL;
+	g_autofree gboolean* results = NULL;
+
+	g_return_if_fail(message != NULL);
+	g_return_if_fail(semantics != NULL);
+	g_return_if_fail(reply != NULL);
+
+	request.type = j_message_get_type(message);
+	request.semantics = semantics;
+	request.count = j_message_get_count(message);
+	request.done = FALSE;
+
+	keys = g_new(gchar const*, request.count);
+	values = g_new0(gconstpointer, request.count);
+	lens = g_new0(guint32, request.count);
+	results = g_new(gboolean, request.count);
+
+	request.keys = keys;
+	request.values = values;
+	request.lens = lens;
+	request.results = results;
+
+	request.namespace = j_message_get_string(message);
+
+	for (guint32 i = 0; i < request.count; i++)
+	{
+		keys[i] = j_message_get_string(message);
+
+		if (request.type == J_MESSAGE_KV_PUT)
+		{
+			lens[i] = j_message_get_4(message);
+			values[i] = j_message_get_n(message, lens[i]);
+		}
+	}
+
+	g_mutex_lock(jd_kv_commit_mutex);
+
+	g_queue_push_tail(jd_kv_commit_pending, &request);
+
+	while (!request.done)
+	{
+		GQueue* requests;
+
+		if (jd_kv_commit_leader)
+		{
+			g_cond_wait(jd_kv_commit_cond, jd_kv_commit_mutex);
+			continue;
+		}
+
+		jd_kv_commit_leader = TRUE;
+
+		if (jd_kv_commit_window > 0)
+		{
+			g_mutex_unlock(jd_kv_commit_mutex);
+			g_usleep(jd_kv_commit_window);
+			g_mutex_lock(jd_kv_commit_mutex);
+		}
+
+		requests = jd_kv_commit_pending;
+		jd_kv_commit_pending = g_queue_new();
+
+		// New requests can be queued while the batches are being written
+		g_mutex_unlock(jd_kv_commit_mutex);
+		jd_kv_commit_execute(requests);
+		g_mutex_lock(jd_kv_commit_mutex);
+
+		for (GList* l = requests->head; l != NULL; l = l->next)
+		{
+			JdKVCommitRequest* committed = l->data;
+
+			committed->done = TRUE;
+		}
+
+		g_queue_free(requests);
+
+		// Wake up the committed threads and let one of the others become the next leader
+		jd_kv_commit_leader = FALSE;
+		g_cond_broadcast(jd_kv_commit_cond);
+	}
+
+	g_mutex_unlock(jd_kv_commit_mutex);
+
+	for (guint32 i = 0; i < request.count; i++)
+	{
+		guint32 dummy;
+
+		dummy = (results[i]) ? 1 : 0;
+		j_message_add_operation(reply, 4);
+		j_message_append_4(reply, &dummy);
+	}
+}
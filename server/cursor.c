@@ -0,0 +1,658 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2020 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <bson.h>
+
+#include <julea.h>
+#include <julea-db.h>
+
+#include "server.h"
+
+/**
+ * The maximum number of entries per page.
+ * Pages are fetched using an IN condition with one value per entry, so this has to stay below the backends' variable limits.
+ **/
+#define JD_DB_CURSOR_PAGE_MAX 500
+
+/**
+ * The time in microseconds after which unused cursors are dropped.
+ **/
+#define JD_DB_CURSOR_TIMEOUT (10 * G_TIME_SPAN_MINUTE)
+
+/**
+ * An open query whose results are returned page by page.
+ *
+ * Only the IDs of the entries are kept unless the entries are aggregated.
+ * Each page is fetched with a separate backend batch, so no locks or statements are held between pages.
+ **/
+struct JdDBCursor
+{
+	/**
+	 * The connection the cursor was opened on.
+	 * Only used to check the cursor's owner, it is not referenced.
+	 **/
+	GSocketConnection* connection;
+
+	gchar* namespace;
+	gchar* name;
+
+	/**
+	 * The IDs of the query's entries.
+	 * Contains guint32 elements.
+	 **/
+	GArray* ids;
+
+	/**
+	 * The query's entries if they are aggregated, NULL otherwise.
+	 * Aggregated entries do not have IDs and cannot be fetched again, so they are kept until they have been returned.
+	 * Contains bson_t* elements.
+	 **/
+	GPtrArray* rows;
+
+	/**
+	 * The fields to return, NULL for all fields.
+	 **/
+	bson_t* projection;
+
+	/**
+	 * The index of the next ID to return.
+	 **/
+	guint position;
+
+	/**
+	 * The monotonic time of the cursor's last use.
+	 **/
+	gint64 last_used;
+};
+
+typedef struct JdDBCursor JdDBCursor;
+
+static GMutex jd_db_cursor_mutex[1];
+
+/**
+ * The open cursors, indexed by ID.
+ * Contains #JdDBCursor elements.
+ **/
+static GHashTable* jd_db_cursors = NULL;
+
+static guint64 jd_db_cursor_last_id = 0;
+
+static void
+jd_db_cursor_free(gpointer data)
+{
+	JdDBCursor* cursor = data;
+
+	if (cursor->projection != NULL)
+	{
+		bson_destroy(cursor->projection);
+	}
+
+	if (cursor->rows != NULL)
+	{
+		g_ptr_array_unref(cursor->rows);
+	}
+
+	g_array_unref(cursor->ids);
+	g_free(cursor->name);
+	g_free(cursor->namespace);
+
+	g_slice_free(JdDBCursor, cursor);
+}
+
+static gboolean
+jd_db_cursor_expired(gpointer key, gpointer value, gpointer user_data)
+{
+	JdDBCursor* cursor = value;
+	gint64* now = user_data;
+
+	(void)key;
+
+	return (cursor->last_used + JD_DB_CURSOR_TIMEOUT < *now);
+}
+
+static gboolean
+jd_db_cursor_owned_by(gpointer key, gpointer value, gpointer user_data)
+{
+	JdDBCursor* cursor = value;
+
+	(void)key;
+
+	return (cursor->connection == user_data);
+}
+
+static void
+jd_db_cursor_append(bson_t* page, guint32* count, bson_t const* entry)
+{
+	char key_buf[16];
+	const char* key;
+
+	bson_uint32_to_string(*count, &key, key_buf, sizeof(key_buf));
+	bson_append_document(page, key, -1, entry);
+	(*count)++;
+}
+
+/**
+ * Runs a query and passes all entries to a callback.
+ *
+ * \param namespace A namespace.
+ * \param name      A table name.
+ * \param selector  A selector, may be NULL.
+ * \param semantics A semantics object.
+ * \param func      The callback.
+ * \param user_data The callback's data.
+ * \param error     A GError.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+jd_db_cursor_run(gchar const* namespace, gchar const* name, bson_t const* selector, JSemantics* semantics, void (*func)(bson_t const*, gpointer), gpointer user_data, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	GError* iterate_error = NULL;
+	gpointer batch = NULL;
+	gpointer iterator = NULL;
+	gboolean ret = FALSE;
+
+	if (!j_backend_db_batch_start(jd_db_backend, namespace, semantics, &batch, error))
+	{
+		return FALSE;
+	}
+
+	if (!j_backend_db_query(jd_db_backend, batch, name, selector, &iterator, error))
+	{
+		goto end;
+	}
+
+	while (TRUE)
+	{
+		bson_t entry[1];
+
+		bson_init(entry);
+
+		if (!j_backend_db_iterate(jd_db_backend, iterator, entry, &iterate_error))
+		{
+			bson_destroy(entry);
+			break;
+		}
+
+		func(entry, user_data);
+		bson_destroy(entry);
+	}
+
+	if (iterate_error != NULL && iterate_error->code != J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS)
+	{
+		g_propagate_error(error, iterate_error);
+		goto end;
+	}
+
+	g_clear_error(&iterate_error);
+	ret = TRUE;
+
+end:
+	j_backend_db_batch_execute(jd_db_backend, batch, NULL);
+
+	return ret;
+}
+
+/**
+ * Returns the number of a cursor's entries, including the ones that have already been returned.
+ **/
+static guint
+jd_db_cursor_length(JdDBCursor* cursor)
+{
+	return (cursor->rows != NULL) ? cursor->rows->len : cursor->ids->len;
+}
+
+static void
+jd_db_cursor_open_func(bson_t const* entry, gpointer user_data)
+{
+	JdDBCursor* cursor = user_data;
+	bson_iter_t iter;
+
+	if (cursor->rows != NULL)
+	{
+		g_ptr_array_add(cursor->rows, bson_copy(entry));
+	}
+	else if (bson_iter_init_find(&iter, entry, "_id") && BSON_ITER_HOLDS_INT32(&iter))
+	{
+		guint32 id = bson_iter_int32(&iter);
+
+		g_array_append_val(cursor->ids, id);
+	}
+}
+
+struct JdDBCursorNextData
+{
+	guint32 count;
+
+	/**
+	 * The fetched entries, indexed by ID.
+	 **/
+	GHashTable* entries;
+};
+
+typedef struct JdDBCursorNextData JdDBCursorNextData;
+
+static void
+jd_db_cursor_next_func(bson_t const* entry, gpointer user_data)
+{
+	JdDBCursorNextData* data = user_data;
+	bson_iter_t iter;
+
+	if (bson_iter_init_find(&iter, entry, "_id") && BSON_ITER_HOLDS_INT32(&iter))
+	{
+		g_hash_table_insert(data->entries, GINT_TO_POINTER(bson_iter_int32(&iter)), bson_copy(entry));
+	}
+}
+
+/**
+ * Returns the selector that fetches the IDs of a query's entries.
+ * The query's conditions and options are kept, only its projection is replaced.
+ *
+ * \param selector A selector, may be NULL.
+ *
+ * \return A new selector.
+ **/
+static bson_t*
+jd_db_cursor_id_selector(bson_t const* selector)
+{
+	bson_t* id_selector;
+	bson_t projection[1];
+	bson_iter_t iter;
+
+	id_selector = bson_new();
+
+	if (selector == NULL)
+	{
+		bson_append_int32(id_selector, "_mode", -1, J_DB_SELECTOR_MODE_AND);
+	}
+	else if (bson_iter_init(&iter, selector))
+	{
+		while (bson_iter_next(&iter))
+		{
+			if (g_strcmp0(bson_iter_key(&iter), "_projection") != 0)
+			{
+				bson_append_value(id_selector, bson_iter_key(&iter), -1, bson_iter_value(&iter));
+			}
+		}
+	}
+
+	bson_append_document_begin(id_selector, "_projection", -1, projection);
+	bson_append_utf8(projection, "0", -1, "_id", -1);
+	bson_append_document_end(id_selector, projection);
+
+	return id_selector;
+}
+
+/**
+ * Appends a cursor's next entries to a page.
+ * Entries with IDs are fetched using a single IN condition and returned in their original order.
+ *
+ * \param cursor    A cursor.
+ * \param semantics A semantics object.
+ * \param page_size The maximum number of entries per page.
+ * \param page      An initialized BSON document that receives the entries, keyed by their position.
+ * \param error     A GError.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+static gboolean
+jd_db_cursor_fetch(JdDBCursor* cursor, JSemantics* semantics, guint32 page_size, bson_t* page, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JdDBCursorNextData data;
+	bson_t selector[1];
+	bson_t condition[1];
+	bson_t values[1];
+	guint32 count;
+	guint32 mode;
+	guint32 operator;
+	gboolean ret;
+
+	count = MIN(CLAMP(page_size, 1, JD_DB_CURSOR_PAGE_MAX), jd_db_cursor_length(cursor) - cursor->position);
+	data.count = 0;
+
+	if (cursor->rows != NULL)
+	{
+		for (guint32 i = 0; i < count; i++)
+		{
+			jd_db_cursor_append(page, &(data.count), g_ptr_array_index(cursor->rows, cursor->position + i));
+		}
+
+		cursor->position += count;
+
+		return TRUE;
+	}
+
+	if (count == 0)
+	{
+		return TRUE;
+	}
+
+	mode = J_DB_SELECTOR_MODE_AND;
+	operator = J_DB_SELECTOR_OPERATOR_IN;
+
+	// Fetch the page's entries using a single IN condition on their IDs
+	bson_init(selector);
+	bson_append_int32(selector, "_mode", -1, mode);
+	bson_append_document_begin(selector, "0", -1, condition);
+	bson_append_utf8(condition, "_name", -1, "_id", -1);
+	bson_append_int32(condition, "_operator", -1, operator);
+	bson_append_array_begin(condition, "_value", -1, values);
+
+	for (guint32 i = 0; i < count; i++)
+	{
+		char key_buf[16];
+		const char* value_key;
+
+		bson_uint32_to_string(i, &value_key, key_buf, sizeof(key_buf));
+		bson_append_int32(values, value_key, -1, g_array_index(cursor->ids, guint32, cursor->position + i));
+	}
+
+	bson_append_array_end(condition, values);
+	bson_append_document_end(selector, condition);
+
+	if (cursor->projection != NULL)
+	{
+		bson_append_document(selector, "_projection", -1, cursor->projection);
+	}
+
+	data.entries = g_hash_table_new_full(NULL, NULL, NULL, (GDestroyNotify)bson_destroy);
+
+	ret = jd_db_cursor_run(cursor->namespace, cursor->name, selector, semantics, jd_db_cursor_next_func, &data, error);
+	bson_destroy(selector);
+
+	// Restore the order of the original query
+	for (guint32 i = 0; i < count; i++)
+	{
+		bson_t* entry;
+
+		entry = g_hash_table_lookup(data.entries, GINT_TO_POINTER(g_array_index(cursor->ids, guint32, cursor->position + i)));
+
+		if (entry != NULL)
+		{
+			jd_db_cursor_append(page, &(data.count), entry);
+		}
+	}
+
+	g_hash_table_unref(data.entries);
+
+	cursor->position += count;
+
+	return ret;
+}
+
+/**
+ * Initializes query cursors.
+ **/
+void
+jd_db_cursor_init(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_mutex_init(jd_db_cursor_mutex);
+
+	jd_db_cursors = g_hash_table_new_full(g_int64_hash, g_int64_equal, g_free, jd_db_cursor_free);
+}
+
+/**
+ * Shuts down query cursors and drops all open ones.
+ **/
+void
+jd_db_cursor_fini(void)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_hash_table_unref(jd_db_cursors);
+	jd_db_cursors = NULL;
+
+	g_mutex_clear(jd_db_cursor_mutex);
+}
+
+/**
+ * Runs a query and returns its first page.
+ * If there are more entries, a cursor is opened to return them using jd_db_cursor_next().
+ *
+ * The query only fetches the entries' IDs, all pages including the first one are fetched by ID.
+ * The cursor is owned by the connection it is opened on and can only be used by it.
+ *
+ * \param connection A connection.
+ * \param namespace  A namespace.
+ * \param name       A table name.
+ * \param selector   A selector, may be NULL.
+ * \param semantics  A semantics object.
+ * \param page_size  The maximum number of entries per page.
+ * \param page       An initialized BSON document that receives the entries, keyed by their position.
+ * \param cursor_id  A pointer that receives the cursor's ID.
+ * \param more       A pointer that receives whether the cursor has more entries.
+ * \param error      A GError.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+gboolean
+jd_db_cursor_open(GSocketConnection* connection, gchar const* namespace, gchar const* name, bson_t const* selector, JSemantics* semantics, guint32 page_size, bson_t* page, guint64* cursor_id, gboolean* more, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JdDBCursor* cursor;
+	bson_t* id_selector = NULL;
+	bson_iter_t iter;
+	gint64 now;
+	gboolean ret;
+
+	g_return_val_if_fail(connection != NULL, FALSE);
+	g_return_val_if_fail(namespace != NULL, FALSE);
+	g_return_val_if_fail(name != NULL, FALSE);
+	g_return_val_if_fail(page != NULL, FALSE);
+	g_return_val_if_fail(cursor_id != NULL, FALSE);
+	g_return_val_if_fail(more != NULL, FALSE);
+
+	*cursor_id = 0;
+	*more = FALSE;
+
+	now = g_get_monotonic_time();
+
+	// Clients that crashed or exited without closing their cursors leave them behind
+	g_mutex_lock(jd_db_cursor_mutex);
+	g_hash_table_foreach_remove(jd_db_cursors, jd_db_cursor_expired, &now);
+	g_mutex_unlock(jd_db_cursor_mutex);
+
+	cursor = g_slice_new(JdDBCursor);
+	cursor->connection = connection;
+	cursor->namespace = g_strdup(namespace);
+	cursor->name = g_strdup(name);
+	cursor->ids = g_array_new(FALSE, FALSE, sizeof(guint32));
+	cursor->rows = NULL;
+	cursor->projection = NULL;
+	cursor->position = 0;
+	cursor->last_used = now;
+
+	if (selector != NULL && (bson_has_field(selector, "_aggregate") || bson_has_field(selector, "_group")))
+	{
+		cursor->rows = g_ptr_array_new_with_free_func((GDestroyNotify)bson_destroy);
+	}
+	else
+	{
+		// Only fetch the IDs here, the entries are fetched page by page
+		id_selector = jd_db_cursor_id_selector(selector);
+
+		if (selector != NULL && bson_iter_init_find(&iter, selector, "_projection") && BSON_ITER_HOLDS_DOCUMENT(&iter))
+		{
+			guint8 const* projection_data;
+			guint32 projection_len;
+
+			bson_iter_document(&iter, &projection_len, &projection_data);
+			cursor->projection = bson_new_from_data(projection_data, projection_len);
+		}
+	}
+
+	ret = jd_db_cursor_run(namespace, name, (id_selector != NULL) ? id_selector : selector, semantics, jd_db_cursor_open_func, cursor, error);
+
+	if (id_selector != NULL)
+	{
+		bson_destroy(id_selector);
+	}
+
+	ret = ret && jd_db_cursor_fetch(cursor, semantics, page_size, page, error);
+
+	if (ret && cursor->position < jd_db_cursor_length(cursor))
+	{
+		guint64* key;
+
+		key = g_new(guint64, 1);
+
+		g_mutex_lock(jd_db_cursor_mutex);
+		*key = ++jd_db_cursor_last_id;
+		g_hash_table_insert(jd_db_cursors, key, cursor);
+		g_mutex_unlock(jd_db_cursor_mutex);
+
+		*cursor_id = *key;
+		*more = TRUE;
+	}
+	else
+	{
+		jd_db_cursor_free(cursor);
+	}
+
+	return ret;
+}
+
+/**
+ * Returns a cursor's next page.
+ * The cursor is closed automatically after its last page or if an error occurs.
+ *
+ * Entries that have been deleted since the cursor was opened are skipped.
+ * Entries that have been updated are returned with their current values but in their original order.
+ *
+ * \param connection A connection.
+ * \param namespace  A namespace.
+ * \param cursor_id  A cursor ID.
+ * \param semantics  A semantics object.
+ * \param page_size  The maximum number of entries per page.
+ * \param page       An initialized BSON document that receives the entries, keyed by their position.
+ * \param more       A pointer that receives whether the cursor has more entries.
+ * \param error      A GError.
+ *
+ * \return TRUE on success, FALSE otherwise.
+ **/
+gboolean
+jd_db_cursor_next(GSocketConnection* connection, gchar const* namespace, guint64 cursor_id, JSemantics* semantics, guint32 page_size, bson_t* page, gboolean* more, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JdDBCursor* cursor = NULL;
+	gpointer key = NULL;
+	gboolean ret;
+
+	g_return_val_if_fail(connection != NULL, FALSE);
+	g_return_val_if_fail(page != NULL, FALSE);
+	g_return_val_if_fail(more != NULL, FALSE);
+
+	*more = FALSE;
+
+	// Take the cursor out of the table, its client does not send concurrent requests for it
+	g_mutex_lock(jd_db_cursor_mutex);
+
+	if (g_hash_table_lookup_extended(jd_db_cursors, &cursor_id, &key, (gpointer*)&cursor))
+	{
+		// Cursor IDs are guessable, so other connections must not be able to use them
+		if (cursor->connection == connection && g_strcmp0(cursor->namespace, namespace) == 0)
+		{
+			g_hash_table_steal(jd_db_cursors, &cursor_id);
+		}
+		else
+		{
+			cursor = NULL;
+		}
+	}
+
+	g_mutex_unlock(jd_db_cursor_mutex);
+
+	if (cursor == NULL)
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_INVALID, "iterator invalid");
+		return FALSE;
+	}
+
+	ret = jd_db_cursor_fetch(cursor, semantics, page_size, page, error);
+
+	if (ret && cursor->position < jd_db_cursor_length(cursor))
+	{
+		cursor->last_used = g_get_monotonic_time();
+
+		g_mutex_lock(jd_db_cursor_mutex);
+		g_hash_table_insert(jd_db_cursors, key, cursor);
+		g_mutex_unlock(jd_db_cursor_mutex);
+
+		*more = TRUE;
+	}
+	else
+	{
+		g_free(key);
+		jd_db_cursor_free(cursor);
+	}
+
+	return ret;
+}
+
+/**
+ * Closes a cursor before all of its pages have been returned.
+ *
+ * \param connection A connection.
+ * \param cursor_id  A cursor ID.
+ **/
+void
+jd_db_cursor_close(GSocketConnection* connection, guint64 cursor_id)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JdDBCursor* cursor;
+
+	g_mutex_lock(jd_db_cursor_mutex);
+
+	cursor = g_hash_table_lookup(jd_db_cursors, &cursor_id);
+
+	if (cursor != NULL && cursor->connection == connection)
+	{
+		g_hash_table_remove(jd_db_cursors, &cursor_id);
+	}
+
+	g_mutex_unlock(jd_db_cursor_mutex);
+}
+
+/**
+ * Drops all cursors of a connection.
+ * Has to be called when the connection is closed.
+ *
+ * \param connection A connection.
+ **/
+void
+jd_db_cursor_close_connection(GSocketConnection* connection)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	g_mutex_lock(jd_db_cursor_mutex);
+	g_hash_table_foreach_remove(jd_db_cursors, jd_db_cursor_owned_by, connection);
+	g_mutex_unlock(jd_db_cursor_mutex);
+}
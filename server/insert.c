@@ -0,0 +1,276 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2020 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <string.h>
+
+#include <bson.h>
+
+#include <julea.h>
+
+#include "server.h"
+
+/**
+ * Inserts entries for the same schema within their own backend batch.
+ *
+ * \param namespace A namespace.
+ * \param semantics A semantics object.
+ * \param name      A schema name.
+ * \param metadata  The entries.
+ * \param count     The number of entries.
+ * \param ids       Initialized BSON documents that receive the entries' IDs.
+ * \param error     A GError, has to be set on failure.
+ *
+ * \return TRUE if all entries have been inserted, FALSE otherwise.
+ *         On failure, only the entries whose IDs have been set were inserted.
+ **/
+static gboolean
+jd_db_insert_chunk(gchar const* namespace, JSemantics* semantics, gchar const* name, bson_t const* metadata, guint32 count, bson_t* ids, GError** error)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	gpointer batch = NULL;
+	GError* execute_error = NULL;
+	gboolean ret;
+
+	if (!j_backend_db_batch_start(jd_db_backend, namespace, semantics, &batch, error))
+	{
+		if (*error == NULL)
+		{
+			g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_FAILED, "batch start failed");
+		}
+
+		return FALSE;
+	}
+
+	ret = j_backend_db_insert_many(jd_db_backend, batch, name, metadata, count, ids, error);
+
+	if (!ret && *error == NULL)
+	{
+		g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_FAILED, "insert failed");
+	}
+
+	// Aborted batches are not committed, so none of the entries have been inserted
+	if (!j_backend_db_batch_execute(jd_db_backend, batch, &execute_error))
+	{
+		if (*error == NULL)
+		{
+			*error = execute_error;
+			execute_error = NULL;
+		}
+
+		if (*error == NULL)
+		{
+			g_set_error_literal(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_FAILED, "batch execute failed");
+		}
+
+		for (guint32 i = 0; i < count; i++)
+		{
+			bson_reinit(&ids[i]);
+		}
+
+		ret = FALSE;
+	}
+
+	g_clear_error(&execute_error);
+
+	return ret;
+}
+
+/**
+ * Inserts all entries of a J_MESSAGE_DB_INSERT message.
+ *
+ * Consecutive entries for the same schema are passed to the backend together, allowing it to use multi-row inserts.
+ * The entries point into the message, they are not copied.
+ *
+ * With batch atomicity, all entries are inserted within a single backend batch.
+ * If inserting fails, the remaining entries are not inserted.
+ * Backends may also abort the batch, rolling back the entries inserted before.
+ * The batch is executed in any case to release it, if this fails none of the entries have been inserted.
+ *
+ * Otherwise, the entries are independent and each group of consecutive entries is inserted within its own backend batch.
+ * If a group fails, its entries that have not been inserted are retried one by one, so only the failing entries report errors.
+ *
+ * \param message   A J_MESSAGE_DB_INSERT message.
+ * \param semantics The message's semantics.
+ * \param reply     The reply, the ID and error of each entry are appended.
+ **/
+void
+jd_db_insert(JMessage* message, JSemantics* semantics, JMessage* reply)
+{
+	J_TRACE_FUNCTION(NULL);
+
+	JBackendOperation backend_operation;
+	g_autofree gchar const** names = NULL;
+	g_autofree bson_t* metadata = NULL;
+	g_autofree bson_t* ids = NULL;
+	g_autofree GError** errors = NULL;
+	gchar const* namespace = NULL;
+	gboolean atomic;
+	guint32 operation_count;
+	guint32 start = 0;
+
+	g_return_if_fail(message != NULL);
+	g_return_if_fail(semantics != NULL);
+	g_return_if_fail(reply != NULL);
+
+	operation_count = j_message_get_count(message);
+	atomic = (j_semantics_get(semantics, J_SEMANTICS_ATOMICITY) == J_SEMANTICS_ATOMICITY_BATCH);
+
+	names = g_new(gchar const*, operation_count);
+	metadata = g_new(bson_t, operation_count);
+	ids = g_new(bson_t, operation_count);
+	errors = g_new0(GError*, operation_count);
+
+	memcpy(&backend_operation, &j_backend_operation_db_insert, sizeof(JBackendOperation));
+
+	for (guint32 i = 0; i < operation_count; i++)
+	{
+		bson_t const* bson;
+
+		j_backend_operation_from_message_static(message, backend_operation.in_param, backend_operation.in_param_count);
+
+		// All operations of a message belong to the same namespace
+		namespace = backend_operation.in_param[0].ptr;
+		names[i] = backend_operation.in_param[1].ptr;
+
+		// Static BSONs must not be copied by value, initialize a new one for the same data
+		bson = backend_operation.in_param[2].ptr;
+		bson_init_static(&metadata[i], bson_get_data(bson), bson->len);
+		bson_init(&ids[i]);
+	}
+
+	if (atomic)
+	{
+		gpointer batch = NULL;
+		GError* error = NULL;
+		GError* execute_error = NULL;
+		guint32 failed;
+
+		failed = operation_count;
+
+		if (operation_count > 0 && !j_backend_db_batch_start(jd_db_backend, namespace, semantics, &batch, &error))
+		{
+			failed = 0;
+
+			if (error == NULL)
+			{
+				g_set_error_literal(&error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_FAILED, "batch start failed");
+			}
+		}
+
+		for (guint32 i = 1; i <= operation_count && error == NULL; i++)
+		{
+			if (i < operation_count && g_strcmp0(names[i], names[start]) == 0)
+			{
+				continue;
+			}
+
+			if (!j_backend_db_insert_many(jd_db_backend, batch, names[start], &metadata[start], i - start, &ids[start], &error))
+			{
+				failed = start;
+
+				if (error == NULL)
+				{
+					g_set_error_literal(&error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_FAILED, "insert failed");
+				}
+
+				break;
+			}
+
+			start = i;
+		}
+
+		// Aborted batches are not committed, so all entries have failed
+		if (batch != NULL && !j_backend_db_batch_execute(jd_db_backend, batch, &execute_error))
+		{
+			failed = 0;
+
+			if (error == NULL)
+			{
+				error = execute_error;
+				execute_error = NULL;
+			}
+
+			if (error == NULL)
+			{
+				g_set_error_literal(&error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_FAILED, "batch execute failed");
+			}
+		}
+
+		g_clear_error(&execute_error);
+
+		for (guint32 i = failed; i < operation_count && error != NULL; i++)
+		{
+			errors[i] = g_error_copy(error);
+		}
+
+		g_clear_error(&error);
+	}
+	else
+	{
+		for (guint32 i = 1; i <= operation_count; i++)
+		{
+			GError* error = NULL;
+
+			if (i < operation_count && g_strcmp0(names[i], names[start]) == 0)
+			{
+				continue;
+			}
+
+			if (!jd_db_insert_chunk(namespace, semantics, names[start], &metadata[start], i - start, &ids[start], &error))
+			{
+				if (i - start == 1)
+				{
+					errors[start] = error;
+				}
+				else
+				{
+					g_clear_error(&error);
+
+					// A single failing entry must not fail the others
+					for (guint32 j = start; j < i; j++)
+					{
+						if (bson_empty(&ids[j]))
+						{
+							jd_db_insert_chunk(namespace, semantics, names[j], &metadata[j], 1, &ids[j], &errors[j]);
+						}
+					}
+				}
+			}
+
+			start = i;
+		}
+	}
+
+	for (guint32 i = 0; i < operation_count; i++)
+	{
+		backend_operation.out_param[0].ptr = &ids[i];
+		backend_operation.out_param[0].bson_initialized = (errors[i] == NULL);
+		backend_operation.out_param[1].ptr = &backend_operation.out_param[1].error_ptr;
+		backend_operation.out_param[1].error_ptr = errors[i];
+
+		j_backend_operation_to_message(reply, backend_operation.out_param, backend_operation.out_param_count);
+
+		bson_destroy(&ids[i]);
+		bson_destroy(&metadata[i]);
+	}
+}
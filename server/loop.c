@@ -490,6 +490,7 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 		{
 			g_autoptr(JMessage) reply = NULL;
 			JStatistics* r_statistics;
+			JStatistics* db_statistics;
 			gchar get_all;
 			guint64 value;
 
@@ -503,7 +504,7 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 			}
 
 			reply = j_message_new_reply(message);
-			j_message_add_operation(reply, 8 * sizeof(guint64));
+			j_message_add_operation(reply, 11 * sizeof(guint64));
 
 			value = j_statistics_get(r_statistics, J_STATISTICS_FILES_CREATED);
 			j_message_append_8(reply, &value);
@@ -527,6 +528,23 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 				g_mutex_unlock(jd_statistics_mutex);
 			}
 
+			// The backend keeps track of its statistics itself, they always cover all threads
+			db_statistics = j_statistics_new(FALSE);
+
+			if (jd_db_backend != NULL)
+			{
+				j_backend_db_statistics(jd_db_backend, db_statistics);
+			}
+
+			value = j_statistics_get(db_statistics, J_STATISTICS_DB_STATEMENTS_HIT);
+			j_message_append_8(reply, &value);
+			value = j_statistics_get(db_statistics, J_STATISTICS_DB_STATEMENTS_MISSED);
+			j_message_append_8(reply, &value);
+			value = j_statistics_get(db_statistics, J_STATISTICS_DB_STATEMENTS_EVICTED);
+			j_message_append_8(reply, &value);
+
+			j_statistics_free(db_statistics);
+
 			j_message_send(reply, connection);
 		}
 		break;
@@ -567,6 +585,14 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 				reply = j_message_new_reply(message);
 			}
 
+			if (safety == J_SEMANTICS_SAFETY_STORAGE)
+			{
+				// Share the synchronous write with concurrent connections
+				jd_kv_commit(message, semantics, reply);
+				j_message_send(reply, connection);
+				break;
+			}
+
 			namespace = j_message_get_string(message);
 			j_backend_kv_batch_start(jd_kv_backend, namespace, semantics, &batch);
 
@@ -600,6 +626,58 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 			}
 		}
 		break;
+		case J_MESSAGE_KV_BULK_PUT:
+		{
+			g_autoptr(JMessage) reply = NULL;
+			g_autofree gboolean* rets = NULL;
+			gpointer bulk;
+			gboolean started;
+			gboolean executed = FALSE;
+
+			if (safety == J_SEMANTICS_SAFETY_NETWORK || safety == J_SEMANTICS_SAFETY_STORAGE)
+			{
+				reply = j_message_new_reply(message);
+			}
+
+			rets = g_new(gboolean, operation_count);
+
+			namespace = j_message_get_string(message);
+			started = j_backend_kv_bulk_start(jd_kv_backend, namespace, semantics, &bulk);
+
+			for (i = 0; i < operation_count; i++)
+			{
+				gconstpointer data;
+				guint32 len;
+
+				key = j_message_get_string(message);
+				len = j_message_get_4(message);
+				data = j_message_get_n(message, len);
+
+				// All puts fail if the bulk could not be started
+				rets[i] = started && j_backend_kv_bulk_put(jd_kv_backend, bulk, key, data, len);
+			}
+
+			if (started)
+			{
+				executed = j_backend_kv_bulk_execute(jd_kv_backend, bulk);
+			}
+
+			// Some backends only write the data during execution, so the replies have to wait for it
+			if (reply != NULL)
+			{
+				for (i = 0; i < operation_count; i++)
+				{
+					guint32 dummy;
+
+					dummy = (rets[i] && executed) ? 1 : 0;
+					j_message_add_operation(reply, 4);
+					j_message_append_4(reply, &dummy);
+				}
+
+				j_message_send(reply, connection);
+			}
+		}
+		break;
 		case J_MESSAGE_KV_DELETE:
 		{
 			g_autoptr(JMessage) reply = NULL;
@@ -610,6 +688,14 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 				reply = j_message_new_reply(message);
 			}
 
+			if (safety == J_SEMANTICS_SAFETY_STORAGE)
+			{
+				// Share the synchronous write with concurrent connections
+				jd_kv_commit(message, semantics, reply);
+				j_message_send(reply, connection);
+				break;
+			}
+
 			namespace = j_message_get_string(message);
 			j_backend_kv_batch_start(jd_kv_backend, namespace, semantics, &batch);
 
@@ -762,13 +848,33 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 				message_matched = TRUE;
 			}
 			// fallthrough
-		case J_MESSAGE_DB_INSERT:
+		case J_MESSAGE_DB_INDEX_CREATE:
+			if (!message_matched)
+			{
+				memcpy(&backend_operation, &j_backend_operation_db_index_create, sizeof(JBackendOperation));
+				message_matched = TRUE;
+			}
+			// fallthrough
+		case J_MESSAGE_DB_INDEX_DELETE:
 			if (!message_matched)
 			{
-				memcpy(&backend_operation, &j_backend_operation_db_insert, sizeof(JBackendOperation));
+				memcpy(&backend_operation, &j_backend_operation_db_index_delete, sizeof(JBackendOperation));
 				message_matched = TRUE;
 			}
 			// fallthrough
+		case J_MESSAGE_DB_INSERT:
+			// Inserts are passed to the backend in bulk, jd_db_insert() takes care of the atomicity
+			if (!message_matched)
+			{
+				g_autoptr(JMessage) reply = NULL;
+
+				reply = j_message_new_reply(message);
+				jd_db_insert(message, semantics, reply);
+				j_message_send(reply, connection);
+
+				break;
+			}
+			// fallthrough
 		case J_MESSAGE_DB_UPDATE:
 			if (!message_matched)
 			{
@@ -928,6 +1034,80 @@ jd_handle_message(JMessage* message, GSocketConnection* connection, JMemoryChunk
 				j_message_send(reply, connection);
 			}
 			break;
+		case J_MESSAGE_DB_QUERY_OPEN:
+		case J_MESSAGE_DB_QUERY_NEXT:
+			{
+				g_autoptr(JMessage) reply = NULL;
+				GError* error = NULL;
+				g_autofree gpointer block = NULL;
+				gchar const* namespace = NULL;
+				guint64 cursor_id = 0;
+				guint32 page_size;
+				guint32 block_length;
+				gboolean more = FALSE;
+				guint32 dummy;
+
+				memcpy(&backend_operation, &j_backend_operation_db_query, sizeof(JBackendOperation));
+				reply = j_message_new_reply(message);
+
+				if (j_message_get_type(message) == J_MESSAGE_DB_QUERY_OPEN)
+				{
+					page_size = j_message_get_4(message);
+					j_backend_operation_from_message_static(message, backend_operation.in_param, backend_operation.in_param_count);
+				}
+				else
+				{
+					cursor_id = j_message_get_8(message);
+					page_size = j_message_get_4(message);
+					namespace = j_message_get_string(message);
+				}
+
+				backend_operation.out_param[0].ptr = &backend_operation.out_param[0].bson;
+				backend_operation.out_param[0].bson_initialized = TRUE;
+				backend_operation.out_param[1].ptr = &error;
+				bson_init(backend_operation.out_param[0].ptr);
+
+				if (j_message_get_type(message) == J_MESSAGE_DB_QUERY_OPEN)
+				{
+					jd_db_cursor_open(connection, backend_operation.in_param[0].ptr, backend_operation.in_param[1].ptr, backend_operation.in_param[2].ptr, semantics, page_size, backend_operation.out_param[0].ptr, &cursor_id, &more, &error);
+				}
+				else
+				{
+					jd_db_cursor_next(connection, namespace, cursor_id, semantics, page_size, backend_operation.out_param[0].ptr, &more, &error);
+				}
+
+				// Send the page as a compact row block, falling back to BSON for rows that cannot be encoded
+				block = j_row_block_encode(backend_operation.out_param[0].ptr, &block_length);
+
+				if (block == NULL)
+				{
+					block_length = 0;
+				}
+
+				dummy = (more) ? 1 : 0;
+				j_message_add_operation(reply, 8 + 4 + 4 + block_length);
+				j_message_append_8(reply, &cursor_id);
+				j_message_append_4(reply, &dummy);
+				j_message_append_4(reply, &block_length);
+
+				if (block != NULL)
+				{
+					j_message_append_n(reply, block, block_length);
+					backend_operation.out_param[0].bson_initialized = FALSE;
+				}
+
+				j_backend_operation_to_message(reply, backend_operation.out_param, backend_operation.out_param_count);
+				bson_destroy(&backend_operation.out_param[0].bson);
+
+				j_message_send(reply, connection);
+			}
+			break;
+		case J_MESSAGE_DB_QUERY_CLOSE:
+			for (i = 0; i < operation_count; i++)
+			{
+				jd_db_cursor_close(connection, j_message_get_8(message));
+			}
+			break;
 		default:
 			g_warn_if_reached();
 			break;
@@ -83,6 +83,9 @@ jd_on_run(GThreadedSocketService* service, GSocketConnection* connection, GObjec
 		jd_handle_message(message, connection, memory_chunk, memory_chunk_size, statistics);
 	}
 
+	// Cursors can only be used by their connection
+	jd_db_cursor_close_connection(connection);
+
 	{
 		guint64 value;
 
@@ -166,8 +169,18 @@ jd_daemon(void)
 	return TRUE;
 }
 
+/**
+ * Returns whether this server is configured for a backend type.
+ *
+ * \param host         The server's host.
+ * \param port         The server's port.
+ * \param backend_type The backend type.
+ * \param index        Returns the server's index among the servers of the backend type, may be NULL.
+ *
+ * \return TRUE if this server is configured for the backend type, FALSE otherwise.
+ **/
 static gboolean
-jd_is_server_for_backend(gchar const* host, gint port, JBackendType backend_type)
+jd_is_server_for_backend(gchar const* host, gint port, JBackendType backend_type, guint* index)
 {
 	guint count;
 
@@ -188,6 +201,11 @@ jd_is_server_for_backend(gchar const* host, gint port, JBackendType backend_type
 
 		if (g_strcmp0(host, addr_server) == 0 && port == addr_port)
 		{
+			if (index != NULL)
+			{
+				*index = i;
+			}
+
 			return TRUE;
 		}
 	}
@@ -221,6 +239,7 @@ main(int argc, char** argv)
 	gchar const* db_backend;
 	gchar const* db_component;
 	g_autofree gchar* db_path = NULL;
+	guint db_index = 0;
 	g_autofree gchar* port_str = NULL;
 	guint listen_retries = 0;
 
@@ -318,7 +337,7 @@ main(int argc, char** argv)
 	db_component = j_configuration_get_backend_component(jd_configuration, J_BACKEND_TYPE_DB);
 	db_path = j_helper_str_replace(j_configuration_get_backend_path(jd_configuration, J_BACKEND_TYPE_DB), "{PORT}", port_str);
 
-	if (jd_is_server_for_backend(opt_host, opt_port, J_BACKEND_TYPE_OBJECT)
+	if (jd_is_server_for_backend(opt_host, opt_port, J_BACKEND_TYPE_OBJECT, NULL)
 	    && j_backend_load_server(object_backend, object_component, J_BACKEND_TYPE_OBJECT, &object_module, &jd_object_backend))
 	{
 		if (jd_object_backend == NULL || !j_backend_object_init(jd_object_backend, object_path))
@@ -330,7 +349,7 @@ main(int argc, char** argv)
 		g_debug("Initialized object backend %s.", object_backend);
 	}
 
-	if (jd_is_server_for_backend(opt_host, opt_port, J_BACKEND_TYPE_KV)
+	if (jd_is_server_for_backend(opt_host, opt_port, J_BACKEND_TYPE_KV, NULL)
 	    && j_backend_load_server(kv_backend, kv_component, J_BACKEND_TYPE_KV, &kv_module, &jd_kv_backend))
 	{
 		if (jd_kv_backend == NULL || !j_backend_kv_init(jd_kv_backend, kv_path))
@@ -342,7 +361,9 @@ main(int argc, char** argv)
 		g_debug("Initialized kv backend %s.", kv_backend);
 	}
 
-	if (jd_is_server_for_backend(opt_host, opt_port, J_BACKEND_TYPE_DB)
+	jd_kv_commit_init(j_configuration_get_kv_group_commit_window(jd_configuration));
+
+	if (jd_is_server_for_backend(opt_host, opt_port, J_BACKEND_TYPE_DB, &db_index)
 	    && j_backend_load_server(db_backend, db_component, J_BACKEND_TYPE_DB, &db_module, &jd_db_backend))
 	{
 		if (jd_db_backend == NULL || !j_backend_db_init(jd_db_backend, db_path))
@@ -351,9 +372,18 @@ main(int argc, char** argv)
 			return 1;
 		}
 
+		// Every DB server assigns entry IDs from its own range
+		if (!j_backend_db_set_id_base(jd_db_backend, j_backend_db_id_base(db_index, j_configuration_get_server_count(jd_configuration, J_BACKEND_TYPE_DB))))
+		{
+			g_warning("DB backend %s does not support multiple servers.", db_backend);
+			return 1;
+		}
+
 		g_debug("Initialized db backend %s.", db_backend);
 	}
 
+	jd_db_cursor_init();
+
 	jd_statistics = j_statistics_new(FALSE);
 	g_mutex_init(jd_statistics_mutex);
 
@@ -373,11 +403,15 @@ main(int argc, char** argv)
 	g_mutex_clear(jd_statistics_mutex);
 	j_statistics_free(jd_statistics);
 
+	jd_db_cursor_fini();
+
 	if (jd_db_backend != NULL)
 	{
 		j_backend_db_fini(jd_db_backend);
 	}
 
+	jd_kv_commit_fini();
+
 	if (jd_kv_backend != NULL)
 	{
 		j_backend_kv_fini(jd_kv_backend);
@@ -36,4 +36,17 @@ G_GNUC_INTERNAL extern JBackend* jd_db_backend;
 
 G_GNUC_INTERNAL gboolean jd_handle_message(JMessage*, GSocketConnection*, JMemoryChunk*, guint64, JStatistics*);
 
+G_GNUC_INTERNAL void jd_kv_commit_init(guint64);
+G_GNUC_INTERNAL void jd_kv_commit_fini(void);
+G_GNUC_INTERNAL void jd_kv_commit(JMessage*, JSemantics*, JMessage*);
+
+G_GNUC_INTERNAL void jd_db_cursor_init(void);
+G_GNUC_INTERNAL void jd_db_cursor_fini(void);
+G_GNUC_INTERNAL gboolean jd_db_cursor_open(GSocketConnection*, gchar const*, gchar const*, bson_t const*, JSemantics*, guint32, bson_t*, guint64*, gboolean*, GError**);
+G_GNUC_INTERNAL gboolean jd_db_cursor_next(GSocketConnection*, gchar const*, guint64, JSemantics*, guint32, bson_t*, gboolean*, GError**);
+G_GNUC_INTERNAL void jd_db_cursor_close(GSocketConnection*, guint64);
+G_GNUC_INTERNAL void jd_db_cursor_close_connection(GSocketConnection*);
+
+G_GNUC_INTERNAL void jd_db_insert(JMessage*, JSemantics*, JMessage*);
+
 #endif
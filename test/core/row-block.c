@@ -0,0 +1,225 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2020 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <string.h>
+
+#include <bson.h>
+
+#include <julea.h>
+
+#include <jrow-block.h>
+
+#include "test.h"
+
+static void
+test_row_block_append_rows(bson_t* rows, guint32 count)
+{
+	for (guint32 i = 0; i < count; i++)
+	{
+		bson_t row;
+		gchar key[16];
+		g_autofree gchar* name = NULL;
+
+		g_snprintf(key, sizeof(key), "%u", i);
+		name = g_strdup_printf("row-%u", i);
+
+		bson_append_document_begin(rows, key, -1, &row);
+		bson_append_int64(&row, "_id", -1, i + 1);
+		bson_append_int32(&row, "number", -1, -(gint32)i);
+		bson_append_double(&row, "value", -1, i * 0.5);
+		bson_append_utf8(&row, "name", -1, name, -1);
+
+		// Every other row has a NULL blob
+		if (i % 2 == 0)
+		{
+			bson_append_binary(&row, "data", -1, BSON_SUBTYPE_BINARY, (guint8 const*)name, strlen(name));
+		}
+		else
+		{
+			bson_append_null(&row, "data", -1);
+		}
+
+		bson_append_document_end(rows, &row);
+	}
+}
+
+static void
+test_row_block_encode_decode(void)
+{
+	JRowBlock* row_block;
+	bson_t rows[1];
+	bson_value_t value;
+	g_autofree gpointer data = NULL;
+	guint32 length;
+	guint32 column;
+
+	bson_init(rows);
+	test_row_block_append_rows(rows, 42);
+
+	data = j_row_block_encode(rows, &length);
+	g_assert_nonnull(data);
+	// Field names are only stored once
+	g_assert_cmpuint(length, <, rows->len);
+
+	row_block = j_row_block_new(data, length);
+	g_assert_nonnull(row_block);
+
+	g_assert_cmpuint(j_row_block_get_row_count(row_block), ==, 42);
+	g_assert_cmpuint(j_row_block_get_column_count(row_block), ==, 5);
+	g_assert_cmpstr(j_row_block_get_column_name(row_block, 0), ==, "_id");
+	g_assert_false(j_row_block_get_column_index(row_block, "missing", &column));
+
+	for (guint32 i = 0; i < 42; i++)
+	{
+		g_autofree gchar* name = NULL;
+
+		name = g_strdup_printf("row-%u", i);
+
+		g_assert_true(j_row_block_get_column_index(row_block, "_id", &column));
+		g_assert_true(j_row_block_get_value(row_block, i, column, &value));
+		g_assert_cmpint(value.value_type, ==, BSON_TYPE_INT64);
+		g_assert_cmpint(value.value.v_int64, ==, i + 1);
+
+		g_assert_true(j_row_block_get_column_index(row_block, "number", &column));
+		g_assert_true(j_row_block_get_value(row_block, i, column, &value));
+		g_assert_cmpint(value.value_type, ==, BSON_TYPE_INT32);
+		g_assert_cmpint(value.value.v_int32, ==, -(gint32)i);
+
+		g_assert_true(j_row_block_get_column_index(row_block, "value", &column));
+		g_assert_true(j_row_block_get_value(row_block, i, column, &value));
+		g_assert_cmpint(value.value_type, ==, BSON_TYPE_DOUBLE);
+		g_assert_cmpfloat(value.value.v_double, ==, i * 0.5);
+
+		g_assert_true(j_row_block_get_column_index(row_block, "name", &column));
+		g_assert_true(j_row_block_get_value(row_block, i, column, &value));
+		g_assert_cmpint(value.value_type, ==, BSON_TYPE_UTF8);
+		g_assert_cmpstr(value.value.v_utf8.str, ==, name);
+		g_assert_cmpuint(value.value.v_utf8.len, ==, strlen(name));
+
+		g_assert_true(j_row_block_get_column_index(row_block, "data", &column));
+		g_assert_true(j_row_block_get_value(row_block, i, column, &value));
+
+		if (i % 2 == 0)
+		{
+			g_assert_cmpint(value.value_type, ==, BSON_TYPE_BINARY);
+			g_assert_cmpuint(value.value.v_binary.data_len, ==, strlen(name));
+			g_assert_true(memcmp(value.value.v_binary.data, name, strlen(name)) == 0);
+		}
+		else
+		{
+			g_assert_cmpint(value.value_type, ==, BSON_TYPE_NULL);
+		}
+	}
+
+	j_row_block_free(row_block);
+	bson_destroy(rows);
+}
+
+static void
+test_row_block_empty(void)
+{
+	JRowBlock* row_block;
+	bson_t rows[1];
+	g_autofree gpointer data = NULL;
+	guint32 length;
+
+	bson_init(rows);
+
+	data = j_row_block_encode(rows, &length);
+	g_assert_nonnull(data);
+
+	row_block = j_row_block_new(data, length);
+	g_assert_nonnull(row_block);
+	g_assert_cmpuint(j_row_block_get_row_count(row_block), ==, 0);
+	g_assert_cmpuint(j_row_block_get_column_count(row_block), ==, 0);
+
+	j_row_block_free(row_block);
+	bson_destroy(rows);
+}
+
+static void
+test_row_block_mismatch(void)
+{
+	bson_t rows[1];
+	bson_t row;
+	gpointer data;
+	guint32 length;
+
+	bson_init(rows);
+	test_row_block_append_rows(rows, 2);
+
+	// The type of a column must not change between rows
+	bson_append_document_begin(rows, "2", -1, &row);
+	bson_append_int64(&row, "_id", -1, 3);
+	bson_append_utf8(&row, "number", -1, "three", -1);
+	bson_append_double(&row, "value", -1, 1.5);
+	bson_append_utf8(&row, "name", -1, "row-2", -1);
+	bson_append_null(&row, "data", -1);
+	bson_append_document_end(rows, &row);
+
+	data = j_row_block_encode(rows, &length);
+	g_assert_null(data);
+
+	bson_reinit(rows);
+	test_row_block_append_rows(rows, 2);
+
+	// All rows must have the same columns
+	bson_append_document_begin(rows, "2", -1, &row);
+	bson_append_int64(&row, "_id", -1, 3);
+	bson_append_document_end(rows, &row);
+
+	data = j_row_block_encode(rows, &length);
+	g_assert_null(data);
+
+	bson_destroy(rows);
+}
+
+static void
+test_row_block_malformed(void)
+{
+	bson_t rows[1];
+	g_autofree gpointer data = NULL;
+	guint32 length;
+
+	bson_init(rows);
+	test_row_block_append_rows(rows, 3);
+
+	data = j_row_block_encode(rows, &length);
+	g_assert_nonnull(data);
+
+	for (guint32 i = 0; i < length; i++)
+	{
+		// Truncated row blocks must be rejected
+		g_assert_null(j_row_block_new(data, i));
+	}
+
+	bson_destroy(rows);
+}
+
+void
+test_core_row_block(void)
+{
+	g_test_add_func("/core/row-block/encode_decode", test_row_block_encode_decode);
+	g_test_add_func("/core/row-block/empty", test_row_block_empty);
+	g_test_add_func("/core/row-block/mismatch", test_row_block_mismatch);
+	g_test_add_func("/core/row-block/malformed", test_row_block_malformed);
+}
@@ -0,0 +1,241 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <string.h>
+
+#include <julea.h>
+
+#include "test.h"
+
+static void
+test_transformation_round_trip(JTransformation* transformation, guint64 length)
+{
+	g_autofree gchar* data = NULL;
+	g_autofree gchar* result = NULL;
+	gpointer transformed = NULL;
+	gpointer output;
+	guint64 transformed_length = 0;
+	guint64 transformed_offset = 0;
+	guint64 output_length;
+	guint64 output_offset;
+
+	data = g_malloc(length);
+	result = g_malloc0(length);
+
+	for (guint64 i = 0; i < length; i++)
+	{
+		data[i] = "JULEA"[i % 5] + (i / 1024);
+	}
+
+	j_transformation_apply(transformation, data, length, 0, &transformed, &transformed_length, &transformed_offset, J_TRANSFORMATION_CALLER_CLIENT_WRITE);
+	g_assert_nonnull(transformed);
+	g_assert_cmpuint(transformed_offset, ==, 0);
+
+	if (length >= 1024)
+	{
+		// Repetitive data has to be compressed
+		g_assert_cmpuint(transformed_length, <, length);
+	}
+
+	output = result;
+	output_length = length;
+	output_offset = 0;
+
+	j_transformation_apply(transformation, transformed, transformed_length, 0, &output, &output_length, &output_offset, J_TRANSFORMATION_CALLER_CLIENT_READ);
+	g_assert_true(output == result);
+	g_assert_cmpmem(result, length, data, length);
+
+	j_transformation_cleanup(transformation, transformed, transformed_length, transformed_offset, J_TRANSFORMATION_CALLER_CLIENT_WRITE);
+}
+
+static void
+test_transformation_zstd(void)
+{
+	g_autoptr(JTransformation) transformation = NULL;
+
+	transformation = j_transformation_new(J_TRANSFORMATION_TYPE_ZSTD, J_TRANSFORMATION_MODE_CLIENT);
+	g_assert_nonnull(transformation);
+	g_assert_cmpint(transformation->level, ==, 0);
+	g_assert_true(j_transformation_need_whole_object(transformation, J_TRANSFORMATION_CALLER_CLIENT_WRITE));
+
+	test_transformation_round_trip(transformation, 1);
+	test_transformation_round_trip(transformation, 64 * 1024);
+}
+
+static void
+test_transformation_zstd_level(void)
+{
+	gint32 levels[] = { -5, 1, 19 };
+
+	for (guint i = 0; i < G_N_ELEMENTS(levels); i++)
+	{
+		g_autoptr(JTransformation) transformation = NULL;
+
+		transformation = j_transformation_new_ext(J_TRANSFORMATION_TYPE_ZSTD, J_TRANSFORMATION_MODE_CLIENT, levels[i], 0);
+		g_assert_cmpint(transformation->level, ==, levels[i]);
+
+		test_transformation_round_trip(transformation, 64 * 1024);
+	}
+}
+
+static void
+test_transformation_zstd_dictionary(void)
+{
+	gchar const* data = "not a dictionary";
+
+	// Only trained dictionaries have an ID
+	g_assert_cmpuint(j_transformation_add_dictionary(data, strlen(data)), ==, 0);
+}
+
+static void
+test_transformation_zstd_corrupt(void)
+{
+	g_autoptr(JTransformation) transformation = NULL;
+	g_autofree gchar* data = NULL;
+	g_autofree gchar* transformed = NULL;
+	g_autofree gchar* result = NULL;
+	guint64 const length = 64 * 1024;
+	guint64 bound;
+	guint64 transformed_length;
+	guint64 output_length;
+
+	transformation = j_transformation_new(J_TRANSFORMATION_TYPE_ZSTD, J_TRANSFORMATION_MODE_CLIENT);
+
+	data = g_malloc(length);
+
+	for (guint64 i = 0; i < length; i++)
+	{
+		data[i] = "JULEA"[i % 5] + (i / 1024);
+	}
+
+	transformed_length = j_transformation_get_bound(transformation, NULL, length, 0, J_TRANSFORMATION_CALLER_CLIENT_WRITE);
+	transformed = g_malloc(transformed_length);
+	g_assert_true(j_transformation_apply_into(transformation, data, length, transformed, &transformed_length, J_TRANSFORMATION_CALLER_CLIENT_WRITE));
+
+	// The size stored in the frame is limited by the expected size
+	bound = j_transformation_get_bound(transformation, transformed, transformed_length, 100, J_TRANSFORMATION_CALLER_CLIENT_READ);
+	g_assert_cmpuint(bound, ==, 100);
+
+	// Decompression stops when the output is full
+	result = g_malloc0(length);
+	output_length = 100;
+	g_assert_true(j_transformation_apply_into(transformation, transformed, transformed_length, result, &output_length, J_TRANSFORMATION_CALLER_CLIENT_READ));
+	g_assert_cmpuint(output_length, ==, 100);
+	g_assert_cmpmem(result, 100, data, 100);
+
+	// Truncated data can not be decompressed
+	output_length = length;
+	g_test_expect_message(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "*truncated*");
+	g_assert_false(j_transformation_apply_into(transformation, transformed, transformed_length / 2, result, &output_length, J_TRANSFORMATION_CALLER_CLIENT_READ));
+
+	// Corrupt data can not be decompressed
+	memset(transformed, 0xff, 4);
+	output_length = length;
+	g_test_expect_message(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "*can not be decompressed*");
+	g_assert_false(j_transformation_apply_into(transformation, transformed, transformed_length, result, &output_length, J_TRANSFORMATION_CALLER_CLIENT_READ));
+	g_test_assert_expected_messages();
+}
+
+static void
+test_transformation_lz4_corrupt(void)
+{
+	g_autoptr(JTransformation) transformation = NULL;
+	gchar transformed[16];
+	gchar result[100];
+	guint64 output_length;
+
+	transformation = j_transformation_new(J_TRANSFORMATION_TYPE_LZ4, J_TRANSFORMATION_MODE_CLIENT);
+
+	// The literals' length exceeds the data
+	memset(transformed, 0xff, sizeof(transformed));
+	output_length = sizeof(result);
+	g_test_expect_message(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "*can not be decompressed*");
+	g_assert_false(j_transformation_apply_into(transformation, transformed, sizeof(transformed), result, &output_length, J_TRANSFORMATION_CALLER_CLIENT_READ));
+	g_test_assert_expected_messages();
+}
+
+static void
+test_transformation_apply_into(void)
+{
+	JTransformationType types[] = { J_TRANSFORMATION_TYPE_XOR, J_TRANSFORMATION_TYPE_RLE, J_TRANSFORMATION_TYPE_LZ4, J_TRANSFORMATION_TYPE_ZSTD };
+	guint64 const length = 64 * 1024;
+
+	g_autofree gchar* data = NULL;
+
+	data = g_malloc(length);
+
+	for (guint64 i = 0; i < length; i++)
+	{
+		data[i] = "JULEA"[i % 5] + (i / 1024);
+	}
+
+	for (guint i = 0; i < G_N_ELEMENTS(types); i++)
+	{
+		g_autoptr(JTransformation) transformation = NULL;
+		g_autofree gchar* transformed = NULL;
+		g_autofree gchar* result = NULL;
+		gpointer output;
+		guint64 bound;
+		guint64 transformed_length;
+		guint64 output_length;
+		guint64 output_offset;
+
+		transformation = j_transformation_new(types[i], J_TRANSFORMATION_MODE_CLIENT);
+
+		bound = j_transformation_get_bound(transformation, NULL, length, 0, J_TRANSFORMATION_CALLER_CLIENT_WRITE);
+		g_assert_cmpuint(bound, >=, length);
+
+		transformed = g_malloc(bound);
+		transformed_length = bound;
+		g_assert_true(j_transformation_apply_into(transformation, data, length, transformed, &transformed_length, J_TRANSFORMATION_CALLER_CLIENT_WRITE));
+		g_assert_cmpuint(transformed_length, <=, bound);
+
+		bound = j_transformation_get_bound(transformation, transformed, transformed_length, length, J_TRANSFORMATION_CALLER_CLIENT_READ);
+		g_assert_cmpuint(bound, ==, length);
+
+		result = g_malloc0(length);
+		output_length = length;
+		g_assert_true(j_transformation_apply_into(transformation, transformed, transformed_length, result, &output_length, J_TRANSFORMATION_CALLER_CLIENT_READ));
+		g_assert_cmpuint(output_length, ==, length);
+		g_assert_cmpmem(result, length, data, length);
+
+		// Only a part of the object is requested
+		memset(result, 0, length);
+		output = result;
+		output_length = 100;
+		output_offset = (types[i] == J_TRANSFORMATION_TYPE_XOR) ? 0 : 5000;
+
+		j_transformation_apply(transformation, transformed, (types[i] == J_TRANSFORMATION_TYPE_XOR) ? output_length : transformed_length, 0, &output, &output_length, &output_offset, J_TRANSFORMATION_CALLER_CLIENT_READ);
+		g_assert_cmpmem(result, 100, data + output_offset, 100);
+	}
+}
+
+void
+test_core_transformation(void)
+{
+	g_test_add_func("/core/transformation/zstd", test_transformation_zstd);
+	g_test_add_func("/core/transformation/zstd/level", test_transformation_zstd_level);
+	g_test_add_func("/core/transformation/zstd/dictionary", test_transformation_zstd_dictionary);
+	g_test_add_func("/core/transformation/zstd/corrupt", test_transformation_zstd_corrupt);
+	g_test_add_func("/core/transformation/lz4/corrupt", test_transformation_lz4_corrupt);
+	g_test_add_func("/core/transformation/apply-into", test_transformation_apply_into);
+}
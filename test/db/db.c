@@ -21,6 +21,8 @@
 
 #include <glib.h>
 
+#include <string.h>
+
 #include <julea.h>
 #include <julea-db.h>
 
@@ -108,6 +110,141 @@ test_db_schema_create_delete(void)
 	g_assert_true(ret);
 }
 
+static void
+test_db_schema_index(void)
+{
+	guint const n = 100;
+
+	g_autoptr(GError) error = NULL;
+	g_autoptr(JBatch) batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	g_autoptr(JDBSchema) schema = NULL;
+	g_autoptr(JDBSelector) selector = NULL;
+	g_autoptr(JDBIterator) iterator = NULL;
+	guint64 value = 42;
+	guint count;
+	gboolean ret;
+
+	gchar const* idx_value[] = { "value", NULL };
+	gchar const* idx_value_name[] = { "value", "name", NULL };
+	// Index names must not exceed the databases' identifier lengths
+	gchar const* idx_long[] = { "description_of_the_entry", "value", "name", NULL };
+
+	schema = j_db_schema_new("test-ns", "test-schema-online-index", &error);
+	g_assert_nonnull(schema);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(schema, "value", J_DB_TYPE_UINT64, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(schema, "name", J_DB_TYPE_STRING, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(schema, "description_of_the_entry", J_DB_TYPE_STRING, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_create(schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	for (guint64 i = 0; i < n; i++)
+	{
+		g_autoptr(JDBEntry) entry = NULL;
+		g_autofree gchar* name = NULL;
+
+		name = g_strdup_printf("entry-%" G_GUINT64_FORMAT, i);
+
+		entry = j_db_entry_new(schema, &error);
+		g_assert_nonnull(entry);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_set_field(entry, "value", &i, sizeof(i), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_set_field(entry, "name", name, strlen(name), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		// FIXME Do not pass error, will not exist anymore when batch is executed
+		ret = j_db_entry_insert(entry, batch, NULL);
+		g_assert_true(ret);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	// Existing entries are indexed
+	// FIXME Do not pass error, will not exist anymore when batch is executed
+	ret = j_db_schema_create_index(schema, idx_value, batch, NULL);
+	g_assert_true(ret);
+
+	// FIXME Do not pass error, will not exist anymore when batch is executed
+	ret = j_db_schema_create_index(schema, idx_value_name, batch, NULL);
+	g_assert_true(ret);
+
+	// FIXME Do not pass error, will not exist anymore when batch is executed
+	ret = j_db_schema_create_index(schema, idx_long, batch, NULL);
+	g_assert_true(ret);
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	selector = j_db_selector_new(schema, J_DB_SELECTOR_MODE_AND, &error);
+	g_assert_nonnull(selector);
+	g_assert_no_error(error);
+
+	ret = j_db_selector_add_field(selector, "value", J_DB_SELECTOR_OPERATOR_EQ, &value, sizeof(value), &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	iterator = j_db_iterator_new(schema, selector, &error);
+	g_assert_nonnull(iterator);
+	g_assert_no_error(error);
+
+	count = 0;
+
+	while (j_db_iterator_next(iterator, NULL))
+	{
+		g_autofree gchar* name = NULL;
+		JDBType type;
+		guint64 length;
+
+		ret = j_db_iterator_get_field(iterator, "name", &type, (gpointer*)&name, &length, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+		g_assert_cmpstr(name, ==, "entry-42");
+
+		count++;
+	}
+
+	g_assert_cmpuint(count, ==, 1);
+
+	// FIXME Do not pass error, will not exist anymore when batch is executed
+	ret = j_db_schema_delete_index(schema, idx_value_name, batch, NULL);
+	g_assert_true(ret);
+
+	// FIXME Do not pass error, will not exist anymore when batch is executed
+	ret = j_db_schema_delete_index(schema, idx_long, batch, NULL);
+	g_assert_true(ret);
+
+	// FIXME Do not pass error, will not exist anymore when batch is executed
+	ret = j_db_schema_delete_index(schema, idx_value, batch, NULL);
+	g_assert_true(ret);
+
+	ret = j_db_schema_delete(schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
 static void
 test_db_entry_new_free(void)
 {
@@ -214,6 +351,32 @@ test_db_entry_insert_update_delete(void)
 	g_assert_true(ret);
 	g_assert_no_error(error);
 
+	// All matching entries are updated at once
+	{
+		g_autoptr(JDBIterator) iterator = NULL;
+		guint count = 0;
+
+		iterator = j_db_iterator_new(schema, selector, &error);
+		g_assert_nonnull(iterator);
+		g_assert_no_error(error);
+
+		while (j_db_iterator_next(iterator, NULL))
+		{
+			g_autofree guint64* value = NULL;
+			JDBType type;
+			guint64 len;
+
+			ret = j_db_iterator_get_field(iterator, "dimensions", &type, (gpointer*)&value, &len, &error);
+			g_assert_true(ret);
+			g_assert_no_error(error);
+			g_assert_cmpuint(*value, ==, 3);
+
+			count++;
+		}
+
+		g_assert_cmpuint(count, ==, n);
+	}
+
 	delete_entry = j_db_entry_new(schema, &error);
 	g_assert_nonnull(delete_entry);
 	g_assert_no_error(error);
@@ -234,6 +397,1214 @@ test_db_entry_insert_update_delete(void)
 	g_assert_true(ret);
 }
 
+static void
+test_db_entry_insert_many(void)
+{
+	guint const n = 1000;
+
+	g_autoptr(GError) error = NULL;
+	g_autoptr(JBatch) batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	g_autoptr(JDBIterator) iterator = NULL;
+	g_autoptr(JDBSchema) schema = NULL;
+	g_autoptr(JDBSelector) selector = NULL;
+	g_autoptr(GPtrArray) entries = NULL;
+	g_autofree gboolean* seen = NULL;
+	guint count = 0;
+	gboolean ret;
+
+	schema = j_db_schema_new("test-ns", "test-schema-insert-many", &error);
+	g_assert_nonnull(schema);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(schema, "value", J_DB_TYPE_UINT64, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_create(schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	entries = g_ptr_array_new_with_free_func((GDestroyNotify)j_db_entry_unref);
+
+	// All inserts are part of one batch and can be executed in bulk
+	for (guint64 i = 0; i < n; i++)
+	{
+		JDBEntry* entry;
+
+		entry = j_db_entry_new(schema, &error);
+		g_assert_nonnull(entry);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_set_field(entry, "value", &i, sizeof(i), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		// FIXME Do not pass error, will not exist anymore when batch is executed
+		ret = j_db_entry_insert(entry, batch, NULL);
+		g_assert_true(ret);
+
+		g_ptr_array_add(entries, entry);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	for (guint i = 0; i < n; i++)
+	{
+		g_autofree gpointer id = NULL;
+		guint64 len;
+
+		ret = j_db_entry_get_id(g_ptr_array_index(entries, i), &id, &len, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+		g_assert_nonnull(id);
+	}
+
+	selector = j_db_selector_new(schema, J_DB_SELECTOR_MODE_AND, &error);
+	g_assert_nonnull(selector);
+	g_assert_no_error(error);
+
+	iterator = j_db_iterator_new(schema, selector, &error);
+	g_assert_nonnull(iterator);
+	g_assert_no_error(error);
+
+	seen = g_new0(gboolean, n);
+
+	while (j_db_iterator_next(iterator, NULL))
+	{
+		g_autofree guint64* value = NULL;
+		JDBType type;
+		guint64 len;
+
+		ret = j_db_iterator_get_field(iterator, "value", &type, (gpointer*)&value, &len, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+		g_assert_cmpuint(*value, <, n);
+		g_assert_false(seen[*value]);
+
+		seen[*value] = TRUE;
+		count++;
+	}
+
+	g_assert_cmpuint(count, ==, n);
+
+	ret = j_db_schema_delete(schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+static void
+test_db_entry_shard_key(void)
+{
+	guint const n = 100;
+
+	g_autoptr(GError) error = NULL;
+	g_autoptr(JBatch) batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	g_autoptr(JDBIterator) iterator = NULL;
+	g_autoptr(JDBSchema) schema = NULL;
+	g_autofree gboolean* found = NULL;
+	gboolean ret;
+
+	found = g_new0(gboolean, n);
+
+	schema = j_db_schema_new("test-ns", "test-schema-shard", &error);
+	g_assert_nonnull(schema);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(schema, "name", J_DB_TYPE_STRING, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(schema, "value", J_DB_TYPE_UINT64, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	// Unknown fields can not be used as shard key
+	ret = j_db_schema_set_shard_key(schema, "nmae", &error);
+	g_assert_false(ret);
+	g_assert_error(error, J_DB_ERROR, J_DB_ERROR_VARIABLE_NOT_FOUND);
+	g_clear_error(&error);
+
+	ret = j_db_schema_set_shard_key(schema, "name", &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_create(schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	for (guint64 i = 0; i < n; i++)
+	{
+		g_autoptr(JDBEntry) entry = NULL;
+		g_autofree gchar* name = NULL;
+
+		name = g_strdup_printf("test-shard-%" G_GUINT64_FORMAT, i);
+
+		entry = j_db_entry_new(schema, &error);
+		g_assert_nonnull(entry);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_set_field(entry, "name", name, strlen(name), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_set_field(entry, "value", &i, sizeof(i), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		// FIXME Do not pass error, will not exist anymore when batch is executed
+		ret = j_db_entry_insert(entry, batch, NULL);
+		g_assert_true(ret);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	// The results of all servers have to be merged
+	iterator = j_db_iterator_new(schema, NULL, &error);
+	g_assert_nonnull(iterator);
+	g_assert_no_error(error);
+
+	while (j_db_iterator_next(iterator, NULL))
+	{
+		g_autofree guint64* value = NULL;
+		JDBType type;
+		guint64 len;
+
+		ret = j_db_iterator_get_field(iterator, "value", &type, (gpointer*)&value, &len, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+		g_assert_cmpuint(*value, <, n);
+		g_assert_false(found[*value]);
+
+		found[*value] = TRUE;
+	}
+
+	for (guint i = 0; i < n; i++)
+	{
+		g_assert_true(found[i]);
+	}
+
+	ret = j_db_schema_delete(schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+static void
+test_db_entry_id_range(void)
+{
+	for (guint32 count = 1; count <= 16; count++)
+	{
+		g_assert_cmpuint(j_backend_db_id_base(0, count), ==, 1);
+
+		for (guint32 i = 0; i < count; i++)
+		{
+			guint32 base;
+
+			base = j_backend_db_id_base(i, count);
+			g_assert_cmpuint(base, <=, G_MAXINT32);
+			g_assert_cmpuint(j_backend_db_id_server(base, count), ==, i);
+			g_assert_cmpuint(j_backend_db_id_server(base + 1000, count), ==, i);
+
+			if (i > 0)
+			{
+				g_assert_cmpuint(j_backend_db_id_server(base - 1, count), ==, i - 1);
+			}
+		}
+	}
+}
+
+static void
+test_db_entry_id_shards(void)
+{
+	guint const n = 20;
+
+	g_autoptr(GError) error = NULL;
+	g_autoptr(JBatch) batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	g_autoptr(JDBSchema) schema = NULL;
+	g_autoptr(JDBSchema) schema_get = NULL;
+	g_autoptr(GPtrArray) entries = NULL;
+	g_autofree guint32* ids = NULL;
+	g_autofree gboolean* servers = NULL;
+	guint32 server_count;
+	guint64 value;
+	guint count;
+	gboolean ret;
+
+	server_count = j_configuration_get_server_count(j_configuration(), J_BACKEND_TYPE_DB);
+
+	if (server_count < 2)
+	{
+		g_test_skip("Requires multiple DB servers");
+		return;
+	}
+
+	entries = g_ptr_array_new_with_free_func((GDestroyNotify)j_db_entry_unref);
+	ids = g_new(guint32, n);
+	servers = g_new0(gboolean, server_count);
+
+	schema = j_db_schema_new("test-ns", "test-schema-id-shards", &error);
+	g_assert_nonnull(schema);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(schema, "value", J_DB_TYPE_UINT64, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_create(schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	// Entries are distributed round-robin
+	for (guint64 i = 0; i < n; i++)
+	{
+		JDBEntry* entry;
+
+		entry = j_db_entry_new(schema, &error);
+		g_assert_nonnull(entry);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_set_field(entry, "value", &i, sizeof(i), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		// FIXME Do not pass error, will not exist anymore when batch is executed
+		ret = j_db_entry_insert(entry, batch, NULL);
+		g_assert_true(ret);
+
+		g_ptr_array_add(entries, entry);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	// IDs are unique across all servers
+	for (guint i = 0; i < n; i++)
+	{
+		g_autofree guint32* id = NULL;
+		guint64 length;
+
+		ret = j_db_entry_get_id(g_ptr_array_index(entries, i), (gpointer*)&id, &length, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		for (guint j = 0; j < i; j++)
+		{
+			g_assert_cmpuint(ids[j], !=, *id);
+		}
+
+		ids[i] = *id;
+		servers[j_backend_db_id_server(*id, server_count)] = TRUE;
+	}
+
+	for (guint i = 0; i < server_count; i++)
+	{
+		g_assert_true(servers[i]);
+	}
+
+	// The schema returned by the server contains the _id field
+	schema_get = j_db_schema_new("test-ns", "test-schema-id-shards", &error);
+	g_assert_nonnull(schema_get);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_get(schema_get, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	// Updates by ID only change the entry on the server that stores it
+	for (guint i = 0; i < server_count; i++)
+	{
+		g_autoptr(JDBEntry) entry = NULL;
+		g_autoptr(JDBSelector) selector = NULL;
+
+		value = n + i;
+
+		entry = j_db_entry_new(schema_get, &error);
+		g_assert_nonnull(entry);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_set_field(entry, "value", &value, sizeof(value), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		selector = j_db_selector_new(schema_get, J_DB_SELECTOR_MODE_AND, &error);
+		g_assert_nonnull(selector);
+		g_assert_no_error(error);
+
+		ret = j_db_selector_add_field(selector, "_id", J_DB_SELECTOR_OPERATOR_EQ, &ids[i], sizeof(ids[i]), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_update(entry, selector, batch, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_batch_execute(batch);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+	}
+
+	for (guint i = 0; i < server_count; i++)
+	{
+		g_autoptr(JDBSelector) selector = NULL;
+		g_autoptr(JDBIterator) iterator = NULL;
+
+		value = n + i;
+
+		selector = j_db_selector_new(schema_get, J_DB_SELECTOR_MODE_AND, &error);
+		g_assert_nonnull(selector);
+		g_assert_no_error(error);
+
+		ret = j_db_selector_add_field(selector, "value", J_DB_SELECTOR_OPERATOR_EQ, &value, sizeof(value), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		iterator = j_db_iterator_new(schema_get, selector, &error);
+		g_assert_nonnull(iterator);
+		g_assert_no_error(error);
+
+		count = 0;
+
+		while (j_db_iterator_next(iterator, NULL))
+		{
+			g_autofree guint32* id = NULL;
+			JDBType type;
+			guint64 length;
+
+			ret = j_db_iterator_get_field(iterator, "_id", &type, (gpointer*)&id, &length, &error);
+			g_assert_true(ret);
+			g_assert_no_error(error);
+			g_assert_cmpuint(*id, ==, ids[i]);
+
+			count++;
+		}
+
+		g_assert_cmpuint(count, ==, 1);
+	}
+
+	// Deleting an entry that only exists on one server succeeds
+	for (guint i = 0; i < 2; i++)
+	{
+		g_autoptr(JDBEntry) entry = NULL;
+		g_autoptr(JDBSelector) selector = NULL;
+
+		value = n - 1;
+
+		entry = j_db_entry_new(schema_get, &error);
+		g_assert_nonnull(entry);
+		g_assert_no_error(error);
+
+		selector = j_db_selector_new(schema_get, J_DB_SELECTOR_MODE_AND, &error);
+		g_assert_nonnull(selector);
+		g_assert_no_error(error);
+
+		ret = j_db_selector_add_field(selector, "value", J_DB_SELECTOR_OPERATOR_EQ, &value, sizeof(value), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_delete(entry, selector, batch, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_batch_execute(batch);
+
+		// Only fails if no server has a matching entry
+		if (i == 0)
+		{
+			g_assert_true(ret);
+			g_assert_no_error(error);
+		}
+		else
+		{
+			g_assert_false(ret);
+			g_assert_error(error, J_BACKEND_DB_ERROR, J_BACKEND_DB_ERROR_ITERATOR_NO_MORE_ELEMENTS);
+			g_clear_error(&error);
+		}
+	}
+
+	ret = j_db_schema_delete(schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+static void
+test_db_iterator_pages(void)
+{
+	// Results span multiple pages
+	guint const n = 1200;
+
+	g_autoptr(GError) error = NULL;
+	g_autoptr(JBatch) batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	g_autoptr(JDBSchema) schema = NULL;
+	JDBIterator* iterator;
+	guint count;
+	gboolean ret;
+
+	schema = j_db_schema_new("test-ns", "test-schema-pages", &error);
+	g_assert_nonnull(schema);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(schema, "value", J_DB_TYPE_UINT64, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_create(schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	for (guint64 i = 0; i < n; i++)
+	{
+		g_autoptr(JDBEntry) entry = NULL;
+
+		entry = j_db_entry_new(schema, &error);
+		g_assert_nonnull(entry);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_set_field(entry, "value", &i, sizeof(i), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		// FIXME Do not pass error, will not exist anymore when batch is executed
+		ret = j_db_entry_insert(entry, batch, NULL);
+		g_assert_true(ret);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	iterator = j_db_iterator_new(schema, NULL, &error);
+	g_assert_nonnull(iterator);
+	g_assert_no_error(error);
+
+	count = 0;
+
+	while (j_db_iterator_next(iterator, NULL))
+	{
+		count++;
+	}
+
+	g_assert_cmpuint(count, ==, n);
+	j_db_iterator_unref(iterator);
+
+	// Projected and aggregated results are split into pages, too
+	for (guint i = 0; i < 2; i++)
+	{
+		g_autoptr(JDBSelector) selector = NULL;
+		gchar const* projection[] = { "value", NULL };
+
+		selector = j_db_selector_new(schema, J_DB_SELECTOR_MODE_AND, &error);
+		g_assert_nonnull(selector);
+		g_assert_no_error(error);
+
+		if (i == 0)
+		{
+			ret = j_db_selector_set_projection(selector, projection, &error);
+		}
+		else
+		{
+			ret = j_db_selector_add_aggregate(selector, "count", J_DB_SELECTOR_AGGREGATE_COUNT, NULL, &error);
+			g_assert_true(ret);
+			g_assert_no_error(error);
+
+			ret = j_db_selector_add_group(selector, "value", &error);
+		}
+
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		iterator = j_db_iterator_new(schema, selector, &error);
+		g_assert_nonnull(iterator);
+		g_assert_no_error(error);
+
+		count = 0;
+
+		while (j_db_iterator_next(iterator, NULL))
+		{
+			g_autofree guint64* value = NULL;
+			JDBType type;
+			guint64 len;
+
+			ret = j_db_iterator_get_field(iterator, "value", &type, (gpointer*)&value, &len, &error);
+			g_assert_true(ret);
+			g_assert_no_error(error);
+			g_assert_cmpuint(*value, <, n);
+
+			count++;
+		}
+
+		g_assert_cmpuint(count, ==, n);
+		j_db_iterator_unref(iterator);
+	}
+
+	// Iterators can be freed before all results have been fetched
+	iterator = j_db_iterator_new(schema, NULL, &error);
+	g_assert_nonnull(iterator);
+	g_assert_no_error(error);
+
+	ret = j_db_iterator_next(iterator, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	j_db_iterator_unref(iterator);
+
+	ret = j_db_schema_delete(schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+static void
+test_db_iterator_field_index(void)
+{
+	// Results span multiple pages
+	guint const n = 1200;
+
+	g_autoptr(GError) error = NULL;
+	g_autoptr(JBatch) batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	g_autoptr(JDBSchema) schema = NULL;
+	g_autoptr(JDBIterator) iterator = NULL;
+	guint32 value_index;
+	guint32 name_index;
+	guint count;
+	gboolean ret;
+
+	schema = j_db_schema_new("test-ns", "test-schema-index", &error);
+	g_assert_nonnull(schema);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(schema, "value", J_DB_TYPE_UINT64, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(schema, "name", J_DB_TYPE_STRING, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_get_field_index(schema, "value", &value_index, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+	g_assert_cmpuint(value_index, ==, 0);
+
+	ret = j_db_schema_get_field_index(schema, "name", &name_index, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+	g_assert_cmpuint(name_index, ==, 1);
+
+	ret = j_db_schema_get_field_index(schema, "missing", &name_index, &error);
+	g_assert_false(ret);
+	g_assert_error(error, J_DB_ERROR, J_DB_ERROR_VARIABLE_NOT_FOUND);
+	g_clear_error(&error);
+
+	ret = j_db_schema_create(schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	for (guint64 i = 0; i < n; i++)
+	{
+		g_autoptr(JDBEntry) entry = NULL;
+		g_autofree gchar* name = NULL;
+
+		name = g_strdup_printf("entry-%" G_GUINT64_FORMAT, i);
+
+		entry = j_db_entry_new(schema, &error);
+		g_assert_nonnull(entry);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_set_field_by_index(entry, value_index, &i, sizeof(i), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_set_field_by_index(entry, name_index, name, strlen(name), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		// Fields set by index cannot be set again by name
+		ret = j_db_entry_set_field(entry, "value", &i, sizeof(i), &error);
+		g_assert_false(ret);
+		g_assert_error(error, J_DB_ERROR, J_DB_ERROR_VARIABLE_ALREADY_SET);
+		g_clear_error(&error);
+
+		// FIXME Do not pass error, will not exist anymore when batch is executed
+		ret = j_db_entry_insert(entry, batch, NULL);
+		g_assert_true(ret);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	iterator = j_db_iterator_new(schema, NULL, &error);
+	g_assert_nonnull(iterator);
+	g_assert_no_error(error);
+
+	count = 0;
+
+	while (j_db_iterator_next(iterator, NULL))
+	{
+		g_autofree guint64* value = NULL;
+		g_autofree gchar* name = NULL;
+		g_autofree gchar* expected = NULL;
+		JDBType type;
+		guint64 length;
+
+		ret = j_db_iterator_get_field_by_index(iterator, value_index, &type, (gpointer*)&value, &length, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+		g_assert_cmpint(type, ==, J_DB_TYPE_UINT64);
+		g_assert_cmpuint(length, ==, sizeof(guint64));
+
+		ret = j_db_iterator_get_field_by_index(iterator, name_index, &type, (gpointer*)&name, &length, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+		g_assert_cmpint(type, ==, J_DB_TYPE_STRING);
+
+		expected = g_strdup_printf("entry-%" G_GUINT64_FORMAT, *value);
+		g_assert_cmpstr(name, ==, expected);
+
+		count++;
+	}
+
+	g_assert_cmpuint(count, ==, n);
+
+	ret = j_db_schema_delete(schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+static guint
+test_db_selector_count(JDBSchema* schema, JDBSelector* selector)
+{
+	g_autoptr(GError) error = NULL;
+	g_autoptr(JDBIterator) iterator = NULL;
+	guint count = 0;
+
+	iterator = j_db_iterator_new(schema, selector, &error);
+	g_assert_nonnull(iterator);
+	g_assert_no_error(error);
+
+	while (j_db_iterator_next(iterator, NULL))
+	{
+		count++;
+	}
+
+	return count;
+}
+
+static void
+test_db_selector_order_limit(void)
+{
+	guint const n = 20;
+
+	g_autoptr(GError) error = NULL;
+	g_autoptr(JBatch) batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	g_autoptr(JDBIterator) iterator = NULL;
+	g_autoptr(JDBSchema) schema = NULL;
+	g_autoptr(JDBSelector) selector = NULL;
+	gchar const* projection[] = { "value", NULL };
+	guint64 expected;
+	gboolean ret;
+
+	schema = j_db_schema_new("test-ns", "test-schema-order", &error);
+	g_assert_nonnull(schema);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(schema, "name", J_DB_TYPE_STRING, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(schema, "value", J_DB_TYPE_UINT64, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_create(schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	for (guint64 i = 0; i < n; i++)
+	{
+		g_autoptr(JDBEntry) entry = NULL;
+		g_autofree gchar* name = NULL;
+
+		name = g_strdup_printf("test-order-%" G_GUINT64_FORMAT, i);
+
+		entry = j_db_entry_new(schema, &error);
+		g_assert_nonnull(entry);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_set_field(entry, "name", name, strlen(name), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_set_field(entry, "value", &i, sizeof(i), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		// FIXME Do not pass error, will not exist anymore when batch is executed
+		ret = j_db_entry_insert(entry, batch, NULL);
+		g_assert_true(ret);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	selector = j_db_selector_new(schema, J_DB_SELECTOR_MODE_AND, &error);
+	g_assert_nonnull(selector);
+	g_assert_no_error(error);
+
+	ret = j_db_selector_set_projection(selector, projection, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_selector_add_order(selector, "value", J_DB_SELECTOR_ORDER_DESCENDING, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_selector_set_limit(selector, 5, 2, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	iterator = j_db_iterator_new(schema, selector, &error);
+	g_assert_nonnull(iterator);
+	g_assert_no_error(error);
+
+	expected = n - 1 - 2;
+
+	while (j_db_iterator_next(iterator, NULL))
+	{
+		g_autofree guint64* value = NULL;
+		g_autofree gchar* name = NULL;
+		JDBType type;
+		guint64 len;
+
+		ret = j_db_iterator_get_field(iterator, "value", &type, (gpointer*)&value, &len, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+		g_assert_cmpuint(*value, ==, expected);
+
+		// Fields that are not part of the projection are not returned
+		ret = j_db_iterator_get_field(iterator, "name", &type, (gpointer*)&name, &len, NULL);
+		g_assert_false(ret);
+
+		expected--;
+	}
+
+	g_assert_cmpuint(expected, ==, n - 1 - 2 - 5);
+
+	// With multiple DB servers, the servers' sorted results are merged
+	g_clear_pointer(&iterator, j_db_iterator_unref);
+	g_clear_pointer(&selector, j_db_selector_unref);
+
+	selector = j_db_selector_new(schema, J_DB_SELECTOR_MODE_AND, &error);
+	g_assert_nonnull(selector);
+	g_assert_no_error(error);
+
+	ret = j_db_selector_add_order(selector, "value", J_DB_SELECTOR_ORDER_ASCENDING, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	iterator = j_db_iterator_new(schema, selector, &error);
+	g_assert_nonnull(iterator);
+	g_assert_no_error(error);
+
+	expected = 0;
+
+	while (j_db_iterator_next(iterator, NULL))
+	{
+		g_autofree guint64* value = NULL;
+		JDBType type;
+		guint64 len;
+
+		ret = j_db_iterator_get_field(iterator, "value", &type, (gpointer*)&value, &len, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+		g_assert_cmpuint(*value, ==, expected);
+
+		expected++;
+	}
+
+	g_assert_cmpuint(expected, ==, n);
+
+	// Limits apply to all results, not to each server's results
+	g_clear_pointer(&iterator, j_db_iterator_unref);
+	g_clear_pointer(&selector, j_db_selector_unref);
+
+	selector = j_db_selector_new(schema, J_DB_SELECTOR_MODE_AND, &error);
+	g_assert_nonnull(selector);
+	g_assert_no_error(error);
+
+	ret = j_db_selector_set_limit(selector, 5, n - 3, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	g_assert_cmpuint(test_db_selector_count(schema, selector), ==, 3);
+
+	ret = j_db_schema_delete(schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+static void
+test_db_selector_operators(void)
+{
+	guint const n = 100;
+
+	g_autoptr(GError) error = NULL;
+	g_autoptr(JBatch) batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	g_autoptr(JDBSchema) schema = NULL;
+	guint64 values[] = { 3, 5, 7, 5, 1000 };
+	gchar const* names[] = { "test-op-1", "test-op-2", "missing" };
+	guint64 lower = 10;
+	guint64 upper = 19;
+	gboolean ret;
+
+	gchar const* idx_value[] = { "value", NULL };
+
+	schema = j_db_schema_new("test-ns", "test-schema-operators", &error);
+	g_assert_nonnull(schema);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(schema, "name", J_DB_TYPE_STRING, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(schema, "value", J_DB_TYPE_UINT64, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_index(schema, idx_value, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_create(schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	for (guint64 i = 0; i < n; i++)
+	{
+		g_autoptr(JDBEntry) entry = NULL;
+		g_autofree gchar* name = NULL;
+
+		name = g_strdup_printf("test-op-%" G_GUINT64_FORMAT, i);
+
+		entry = j_db_entry_new(schema, &error);
+		g_assert_nonnull(entry);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_set_field(entry, "name", name, strlen(name), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_set_field(entry, "value", &i, sizeof(i), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		// FIXME Do not pass error, will not exist anymore when batch is executed
+		ret = j_db_entry_insert(entry, batch, NULL);
+		g_assert_true(ret);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	{
+		g_autoptr(JDBSelector) selector = NULL;
+
+		selector = j_db_selector_new(schema, J_DB_SELECTOR_MODE_AND, &error);
+		g_assert_nonnull(selector);
+		g_assert_no_error(error);
+
+		// Lists have their own function
+		ret = j_db_selector_add_field(selector, "value", J_DB_SELECTOR_OPERATOR_IN, values, sizeof(values[0]), &error);
+		g_assert_false(ret);
+		g_assert_error(error, J_DB_ERROR, J_DB_ERROR_OPERATOR_INVALID);
+		g_clear_error(&error);
+
+		// Duplicate values do not return entries twice
+		ret = j_db_selector_add_field_in(selector, "value", values, NULL, G_N_ELEMENTS(values), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		g_assert_cmpuint(test_db_selector_count(schema, selector), ==, 3);
+	}
+
+	{
+		g_autoptr(JDBSelector) selector = NULL;
+
+		selector = j_db_selector_new(schema, J_DB_SELECTOR_MODE_AND, &error);
+		g_assert_nonnull(selector);
+		g_assert_no_error(error);
+
+		ret = j_db_selector_add_field_in(selector, "name", names, NULL, G_N_ELEMENTS(names), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		g_assert_cmpuint(test_db_selector_count(schema, selector), ==, 2);
+	}
+
+	{
+		g_autoptr(JDBSelector) selector = NULL;
+
+		selector = j_db_selector_new(schema, J_DB_SELECTOR_MODE_AND, &error);
+		g_assert_nonnull(selector);
+		g_assert_no_error(error);
+
+		ret = j_db_selector_add_field_between(selector, "value", &lower, sizeof(lower), &upper, sizeof(upper), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		g_assert_cmpuint(test_db_selector_count(schema, selector), ==, 10);
+	}
+
+	{
+		g_autoptr(JDBSelector) selector = NULL;
+
+		selector = j_db_selector_new(schema, J_DB_SELECTOR_MODE_AND, &error);
+		g_assert_nonnull(selector);
+		g_assert_no_error(error);
+
+		// Prefixes only apply to strings
+		ret = j_db_selector_add_field(selector, "value", J_DB_SELECTOR_OPERATOR_PREFIX, &lower, sizeof(lower), &error);
+		g_assert_false(ret);
+		g_assert_error(error, J_DB_ERROR, J_DB_ERROR_TYPE_INVALID);
+		g_clear_error(&error);
+
+		// test-op-1 and test-op-10 to test-op-19
+		ret = j_db_selector_add_field(selector, "name", J_DB_SELECTOR_OPERATOR_PREFIX, "test-op-1", 0, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		g_assert_cmpuint(test_db_selector_count(schema, selector), ==, 11);
+	}
+
+	{
+		g_autoptr(JDBSelector) selector = NULL;
+
+		selector = j_db_selector_new(schema, J_DB_SELECTOR_MODE_AND, &error);
+		g_assert_nonnull(selector);
+		g_assert_no_error(error);
+
+		// Wildcards are matched literally
+		ret = j_db_selector_add_field(selector, "name", J_DB_SELECTOR_OPERATOR_PREFIX, "test_op%", 0, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		g_assert_cmpuint(test_db_selector_count(schema, selector), ==, 0);
+	}
+
+	ret = j_db_schema_delete(schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+static void
+test_db_selector_aggregate(void)
+{
+	guint const n = 20;
+
+	g_autoptr(GError) error = NULL;
+	g_autoptr(JBatch) batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	g_autoptr(JDBIterator) iterator = NULL;
+	g_autoptr(JDBSchema) schema = NULL;
+	g_autoptr(JDBSelector) selector = NULL;
+	guint32 groups = 0;
+	gboolean ret;
+
+	schema = j_db_schema_new("test-ns", "test-schema-aggregate", &error);
+	g_assert_nonnull(schema);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(schema, "parity", J_DB_TYPE_UINT32, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_add_field(schema, "value", J_DB_TYPE_UINT64, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_schema_create(schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	for (guint64 i = 0; i < n; i++)
+	{
+		g_autoptr(JDBEntry) entry = NULL;
+		guint32 parity = i % 2;
+
+		entry = j_db_entry_new(schema, &error);
+		g_assert_nonnull(entry);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_set_field(entry, "parity", &parity, sizeof(parity), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		ret = j_db_entry_set_field(entry, "value", &i, sizeof(i), &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+
+		// FIXME Do not pass error, will not exist anymore when batch is executed
+		ret = j_db_entry_insert(entry, batch, NULL);
+		g_assert_true(ret);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	selector = j_db_selector_new(schema, J_DB_SELECTOR_MODE_AND, &error);
+	g_assert_nonnull(selector);
+	g_assert_no_error(error);
+
+	ret = j_db_selector_add_aggregate(selector, "count", J_DB_SELECTOR_AGGREGATE_COUNT, NULL, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_selector_add_aggregate(selector, "total", J_DB_SELECTOR_AGGREGATE_SUM, "value", &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_selector_add_aggregate(selector, "maximum", J_DB_SELECTOR_AGGREGATE_MAX, "value", &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_selector_add_aggregate(selector, "average", J_DB_SELECTOR_AGGREGATE_AVG, "value", &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_selector_add_aggregate(selector, "minimum", J_DB_SELECTOR_AGGREGATE_MIN, "value", &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	// With multiple DB servers, averages are combined from a sum and a count whose name must not clash with this one
+	ret = j_db_selector_add_aggregate(selector, "average_count", J_DB_SELECTOR_AGGREGATE_COUNT, "value", &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	// Aggregate names must not clash with fields
+	ret = j_db_selector_add_aggregate(selector, "value", J_DB_SELECTOR_AGGREGATE_MIN, "value", &error);
+	g_assert_false(ret);
+	g_assert_error(error, J_DB_ERROR, J_DB_ERROR_VARIABLE_ALREADY_SET);
+	g_clear_error(&error);
+
+	ret = j_db_selector_add_group(selector, "parity", &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_db_selector_add_order(selector, "parity", J_DB_SELECTOR_ORDER_ASCENDING, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	iterator = j_db_iterator_new(schema, selector, &error);
+	g_assert_nonnull(iterator);
+	g_assert_no_error(error);
+
+	while (j_db_iterator_next(iterator, NULL))
+	{
+		g_autofree guint32* parity = NULL;
+		g_autofree guint64* count = NULL;
+		g_autofree guint64* total = NULL;
+		g_autofree guint64* maximum = NULL;
+		g_autofree gdouble* average = NULL;
+		g_autofree guint64* minimum = NULL;
+		g_autofree guint64* average_count = NULL;
+		JDBType type;
+		guint64 len;
+
+		ret = j_db_iterator_get_field(iterator, "parity", &type, (gpointer*)&parity, &len, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+		g_assert_cmpuint(*parity, ==, groups);
+
+		ret = j_db_iterator_get_field(iterator, "count", &type, (gpointer*)&count, &len, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+		g_assert_cmpint(type, ==, J_DB_TYPE_UINT64);
+		g_assert_cmpuint(*count, ==, n / 2);
+
+		ret = j_db_iterator_get_field(iterator, "total", &type, (gpointer*)&total, &len, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+		g_assert_cmpuint(*total, ==, (n / 2) * (n / 2 - 1) + groups * (n / 2));
+
+		ret = j_db_iterator_get_field(iterator, "maximum", &type, (gpointer*)&maximum, &len, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+		g_assert_cmpuint(*maximum, ==, n - 2 + groups);
+
+		ret = j_db_iterator_get_field(iterator, "average", &type, (gpointer*)&average, &len, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+		g_assert_cmpint(type, ==, J_DB_TYPE_FLOAT64);
+		g_assert_cmpfloat(*average, ==, (n / 2 - 1) + groups);
+
+		ret = j_db_iterator_get_field(iterator, "minimum", &type, (gpointer*)&minimum, &len, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+		g_assert_cmpuint(*minimum, ==, groups);
+
+		ret = j_db_iterator_get_field(iterator, "average_count", &type, (gpointer*)&average_count, &len, &error);
+		g_assert_true(ret);
+		g_assert_no_error(error);
+		g_assert_cmpuint(*average_count, ==, n / 2);
+
+		groups++;
+	}
+
+	g_assert_cmpuint(groups, ==, 2);
+
+	ret = j_db_schema_delete(schema, batch, &error);
+	g_assert_true(ret);
+	g_assert_no_error(error);
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
 static void
 schema_create(void)
 {
@@ -539,7 +1910,17 @@ test_db_db(void)
 	// FIXME add more tests
 	g_test_add_func("/db/schema/new_free", test_db_schema_new_free);
 	g_test_add_func("/db/schema/create_delete", test_db_schema_create_delete);
+	g_test_add_func("/db/schema/index", test_db_schema_index);
 	g_test_add_func("/db/entry/new_free", test_db_entry_new_free);
 	g_test_add_func("/db/entry/insert_update_delete", test_db_entry_insert_update_delete);
+	g_test_add_func("/db/entry/insert_many", test_db_entry_insert_many);
+	g_test_add_func("/db/entry/shard_key", test_db_entry_shard_key);
+	g_test_add_func("/db/entry/id_range", test_db_entry_id_range);
+	g_test_add_func("/db/entry/id_shards", test_db_entry_id_shards);
+	g_test_add_func("/db/iterator/pages", test_db_iterator_pages);
+	g_test_add_func("/db/iterator/field_index", test_db_iterator_field_index);
+	g_test_add_func("/db/selector/order_limit", test_db_selector_order_limit);
+	g_test_add_func("/db/selector/operators", test_db_selector_operators);
+	g_test_add_func("/db/selector/aggregate", test_db_selector_aggregate);
 	g_test_add_func("/db/all", test_db_all);
 }
@@ -0,0 +1,161 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2020 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#include <string.h>
+
+#include <julea.h>
+
+#include "test.h"
+
+/**
+ * Loads a private instance of the memory backend.
+ * The backend is copied so a memory backend used by the client itself is not affected.
+ **/
+static gboolean
+test_kv_memory_load(JBackend* backend, GModule** module)
+{
+	JBackend* tmp_backend = NULL;
+
+	if (!j_backend_load_client("memory", "client", J_BACKEND_TYPE_KV, module, &tmp_backend) || tmp_backend == NULL)
+	{
+		return FALSE;
+	}
+
+	*backend = *tmp_backend;
+
+	return TRUE;
+}
+
+static void
+test_kv_memory_snapshot(void)
+{
+	guint const n = 100;
+
+	JBackend backend[1];
+	GModule* module = NULL;
+	g_autoptr(JSemantics) semantics = NULL;
+	g_autoptr(GError) error = NULL;
+	g_autofree gchar* dir = NULL;
+	g_autofree gchar* snapshot = NULL;
+	gpointer batch;
+	gpointer iterator;
+	gchar const* key;
+	gconstpointer value;
+	guint32 len;
+	guint count;
+	gboolean ret;
+
+	if (!test_kv_memory_load(backend, &module))
+	{
+		g_test_skip("Memory backend not available");
+		return;
+	}
+
+	dir = g_dir_make_tmp("julea-kv-memory-XXXXXX", &error);
+	g_assert_no_error(error);
+
+	snapshot = g_build_filename(dir, "snapshot", NULL);
+	semantics = j_semantics_new(J_SEMANTICS_TEMPLATE_DEFAULT);
+
+	ret = j_backend_kv_init(backend, snapshot);
+	g_assert_true(ret);
+
+	ret = j_backend_kv_batch_start(backend, "test-ns", semantics, &batch);
+	g_assert_true(ret);
+
+	for (guint i = 0; i < n; i++)
+	{
+		g_autofree gchar* k = NULL;
+
+		k = g_strdup_printf("test-key-%03u", i);
+		ret = j_backend_kv_put(backend, batch, k, &i, sizeof(i));
+		g_assert_true(ret);
+	}
+
+	ret = j_backend_kv_batch_execute(backend, batch);
+	g_assert_true(ret);
+
+	// Shutting down writes the snapshot
+	j_backend_kv_fini(backend);
+	g_assert_true(g_file_test(snapshot, G_FILE_TEST_IS_REGULAR));
+
+	ret = j_backend_kv_init(backend, snapshot);
+	g_assert_true(ret);
+
+	ret = j_backend_kv_get_by_prefix(backend, "test-ns", "test-key-", &iterator);
+	g_assert_true(ret);
+
+	count = 0;
+
+	// The restored entries have to be returned in key order
+	while (j_backend_kv_iterate(backend, iterator, &key, &value, &len))
+	{
+		g_autofree gchar* k = NULL;
+
+		k = g_strdup_printf("test-key-%03u", count);
+		g_assert_cmpstr(key, ==, k);
+		g_assert_cmpuint(len, ==, sizeof(count));
+		g_assert_cmpmem(value, len, &count, sizeof(count));
+
+		count++;
+	}
+
+	g_assert_cmpuint(count, ==, n);
+
+	j_backend_kv_fini(backend);
+
+	// A corrupt snapshot must not be replaced by an empty store
+	ret = g_file_set_contents(snapshot, "corrupt", -1, &error);
+	g_assert_no_error(error);
+	g_assert_true(ret);
+
+	g_test_expect_message(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "*unknown format*");
+	g_test_expect_message(G_LOG_DOMAIN, G_LOG_LEVEL_CRITICAL, "*Could not restore snapshot*");
+	ret = j_backend_kv_init(backend, snapshot);
+	g_test_assert_expected_messages();
+	g_assert_false(ret);
+
+	// Lengths beyond the end of the snapshot must not be allocated
+	{
+		gchar const corrupt[] = { 'J', 'K', 'V', 'M', 'E', 'M', '0', '1', '\xff', '\xff', '\xff', '\xff' };
+
+		ret = g_file_set_contents(snapshot, corrupt, sizeof(corrupt), &error);
+		g_assert_no_error(error);
+		g_assert_true(ret);
+	}
+
+	g_test_expect_message(G_LOG_DOMAIN, G_LOG_LEVEL_WARNING, "*truncated or corrupt*");
+	g_test_expect_message(G_LOG_DOMAIN, G_LOG_LEVEL_CRITICAL, "*Could not restore snapshot*");
+	ret = j_backend_kv_init(backend, snapshot);
+	g_test_assert_expected_messages();
+	g_assert_false(ret);
+
+	g_unlink(snapshot);
+	g_rmdir(dir);
+}
+
+void
+test_kv_kv_memory(void)
+{
+	g_test_add_func("/kv/kv-memory/snapshot", test_kv_memory_snapshot);
+}
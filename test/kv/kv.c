@@ -213,6 +213,280 @@ test_kv_get_callback(void)
 	g_assert_cmpuint(num_callbacks, ==, 1);
 }
 
+static void
+test_kv_put_get_many(void)
+{
+	guint const n = 100;
+
+	g_autoptr(JBatch) batch = NULL;
+	g_autofree gchar** get_values = NULL;
+	g_autofree guint32* get_lens = NULL;
+	gboolean ret;
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	get_values = g_new0(gchar*, n);
+	get_lens = g_new0(guint32, n);
+
+	// Operations for different keys and namespaces should be combined per server and namespace
+	for (guint i = 0; i < n; i++)
+	{
+		g_autoptr(JKV) kv = NULL;
+		g_autofree gchar* key = NULL;
+
+		key = g_strdup_printf("test-kv-put-get-many-%u", i);
+		kv = j_kv_new((i % 2 == 0) ? "test" : "test-many", key);
+		j_kv_put(kv, g_strdup(key), strlen(key) + 1, g_free, batch);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	for (guint i = 0; i < n; i++)
+	{
+		g_autoptr(JKV) kv = NULL;
+		g_autofree gchar* key = NULL;
+
+		key = g_strdup_printf("test-kv-put-get-many-%u", i);
+		kv = j_kv_new((i % 2 == 0) ? "test" : "test-many", key);
+		j_kv_get(kv, (gpointer)&(get_values[i]), &(get_lens[i]), batch);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	for (guint i = 0; i < n; i++)
+	{
+		g_autoptr(JKV) kv = NULL;
+		g_autofree gchar* key = NULL;
+
+		key = g_strdup_printf("test-kv-put-get-many-%u", i);
+		g_assert_cmpstr(get_values[i], ==, key);
+		g_assert_cmpuint(get_lens[i], ==, strlen(key) + 1);
+		g_free(get_values[i]);
+
+		kv = j_kv_new((i % 2 == 0) ? "test" : "test-many", key);
+		j_kv_delete(kv, batch);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+static void
+test_kv_bulk_put(void)
+{
+	guint const n = 100;
+
+	g_autoptr(JBatch) batch = NULL;
+	g_autofree gchar** get_values = NULL;
+	g_autofree guint32* get_lens = NULL;
+	gboolean ret;
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	get_values = g_new0(gchar*, n);
+	get_lens = g_new0(guint32, n);
+
+	// Put the keys in descending order, bulk puts are sorted before being executed
+	for (guint i = n; i > 0; i--)
+	{
+		g_autoptr(JKV) kv = NULL;
+		g_autofree gchar* key = NULL;
+
+		key = g_strdup_printf("test-kv-bulk-put-%u", i - 1);
+		kv = j_kv_new("test", key);
+		j_kv_bulk_put(kv, g_strdup("old"), 4, g_free, batch);
+		j_kv_bulk_put(kv, g_strdup(key), strlen(key) + 1, g_free, batch);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	for (guint i = 0; i < n; i++)
+	{
+		g_autoptr(JKV) kv = NULL;
+		g_autofree gchar* key = NULL;
+
+		key = g_strdup_printf("test-kv-bulk-put-%u", i);
+		kv = j_kv_new("test", key);
+		j_kv_get(kv, (gpointer)&(get_values[i]), &(get_lens[i]), batch);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	for (guint i = 0; i < n; i++)
+	{
+		g_autoptr(JKV) kv = NULL;
+		g_autofree gchar* key = NULL;
+
+		// The last put for a key has to win
+		key = g_strdup_printf("test-kv-bulk-put-%u", i);
+		g_assert_cmpstr(get_values[i], ==, key);
+		g_assert_cmpuint(get_lens[i], ==, strlen(key) + 1);
+		g_free(get_values[i]);
+
+		kv = j_kv_new("test", key);
+		j_kv_delete(kv, batch);
+	}
+
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+static void
+test_kv_cache(void)
+{
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JBatch) batch_immediate = NULL;
+	g_autoptr(JKV) kv = NULL;
+	g_autofree gchar* get_value = NULL;
+	g_autofree gchar* value = NULL;
+	g_autofree gchar* value_other = NULL;
+	guint32 get_len = 0;
+	gboolean ret;
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	value = g_strdup("kv-value");
+	value_other = g_strdup("kv-value-other");
+
+	kv = j_kv_new("test-cache", "test-kv-cache");
+	g_assert_nonnull(kv);
+
+	if (g_test_subprocess())
+	{
+		// A second client without a cache changes the value
+		j_kv_put(kv, value_other, strlen(value_other) + 1, NULL, batch);
+		ret = j_batch_execute(batch);
+		g_assert_true(ret);
+
+		return;
+	}
+
+	j_kv_cache_enable("test-cache", 1024 * 1024, 0);
+
+	j_kv_put(kv, value, strlen(value) + 1, NULL, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	g_test_trap_subprocess(NULL, 0, 0);
+	g_test_trap_assert_passed();
+
+	// Eventual consistency has to return the stale cached value
+	j_kv_get(kv, (gpointer)&get_value, &get_len, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	g_assert_cmpstr(value, ==, get_value);
+	g_assert_cmpuint(strlen(value) + 1, ==, get_len);
+
+	g_clear_pointer(&get_value, g_free);
+
+	// Immediate consistency has to contact the server and refresh the cache
+	batch_immediate = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_POSIX);
+
+	j_kv_get(kv, (gpointer)&get_value, &get_len, batch_immediate);
+	ret = j_batch_execute(batch_immediate);
+	g_assert_true(ret);
+
+	g_assert_cmpstr(value_other, ==, get_value);
+
+	g_clear_pointer(&get_value, g_free);
+
+	j_kv_get(kv, (gpointer)&get_value, &get_len, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	g_assert_cmpstr(value_other, ==, get_value);
+	g_assert_cmpuint(strlen(value_other) + 1, ==, get_len);
+
+	g_clear_pointer(&get_value, g_free);
+
+	j_kv_delete(kv, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	// The local delete has to invalidate the cached value
+	j_kv_get(kv, (gpointer)&get_value, &get_len, batch);
+	ret = j_batch_execute(batch);
+	g_assert_false(ret);
+	g_assert_null(get_value);
+
+	j_kv_cache_disable("test-cache");
+}
+
+static void
+test_kv_compression(void)
+{
+	guint const len = 4096;
+
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JKV) kv = NULL;
+	g_autoptr(JKV) kv_magic = NULL;
+	g_autoptr(JKV) kv_magic_compressed = NULL;
+	g_autofree gchar* value = NULL;
+	g_autofree gchar* get_value = NULL;
+	g_autofree gchar* get_value_magic = NULL;
+	g_autofree gchar* get_value_magic_compressed = NULL;
+	guint32 get_len = 0;
+	guint32 get_len_magic = 0;
+	guint32 get_len_magic_compressed = 0;
+	// Raw values starting with the magic number have to be returned unchanged
+	gchar const value_magic[] = "\x89JKZ\x01 not a compressed value";
+	gboolean ret;
+
+	j_kv_compression_enable("test-compression", 64);
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	value = g_malloc(len);
+
+	for (guint i = 0; i < len; i++)
+	{
+		value[i] = 'a' + (i % 4);
+	}
+
+	kv = j_kv_new("test-compression", "test-kv-compression");
+	kv_magic = j_kv_new("test", "test-kv-compression-magic");
+	kv_magic_compressed = j_kv_new("test-compression", "test-kv-compression-magic");
+
+	j_kv_put(kv, value, len, NULL, batch);
+	j_kv_put(kv_magic, (gpointer)value_magic, sizeof(value_magic), NULL, batch);
+	j_kv_put(kv_magic_compressed, (gpointer)value_magic, sizeof(value_magic), NULL, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	j_kv_get(kv, (gpointer)&get_value, &get_len, batch);
+	j_kv_get(kv_magic, (gpointer)&get_value_magic, &get_len_magic, batch);
+	j_kv_get(kv_magic_compressed, (gpointer)&get_value_magic_compressed, &get_len_magic_compressed, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	g_assert_cmpuint(get_len, ==, len);
+	g_assert_true(memcmp(get_value, value, len) == 0);
+	g_assert_cmpuint(get_len_magic, ==, sizeof(value_magic));
+	g_assert_true(memcmp(get_value_magic, value_magic, sizeof(value_magic)) == 0);
+	g_assert_cmpuint(get_len_magic_compressed, ==, sizeof(value_magic));
+	g_assert_true(memcmp(get_value_magic_compressed, value_magic, sizeof(value_magic)) == 0);
+
+	j_kv_compression_disable("test-compression");
+
+	// Compressed values are decoded without enabling compression
+	g_clear_pointer(&get_value, g_free);
+	get_len = 0;
+
+	j_kv_get(kv, (gpointer)&get_value, &get_len, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	g_assert_cmpuint(get_len, ==, len);
+	g_assert_true(memcmp(get_value, value, len) == 0);
+
+	j_kv_delete(kv, batch);
+	j_kv_delete(kv_magic, batch);
+	j_kv_delete(kv_magic_compressed, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
 void
 test_kv_kv(void)
 {
@@ -222,4 +496,8 @@ test_kv_kv(void)
 	g_test_add_func("/kv/kv/put_update", test_kv_put_update);
 	g_test_add_func("/kv/kv/get", test_kv_get);
 	g_test_add_func("/kv/kv/get_callback", test_kv_get_callback);
+	g_test_add_func("/kv/kv/put_get_many", test_kv_put_get_many);
+	g_test_add_func("/kv/kv/bulk_put", test_kv_bulk_put);
+	g_test_add_func("/kv/kv/cache", test_kv_cache);
+	g_test_add_func("/kv/kv/compression", test_kv_compression);
 }
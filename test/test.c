@@ -42,7 +42,9 @@ main(int argc, char** argv)
 	test_core_list_iterator();
 	test_core_memory_chunk();
 	test_core_message();
+	test_core_row_block();
 	test_core_semantics();
+	test_core_transformation();
 
 	// Object client
 	test_object_distributed_object();
@@ -51,6 +53,7 @@ main(int argc, char** argv)
 	// KV client
 	test_kv_kv();
 	test_kv_kv_iterator();
+	test_kv_kv_memory();
 
 	// DB client
 	test_db_db();
@@ -65,6 +68,9 @@ main(int argc, char** argv)
 	// HDF5 client
 	test_hdf_hdf();
 
+	// Transformation client
+	test_transformation_transformation_object();
+
 	ret = g_test_run();
 
 	return ret;
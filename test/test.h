@@ -29,13 +29,16 @@ void test_core_list(void);
 void test_core_list_iterator(void);
 void test_core_memory_chunk(void);
 void test_core_message(void);
+void test_core_row_block(void);
 void test_core_semantics(void);
+void test_core_transformation(void);
 
 void test_object_distributed_object(void);
 void test_object_object(void);
 
 void test_kv_kv(void);
 void test_kv_kv_iterator(void);
+void test_kv_kv_memory(void);
 
 void test_db_db(void);
 
@@ -47,4 +50,6 @@ void test_item_uri(void);
 
 void test_hdf_hdf(void);
 
+void test_transformation_transformation_object(void);
+
 #endif
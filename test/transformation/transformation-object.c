@@ -0,0 +1,217 @@
+/*
+ * JULEA - Flexible storage framework
+ * Copyright (C) 2021 Michael Kuhn
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Lesser General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <julea-config.h>
+
+#include <glib.h>
+
+#include <string.h>
+
+#include <julea.h>
+#include <julea-transformation.h>
+
+#include "test.h"
+
+/**
+ * Fills a block whose first random_length bytes can not be compressed.
+ **/
+static void
+test_transformation_object_fill(gchar* data, guint64 length, guint64 random_length, GRand* rand)
+{
+	for (guint64 i = 0; i < length; i++)
+	{
+		data[i] = (i < random_length) ? (gchar)g_rand_int_range(rand, 0, 256) : 'J';
+	}
+}
+
+static guint64
+test_transformation_object_transformed_size(JTransformationObject* object, JBatch* batch)
+{
+	guint64 original_size = 0;
+	guint64 transformed_size = 0;
+	gboolean ret;
+
+	j_transformation_object_status_ext(object, NULL, &original_size, &transformed_size, NULL, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	return transformed_size;
+}
+
+static void
+test_transformation_object_blocks(void)
+{
+	guint64 const block_size = 4096;
+	guint64 const size = 16 * block_size;
+
+	g_autoptr(JBatch) batch = NULL;
+	g_autoptr(JBatch) immediate_batch = NULL;
+	g_autoptr(JSemantics) immediate_semantics = NULL;
+	g_autoptr(JTransformationObject) object = NULL;
+	g_autoptr(JTransformationObject) other_object = NULL;
+	g_autofree gchar* data = NULL;
+	g_autofree gchar* buffer = NULL;
+	g_autoptr(GRand) rand = NULL;
+	guint64 transformed_size;
+	guint64 nbytes = 0;
+	gboolean ret;
+
+	batch = j_batch_new_for_template(J_SEMANTICS_TEMPLATE_DEFAULT);
+	data = g_malloc(size);
+	buffer = g_malloc0(size);
+
+	for (guint64 i = 0; i < size; i++)
+	{
+		data[i] = "JULEA"[i % 5] + (i / 1000);
+	}
+
+	object = j_transformation_object_new("test", "test-transformation-object-blocks");
+	g_assert_true(object != NULL);
+
+	j_transformation_object_create_indexed(object, batch, J_TRANSFORMATION_TYPE_ZSTD, J_TRANSFORMATION_MODE_CLIENT, 0, 0, block_size);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	j_transformation_object_write(object, data, size, 0, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, size);
+
+	// Reads covering parts of one or more blocks
+	nbytes = 0;
+	j_transformation_object_read(object, buffer, 1024, 10000, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, 1024);
+	g_assert_cmpmem(buffer, 1024, data + 10000, 1024);
+
+	nbytes = 0;
+	j_transformation_object_read(object, buffer, 3 * block_size, block_size / 2, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, 3 * block_size);
+	g_assert_cmpmem(buffer, 3 * block_size, data + block_size / 2, 3 * block_size);
+
+	// Overwrite parts of two blocks
+	memset(data + block_size - 100, 'x', 200);
+
+	nbytes = 0;
+	j_transformation_object_write(object, data + block_size - 100, 200, block_size - 100, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, 200);
+
+	// Another handle has to load the block index
+	other_object = j_transformation_object_new("test", "test-transformation-object-blocks");
+
+	nbytes = 0;
+	j_transformation_object_read(other_object, buffer, size, 0, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, size);
+	g_assert_cmpmem(buffer, size, data, size);
+
+	// Reads beyond the end of the object are truncated
+	nbytes = 0;
+	j_transformation_object_read(other_object, buffer, 2 * block_size, size - block_size, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, block_size);
+
+	// Appending a block through one handle is only seen by the other one with immediate consistency
+	nbytes = 0;
+	j_transformation_object_write(object, data, block_size, size, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, block_size);
+
+	immediate_semantics = j_semantics_new(J_SEMANTICS_TEMPLATE_DEFAULT);
+	j_semantics_set(immediate_semantics, J_SEMANTICS_CONSISTENCY, J_SEMANTICS_CONSISTENCY_IMMEDIATE);
+	immediate_batch = j_batch_new(immediate_semantics);
+
+	nbytes = 0;
+	memset(buffer, 0, block_size);
+	j_transformation_object_read(other_object, buffer, block_size, size, &nbytes, immediate_batch);
+	ret = j_batch_execute(immediate_batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, block_size);
+	g_assert_cmpmem(buffer, block_size, data, block_size);
+
+	// Blocks that do not fit into their space anymore are moved, their old space is reused by later writes
+	rand = g_rand_new_with_seed(42);
+
+	test_transformation_object_fill(data, block_size, block_size / 2, rand);
+	j_transformation_object_write(object, data, block_size, 5 * block_size, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	test_transformation_object_fill(data, block_size, block_size, rand);
+	j_transformation_object_write(object, data, block_size, 5 * block_size, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+
+	transformed_size = test_transformation_object_transformed_size(object, batch);
+
+	test_transformation_object_fill(data, block_size, block_size / 4, rand);
+	nbytes = 0;
+	j_transformation_object_write(object, data, block_size, 6 * block_size, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, block_size);
+	g_assert_cmpuint(test_transformation_object_transformed_size(object, batch), ==, transformed_size);
+
+	nbytes = 0;
+	j_transformation_object_read(object, buffer, block_size, 6 * block_size, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, block_size);
+	g_assert_cmpmem(buffer, block_size, data, block_size);
+
+	// Writing beyond the end of the object leaves holes that are read as zeros
+	memset(data, 'x', 100);
+	nbytes = 0;
+	j_transformation_object_write(object, data, 100, size + 5 * block_size, &nbytes, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, 100);
+	g_assert_cmpuint(test_transformation_object_transformed_size(object, batch), <, transformed_size + block_size);
+
+	nbytes = 0;
+	memset(buffer, 'y', size);
+	j_transformation_object_read(other_object, buffer, 4 * block_size + 100, size + block_size, &nbytes, immediate_batch);
+	ret = j_batch_execute(immediate_batch);
+	g_assert_true(ret);
+	g_assert_cmpuint(nbytes, ==, 4 * block_size + 100);
+
+	for (guint64 i = 0; i < 4 * block_size; i++)
+	{
+		g_assert_cmpint(buffer[i], ==, 0);
+	}
+
+	g_assert_cmpmem(buffer + 4 * block_size, 100, data, 100);
+
+	j_transformation_object_delete(object, batch);
+	ret = j_batch_execute(batch);
+	g_assert_true(ret);
+}
+
+void
+test_transformation_transformation_object(void)
+{
+	g_test_add_func("/transformation/transformation-object/blocks", test_transformation_object_blocks);
+}
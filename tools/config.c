@@ -43,6 +43,7 @@ static gchar const* opt_db_path = NULL;
 static gint64 opt_max_operation_size = 0;
 static gint opt_max_connections = 0;
 static gint64 opt_stripe_size = 0;
+static gint64 opt_kv_group_commit_window = 0;
 
 static gchar**
 string_split(gchar const* string)
@@ -115,6 +116,7 @@ write_config(gchar* path)
 	g_key_file_set_string(key_file, "kv", "backend", opt_kv_backend);
 	g_key_file_set_string(key_file, "kv", "component", opt_kv_component);
 	g_key_file_set_string(key_file, "kv", "path", opt_kv_path);
+	g_key_file_set_int64(key_file, "kv", "group-commit-window", opt_kv_group_commit_window);
 	g_key_file_set_string(key_file, "db", "backend", opt_db_backend);
 	g_key_file_set_string(key_file, "db", "component", opt_db_component);
 	g_key_file_set_string(key_file, "db", "path", opt_db_path);
@@ -160,6 +162,7 @@ main(gint argc, gchar** argv)
 		{ "kv-backend", 0, 0, G_OPTION_ARG_STRING, &opt_kv_backend, "Key-value backend to use", "posix|null|gio|…" },
 		{ "kv-component", 0, 0, G_OPTION_ARG_STRING, &opt_kv_component, "Key-value component to use", "client|server" },
 		{ "kv-path", 0, 0, G_OPTION_ARG_STRING, &opt_kv_path, "Key-value path to use", "/path/to/storage" },
+		{ "kv-group-commit-window", 0, 0, G_OPTION_ARG_INT64, &opt_kv_group_commit_window, "Time in microseconds to group durable key-value commits", "0" },
 		{ "db-backend", 0, 0, G_OPTION_ARG_STRING, &opt_db_backend, "Database backend to use", "sqlite|null|…" },
 		{ "db-component", 0, 0, G_OPTION_ARG_STRING, &opt_db_component, "Database component to use", "client|server" },
 		{ "db-path", 0, 0, G_OPTION_ARG_STRING, &opt_db_path, "Database path to use", "/path/to/storage" },
@@ -189,7 +192,8 @@ main(gint argc, gchar** argv)
 	    || (!opt_read && (opt_servers_object == NULL || opt_servers_kv == NULL || opt_servers_db == NULL || opt_object_backend == NULL || opt_object_component == NULL || opt_object_path == NULL || opt_kv_backend == NULL || opt_kv_component == NULL || opt_kv_path == NULL || opt_db_backend == NULL || opt_db_component == NULL || opt_db_path == NULL))
 	    || opt_max_operation_size < 0
 	    || opt_max_connections < 0
-	    || opt_stripe_size < 0)
+	    || opt_stripe_size < 0
+	    || opt_kv_group_commit_window < 0)
 	{
 		g_autofree gchar* help = NULL;
 
@@ -47,6 +47,9 @@ print_statistics(JStatistics* statistics)
 	g_print("  %s written\n", size_written);
 	g_print("  %s received\n", size_received);
 	g_print("  %s sent\n", size_sent);
+	g_print("  %" G_GUINT64_FORMAT " DB statements reused\n", j_statistics_get(statistics, J_STATISTICS_DB_STATEMENTS_HIT));
+	g_print("  %" G_GUINT64_FORMAT " DB statements prepared\n", j_statistics_get(statistics, J_STATISTICS_DB_STATEMENTS_MISSED));
+	g_print("  %" G_GUINT64_FORMAT " DB statements evicted\n", j_statistics_get(statistics, J_STATISTICS_DB_STATEMENTS_EVICTED));
 
 	g_free(size_read);
 	g_free(size_written);
@@ -120,6 +123,18 @@ main(int argc, char** argv)
 		j_statistics_add(statistics, J_STATISTICS_BYTES_SENT, value);
 		j_statistics_add(statistics_total, J_STATISTICS_BYTES_SENT, value);
 
+		value = j_message_get_8(reply);
+		j_statistics_add(statistics, J_STATISTICS_DB_STATEMENTS_HIT, value);
+		j_statistics_add(statistics_total, J_STATISTICS_DB_STATEMENTS_HIT, value);
+
+		value = j_message_get_8(reply);
+		j_statistics_add(statistics, J_STATISTICS_DB_STATEMENTS_MISSED, value);
+		j_statistics_add(statistics_total, J_STATISTICS_DB_STATEMENTS_MISSED, value);
+
+		value = j_message_get_8(reply);
+		j_statistics_add(statistics, J_STATISTICS_DB_STATEMENTS_EVICTED, value);
+		j_statistics_add(statistics_total, J_STATISTICS_DB_STATEMENTS_EVICTED, value);
+
 		g_print("Data server %d\n", i);
 		print_statistics(statistics);
 